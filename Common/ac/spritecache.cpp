@@ -13,8 +13,15 @@
 //=============================================================================
 #include "core/platform.h"
 #include "ac/spritecache.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include "ac/gamestructdefines.h"
 #include "debug/out.h"
+#include "debug/profiler.h"
 #include "gfx/bitmap.h"
 
 using namespace AGS::Common;
@@ -41,9 +48,25 @@ namespace AGS
 namespace Common
 {
 
+struct SpriteCache::PrefetchState
+{
+    // Guards sprite file stream from concurrent access
+    std::mutex FileMutex;
+    std::thread Thread;
+    std::mutex Mutex;
+    std::condition_variable CV;
+    std::deque<sprkey_t> Queue;
+    sprkey_t Current = -1; // sprite being decoded right now
+    std::vector<std::pair<sprkey_t, std::unique_ptr<Bitmap>>> Ready;
+    // Number of ready sprites, for the quick test without a mutex lock
+    std::atomic<size_t> ReadyCount{ 0u };
+    bool Exit = false;
+};
+
 SpriteCache::SpriteCache(std::vector<SpriteInfo> &sprInfos, const Callbacks &callbacks)
-    : ResourceCache(DEFAULTCACHESIZE_KB * 1024u)
+    : DenseResourceCache(DEFAULTCACHESIZE_KB * 1024u)
     , _sprInfos(sprInfos)
+    , _prefetch(new PrefetchState())
 {
     _callbacks.AdjustSize = (callbacks.AdjustSize) ? callbacks.AdjustSize : DummyAdjustSize;
     _callbacks.InitSprite = (callbacks.InitSprite) ? callbacks.InitSprite : DummyInitSprite;
@@ -74,8 +97,9 @@ bool SpriteCache::IsAssetSprite(sprkey_t index) const
 
 void SpriteCache::Reset()
 {
+    StopPrefetch();
     _file.Close();
-    ResourceCache::Clear();
+    DenseResourceCache::Clear();
     _spriteData.clear();
 }
 
@@ -112,7 +136,7 @@ void SpriteCache::SetEmptySprite(sprkey_t index, bool as_asset)
         Debug::Printf(kDbgGroup_SprCache, kDbgMsg_Error, "SetEmptySprite: unable to use index %d", index);
         return;
     }
-    ResourceCache::Dispose(index); // make sure it's free
+    DenseResourceCache::Dispose(index); // make sure it's free
     if (as_asset)
         _spriteData[index].Flags = SPRCACHEFLAG_ISASSET;
     RemapSpriteToSprite0(index);
@@ -123,7 +147,7 @@ Bitmap *SpriteCache::RemoveSprite(sprkey_t index)
     assert(index >= 0); // out of positive range indexes are valid to fail
     if (index < 0 || (size_t)index >= _spriteData.size())
         return nullptr;
-    std::unique_ptr<Bitmap> image = ResourceCache::Remove(index);
+    std::unique_ptr<Bitmap> image = DenseResourceCache::Remove(index);
     InitNullSprite(index);
     SprCacheLog("RemoveSprite: %d", index);
     return image.release();
@@ -134,7 +158,7 @@ void SpriteCache::DisposeSprite(sprkey_t index)
     assert(index >= 0); // out of positive range indexes are valid to fail
     if (index < 0 || (size_t)index >= _spriteData.size())
         return;
-    ResourceCache::Dispose(index);
+    DenseResourceCache::Dispose(index);
     InitNullSprite(index);
     SprCacheLog("RemoveAndDispose: %d", index);
 }
@@ -211,10 +235,13 @@ Bitmap *SpriteCache::operator [] (sprkey_t index)
     if (index < 0 || (size_t)index >= _spriteData.size())
         return nullptr;
 
+    // Pick up any sprites decoded in the background
+    if (_prefetch->ReadyCount > 0)
+        ProcessPrefetched();
     // Resolve potentially remapped sprites
     index = GetDataIndex(index);
     // Try get image from cache
-    auto &image = ResourceCache::Get(index);
+    auto &image = DenseResourceCache::Get(index);
     if (image)
         return image.get();
     // If no ready image, but has an asset, then try loading one
@@ -225,7 +252,7 @@ Bitmap *SpriteCache::operator [] (sprkey_t index)
 
 void SpriteCache::DisposeAllCached()
 {
-    ResourceCache::DisposeFreeItems();
+    DenseResourceCache::DisposeFreeItems();
 }
 
 void SpriteCache::Precache(sprkey_t index)
@@ -236,11 +263,11 @@ void SpriteCache::Precache(sprkey_t index)
     if (!_spriteData[index].IsAssetSprite())
         return; // cannot precache a non-asset sprite
 
-    if (!ResourceCache::Exists(index))
+    if (!DenseResourceCache::Exists(index))
         LoadSprite(index);
 
     // make sure locked sprites can't fill the cache
-    ResourceCache::Lock(index);
+    DenseResourceCache::Lock(index);
     _spriteData[index].Flags |= SPRCACHEFLAG_LOCKED;
     SprCacheLog("Precached %d", index);
 }
@@ -264,8 +291,15 @@ Bitmap *SpriteCache::LoadSprite(sprkey_t index)
         return nullptr;
     assert((_spriteData[index].Flags & SPRCACHEFLAG_ISASSET) != 0);
 
-    Bitmap *image{};
-    HError err = _file.LoadSprite(index, image);
+    AGS_PROFILE_ZONE("Sprite load");
+    AGS_PROFILE_COUNT("Sprite loads", 1);
+    Bitmap *image = TakePrefetched(index);
+    HError err = HError::None();
+    if (!image)
+    {
+        std::lock_guard<std::mutex> lk(_prefetch->FileMutex);
+        err = _file.LoadSprite(index, image);
+    }
     if (!image)
     {
         Debug::Printf(kDbgGroup_SprCache, kDbgMsg_Warn,
@@ -274,7 +308,11 @@ Bitmap *SpriteCache::LoadSprite(sprkey_t index)
         RemapSpriteToSprite0(index);
         return nullptr;
     }
+    return InitLoadedSprite(index, image);
+}
 
+Bitmap *SpriteCache::InitLoadedSprite(sprkey_t index, Bitmap *image)
+{
     // Let the external user convert this sprite's image for their needs
     image = _callbacks.InitSprite(index, image, _sprInfos[index].Flags);
     if (!image)
@@ -290,11 +328,11 @@ Bitmap *SpriteCache::LoadSprite(sprkey_t index)
     _sprInfos[index].Height = image->GetHeight();
 
     // Add to the cache
-    ResourceCache::Put(index, std::unique_ptr<Bitmap>(image));
+    DenseResourceCache::Put(index, std::unique_ptr<Bitmap>(image));
     _spriteData[index].Flags = SPRCACHEFLAG_ISASSET;
     if (index == 0) // keep sprite 0 locked
         _spriteData[index].Flags |= SPRCACHEFLAG_LOCKED;
-    SprCacheLog("Loaded %d, size now %zu KB", index, _cacheSize / 1024);
+    SprCacheLog("Loaded %d, size now %zu KB", index, GetCacheSize() / 1024);
 
     // Let the external user to react to the new sprite;
     // note that this callback is allowed to modify the sprite's pixels,
@@ -303,6 +341,137 @@ Bitmap *SpriteCache::LoadSprite(sprkey_t index)
     return image;
 }
 
+void SpriteCache::Prefetch(sprkey_t index)
+{
+#if !defined(AGS_DISABLE_THREADS)
+    if (index < 0 || (size_t)index >= _spriteData.size())
+        return;
+    const auto &spr = _spriteData[index];
+    if (!spr.IsAssetSprite() || spr.IsRemapped() || DenseResourceCache::Exists(index))
+        return; // not an asset, or already loaded
+
+    std::lock_guard<std::mutex> lk(_prefetch->Mutex);
+    if ((_prefetch->Current == index) ||
+        (std::find(_prefetch->Queue.begin(), _prefetch->Queue.end(), index) != _prefetch->Queue.end()))
+        return; // already pending
+    for (const auto &ready : _prefetch->Ready)
+        if (ready.first == index)
+            return; // already decoded
+    _prefetch->Queue.push_back(index);
+    if (!_prefetch->Thread.joinable())
+        _prefetch->Thread = std::thread(&SpriteCache::PrefetchThread, this);
+    _prefetch->CV.notify_one();
+#else
+    (void)index; // no background loading, sprites are loaded when requested
+#endif
+}
+
+size_t SpriteCache::GetPrefetchedCount() const
+{
+    return _prefetch->ReadyCount;
+}
+
+Bitmap *SpriteCache::TakePrefetched(sprkey_t index)
+{
+    if (!_prefetch->Thread.joinable())
+        return nullptr;
+    std::unique_lock<std::mutex> lk(_prefetch->Mutex);
+    auto it_queue = std::find(_prefetch->Queue.begin(), _prefetch->Queue.end(), index);
+    if (it_queue != _prefetch->Queue.end())
+        _prefetch->Queue.erase(it_queue);
+    // If the sprite is being decoded now, then waiting is faster than loading it again
+    _prefetch->CV.wait(lk, [this, index]() { return _prefetch->Current != index; });
+    for (auto it = _prefetch->Ready.begin(); it != _prefetch->Ready.end(); ++it)
+    {
+        if (it->first == index)
+        {
+            Bitmap *image = it->second.release();
+            _prefetch->Ready.erase(it);
+            _prefetch->ReadyCount = _prefetch->Ready.size();
+            return image;
+        }
+    }
+    return nullptr;
+}
+
+void SpriteCache::ProcessPrefetched()
+{
+    std::vector<std::pair<sprkey_t, std::unique_ptr<Bitmap>>> ready;
+    {
+        std::lock_guard<std::mutex> lk(_prefetch->Mutex);
+        std::swap(ready, _prefetch->Ready);
+        _prefetch->ReadyCount = 0u;
+    }
+    for (auto &item : ready)
+    {
+        const sprkey_t index = item.first;
+        // The sprite could have been replaced or loaded while it was decoded
+        if ((size_t)index >= _spriteData.size())
+            continue;
+        const auto &spr = _spriteData[index];
+        if (!spr.IsAssetSprite() || spr.IsRemapped() || spr.IsExternalSprite() ||
+            DenseResourceCache::Exists(index))
+            continue;
+        InitLoadedSprite(index, item.second.release());
+        SprCacheLog("Prefetched %d", index);
+    }
+}
+
+void SpriteCache::StopPrefetch()
+{
+    if (_prefetch->Thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lk(_prefetch->Mutex);
+            _prefetch->Exit = true;
+        }
+        _prefetch->CV.notify_all();
+        _prefetch->Thread.join();
+    }
+    _prefetch->Queue.clear();
+    _prefetch->Ready.clear();
+    _prefetch->ReadyCount = 0u;
+    _prefetch->Exit = false;
+}
+
+void SpriteCache::PrefetchThread()
+{
+    SpriteDatHeader hdr;
+    std::vector<uint8_t> data;
+    std::unique_lock<std::mutex> lk(_prefetch->Mutex);
+    while (true)
+    {
+        _prefetch->CV.wait(lk, [this]() { return _prefetch->Exit || !_prefetch->Queue.empty(); });
+        if (_prefetch->Exit)
+            break;
+        const sprkey_t index = _prefetch->Queue.front();
+        _prefetch->Queue.pop_front();
+        _prefetch->Current = index;
+        lk.unlock();
+
+        // Only read the data under the file lock, and decode separately,
+        // so that the sprites requested by the game are not kept waiting
+        Bitmap *image = nullptr;
+        {
+            AGS_PROFILE_ZONE("Sprite prefetch");
+            {
+                std::lock_guard<std::mutex> file_lk(_prefetch->FileMutex);
+                _file.LoadRawData(index, hdr, data);
+            }
+            _file.DecodeRawData(index, hdr, data, image);
+        }
+
+        lk.lock();
+        _prefetch->Current = -1;
+        if (image)
+        {
+            _prefetch->Ready.emplace_back(index, std::unique_ptr<Bitmap>(image));
+            _prefetch->ReadyCount = _prefetch->Ready.size();
+        }
+        _prefetch->CV.notify_all(); // wake up anyone waiting for this sprite
+    }
+}
+
 void SpriteCache::RemapSpriteToSprite0(sprkey_t index)
 {
     assert((index > 0) && ((size_t)index < _spriteData.size()));
@@ -330,13 +499,14 @@ int SpriteCache::SaveToFile(const String &filename, int store_flags, SpriteCompr
     std::vector<std::pair<bool, Bitmap*>> sprites;
     for (size_t i = 0; i < _spriteData.size(); ++i)
     {
-        auto &image = ResourceCache::Get(i);
+        auto &image = DenseResourceCache::Get(i);
         if (image) // optionally convert a sprite's pixel data for the saving
             _callbacks.PrewriteSprite(image.get());
         sprites.push_back(std::make_pair(
             (image || _spriteData[i].IsAssetSprite()),
             image.get()));
     }
+    std::lock_guard<std::mutex> lk(_prefetch->FileMutex);
     return SaveSpriteFile(filename, sprites, &_file, store_flags, compress, index);
 }
 
@@ -374,6 +544,7 @@ HError SpriteCache::InitFile(const String &filename, const String &sprindex_file
 
 void SpriteCache::DetachFile()
 {
+    StopPrefetch();
     _file.Close();
 }
 
@@ -19,7 +19,7 @@
 //
 // TODO: refactor engine code to allow store and return shared_ptr<Bitmap>.
 //
-// TODO: currently inherits ResourceCache<Bitmap> as protected, because sprites
+// TODO: currently inherits DenseResourceCache<Bitmap> as protected, because sprites
 // are supposed to be added through specific methods that also imply streaming
 // from the file. Possibly we need another (base) class concept, something
 // called a ResourceManager, for instance. ResourceManager would contain both
@@ -61,7 +61,7 @@ namespace Common
 {
 
 class SpriteCache :
-    protected ResourceCache<sprkey_t, std::unique_ptr<Bitmap>>
+    protected DenseResourceCache<sprkey_t, std::unique_ptr<Bitmap>>
 {
 public:
     static const sprkey_t MIN_SPRITE_INDEX = 1; // 0 is reserved for "empty sprite"
@@ -106,13 +106,13 @@ public:
     // Finds a free slot index, if all slots are occupied enlarges sprite bank; returns index
     sprkey_t    GetFreeIndex();
     // Returns current size of the cache, in bytes; this includes locked size too!
-    inline size_t GetCacheSize() const { return ResourceCache::GetCacheSize(); }
+    inline size_t GetCacheSize() const { return DenseResourceCache::GetCacheSize(); }
     // Gets the total size of the locked sprites, in bytes
-    inline size_t GetLockedSize() const { return ResourceCache::GetLockedSize(); }
+    inline size_t GetLockedSize() const { return DenseResourceCache::GetLockedSize(); }
     // Gets the total size of the external locked sprites, in bytes
-    inline size_t GetExternalSize() const { return ResourceCache::GetExternalSize(); }
+    inline size_t GetExternalSize() const { return DenseResourceCache::GetExternalSize(); }
     // Returns maximal size limit of the cache, in bytes; this includes locked size too!
-    inline size_t GetMaxCacheSize() const { return ResourceCache::GetMaxCacheSize(); }
+    inline size_t GetMaxCacheSize() const { return DenseResourceCache::GetMaxCacheSize(); }
     // Returns number of sprite slots in the bank (this includes both actual sprites and free slots)
     size_t      GetSpriteSlotCount() const;
     // Tells if the sprite storage still has unoccupied slots to put new sprites in
@@ -122,6 +122,13 @@ public:
     bool        IsAssetSprite(sprkey_t index) const;
     // Loads sprite and and locks in memory (so it cannot get removed implicitly)
     void        Precache(sprkey_t index);
+    // Queues an asset sprite for decoding on the background thread;
+    // the decoded image is picked up by the cache on the next sprite request.
+    // If the sprite is requested before it's ready, it will be loaded as usual.
+    void        Prefetch(sprkey_t index);
+    // Returns the number of prefetched sprites which are decoded and wait
+    // to be picked up by the cache
+    size_t      GetPrefetchedCount() const;
     // Unregisters sprite from the bank and returns the bitmap
     Bitmap*     RemoveSprite(sprkey_t index);
     // Deletes particular sprite, marks slot as unused
@@ -140,7 +147,7 @@ public:
     // *Deletes* the previous sprite if one was found at the same index.
     void        SetEmptySprite(sprkey_t index, bool as_asset);
     // Sets max cache size in bytes
-    inline void SetMaxCacheSize(size_t size) { ResourceCache::SetMaxCacheSize(size); }
+    inline void SetMaxCacheSize(size_t size) { DenseResourceCache::SetMaxCacheSize(size); }
 
     // Loads (if it's not in cache yet) and returns bitmap by the sprite index
     Bitmap *operator[] (sprkey_t index);
@@ -153,6 +160,17 @@ protected:
 private:
     // Load sprite from game resource and put into the cache
     Bitmap *    LoadSprite(sprkey_t index);
+    // Initializes the loaded sprite image and puts into the cache
+    Bitmap *    InitLoadedSprite(sprkey_t index, Bitmap *image);
+    // Takes the given sprite out of the prefetch queue; if the sprite is being
+    // decoded right now, then waits for it. Returns the image if it's ready.
+    Bitmap *    TakePrefetched(sprkey_t index);
+    // Puts all the ready prefetched sprites into the cache
+    void        ProcessPrefetched();
+    // Stops prefetching thread, and discards all the pending sprites
+    void        StopPrefetch();
+    // Prefetching thread's function
+    void        PrefetchThread();
     // Remap the given index to the sprite 0
     void        RemapSpriteToSprite0(sprkey_t index);
     // Gets the index of a sprite which data is used for the given slot;
@@ -195,6 +213,12 @@ private:
 
     Callbacks  _callbacks;
     SpriteFile _file;
+    // Sprite prefetching state: the sprites are decoded by a background thread,
+    // and the ready images are kept until the cache picks them up.
+    // NOTE: hidden from the header, because threading headers may not be
+    // available for all the units that include it (e.g. managed code).
+    struct PrefetchState;
+    std::unique_ptr<PrefetchState> _prefetch;
 
 };
 
@@ -151,6 +151,10 @@ public:
     HError      LoadSprite(sprkey_t index, Bitmap *&sprite);
     // Loads a raw sprite element data into the buffer, stores header info separately
     HError      LoadRawData(sprkey_t index, SpriteDatHeader &hdr, std::vector<uint8_t> &data);
+    // Creates a ready bitmap from the raw sprite element data, previously read
+    // by LoadRawData; does not access the file stream
+    HError      DecodeRawData(sprkey_t index, const SpriteDatHeader &hdr,
+        const std::vector<uint8_t> &data, Bitmap *&sprite) const;
 
 private:
     // Seek stream to sprite
@@ -12,6 +12,7 @@
 //
 //=============================================================================
 #include <algorithm>
+#include <numeric>
 #include <stdio.h>
 #include <string.h>
 #include "ac/wordsdictionary.h"
@@ -19,11 +20,13 @@
 #include "util/string_compat.h"
 
 using AGS::Common::Stream;
+using AGS::Common::String;
 
 WordsDictionary::WordsDictionary()
     : num_words(0)
     , word(nullptr)
     , wordnum(nullptr)
+    , _hasIndex(false)
 {
 }
 
@@ -58,28 +61,52 @@ void WordsDictionary::free_memory()
         wordnum = nullptr;
         num_words = 0;
     }
+    _hasIndex = false;
+    _index.clear();
+    _multiwordPrefixes.clear();
 }
 
 void WordsDictionary::sort () {
-    int aa, bb;
-    for (aa = 0; aa < num_words; aa++) {
-        for (bb = aa + 1; bb < num_words; bb++) {
-            if (((wordnum[aa] == wordnum[bb]) && (ags_stricmp(word[aa], word[bb]) > 0))
-                || (wordnum[aa] > wordnum[bb])) {
-                    short temp = wordnum[aa];
-                    char tempst[MAX_PARSER_WORD_LENGTH];
-                    wordnum[aa] = wordnum[bb];
-                    wordnum[bb] = temp;
-                    snprintf(tempst, MAX_PARSER_WORD_LENGTH, "%s", word[aa]);
-                    snprintf(word[aa], MAX_PARSER_WORD_LENGTH, "%s", word[bb]);
-                    snprintf(word[bb], MAX_PARSER_WORD_LENGTH, "%s", tempst);
-                    bb = aa;
-            }
+    // Sort the word indexes, and then move the words into their places
+    std::vector<int> order(num_words);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        if (wordnum[a] != wordnum[b])
+            return wordnum[a] < wordnum[b];
+        return ags_stricmp(word[a], word[b]) < 0;
+    });
+
+    if (num_words > 0) {
+        std::vector<char> old_words(word[0], word[0] + num_words * MAX_PARSER_WORD_LENGTH);
+        std::vector<short> old_nums(wordnum, wordnum + num_words);
+        for (int i = 0; i < num_words; i++) {
+            memcpy(word[i], &old_words[order[i] * MAX_PARSER_WORD_LENGTH], MAX_PARSER_WORD_LENGTH);
+            wordnum[i] = old_nums[order[i]];
         }
     }
+    build_index();
+}
+
+void WordsDictionary::build_index() {
+    _index.clear();
+    _multiwordPrefixes.clear();
+    _index.reserve(num_words);
+    for (int i = 0; i < num_words; i++) {
+        // only the first of the duplicate words is found by the lookup
+        _index.emplace(String(word[i]), i);
+        // register the leading words of the multi-word words
+        for (const char *sp = strchr(word[i], ' '); sp; sp = strchr(sp + 1, ' '))
+            _multiwordPrefixes.insert(String(word[i], sp - word[i]));
+    }
+    _hasIndex = true;
 }
 
 int WordsDictionary::find_index (const char*wrem) {
+    if (_hasIndex) {
+        auto it = _index.find(String::Wrapper(wrem));
+        return it != _index.end() ? it->second : -1;
+    }
+
     int aa;
     for (aa = 0; aa < num_words; aa++) {
         if (ags_stricmp (wrem, word[aa]) == 0)
@@ -88,6 +115,12 @@ int WordsDictionary::find_index (const char*wrem) {
     return -1;
 }
 
+bool WordsDictionary::is_multiword_prefix(const char *text) {
+    if (!_hasIndex)
+        return true; // unknown, let the caller test all the variants
+    return _multiwordPrefixes.count(String::Wrapper(text)) > 0;
+}
+
 const char *passwencstring = "Avis Durgan";
 
 void decrypt_text(char *toenc, size_t buf_sz) {
@@ -125,6 +158,7 @@ void read_dictionary (WordsDictionary *dict, Stream *out) {
     read_string_decrypt (out, dict->word[ii], MAX_PARSER_WORD_LENGTH);
     dict->wordnum[ii] = out->ReadInt16();
   }
+  dict->build_index();
 }
 
 #if defined (OBSOLETE)
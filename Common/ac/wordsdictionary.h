@@ -15,7 +15,10 @@
 #ifndef __AC_WORDSDICTIONARY_H
 #define __AC_WORDSDICTIONARY_H
 
+#include <unordered_map>
+#include <unordered_set>
 #include "core/types.h"
+#include "util/string_types.h"
 
 namespace AGS { namespace Common { class Stream; } }
 using namespace AGS; // FIXME later
@@ -33,8 +36,28 @@ struct WordsDictionary {
     ~WordsDictionary();
     void allocate_memory(int wordCount);
     void free_memory();
+    // Sorts words by their word number, and alphabetically among the same
+    // numbers; rebuilds the lookup index
     void  sort();
+    // Builds the case-insensitive lookup index;
+    // must be called after the words are loaded or modified
+    void  build_index();
+    // Finds the word, case-insensitive; returns the index of the first
+    // matching entry, or -1 if none found
     int   find_index (const char *);
+    // Tells whether there are multi-word words which begin with the given
+    // text followed by a space (e.g. "pick" for "pick up")
+    bool  is_multiword_prefix(const char *);
+
+private:
+    typedef std::unordered_map<Common::String, int,
+        Common::HashStrNoCase, Common::StrEqNoCase> WordIndex;
+    typedef std::unordered_set<Common::String,
+        Common::HashStrNoCase, Common::StrEqNoCase> PrefixSet;
+
+    bool      _hasIndex;
+    WordIndex _index;
+    PrefixSet _multiwordPrefixes;
 };
 
 extern const char *passwencstring;
@@ -23,6 +23,8 @@ AssetInfo::AssetInfo()
     : LibUid(0)
     , Offset(0)
     , Size(0)
+    , Flags(0)
+    , UncompressedSize(0)
 {
 }
 
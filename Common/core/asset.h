@@ -26,6 +26,12 @@ namespace AGS
 namespace Common
 {
 
+// Asset storage flags
+enum AssetFlags
+{
+    kAssetFlag_Compressed   = 0x0001 // asset's data is compressed with LZW
+};
+
 // Information on single asset
 struct AssetInfo
 {
@@ -33,7 +39,9 @@ struct AssetInfo
     String      FileName;   // filename associated with asset
     int32_t     LibUid;     // index of library partition (separate file)
     soff_t      Offset;     // asset's position in library file (in bytes)
-    soff_t      Size;       // asset's size (in bytes)
+    soff_t      Size;       // asset's size in library file (in bytes)
+    uint32_t    Flags;      // storage flags (see AssetFlags)
+    soff_t      UncompressedSize; // size of the unpacked data, if it's compressed
 
     AssetInfo();
 };
@@ -0,0 +1,93 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "core/assetindex.h"
+#include <algorithm>
+#include <regex>
+#include "util/string_utils.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+void AssetIndex::Build(const std::vector<AssetInfo> &assets)
+{
+    Clear();
+    _lookup.reserve(assets.size());
+    _sorted.reserve(assets.size());
+    for (const auto &a : assets)
+    {
+        // emplace does not overwrite existing keys, so first asset wins
+        _lookup.emplace(a.FileName, &a);
+        _sorted.push_back(&a);
+    }
+    std::stable_sort(_sorted.begin(), _sorted.end(),
+        [](const AssetInfo *a1, const AssetInfo *a2)
+        { return a1->FileName.CompareNoCase(a2->FileName) < 0; });
+}
+
+void AssetIndex::Clear()
+{
+    _lookup.clear();
+    _sorted.clear();
+}
+
+const AssetInfo *AssetIndex::Find(const String &name) const
+{
+    auto it = _lookup.find(name);
+    return it != _lookup.end() ? it->second : nullptr;
+}
+
+void AssetIndex::FindAll(std::vector<String> &names, const String &wildcard) const
+{
+    // Only the names that begin with the pattern's literal prefix may match,
+    // and these form a contiguous range in the sorted list
+    const size_t prefix_len = std::min(wildcard.FindChar('*'), wildcard.FindChar('?'));
+    auto first = _sorted.begin(), last = _sorted.end();
+    if (prefix_len > 0)
+    {
+        const String prefix = wildcard.Left(prefix_len);
+        first = std::lower_bound(_sorted.begin(), _sorted.end(), prefix,
+            [](const AssetInfo *a, const String &pref)
+            { return a->FileName.CompareLeftNoCase(pref) < 0; });
+        last = std::upper_bound(first, _sorted.end(), prefix,
+            [](const String &pref, const AssetInfo *a)
+            { return a->FileName.CompareLeftNoCase(pref) > 0; });
+    }
+    if (first == last)
+        return;
+
+    // Pattern without wildcard characters: exact match, case-insensitive
+    if (prefix_len == String::NoIndex)
+    {
+        for (; first != last; ++first)
+        {
+            if ((*first)->FileName.GetLength() == wildcard.GetLength())
+                names.push_back((*first)->FileName);
+        }
+        return;
+    }
+
+    String pattern = StrUtil::WildcardToRegex(wildcard);
+    const std::regex regex(pattern.GetCStr(), std::regex_constants::icase);
+    std::cmatch mr;
+    for (; first != last; ++first)
+    {
+        if (std::regex_match((*first)->FileName.GetCStr(), mr, regex))
+            names.push_back((*first)->FileName);
+    }
+}
+
+} // namespace Common
+} // namespace AGS
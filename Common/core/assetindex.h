@@ -0,0 +1,63 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// AssetIndex - a lookup table over the list of assets of a single library.
+// Provides case-insensitive search of an asset by its name in constant time,
+// and wildcard search narrowed down by the pattern's literal prefix.
+//
+// NOTE: index refers to the elements of the assets list it was built from,
+// so this list must stay unchanged for as long as the index is used.
+//
+//=============================================================================
+#ifndef __AGS_CN_CORE__ASSETINDEX_H
+#define __AGS_CN_CORE__ASSETINDEX_H
+
+#include <unordered_map>
+#include <vector>
+#include "core/asset.h"
+#include "util/string_types.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+class AssetIndex
+{
+public:
+    // Builds index over the given list of assets, discarding previous one
+    void Build(const std::vector<AssetInfo> &assets);
+    // Clears the index
+    void Clear();
+
+    // Tells the number of indexed assets
+    size_t GetCount() const { return _sorted.size(); }
+    // Finds asset by its name, case-insensitive; returns null if no such asset.
+    // If there are several assets with the same name, returns the first one.
+    const AssetInfo *Find(const String &name) const;
+    // Collects names of all the assets matching the given wildcard pattern
+    void FindAll(std::vector<String> &names, const String &wildcard) const;
+
+private:
+    typedef std::unordered_map<String, const AssetInfo*, HashStrNoCase, StrEqNoCase> AssetLookup;
+
+    AssetLookup _lookup;
+    // Assets sorted by their names, case-insensitive
+    std::vector<const AssetInfo*> _sorted;
+};
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_CORE__ASSETINDEX_H
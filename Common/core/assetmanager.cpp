@@ -13,8 +13,9 @@
 //=============================================================================
 #include "core/assetmanager.h"
 #include <algorithm>
-#include <regex>
 #include "util/directory.h"
+#include "util/lzw.h"
+#include "util/mappedfile.h"
 #include "util/multifilelib.h"
 #include "util/path.h"
 #include "util/string_utils.h" // cbuf_to_string_and_free
@@ -173,11 +174,8 @@ bool AssetManager::DoesAssetExist(const String &asset_name, const String &filter
         }
         else
         {
-            for (const auto &a : lib->AssetInfos)
-            {
-                if (a.FileName.CompareNoCase(asset_name) == 0)
-                    return true;
-            }
+            if (lib->Index.Find(asset_name))
+                return true;
         }
     }
     return false;
@@ -186,10 +184,6 @@ bool AssetManager::DoesAssetExist(const String &asset_name, const String &filter
 void AssetManager::FindAssets(std::vector<String> &assets, const String &wildcard,
     const String &filter) const
 {
-    String pattern = StrUtil::WildcardToRegex(wildcard);
-    const std::regex regex(pattern.GetCStr(), std::regex_constants::icase);
-    std::cmatch mr;
-
     for (const auto *lib : _activeLibs)
     {
         if (!lib->TestFilter(filter)) continue; // filter does not match
@@ -204,11 +198,7 @@ void AssetManager::FindAssets(std::vector<String> &assets, const String &wildcar
         }
         else
         {
-            for (const auto &a : lib->AssetInfos)
-            {
-                if (std::regex_match(a.FileName.GetCStr(), mr, regex))
-                    assets.push_back(a.FileName);
-            }
+            lib->Index.FindAll(assets, wildcard);
         }
     }
 
@@ -249,11 +239,15 @@ AssetError AssetManager::RegisterAssetLib(const String &path, AssetLibEx *&out_l
         lib->BaseFileName = Path::GetFilename(lib->BasePath);
         lib->LibFileNames[0] = lib->BaseFileName;
 
-        // Find out real library files in the current filesystem and save them
+        // Find out real library files in the current filesystem and save them;
+        // map them into memory where possible, for the faster asset reading
         for (size_t i = 0; i < lib->LibFileNames.size(); ++i)
         {
             lib->RealLibFiles.push_back(File::FindFileCI(lib->BaseDir, lib->LibFileNames[i]));
+            lib->MappedLibFiles.push_back(lib->RealLibFiles.back().IsEmpty() ?
+                nullptr : MappedFile::Open(lib->RealLibFiles.back()));
         }
+        lib->Index.Build(lib->AssetInfos);
     }
 
     out_lib = lib.get();
@@ -278,19 +272,65 @@ Stream *AssetManager::OpenAsset(const String &asset_name, const String &filter)
     return nullptr;
 }
 
-Stream *AssetManager::OpenAssetFromLib(const AssetLibEx *lib, const String &asset_name) const
+// Read-only memory stream which owns the data buffer
+class OwningMemoryStream : public MemoryStream
 {
-    for (const auto &a : lib->AssetInfos)
+public:
+    OwningMemoryStream(std::vector<uint8_t> &&data, const String &path)
+        : MemoryStream(nullptr, 0u)
+        , _data(std::move(data))
     {
-        if (a.FileName.CompareNoCase(asset_name) == 0)
-        {
-            String libfile = lib->RealLibFiles[a.LibUid];
-            if (libfile.IsEmpty())
-                return nullptr;
-            return File::OpenFile(libfile, a.Offset, a.Offset + a.Size);
-        }
+        _cbuf = _data.data();
+        _buf_sz = _len = _data.size();
+        _path = path;
     }
-    return nullptr;
+
+private:
+    std::vector<uint8_t> _data;
+};
+
+// Unpacks the compressed asset into memory, and opens a stream over it
+static Stream *OpenCompressedAsset(const AssetInfo *a, const String &libfile, const MappedFile *mapped)
+{
+    std::vector<uint8_t> packed;
+    const uint8_t *src = nullptr;
+    if (mapped)
+    {
+        if (a->Offset < 0 || a->Size < 0 ||
+            static_cast<uint64_t>(a->Offset + a->Size) > mapped->GetSize())
+            return nullptr;
+        src = mapped->GetData() + a->Offset;
+    }
+    else
+    {
+        std::unique_ptr<Stream> in(File::OpenFile(libfile, a->Offset, a->Offset + a->Size));
+        if (!in)
+            return nullptr;
+        packed.resize(static_cast<size_t>(a->Size));
+        if (in->Read(packed.data(), packed.size()) != packed.size())
+            return nullptr;
+        src = packed.data();
+    }
+    std::vector<uint8_t> data(static_cast<size_t>(a->UncompressedSize));
+    if (!data.empty() && !lzwexpand(src, static_cast<size_t>(a->Size), data.data(), data.size()))
+        return nullptr;
+    return new OwningMemoryStream(std::move(data), libfile);
+}
+
+Stream *AssetManager::OpenAssetFromLib(const AssetLibEx *lib, const String &asset_name) const
+{
+    const AssetInfo *a = lib->Index.Find(asset_name);
+    if (!a)
+        return nullptr;
+    const auto &mapped = lib->MappedLibFiles[a->LibUid];
+    if ((a->Flags & kAssetFlag_Compressed) != 0)
+        return OpenCompressedAsset(a, lib->RealLibFiles[a->LibUid], mapped.get());
+    if (mapped)
+        return new MappedSectionStream(mapped, a->Offset, a->Offset + a->Size);
+    String libfile = lib->RealLibFiles[a->LibUid];
+    if (libfile.IsEmpty())
+        return nullptr;
+    return File::OpenFile(libfile, a->Offset, a->Offset + a->Size);
 }
 
 Stream *AssetManager::OpenAssetFromDir(const AssetLibEx *lib, const String &file_name) const
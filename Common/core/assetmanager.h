@@ -31,6 +31,7 @@
 
 #include <memory>
 #include "core/asset.h"
+#include "core/assetindex.h"
 #include "util/file.h" // TODO: extract filestream mode constants or introduce generic ones
 
 namespace AGS
@@ -38,6 +39,7 @@ namespace AGS
 namespace Common
 {
 
+class MappedFile;
 class Stream;
 struct MultiFileLib;
 
@@ -113,6 +115,9 @@ private:
     {
         std::vector<String> Filters; // asset filters this library is matching to
         std::vector<String> RealLibFiles; // fixed up library filenames
+        // memory mappings of the library files, null where mapping failed
+        std::vector<std::shared_ptr<MappedFile>> MappedLibFiles;
+        AssetIndex Index; // fast lookup over AssetInfos
 
         bool TestFilter(const String &filter) const;
     };
@@ -177,4 +177,8 @@
     #define DEBUG_SPRITECACHE (0)
 #endif
 
+#if !defined(AGS_PROFILER)
+    #define AGS_PROFILER (1)
+#endif
+
 #endif // __AC_PLATFORM_H
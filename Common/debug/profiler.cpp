@@ -0,0 +1,376 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "debug/profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string.h>
+#include "debug/out.h"
+#include "util/file.h"
+#include "util/stream.h"
+
+namespace AGS
+{
+namespace Common
+{
+namespace Profiler
+{
+
+// Period over which the frame stats are averaged
+const uint64_t StatPeriodUs = 500000u;
+
+struct ZoneAccum
+{
+    const char *Name;
+    uint64_t TimeUs;
+    uint32_t Calls;
+};
+
+struct CounterAccum
+{
+    const char *Name;
+    int64_t PeriodValue;
+    int64_t FrameValue;
+};
+
+struct TraceEvent
+{
+    const char *Name;
+    String   Detail;
+    uint32_t Tid;
+    uint64_t StartUs;
+    uint64_t DurUs; // for zones
+    int64_t  Value; // for counters
+    bool     IsCounter;
+};
+
+static std::atomic<bool> Enabled{ false };
+static const auto Epoch = std::chrono::steady_clock::now();
+static std::atomic<uint32_t> LastTid{ 0u };
+// Innermost open zone on the current thread
+static thread_local ScopedZone *TopZone = nullptr;
+static thread_local bool IsGameThread = false;
+static thread_local uint32_t ThreadId = 0u;
+
+// Frame stats, only accessed on the game thread
+static uint64_t FrameStartUs = 0u;
+static uint64_t PeriodStartUs = 0u;
+static uint32_t PeriodFrames = 0u;
+static std::vector<ZoneAccum> Zones;
+static std::vector<CounterAccum> Counters;
+static FrameStats Stats;
+
+// Trace recording
+static std::atomic<bool> Tracing{ false };
+static uint32_t TraceFramesPending = 0u;
+static uint32_t TraceFramesLeft = 0u;
+static String TraceFile;
+static std::mutex TraceMutex;
+static std::vector<TraceEvent> Trace;
+
+
+static uint64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - Epoch).count();
+}
+
+static uint32_t GetThreadId()
+{
+    if (ThreadId == 0u)
+        ThreadId = ++LastTid;
+    return ThreadId;
+}
+
+// Tells if the two names are same; the same literals are usually merged
+// into a single one by the compiler, but that's not guaranteed
+static inline bool SameName(const char *a, const char *b)
+{
+    return (a == b) || (strcmp(a, b) == 0);
+}
+
+static ZoneAccum &GetZoneAccum(const char *name)
+{
+    for (auto &z : Zones)
+        if (SameName(z.Name, name))
+            return z;
+    Zones.push_back({ name, 0u, 0u });
+    return Zones.back();
+}
+
+static void AddTraceEvent(TraceEvent &&evt)
+{
+    std::lock_guard<std::mutex> lk(TraceMutex);
+    if (Tracing)
+        Trace.push_back(std::move(evt));
+}
+
+void SetEnabled(bool on)
+{
+    Enabled = on;
+}
+
+bool IsEnabled()
+{
+    return Enabled.load(std::memory_order_relaxed);
+}
+
+void Reset()
+{
+    Enabled = false;
+    Tracing = false;
+    TraceFramesPending = 0u;
+    TraceFramesLeft = 0u;
+    {
+        std::lock_guard<std::mutex> lk(TraceMutex);
+        Trace.clear();
+    }
+    FrameStartUs = PeriodStartUs = 0u;
+    PeriodFrames = 0u;
+    Zones.clear();
+    Counters.clear();
+    Stats = FrameStats();
+}
+
+// Calculates the average stats over the finished period
+static void UpdateStats(uint64_t now_us)
+{
+    Stats.FrameCount = PeriodFrames;
+    Stats.FrameMs = (now_us - PeriodStartUs) / 1000.f / PeriodFrames;
+    Stats.Zones.clear();
+    for (const auto &z : Zones)
+    {
+        if (z.Calls == 0u && z.TimeUs == 0u)
+            continue; // not seen during this period
+        ZoneStat stat;
+        stat.Name = z.Name;
+        stat.TimeMs = z.TimeUs / 1000.f / PeriodFrames;
+        stat.Calls = static_cast<float>(z.Calls) / PeriodFrames;
+        Stats.Zones.push_back(stat);
+    }
+    std::stable_sort(Stats.Zones.begin(), Stats.Zones.end(),
+        [](const ZoneStat &a, const ZoneStat &b) { return a.TimeMs > b.TimeMs; });
+    Stats.Counters.clear();
+    for (const auto &c : Counters)
+    {
+        CounterStat stat;
+        stat.Name = c.Name;
+        stat.Value = static_cast<float>(c.PeriodValue) / PeriodFrames;
+        Stats.Counters.push_back(stat);
+    }
+    // Keep the names, so that they stay in the same order in the next period
+    for (auto &z : Zones)
+        z.TimeUs = z.Calls = 0u;
+    for (auto &c : Counters)
+        c.PeriodValue = 0;
+    PeriodFrames = 0u;
+    PeriodStartUs = now_us;
+}
+
+static void WriteTraceEvents(Stream *out, const std::vector<TraceEvent> &trace);
+
+static void FinishTrace()
+{
+    std::vector<TraceEvent> trace;
+    {
+        std::lock_guard<std::mutex> lk(TraceMutex);
+        Tracing = false;
+        std::swap(trace, Trace);
+    }
+    std::unique_ptr<Stream> out(File::CreateFile(TraceFile));
+    if (!out)
+    {
+        Debug::Printf(kDbgMsg_Error, "Profiler: failed to create the trace file %s", TraceFile.GetCStr());
+        return;
+    }
+    WriteTraceEvents(out.get(), trace);
+    Debug::Printf(kDbgMsg_Info, "Profiler: trace of %zu events written to %s", trace.size(), TraceFile.GetCStr());
+}
+
+void NextFrame()
+{
+    if (!IsEnabled())
+        return;
+    IsGameThread = true;
+    const uint64_t now = NowUs();
+
+    // Account the zones which continue into the next frame
+    for (ScopedZone *zone = TopZone; zone; zone = zone->_parent)
+    {
+        GetZoneAccum(zone->_name).TimeUs += now - zone->_statUs;
+        zone->_statUs = now;
+    }
+
+    if (FrameStartUs > 0u)
+    {
+        if (Tracing)
+        {
+            const uint32_t tid = GetThreadId();
+            AddTraceEvent({ "Frame", String(), tid, FrameStartUs, now - FrameStartUs, 0, false });
+            for (const auto &c : Counters)
+                AddTraceEvent({ c.Name, String(), tid, FrameStartUs, 0u, c.FrameValue, true });
+            if (--TraceFramesLeft == 0u)
+                FinishTrace();
+        }
+        PeriodFrames++;
+        if (now - PeriodStartUs >= StatPeriodUs)
+            UpdateStats(now);
+    }
+    else
+    {
+        PeriodStartUs = now;
+    }
+
+    for (auto &c : Counters)
+        c.FrameValue = 0;
+    FrameStartUs = now;
+
+    if (TraceFramesPending > 0u)
+    {
+        std::lock_guard<std::mutex> lk(TraceMutex);
+        Trace.clear();
+        TraceFramesLeft = TraceFramesPending;
+        TraceFramesPending = 0u;
+        Tracing = true;
+    }
+}
+
+const FrameStats &GetStats()
+{
+    return Stats;
+}
+
+void StartTrace(uint32_t frames, const String &filename)
+{
+    if (frames == 0u)
+        return;
+    TraceFramesPending = frames;
+    TraceFile = filename;
+    Enabled = true;
+}
+
+bool IsTracing()
+{
+    return Tracing || (TraceFramesPending > 0u);
+}
+
+static void WriteJsonString(Stream *out, const char *str)
+{
+    out->WriteByte('"');
+    for (const char *p = str; *p; ++p)
+    {
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\')
+        {
+            out->WriteByte('\\');
+            out->WriteByte(c);
+        }
+        else if (c < 0x20)
+        {
+            out->Write(String::FromFormat("\\u%04x", c).GetCStr(), 6);
+        }
+        else
+        {
+            out->WriteByte(c);
+        }
+    }
+    out->WriteByte('"');
+}
+
+static void WriteText(Stream *out, const String &text)
+{
+    out->Write(text.GetCStr(), text.GetLength());
+}
+
+static void WriteTraceEvents(Stream *out, const std::vector<TraceEvent> &trace)
+{
+    WriteText(out, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < trace.size(); ++i)
+    {
+        const auto &evt = trace[i];
+        WriteText(out, "{\"name\":");
+        WriteJsonString(out, evt.Name);
+        if (evt.IsCounter)
+        {
+            WriteText(out, String::FromFormat(",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}}",
+                static_cast<unsigned long long>(evt.StartUs), evt.Tid, static_cast<long long>(evt.Value)));
+        }
+        else
+        {
+            WriteText(out, String::FromFormat(",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u",
+                static_cast<unsigned long long>(evt.StartUs), static_cast<unsigned long long>(evt.DurUs), evt.Tid));
+            if (!evt.Detail.IsEmpty())
+            {
+                WriteText(out, ",\"args\":{\"detail\":");
+                WriteJsonString(out, evt.Detail.GetCStr());
+                out->WriteByte('}');
+            }
+            out->WriteByte('}');
+        }
+        WriteText(out, (i + 1 < trace.size()) ? ",\n" : "\n");
+    }
+    WriteText(out, "],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+void WriteTrace(Stream *out)
+{
+    std::lock_guard<std::mutex> lk(TraceMutex);
+    WriteTraceEvents(out, Trace);
+}
+
+void AddCount(const char *name, int64_t value)
+{
+    if (!IsGameThread)
+        return; // only the game thread's counters are supported
+    for (auto &c : Counters)
+    {
+        if (SameName(c.Name, name))
+        {
+            c.PeriodValue += value;
+            c.FrameValue += value;
+            return;
+        }
+    }
+    Counters.push_back({ name, value, value });
+}
+
+void ScopedZone::Begin(const char *name, const char *detail)
+{
+    _name = name;
+    if (detail && Tracing)
+        _detail = detail;
+    _startUs = _statUs = NowUs();
+    _parent = TopZone;
+    TopZone = this;
+}
+
+void ScopedZone::End()
+{
+    TopZone = _parent;
+    const uint64_t now = NowUs();
+    if (IsGameThread)
+    {
+        ZoneAccum &acc = GetZoneAccum(_name);
+        acc.TimeUs += now - _statUs;
+        acc.Calls++;
+    }
+    if (Tracing)
+        AddTraceEvent({ _name, std::move(_detail), GetThreadId(), _startUs, now - _startUs, 0, false });
+}
+
+} // namespace Profiler
+} // namespace Common
+} // namespace AGS
@@ -0,0 +1,153 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Frame profiler measures the time spent in the named zones of code,
+// and counts events, per game frame.
+//
+// Zones are marked with AGS_PROFILE_ZONE at the start of a scope, and last
+// until the end of that scope. Counters are increased with AGS_PROFILE_COUNT.
+// Both are removed from the program when it's built with AGS_PROFILER=0, and
+// only cost a test of a flag when the profiler is not enabled at runtime.
+// Zone and counter names must be string literals (or otherwise stay valid
+// until the program's end).
+//
+// The frame statistics are averaged over a short period and include only
+// the zones on the thread which calls NextFrame (the game thread). Zone times
+// are inclusive, i.e. contain the time of the nested zones.
+// Optionally the profiler records the zones from all threads for the given
+// number of frames, and writes them in the Chrome's trace event format,
+// which may be opened by chrome://tracing or https://ui.perfetto.dev.
+//
+//=============================================================================
+#ifndef __AGS_CN_DEBUG__PROFILER_H
+#define __AGS_CN_DEBUG__PROFILER_H
+
+#include <vector>
+#include "core/platform.h"
+#include "core/types.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+class Stream;
+
+namespace Profiler
+{
+    // Average zone time per frame
+    struct ZoneStat
+    {
+        const char *Name = nullptr;
+        float TimeMs = 0.f;
+        float Calls = 0.f;
+    };
+
+    // Average counter value per frame
+    struct CounterStat
+    {
+        const char *Name = nullptr;
+        float Value = 0.f;
+    };
+
+    struct FrameStats
+    {
+        // Number of frames the stats were averaged over
+        uint32_t FrameCount = 0u;
+        float FrameMs = 0.f;
+        // Zones in the order of decreasing time
+        std::vector<ZoneStat> Zones;
+        // Counters in the order of the first use
+        std::vector<CounterStat> Counters;
+    };
+
+    // Enables or disables the profiler; when disabled, zones are not measured
+    void SetEnabled(bool on);
+    // Tells if the profiler is enabled
+    bool IsEnabled();
+    // Forgets all measurements and trace, disables the profiler
+    void Reset();
+
+    // Ends the current frame and begins the next one. The thread which calls
+    // this is considered the game thread.
+    void NextFrame();
+    // Gets the frame statistics, averaged over the last completed period
+    const FrameStats &GetStats();
+
+    // Starts recording the trace for the given number of frames, starting
+    // with the next frame; after that writes it into the file.
+    // This enables the profiler too.
+    void StartTrace(uint32_t frames, const String &filename);
+    // Tells if the trace is being recorded
+    bool IsTracing();
+    // Writes the recorded trace into the stream, in Chrome's trace event format
+    void WriteTrace(Stream *out);
+
+    // Adds to the named counter of the current frame
+    void AddCount(const char *name, int64_t value);
+
+    // ScopedZone measures the time from its construction till destruction
+    class ScopedZone
+    {
+    public:
+        // Detail is an optional text attached to this zone's trace event,
+        // such as the name of a script function; it's copied when needed
+        ScopedZone(const char *name, const char *detail = nullptr)
+        {
+            if (IsEnabled())
+                Begin(name, detail);
+        }
+        ~ScopedZone()
+        {
+            if (_name)
+                End();
+        }
+
+    private:
+        friend void NextFrame();
+
+        void Begin(const char *name, const char *detail);
+        void End();
+
+        const char *_name = nullptr;
+        String      _detail;
+        uint64_t    _startUs = 0u; // time of the zone start
+        uint64_t    _statUs = 0u; // time since which to add to the frame stats
+        ScopedZone *_parent = nullptr; // enclosing zone on this thread
+    };
+} // namespace Profiler
+
+} // namespace Common
+} // namespace AGS
+
+#if AGS_PROFILER
+#define AGS_PROFILE_CONCAT2(a, b) a##b
+#define AGS_PROFILE_CONCAT(a, b) AGS_PROFILE_CONCAT2(a, b)
+// Measures the time until the end of the current scope
+#define AGS_PROFILE_ZONE(name) \
+    AGS::Common::Profiler::ScopedZone AGS_PROFILE_CONCAT(ags_profile_zone_, __LINE__)(name)
+// Same as AGS_PROFILE_ZONE, with a detail text for the trace
+#define AGS_PROFILE_ZONE_DETAIL(name, detail) \
+    AGS::Common::Profiler::ScopedZone AGS_PROFILE_CONCAT(ags_profile_zone_, __LINE__)(name, detail)
+// Adds the value to the named counter
+#define AGS_PROFILE_COUNT(name, value) \
+    do { if (AGS::Common::Profiler::IsEnabled()) AGS::Common::Profiler::AddCount(name, value); } while (0)
+#else
+#define AGS_PROFILE_ZONE(name)
+#define AGS_PROFILE_ZONE_DETAIL(name, detail)
+#define AGS_PROFILE_COUNT(name, value)
+#endif
+
+#endif // __AGS_CN_DEBUG__PROFILER_H
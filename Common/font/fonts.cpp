@@ -12,7 +12,9 @@
 //
 //=============================================================================
 #include <algorithm>
+#include <cassert>
 #include <cstdio>
+#include <memory>
 #include <vector>
 #include <alfont.h>
 #include "ac/common.h" // set_our_eip
@@ -22,6 +24,8 @@
 #include "font/wfnfontrenderer.h"
 #include "gfx/bitmap.h"
 #include "gui/guidefines.h" // MAXLINE
+#include "util/resourcecache.h"
+#include "util/string_types.h"
 #include "util/string_utils.h"
 #include "util/utf8.h"
 
@@ -109,6 +113,8 @@ bool is_font_loaded(size_t fontNumber)
 static void font_post_init(size_t fontNumber)
 {
     Font &font = fonts[fontNumber];
+    // Text measurements made with the previous font data are no longer valid
+    clear_text_layout_cache();
     // If no font height property was provided, then try several methods,
     // depending on which interface is available
     if ((font.Metrics.Height == 0) && font.Renderer)
@@ -296,6 +302,7 @@ void set_font_outline(size_t font_number, int outline_type,
     fonts[font_number].Info.Outline = outline_type;
     fonts[font_number].Info.AutoOutlineStyle = style;
     fonts[font_number].Info.AutoOutlineThickness = thickness;
+    clear_text_layout_cache();
 }
 
 bool is_font_antialiased(size_t font_number)
@@ -370,6 +377,71 @@ int get_text_lines_surf_height(size_t fontNumber, size_t numlines)
 
 namespace AGS { namespace Common { SplitLines Lines; } }
 
+// Text layout cache key: the text, and the parameters it was split with
+struct TextLayoutKey
+{
+    int Font = 0;
+    int Width = 0;
+    size_t MaxLines = 0u;
+    size_t Hash = 0u; // precalculated text hash
+    String Text;
+
+    TextLayoutKey() = default;
+    TextLayoutKey(int font, int width, size_t max_lines, const String &text)
+        : Font(font), Width(width), MaxLines(max_lines)
+        , Hash(FNV::Hash(text.GetCStr(), text.GetLength())), Text(text) {}
+
+    bool operator ==(const TextLayoutKey &other) const
+    {
+        return Hash == other.Hash && Font == other.Font && Width == other.Width &&
+            MaxLines == other.MaxLines && Text == other.Text;
+    }
+};
+
+struct TextLayoutKeyHash
+{
+    size_t operator ()(const TextLayoutKey &key) const
+    {
+        return key.Hash ^ (static_cast<size_t>(key.Font) << 24) ^ static_cast<size_t>(key.Width);
+    }
+};
+
+// Result of the text splitting: the lines and their outlined widths
+struct TextLayout
+{
+    std::vector<String> Lines;
+    std::vector<int> Widths;
+    size_t TextLength = 0u; // length of the source text, for the size calculation
+};
+
+// Text layout cache, stores the results of the most recent split_lines calls,
+// so that the same texts are not measured again each time they are drawn.
+class TextLayoutCache final :
+    public ResourceCache<TextLayoutKey, std::shared_ptr<TextLayout>, size_t, TextLayoutKeyHash>
+{
+public:
+    TextLayoutCache() : ResourceCache(256 * 1024) {}
+
+private:
+    size_t CalcSize(const std::shared_ptr<TextLayout> &item) override
+    {
+        assert(item);
+        if (!item)
+            return 0u;
+        size_t size = sizeof(TextLayout) + sizeof(TextLayoutKey) + item->TextLength;
+        for (const auto &line : item->Lines)
+            size += sizeof(String) + sizeof(int) + line.GetLength();
+        return size;
+    }
+};
+
+static TextLayoutCache TextCache;
+
+void clear_text_layout_cache()
+{
+    TextCache.Clear();
+}
+
 // Replaces AGS-specific linebreak tags with common '\n'
 static void unescape_script_string(const char *cstr, std::string &out)
 {
@@ -405,7 +477,7 @@ static void unescape_script_string(const char *cstr, std::string &out)
 }
 
 // Break up the text into lines
-size_t split_lines(const char *todis, SplitLines &lines, int wii, int fonnt, size_t max_lines) {
+static size_t split_lines_impl(const char *todis, SplitLines &lines, int wii, int fonnt, size_t max_lines) {
     // NOTE: following hack accomodates for the legacy math mistake in split_lines.
     // It's hard to tell how cruicial it is for the game looks, so research may be needed.
     // TODO: IMHO this should rely not on game format, but script API level, because it
@@ -495,6 +567,38 @@ size_t split_lines(const char *todis, SplitLines &lines, int wii, int fonnt, siz
             last_whitespace = nullptr;
         }
     }
+    // Measure the final lines, for the callers' reference
+    for (size_t i = 0; i < lines.Count(); ++i)
+        lines.SetWidth(i, get_text_width_outlined(lines[i].GetCStr(), fonnt));
+    return lines.Count();
+}
+
+size_t split_lines(const char *todis, SplitLines &lines, int wii, int fonnt, size_t max_lines) {
+    // Look up for the previous results first; the text is wrapped
+    // without making a copy, which is only done when storing a new item
+    TextLayoutKey key(fonnt, wii, max_lines, String::Wrapper(todis));
+    auto layout = TextCache.Get(key);
+    if (layout)
+    {
+        lines.Reset();
+        for (size_t i = 0; i < layout->Lines.size(); ++i)
+            lines.Add(layout->Lines[i].GetCStr(), layout->Widths[i]);
+        return lines.Count();
+    }
+
+    split_lines_impl(todis, lines, wii, fonnt, max_lines);
+
+    layout = std::make_shared<TextLayout>();
+    layout->Lines.resize(lines.Count());
+    layout->Widths.resize(lines.Count());
+    for (size_t i = 0; i < lines.Count(); ++i)
+    {
+        layout->Lines[i].SetString(lines[i].GetCStr()); // don't share line pool buffers
+        layout->Widths[i] = lines.GetWidth(i);
+    }
+    layout->TextLength = key.Text.GetLength();
+    key.Text = String(todis); // make an owned copy of the text
+    TextCache.Put(key, layout);
     return lines.Count();
 }
 
@@ -606,6 +710,7 @@ void alloc_font_outline_buffers(size_t font_number,
 
 void adjust_fonts_for_render_mode(bool aa_mode)
 {
+    clear_text_layout_cache();
     for (size_t i = 0; i < fonts.size(); ++i)
     {
         if (fonts[i].RendererInt)
@@ -618,6 +723,8 @@ void wfreefont(size_t fontNumber)
   if (fontNumber >= fonts.size())
     return;
 
+  clear_text_layout_cache();
+
   fonts[fontNumber].TextStencilSub.Destroy();
   fonts[fontNumber].OutlineStencilSub.Destroy();
   fonts[fontNumber].TextStencil.Destroy();
@@ -630,6 +737,7 @@ void wfreefont(size_t fontNumber)
 
 void free_all_fonts()
 {
+    clear_text_layout_cache();
     for (size_t i = 0; i < fonts.size(); ++i)
     {
         if (fonts[i].Renderer != nullptr)
@@ -119,11 +119,19 @@ public:
     inline size_t Count() const { return _count; }
     inline const Common::String &operator[](size_t i) const { return _pool[i]; }
     inline Common::String &operator[](size_t i) { return _pool[i]; }
-    inline void Clear() { _pool.clear(); _count = 0; }
+    // Gets the outlined width of the line, as measured by split_lines
+    inline int GetWidth(size_t i) const { return _widths[i]; }
+    inline void SetWidth(size_t i, int width) { _widths[i] = width; }
+    inline void Clear() { _pool.clear(); _widths.clear(); _count = 0; }
     inline void Reset() { _count = 0; }
-    inline void Add(const char *cstr)
+    inline void Add(const char *cstr, int width = 0)
     {
-        if (_pool.size() == _count) _pool.resize(_count + 1);
+        if (_pool.size() == _count)
+        {
+            _pool.resize(_count + 1);
+            _widths.resize(_count + 1);
+        }
+        _widths[_count] = width;
         _pool[_count++].SetString(cstr);
     }
 
@@ -132,12 +140,17 @@ public:
 
 private:
     std::vector<Common::String> _pool;
+    std::vector<int> _widths;
     size_t _count; // actual number of lines in use
 };
 
 // Break up the text into lines restricted by the given width;
-// returns number of lines, or 0 if text cannot be split well to fit in this width
+// returns number of lines, or 0 if text cannot be split well to fit in this width.
+// The results are cached, so repeated calls with the same text and font are cheap.
 size_t split_lines(const char *texx, SplitLines &lines, int width, int fontNumber, size_t max_lines = -1);
+// Disposes all the cached text layouts; must be called whenever anything
+// that affects text measurement changes (fonts, text encoding, etc)
+void clear_text_layout_cache();
 
 namespace AGS { namespace Common { extern SplitLines Lines; } }
 
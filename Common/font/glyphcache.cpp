@@ -0,0 +1,195 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "font/glyphcache.h"
+#include <algorithm>
+#include <cassert>
+#include <allegro.h>
+
+// The blenders below reproduce the alfont's ones, which it sets up for
+// drawing the anti-aliased glyphs: x is the text color, y is the
+// destination pixel, and n is the glyph's coverage value.
+
+struct BlendGlyph15
+{
+    uint32_t operator()(uint32_t x, uint32_t y, uint32_t n) const
+    {
+        if ((y & 0xFFFF) == 0x7C1F)
+            return x;
+        if (n)
+            n = (n + 1) / 8;
+        x = ((x & 0xFFFF) | (x << 16)) & 0x3E07C1F;
+        y = ((y & 0xFFFF) | (y << 16)) & 0x3E07C1F;
+        uint32_t result = ((x - y) * n / 32 + y) & 0x3E07C1F;
+        return ((result & 0xFFFF) | (result >> 16));
+    }
+};
+
+struct BlendGlyph16
+{
+    uint32_t operator()(uint32_t x, uint32_t y, uint32_t n) const
+    {
+        if ((y & 0xFFFF) == 0xF81F)
+            return x;
+        if (n)
+            n = (n + 1) / 8;
+        x = ((x & 0xFFFF) | (x << 16)) & 0x7E0F81F;
+        y = ((y & 0xFFFF) | (y << 16)) & 0x7E0F81F;
+        uint32_t result = ((x - y) * n / 32 + y) & 0x7E0F81F;
+        return ((result & 0xFFFF) | (result >> 16));
+    }
+};
+
+struct BlendGlyph32
+{
+    uint32_t operator()(uint32_t x, uint32_t y, uint32_t n) const
+    {
+        const uint32_t alpha = (y & 0xFF000000);
+        if ((y & 0xFFFFFF) == 0xFF00FF)
+            return ((x & 0xFFFFFF) | (n << 24));
+        if (n)
+            n++;
+        uint32_t res = ((x & 0xFF00FF) - (y & 0xFF00FF)) * n / 256 + y;
+        y &= 0xFF00;
+        x &= 0xFF00;
+        uint32_t g = (x - y) * n / 256 + y;
+        res &= 0xFF00FF;
+        g &= 0xFF00;
+        return res | g | alpha;
+    }
+};
+
+
+GlyphCache::GlyphCache(GlyphLoader loader)
+    : _loader(loader)
+{
+}
+
+/* static */ bool GlyphCache::CanDraw(BITMAP *dst, bool antialias)
+{
+    // NOTE: all the bitmaps in our allegro are memory bitmaps,
+    // so their lines may be accessed directly
+    switch (bitmap_color_depth(dst))
+    {
+    case 8: return !antialias;
+    case 15:
+    case 16:
+    case 32: return true;
+    default: return false;
+    }
+}
+
+const Glyph &GlyphCache::GetGlyph(int character)
+{
+    if ((character >= 0) && (character < LowCharCount))
+    {
+        if (_lowGlyphs.empty())
+        {
+            _lowGlyphs.resize(LowCharCount);
+            _lowLoaded.resize(LowCharCount);
+        }
+        if (!_lowLoaded[character])
+        {
+            if (_loader)
+                _loader(character, _lowGlyphs[character]);
+            _lowLoaded[character] = true;
+        }
+        return _lowGlyphs[character];
+    }
+
+    auto it = _glyphs.find(character);
+    if (it != _glyphs.end())
+        return it->second;
+    Glyph glyph;
+    if (_loader)
+        _loader(character, glyph);
+    return _glyphs.emplace(character, std::move(glyph)).first->second;
+}
+
+int GlyphCache::GetTextWidth(const char *text)
+{
+    int width = 0;
+    for (int ch = ugetxc(&text); ch != 0; ch = ugetxc(&text))
+    {
+        const Glyph &glyph = GetGlyph(ch);
+        if (glyph.Valid)
+            width += glyph.AdvanceX;
+    }
+    return width;
+}
+
+template <typename TPixel, typename TPutAA>
+void GlyphCache::DrawTextImpl(const char *text, BITMAP *dst, int x, int y, int color, bool antialias, TPutAA put_aa)
+{
+    int cl = 0, ct = 0, cr = dst->w, cb = dst->h;
+    if (dst->clip)
+    {
+        cl = std::max(cl, dst->cl); ct = std::max(ct, dst->ct);
+        cr = std::min(cr, dst->cr); cb = std::min(cb, dst->cb);
+    }
+    const TPixel solid = static_cast<TPixel>(color);
+
+    for (int ch = ugetxc(&text); ch != 0; ch = ugetxc(&text))
+    {
+        // if left side of char farther than right side of clipping, we are done
+        if (x > dst->cr)
+            break;
+        const Glyph &glyph = GetGlyph(ch);
+        if (!glyph.Valid)
+            continue;
+
+        const GlyphImage &img = antialias ? glyph.AA : glyph.Mono;
+        const int gx = x + img.Left, gy = y + img.Top;
+        const int x1 = std::max(gx, cl), x2 = std::min(gx + img.Width, cr);
+        const int y1 = std::max(gy, ct), y2 = std::min(gy + img.Height, cb);
+        for (int py = y1; py < y2; ++py)
+        {
+            const uint8_t *src = &img.Pixels[(py - gy) * img.Width + (x1 - gx)];
+            TPixel *px = reinterpret_cast<TPixel*>(dst->line[py]) + x1;
+            for (const uint8_t *src_end = src + (x2 - x1); src < src_end; ++src, ++px)
+            {
+                const uint8_t a = *src;
+                if (a == 0)
+                    continue;
+                if (!antialias || a == 255)
+                    *px = solid;
+                else
+                    *px = static_cast<TPixel>(put_aa(color, *px, a));
+            }
+        }
+
+        x += glyph.AdvanceX;
+        y += glyph.AdvanceY;
+    }
+}
+
+void GlyphCache::DrawText(const char *text, BITMAP *dst, int x, int y, int color, bool antialias)
+{
+    switch (bitmap_color_depth(dst))
+    {
+    case 8: DrawTextImpl<uint8_t>(text, dst, x, y, color, false, BlendGlyph32()); break;
+    case 15: DrawTextImpl<uint16_t>(text, dst, x, y, color, antialias, BlendGlyph15()); break;
+    case 16: DrawTextImpl<uint16_t>(text, dst, x, y, color, antialias, BlendGlyph16()); break;
+    case 32: DrawTextImpl<uint32_t>(text, dst, x, y, color, antialias, BlendGlyph32()); break;
+    default: assert(false); break;
+    }
+    // alfont always leaves the solid drawing mode after the text output
+    solid_mode();
+}
+
+void GlyphCache::Clear()
+{
+    _lowGlyphs.clear();
+    _lowLoaded.clear();
+    _glyphs.clear();
+}
@@ -0,0 +1,89 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// GlyphCache keeps pre-rendered glyphs of a single font of a certain size,
+// and draws texts by copying these glyph images directly onto the bitmap.
+// Glyphs are requested from the provided loader on the first use.
+//
+// The drawing follows the rules of the alfont's text output in transparent
+// mode: monochrome glyphs are drawn solid, and anti-aliased glyphs are
+// blended using the glyph's coverage as an alpha, keeping the destination's
+// alpha channel, and replacing the destination's mask color.
+//
+//=============================================================================
+#ifndef __AGS_CN_FONT__GLYPHCACHE_H
+#define __AGS_CN_FONT__GLYPHCACHE_H
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "core/types.h"
+
+struct BITMAP;
+
+// Glyph image, one byte per pixel, 0 means transparent
+struct GlyphImage
+{
+    int Left = 0; // offset from the pen position
+    int Top = 0; // offset from the text's top
+    int Width = 0;
+    int Height = 0;
+    std::vector<uint8_t> Pixels;
+};
+
+struct Glyph
+{
+    // Whether the font has this glyph at all
+    bool Valid = false;
+    // Pen advance, including any extra character spacing
+    int AdvanceX = 0;
+    int AdvanceY = 0;
+    GlyphImage Mono;
+    GlyphImage AA;
+};
+
+class GlyphCache
+{
+public:
+    // Loader fills in the glyph of the given character
+    typedef std::function<void(int character, Glyph &glyph)> GlyphLoader;
+
+    GlyphCache() = default;
+    GlyphCache(GlyphLoader loader);
+
+    // Tells if the text may be drawn onto this bitmap using the cache
+    static bool CanDraw(BITMAP *dst, bool antialias);
+
+    // Gets the glyph of the given character, loads it on the first request
+    const Glyph &GetGlyph(int character);
+    // Calculates the width of the text, as a sum of glyph advances
+    int GetTextWidth(const char *text);
+    // Draws the text, using the current allegro's text encoding
+    void DrawText(const char *text, BITMAP *dst, int x, int y, int color, bool antialias);
+    // Disposes all the cached glyphs
+    void Clear();
+
+private:
+    template <typename TPixel, typename TPutAA>
+    void DrawTextImpl(const char *text, BITMAP *dst, int x, int y, int color, bool antialias, TPutAA put_aa);
+
+    GlyphLoader _loader;
+    // Low characters are most common in texts, and are looked up in a plain array
+    static const int LowCharCount = 256;
+    std::vector<Glyph> _lowGlyphs;
+    std::vector<bool> _lowLoaded;
+    std::unordered_map<int, Glyph> _glyphs;
+};
+
+#endif // __AGS_CN_FONT__GLYPHCACHE_H
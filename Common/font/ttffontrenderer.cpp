@@ -39,7 +39,7 @@ void TTFFontRenderer::EnsureTextValidForFont(char * /*text*/, int /*fontNumber*/
 
 int TTFFontRenderer::GetTextWidth(const char *text, int fontNumber)
 {
-  return alfont_text_length(_fontData[fontNumber].AlFont, text);
+  return _fontData[fontNumber].Glyphs.GetTextWidth(text);
 }
 
 int TTFFontRenderer::GetTextHeight(const char * /*text*/, int fontNumber)
@@ -53,10 +53,14 @@ void TTFFontRenderer::RenderText(const char *text, int fontNumber, BITMAP *desti
     return;
 
   // Y - 1 because it seems to get drawn down a bit
-  if ((ShouldAntiAliasText()) && (bitmap_color_depth(destination) > 8))
-    alfont_textout_aa(destination, _fontData[fontNumber].AlFont, text, x, y - 1, colour);
+  FontData &font = _fontData[fontNumber];
+  const bool aa = (ShouldAntiAliasText()) && (bitmap_color_depth(destination) > 8);
+  if (GlyphCache::CanDraw(destination, aa))
+    font.Glyphs.DrawText(text, destination, x, y - 1, colour, aa);
+  else if (aa)
+    alfont_textout_aa(destination, font.AlFont, text, x, y - 1, colour);
   else
-    alfont_textout(destination, _fontData[fontNumber].AlFont, text, x, y - 1, colour);
+    alfont_textout(destination, font.AlFont, text, x, y - 1, colour);
 }
 
 bool TTFFontRenderer::LoadFromDisk(int fontNumber, int fontSize)
@@ -100,6 +104,37 @@ static ALFONT_FONT *LoadTTF(const String &filename, int fontSize, int alfont_fla
     return alfptr;
 }
 
+// Copies the glyph image received from alfont
+static void CopyGlyphImage(const ALFONT_GLYPH &src, GlyphImage &img)
+{
+    if (!src.bmp)
+        return;
+    img.Left = src.left;
+    img.Top = src.top;
+    img.Width = src.width;
+    img.Height = src.height;
+    img.Pixels.assign(src.bmp, src.bmp + src.width * src.height);
+}
+
+// Creates the glyph cache which loads glyphs from the given ALFONT
+static GlyphCache CreateGlyphCache(ALFONT_FONT *alfptr)
+{
+    return GlyphCache([alfptr](int character, Glyph &glyph)
+    {
+        int adv_x, adv_y;
+        ALFONT_GLYPH mono, aa;
+        if (!alfont_get_char_glyph(alfptr, character, &adv_x, &adv_y, &mono, &aa))
+            return;
+        // advance the same way as alfont does when drawing
+        const int spacing = alfont_get_char_extra_spacing(alfptr);
+        glyph.Valid = true;
+        glyph.AdvanceX = adv_x ? adv_x + spacing : 0;
+        glyph.AdvanceY = adv_y ? adv_y + spacing : 0;
+        CopyGlyphImage(mono, glyph.Mono);
+        CopyGlyphImage(aa, glyph.AA);
+    });
+}
+
 // Fill the FontMetrics struct from the given ALFONT
 static void FillMetrics(ALFONT_FONT *alfptr, FontMetrics *metrics)
 {
@@ -126,6 +161,7 @@ bool TTFFontRenderer::LoadFromDiskEx(int fontNumber, int fontSize,
 
     _fontData[fontNumber].AlFont = alfptr;
     _fontData[fontNumber].Params = f_params;
+    _fontData[fontNumber].Glyphs = CreateGlyphCache(alfptr);
     if (metrics)
         FillMetrics(alfptr, metrics);
     return true;
@@ -154,6 +190,7 @@ void TTFFontRenderer::AdjustFontForAntiAlias(int fontNumber, bool /*aa_mode*/)
     const FontRenderParams &params = _fontData[fontNumber].Params;
     int old_height = alfont_get_font_height(alfptr);
     alfont_set_font_size_ex(alfptr, old_height, GetAlfontFlags(params.LoadMode));
+    _fontData[fontNumber].Glyphs.Clear();
   }
 }
 
@@ -16,6 +16,7 @@
 
 #include <map>
 #include "font/agsfontrenderer.h"
+#include "font/glyphcache.h"
 #include "util/string.h"
 
 struct ALFONT_FONT;
@@ -60,6 +61,8 @@ private:
     {
         ALFONT_FONT     *AlFont;
         FontRenderParams Params;
+        // Copies of the font's glyphs, for the faster text output
+        GlyphCache       Glyphs;
     };
     std::map<int, FontData> _fontData;
 };
@@ -475,11 +475,13 @@ HError ReadRoomBlock(RoomStruct *room, Stream *in, RoomFileBlock block, const St
 class RoomBlockReader : public DataExtReader
 {
 public:
-    RoomBlockReader(RoomStruct *room, RoomFileVersion data_ver, Stream *in)
+    RoomBlockReader(RoomStruct *room, RoomFileVersion data_ver, Stream *in,
+            std::vector<uint8_t> *script_data = nullptr)
         : DataExtReader(in,
             kDataExt_NumID8 | ((data_ver < kRoomVersion_350) ? kDataExt_File32 : kDataExt_File64))
         , _room(room)
         , _dataVer(data_ver)
+        , _scriptData(script_data)
     {}
 
     // Helper function that extracts legacy room script
@@ -502,11 +504,19 @@ private:
         soff_t block_len, bool &read_next) override
     {
         read_next = true;
+        if ((block_id == kRoomFblk_CompScript3) && _scriptData)
+        { // keep serialized script for the caller to create later
+            _scriptData->resize(static_cast<size_t>(block_len));
+            if (block_len > 0)
+                _in->Read(_scriptData->data(), _scriptData->size());
+            return HError::None();
+        }
         return ReadRoomBlock(_room, _in, (RoomFileBlock)block_id, ext_id, block_len, _dataVer);
     }
 
     RoomStruct *_room {};
     RoomFileVersion _dataVer {};
+    std::vector<uint8_t> *_scriptData {};
 };
 
 
@@ -518,6 +528,16 @@ HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_v
     return err ? HRoomFileError::None() : new RoomFileError(kRoomFileErr_BlockListFailed, err);
 }
 
+HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_ver,
+    std::vector<uint8_t> &script_data)
+{
+    room->DataVersion = data_ver;
+    script_data.clear();
+    RoomBlockReader reader(room, data_ver, in, &script_data);
+    HError err = reader.Read();
+    return err ? HRoomFileError::None() : new RoomFileError(kRoomFileErr_BlockListFailed, err);
+}
+
 HRoomFileError UpdateRoomData(RoomStruct *room, RoomFileVersion data_ver, bool game_is_hires, const std::vector<SpriteInfo> &sprinfos)
 {
     if (data_ver < kRoomVersion_200_final)
@@ -106,6 +106,11 @@ HRoomFileError OpenRoomFile(const String &filename, RoomDataSource &src);
 HRoomFileError OpenRoomFileFromAsset(const String &filename, RoomDataSource &src);
 // Reads room data
 HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_ver);
+// Reads room data, except that the compiled script is not created, but its
+// serialized data is stored in script_data, for ccScript::CreateFromStream.
+// This lets read rooms on a thread other than the one which runs the scripts.
+HRoomFileError ReadRoomData(RoomStruct *room, Stream *in, RoomFileVersion data_ver,
+    std::vector<uint8_t> &script_data);
 // Applies necessary updates, conversions and fixups to the loaded data
 // making it compatible with current engine
 HRoomFileError UpdateRoomData(RoomStruct *room, RoomFileVersion data_ver, bool game_is_hires, const std::vector<SpriteInfo> &sprinfos);
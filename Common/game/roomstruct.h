@@ -273,8 +273,13 @@ class RoomStruct
 {
 public:
     RoomStruct();
+    RoomStruct(const RoomStruct &) = default;
+    RoomStruct(RoomStruct &&) = default;
     ~RoomStruct();
 
+    RoomStruct &operator=(const RoomStruct &) = default;
+    RoomStruct &operator=(RoomStruct &&) = default;
+
     // Gets if room should adjust its base size depending on game's resolution
     inline bool IsRelativeRes() const { return _resolution != kRoomRealRes; }
     // Gets if room belongs to high resolution
@@ -282,15 +282,26 @@ void Bitmap::AAStretchBlt(Bitmap *src, const Rect &src_rc, const Rect &dst_rc, B
 void Bitmap::TransBlendBlt(Bitmap *src, int dst_x, int dst_y)
 {
 	BITMAP *al_src_bmp = src->_alBitmap;
+	if (_blendBltHandler && _blendBltHandler(_alBitmap, al_src_bmp, dst_x, dst_y, false, 0))
+		return;
 	draw_trans_sprite(_alBitmap, al_src_bmp, dst_x, dst_y);
 }
 
 void Bitmap::LitBlendBlt(Bitmap *src, int dst_x, int dst_y, int light_amount)
 {
 	BITMAP *al_src_bmp = src->_alBitmap;
+	if (_blendBltHandler && _blendBltHandler(_alBitmap, al_src_bmp, dst_x, dst_y, true, light_amount))
+		return;
 	draw_lit_sprite(_alBitmap, al_src_bmp, dst_x, dst_y, light_amount);
 }
 
+Bitmap::PfnBlendBlt Bitmap::_blendBltHandler = nullptr;
+
+void Bitmap::SetBlendBltHandler(PfnBlendBlt handler)
+{
+	_blendBltHandler = handler;
+}
+
 void Bitmap::FlipBlt(Bitmap *src, int dst_x, int dst_y, GraphicFlip flip)
 {	
 	BITMAP *al_src_bmp = src->_alBitmap;
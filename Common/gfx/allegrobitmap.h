@@ -190,6 +190,11 @@ public:
     void    TransBlendBlt(Bitmap *src, int dst_x, int dst_y);
     // Draw bitmap using lighting preset
     void    LitBlendBlt(Bitmap *src, int dst_x, int dst_y, int light_amount);
+    // Handler which may perform TransBlendBlt and LitBlendBlt instead of allegro,
+    // for example using an optimized version of the current blender;
+    // returns false if it could not do the job, in which case allegro is used
+    typedef bool (*PfnBlendBlt)(BITMAP *dst, BITMAP *src, int dst_x, int dst_y, bool lit, int light_amount);
+    static void SetBlendBltHandler(PfnBlendBlt handler);
     // TODO: generic "draw transformed" function? What about mask option?
     void    FlipBlt(Bitmap *src, int dst_x, int dst_y, GraphicFlip flip);
     void    RotateBlt(Bitmap *src, int dst_x, int dst_y, fixed_t angle);
@@ -242,6 +247,8 @@ public:
 private:
 	BITMAP			*_alBitmap;
 	bool			_isDataOwner;
+
+    static PfnBlendBlt _blendBltHandler;
 };
 
 
@@ -786,6 +786,8 @@ void MarkAllGUIForUpdate(bool redraw, bool reset_over_ctrl)
 
 void MarkForTranslationUpdate()
 {
+    // translated texts (and possibly text encoding) have changed
+    clear_text_layout_cache();
     for (auto &btn : guibuts)
     {
         if (btn.IsTranslated())
@@ -805,6 +807,7 @@ void MarkForTranslationUpdate()
 
 void MarkForFontUpdate(int font)
 {
+    clear_text_layout_cache();
     const bool update_all = (font < 0);
     for (auto &btn : guibuts)
     {
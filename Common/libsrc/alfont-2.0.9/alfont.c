@@ -4967,6 +4967,45 @@ int alfont_get_char_extra_spacing(ALFONT_FONT *f) {
 }
 
 
+int alfont_get_char_glyph(ALFONT_FONT *f, int character, int *advancex, int *advancey,
+  ALFONT_GLYPH *mono, ALFONT_GLYPH *aa) {
+  int glyph_index;
+  struct _ALFONT_CACHED_GLYPH *cglyph;
+
+  /* get the character out of the font, same way as the text drawing does */
+  if (f->face->charmap)
+    glyph_index = FT_Get_Char_Index(f->face, character);
+  else
+    glyph_index = character;
+
+  if ((glyph_index < 0) || (glyph_index >= f->face->num_glyphs))
+    return FALSE;
+
+  _alfont_cache_glyph(f, glyph_index);
+  cglyph = &f->cached_glyphs[glyph_index];
+
+  *advancex = cglyph->advancex;
+  *advancey = cglyph->advancey;
+  memset(mono, 0, sizeof(ALFONT_GLYPH));
+  memset(aa, 0, sizeof(ALFONT_GLYPH));
+  if (cglyph->mono_available) {
+    mono->left = cglyph->left;
+    mono->top = f->face_ascender - cglyph->top;
+    mono->width = cglyph->width;
+    mono->height = cglyph->height;
+    mono->bmp = cglyph->bmp;
+  }
+  if (cglyph->aa_available) {
+    aa->left = cglyph->aaleft;
+    aa->top = f->face_ascender - cglyph->aatop;
+    aa->width = cglyph->aawidth;
+    aa->height = cglyph->aaheight;
+    aa->bmp = cglyph->aabmp;
+  }
+  return TRUE;
+}
+
+
 void alfont_set_char_extra_spacing(ALFONT_FONT *f, int spacing) {
   if (spacing  < 0)
     f->ch_spacing = 0;
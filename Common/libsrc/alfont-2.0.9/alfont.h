@@ -56,6 +56,13 @@ extern "C" {
 /* structs */
 typedef struct ALFONT_FONT ALFONT_FONT;
 
+/* pre-rendered glyph image (AGS addition) */
+typedef struct ALFONT_GLYPH {
+  int left, top;          /* image offset from the pen position and the text's top */
+  int width, height;      /* image size */
+  const unsigned char *bmp; /* one byte per pixel, 0 means transparent; may be NULL */
+} ALFONT_GLYPH;
+
 /* API */
 
 ALFONT_DLL_DECLSPEC char* alfont_get_name(ALFONT_FONT *f);
@@ -117,6 +124,14 @@ ALFONT_DLL_DECLSPEC int alfont_get_nof_available_fixed_sizes(ALFONT_FONT *f);
 ALFONT_DLL_DECLSPEC int alfont_get_char_extra_spacing(ALFONT_FONT *f);
 ALFONT_DLL_DECLSPEC void alfont_set_char_extra_spacing(ALFONT_FONT *f, int spacing);
 
+/* Gets the cached glyph of a character: the pen advance (without the extra char
+   spacing), and its monochrome and anti-aliased images. The image data is owned
+   by the font and remains valid until the font is resized or destroyed.
+   Does not account for the fixed width mode. Returns FALSE if there's no such glyph.
+   (AGS addition) */
+ALFONT_DLL_DECLSPEC int alfont_get_char_glyph(ALFONT_FONT *f, int character, int *advancex, int *advancey,
+  ALFONT_GLYPH *mono, ALFONT_GLYPH *aa);
+
 #ifdef __cplusplus
 }
 #endif
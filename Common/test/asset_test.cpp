@@ -0,0 +1,387 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "core/assetindex.h"
+#include "core/assetmanager.h"
+#include "util/file.h"
+#include "util/lzw.h"
+#include "util/mappedfile.h"
+#include "util/memorystream.h"
+#include "util/multifilelib.h"
+
+using namespace AGS::Common;
+
+static AssetInfo MakeAsset(const char *name, soff_t offset)
+{
+    AssetInfo a;
+    a.FileName = name;
+    a.Offset = offset;
+    return a;
+}
+
+TEST(Asset, IndexFind) {
+    std::vector<AssetInfo> assets;
+    assets.push_back(MakeAsset("room1.crm", 0));
+    assets.push_back(MakeAsset("Room2.crm", 1));
+    assets.push_back(MakeAsset("acsprset.spr", 2));
+    assets.push_back(MakeAsset("ROOM1.CRM", 3)); // duplicate, should be ignored
+    assets.push_back(MakeAsset("audio.vox", 4));
+
+    AssetIndex index;
+    index.Build(assets);
+    ASSERT_EQ(index.GetCount(), 5u);
+    ASSERT_EQ(index.Find("room1.crm"), &assets[0]);
+    ASSERT_EQ(index.Find("Room1.Crm"), &assets[0]);
+    ASSERT_EQ(index.Find("room2.crm"), &assets[1]);
+    ASSERT_EQ(index.Find("ACSPRSET.SPR"), &assets[2]);
+    ASSERT_EQ(index.Find("audio.vox"), &assets[4]);
+    ASSERT_EQ(index.Find("room3.crm"), nullptr);
+    ASSERT_EQ(index.Find("room1"), nullptr);
+    ASSERT_EQ(index.Find(""), nullptr);
+
+    index.Clear();
+    ASSERT_EQ(index.GetCount(), 0u);
+    ASSERT_EQ(index.Find("room1.crm"), nullptr);
+}
+
+TEST(Asset, IndexFindAll) {
+    std::vector<AssetInfo> assets;
+    assets.push_back(MakeAsset("room1.crm", 0));
+    assets.push_back(MakeAsset("Room2.crm", 0));
+    assets.push_back(MakeAsset("room10.crm", 0));
+    assets.push_back(MakeAsset("acsprset.spr", 0));
+    assets.push_back(MakeAsset("roomdata.dat", 0));
+    assets.push_back(MakeAsset("audio.vox", 0));
+
+    AssetIndex index;
+    index.Build(assets);
+
+    std::vector<String> names;
+    index.FindAll(names, "room*.crm");
+    std::sort(names.begin(), names.end());
+    ASSERT_EQ(names.size(), 3u);
+    ASSERT_STREQ(names[0].GetCStr(), "Room2.crm");
+    ASSERT_STREQ(names[1].GetCStr(), "room1.crm");
+    ASSERT_STREQ(names[2].GetCStr(), "room10.crm");
+
+    names.clear();
+    index.FindAll(names, "ROOM?.CRM");
+    std::sort(names.begin(), names.end());
+    ASSERT_EQ(names.size(), 2u);
+    ASSERT_STREQ(names[0].GetCStr(), "Room2.crm");
+    ASSERT_STREQ(names[1].GetCStr(), "room1.crm");
+
+    names.clear();
+    index.FindAll(names, "*.vox");
+    ASSERT_EQ(names.size(), 1u);
+    ASSERT_STREQ(names[0].GetCStr(), "audio.vox");
+
+    names.clear();
+    index.FindAll(names, "*");
+    ASSERT_EQ(names.size(), assets.size());
+
+    names.clear();
+    index.FindAll(names, "AUDIO.VOX");
+    ASSERT_EQ(names.size(), 1u);
+    ASSERT_STREQ(names[0].GetCStr(), "audio.vox");
+
+    names.clear();
+    index.FindAll(names, "audio");
+    ASSERT_EQ(names.size(), 0u);
+    index.FindAll(names, "speech*");
+    ASSERT_EQ(names.size(), 0u);
+}
+
+// Compares indexed lookup with the plain linear search over a large library
+TEST(Asset, DISABLED_IndexBenchmark) {
+    const size_t asset_count = 100000;
+    const size_t linear_lookups = 1000;
+    std::vector<AssetInfo> assets;
+    assets.reserve(asset_count);
+    for (size_t i = 0; i < asset_count; ++i)
+        assets.push_back(MakeAsset(String::FromFormat("speech/EGO%zu.ogg", i).GetCStr(), i));
+    std::vector<String> queries;
+    queries.reserve(asset_count);
+    for (size_t i = 0; i < asset_count; ++i)
+        queries.push_back(String::FromFormat("Speech/ego%zu.OGG", (i * 7919) % asset_count));
+
+    typedef std::chrono::high_resolution_clock Clock;
+    auto t0 = Clock::now();
+    AssetIndex index;
+    index.Build(assets);
+    auto t1 = Clock::now();
+    size_t found_indexed = 0;
+    for (const auto &q : queries)
+    {
+        const AssetInfo *a = index.Find(q);
+        if (a && a->FileName.CompareNoCase(q) == 0)
+            found_indexed++;
+    }
+    auto t2 = Clock::now();
+    size_t found_linear = 0;
+    for (size_t i = 0; i < linear_lookups; ++i)
+    {
+        const String &q = queries[i];
+        for (const auto &a : assets)
+        {
+            if (a.FileName.CompareNoCase(q) == 0)
+            {
+                found_linear++;
+                break;
+            }
+        }
+    }
+    auto t3 = Clock::now();
+    std::vector<String> names;
+    index.FindAll(names, "speech/ego1234*.ogg");
+    auto t4 = Clock::now();
+
+    ASSERT_EQ(found_indexed, asset_count);
+    ASSERT_EQ(found_linear, linear_lookups);
+    ASSERT_EQ(names.size(), 11u); // ego1234 and ego12340..12349
+
+    typedef std::chrono::duration<double, std::micro> usec;
+    printf("AssetIndex (%zu assets): build %.0f us; indexed lookup %.3f us/op; "
+        "linear lookup %.3f us/op; wildcard search %.0f us\n",
+        asset_count, usec(t1 - t0).count(),
+        usec(t2 - t1).count() / asset_count,
+        usec(t3 - t2).count() / linear_lookups,
+        usec(t4 - t3).count());
+}
+
+// Writes a single-file asset library with the given asset contents
+static void WriteTestLibrary(const String &lib_file, const std::vector<std::vector<uint8_t>> &data)
+{
+    AssetLibInfo lib;
+    lib.LibFileNames.push_back(lib_file);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        AssetInfo a = MakeAsset(String::FromFormat("asset%zu.dat", i).GetCStr(), 0);
+        a.Size = data[i].size();
+        lib.AssetInfos.push_back(a);
+    }
+    std::unique_ptr<Stream> out(File::CreateFile(lib_file));
+    MFLUtil::WriteHeader(lib, MFLUtil::kMFLVersion_MultiV30, 0, out.get());
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        lib.AssetInfos[i].Offset = out->GetPosition();
+        out->Write(data[i].data(), data[i].size());
+    }
+    out->Seek(0, kSeekBegin);
+    MFLUtil::WriteHeader(lib, MFLUtil::kMFLVersion_MultiV30, 0, out.get());
+    out->Seek(0, kSeekEnd);
+    MFLUtil::WriteEnder(0, MFLUtil::kMFLVersion_MultiV30, out.get());
+}
+
+static std::vector<std::vector<uint8_t>> MakeAssetData(size_t count, size_t max_size, std::mt19937 &rng)
+{
+    std::vector<std::vector<uint8_t>> data(count);
+    for (auto &d : data)
+    {
+        d.resize(rng() % max_size);
+        for (auto &b : d)
+            b = static_cast<uint8_t>(rng());
+    }
+    return data;
+}
+
+TEST(Asset, MappedLibrary) {
+    const String lib_file = "test_mapped.ags";
+    std::mt19937 rng(2024);
+    const auto data = MakeAssetData(20, 40000, rng);
+    WriteTestLibrary(lib_file, data);
+
+    AssetManager mgr;
+    ASSERT_EQ(mgr.AddLibrary(lib_file), kAssetNoError);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        std::unique_ptr<Stream> in(mgr.OpenAsset(String::FromFormat("asset%zu.dat", i)));
+        ASSERT_TRUE(in);
+        if (MappedFile::IsSupported())
+        {
+            ASSERT_TRUE(dynamic_cast<MappedSectionStream*>(in.get()));
+        }
+        ASSERT_EQ(in->GetLength(), static_cast<soff_t>(data[i].size()));
+        std::vector<uint8_t> buf(data[i].size() + 10);
+        ASSERT_EQ(in->Read(buf.data(), buf.size()), data[i].size());
+        ASSERT_TRUE(std::equal(data[i].begin(), data[i].end(), buf.begin()));
+        ASSERT_TRUE(in->EOS());
+        if (data[i].size() > 4)
+        {
+            in->Seek(-4, kSeekEnd);
+            ASSERT_EQ(in->GetPosition(), static_cast<soff_t>(data[i].size() - 4));
+            ASSERT_EQ(in->ReadByte(), data[i][data[i].size() - 4]);
+        }
+    }
+    ASSERT_EQ(mgr.OpenAsset("asset100.dat"), nullptr);
+
+    // Streams keep the mapping alive after the library is removed
+    std::unique_ptr<Stream> in(mgr.OpenAsset("asset3.dat"));
+    mgr.RemoveAllLibraries();
+    ASSERT_TRUE(in);
+    std::vector<uint8_t> buf(data[3].size());
+    ASSERT_EQ(in->Read(buf.data(), buf.size()), data[3].size());
+    ASSERT_TRUE(std::equal(data[3].begin(), data[3].end(), buf.begin()));
+    in.reset();
+
+    // Sections are clamped to the file's size
+    auto mapped = MappedFile::Open(lib_file);
+    if (MappedFile::IsSupported())
+    {
+        ASSERT_TRUE(mapped);
+        MappedSectionStream sec(mapped, mapped->GetSize() - 10, mapped->GetSize() + 100);
+        ASSERT_EQ(sec.GetLength(), 10);
+        MappedSectionStream empty(mapped, mapped->GetSize() + 10, mapped->GetSize() + 100);
+        ASSERT_EQ(empty.GetLength(), 0);
+        ASSERT_TRUE(empty.EOS());
+    }
+    mapped.reset();
+    ASSERT_EQ(MappedFile::Open("test_mapped_missing.ags"), nullptr);
+    File::DeleteFile(lib_file);
+}
+
+// Tests the library having compressed assets, and the assets sharing
+// same data block
+TEST(Asset, CompressedLibrary) {
+    const String lib_file = "test_compressed.ags";
+    std::mt19937 rng(31);
+    std::vector<std::vector<uint8_t>> data(3);
+    // repetitive data that compresses well, and random data that does not
+    for (size_t i = 0; i < 50000; ++i)
+        data[0].push_back(static_cast<uint8_t>("abcabcabd"[i % 9]));
+    data[1] = MakeAssetData(1, 40000, rng)[0];
+    data[1].resize(std::max<size_t>(data[1].size(), 16));
+
+    AssetLibInfo lib;
+    lib.LibFileNames.push_back(lib_file);
+    for (size_t i = 0; i < data.size(); ++i)
+        lib.AssetInfos.push_back(MakeAsset(String::FromFormat("asset%zu.dat", i).GetCStr(), 0));
+    std::unique_ptr<Stream> out(File::CreateFile(lib_file));
+    MFLUtil::WriteHeader(lib, MFLUtil::kMFLVersion_MultiV31, 0, out.get());
+    for (size_t i = 0; i < 2; ++i)
+    {
+        AssetInfo &a = lib.AssetInfos[i];
+        std::vector<uint8_t> packed;
+        VectorStream data_in(data[i]);
+        VectorStream packed_out(packed, kStream_Write);
+        ASSERT_TRUE(lzwcompress(&data_in, &packed_out));
+        const auto &write = (i == 0) ? packed : data[i];
+        a.Offset = out->GetPosition();
+        a.Size = write.size();
+        a.Flags = (i == 0) ? kAssetFlag_Compressed : 0;
+        a.UncompressedSize = data[i].size();
+        out->Write(write.data(), write.size());
+    }
+    ASSERT_LT(lib.AssetInfos[0].Size, static_cast<soff_t>(data[0].size()));
+    // last asset is a duplicate of the first one
+    data[2] = data[0];
+    lib.AssetInfos[2].Offset = lib.AssetInfos[0].Offset;
+    lib.AssetInfos[2].Size = lib.AssetInfos[0].Size;
+    lib.AssetInfos[2].Flags = lib.AssetInfos[0].Flags;
+    lib.AssetInfos[2].UncompressedSize = lib.AssetInfos[0].UncompressedSize;
+    out->Seek(0, kSeekBegin);
+    MFLUtil::WriteHeader(lib, MFLUtil::kMFLVersion_MultiV31, 0, out.get());
+    out->Seek(0, kSeekEnd);
+    MFLUtil::WriteEnder(0, MFLUtil::kMFLVersion_MultiV31, out.get());
+    out.reset();
+
+    AssetManager mgr;
+    ASSERT_EQ(mgr.AddLibrary(lib_file), kAssetNoError);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        std::unique_ptr<Stream> in(mgr.OpenAsset(String::FromFormat("asset%zu.dat", i)));
+        ASSERT_TRUE(in);
+        ASSERT_EQ(in->GetLength(), static_cast<soff_t>(data[i].size()));
+        std::vector<uint8_t> buf(data[i].size() + 10);
+        ASSERT_EQ(in->Read(buf.data(), buf.size()), data[i].size());
+        ASSERT_TRUE(std::equal(data[i].begin(), data[i].end(), buf.begin()));
+        ASSERT_TRUE(in->EOS());
+    }
+    mgr.RemoveAllLibraries();
+
+    // Table of contents keeps the per-asset storage flags
+    AssetLibInfo read_lib;
+    std::unique_ptr<Stream> in(File::OpenFileRead(lib_file));
+    ASSERT_EQ(MFLUtil::ReadHeader(read_lib, in.get()), MFLUtil::kMFLNoError);
+    ASSERT_EQ(read_lib.AssetInfos.size(), 3u);
+    ASSERT_EQ(read_lib.AssetInfos[0].Flags, static_cast<uint32_t>(kAssetFlag_Compressed));
+    ASSERT_EQ(read_lib.AssetInfos[1].Flags, 0u);
+    ASSERT_EQ(read_lib.AssetInfos[2].Offset, read_lib.AssetInfos[0].Offset);
+    in.reset();
+    File::DeleteFile(lib_file);
+}
+
+// Simulates loading the rooms of a large game, reading each room asset with
+// a mix of the small field reads and the larger block reads; compares the
+// regular buffered file streams with the memory mapped library
+TEST(Asset, DISABLED_MappedLibraryBenchmark) {
+    const String lib_file = "test_mapped_bench.ags";
+    const size_t room_count = 60;
+    std::mt19937 rng(7);
+    const auto data = MakeAssetData(room_count, 2 * 1024 * 1024, rng);
+    WriteTestLibrary(lib_file, data);
+    AssetManager mgr;
+    ASSERT_EQ(mgr.AddLibrary(lib_file), kAssetNoError);
+    std::vector<AssetInfo> assets;
+    for (size_t i = 0; i < room_count; ++i)
+        assets.push_back(*std::find_if(mgr.GetLibraryInfo(0)->AssetInfos.begin(), mgr.GetLibraryInfo(0)->AssetInfos.end(),
+            [i](const AssetInfo &a) { return a.FileName == String::FromFormat("asset%zu.dat", i); }));
+
+    auto load_room = [](Stream *in)
+    {
+        // room files are mostly a sequence of small fields, and a few
+        // large blocks, such as the background and mask bitmaps
+        std::vector<uint8_t> block(64 * 1024);
+        int64_t sum = 0;
+        while (!in->EOS())
+        {
+            for (int i = 0; i < 256 && !in->EOS(); ++i)
+                sum += in->ReadInt32();
+            sum += in->Read(block.data(), block.size());
+        }
+        return sum;
+    };
+
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+    int64_t sum_file = 0, sum_mapped = 0;
+    std::unique_ptr<Stream> warm_up(File::OpenFileRead(lib_file));
+    load_room(warm_up.get()); // warm up the system file cache
+    warm_up.reset();
+    auto t0 = Clock::now();
+    for (const auto &a : assets)
+    {
+        std::unique_ptr<Stream> in(File::OpenFile(lib_file, a.Offset, a.Offset + a.Size));
+        sum_file += load_room(in.get());
+    }
+    auto t1 = Clock::now();
+    for (const auto &a : assets)
+    {
+        std::unique_ptr<Stream> in(mgr.OpenAsset(a.FileName));
+        sum_mapped += load_room(in.get());
+    }
+    auto t2 = Clock::now();
+    ASSERT_EQ(sum_file, sum_mapped);
+    printf("Asset library (%zu rooms, %zu MB): file streams %.2f ms, mapped %.2f ms\n",
+        room_count, static_cast<size_t>(File::GetFileSize(lib_file) / (1024 * 1024)),
+        msec(t1 - t0).count(), msec(t2 - t1).count());
+    mgr.RemoveAllLibraries();
+    File::DeleteFile(lib_file);
+}
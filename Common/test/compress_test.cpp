@@ -0,0 +1,111 @@
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "util/lzw.h"
+#include "util/memorystream.h"
+#include "util/png.h"
+
+using namespace AGS::Common;
+
+// Makes the data resembling a serialized game state: runs of zeroes,
+// small integers and repeating text, mixed with some random bytes
+static std::vector<uint8_t> MakeSaveLikeData(size_t size)
+{
+    std::mt19937 rng(1);
+    std::vector<uint8_t> data;
+    data.reserve(size);
+    const char *text = "Character.Walk ";
+    while (data.size() < size)
+    {
+        switch (rng() % 4)
+        {
+        case 0: data.insert(data.end(), rng() % 64, 0); break;
+        case 1: for (int i = 0; i < 16; ++i) data.push_back(static_cast<uint8_t>(rng() % 8)); break;
+        case 2: data.insert(data.end(), text, text + 15); break;
+        default: data.push_back(static_cast<uint8_t>(rng())); break;
+        }
+    }
+    data.resize(size);
+    return data;
+}
+
+// Deflate at the default level, as used for the savegames
+static bool ZlibCompress(Stream *in, Stream *out)
+{
+    return pngcompress(in, out, Z_DEFAULT_COMPRESSION);
+}
+
+typedef bool (*CompressFn)(Stream*, Stream*);
+typedef bool (*ExpandFn)(const uint8_t*, size_t, uint8_t*, size_t);
+
+static std::vector<uint8_t> Compress(const std::vector<uint8_t> &data, CompressFn compress)
+{
+    std::vector<uint8_t> packed;
+    MemoryStream in(data.data(), data.size());
+    VectorStream out(packed, kStream_Write);
+    EXPECT_TRUE(compress(&in, &out));
+    return packed;
+}
+
+static std::vector<uint8_t> Expand(const std::vector<uint8_t> &packed, size_t size, ExpandFn expand)
+{
+    std::vector<uint8_t> unpacked(size);
+    EXPECT_TRUE(expand(packed.data(), packed.size(), unpacked.data(), unpacked.size()));
+    return unpacked;
+}
+
+TEST(Compress, ZlibRoundtrip) {
+    // Includes the sizes larger than the internal buffers, to test the streaming
+    for (size_t size : { 0u, 8u, 1000u, 100000u, 200000u })
+    {
+        const auto data = MakeSaveLikeData(size);
+        const auto packed = Compress(data, ZlibCompress);
+        ASSERT_EQ(data, Expand(packed, size, pngexpand));
+        if (size >= 1000u)
+        {
+            ASSERT_LT(packed.size(), size);
+        }
+    }
+}
+
+TEST(Compress, ZlibTruncated) {
+    const auto data = MakeSaveLikeData(100000u);
+    const auto packed = Compress(data, ZlibCompress);
+    std::vector<uint8_t> unpacked(data.size());
+    ASSERT_FALSE(pngexpand(packed.data(), packed.size() / 2, unpacked.data(), unpacked.size()));
+}
+
+TEST(Compress, LZWRoundtrip) {
+    // NOTE: LZW algorithm that we use fails on sequence less than 16 bytes
+    for (size_t size : { 16u, 1000u, 100000u })
+    {
+        const auto data = MakeSaveLikeData(size);
+        const auto packed = Compress(data, lzwcompress);
+        ASSERT_EQ(data, Expand(packed, size, lzwexpand));
+    }
+}
+
+// Measures compression time and ratio of the savegame-like data
+TEST(Compress, DISABLED_Benchmark) {
+    const auto data = MakeSaveLikeData(4 * 1024 * 1024);
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+    struct { const char *Name; CompressFn Compress; ExpandFn Expand; } cases[] = {
+        { "zlib", ZlibCompress, pngexpand },
+        { "lzw", lzwcompress, lzwexpand },
+    };
+    for (auto &c : cases)
+    {
+        auto t0 = Clock::now();
+        const auto packed = Compress(data, c.Compress);
+        const double pack_time = msec(Clock::now() - t0).count();
+        t0 = Clock::now();
+        const auto unpacked = Expand(packed, data.size(), c.Expand);
+        const double unpack_time = msec(Clock::now() - t0).count();
+        ASSERT_EQ(data, unpacked);
+        printf("Compress: %s, %zu KB -> %zu KB; compress %.3f ms, decompress %.3f ms\n",
+            c.Name, data.size() / 1024, packed.size() / 1024, pack_time, unpack_time);
+    }
+}
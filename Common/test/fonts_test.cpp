@@ -0,0 +1,333 @@
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <alfont.h>
+#include "gtest/gtest.h"
+#include "ac/common.h"
+#include "ac/game_version.h"
+#include "core/assetmanager.h"
+#include "font/agsfontrenderer.h"
+#include "font/fonts.h"
+#include "font/ttffontrenderer.h"
+#include "util/file.h"
+#include "util/stream.h"
+
+using namespace AGS::Common;
+
+// Project-dependent definitions required by the font code,
+// implemented separately by the Engine and the Editor
+GameDataVersion loaded_game_file_version = kGameVersion_Current;
+static bool AntiAliasText = false;
+bool ShouldAntiAliasText() { return AntiAliasText; }
+void set_our_eip(int) {}
+int get_our_eip() { return 0; }
+void __my_setcolor(int *ctset, int newcol, int) { *ctset = newcol; }
+
+// Font renderer which measures each character as CharWidth pixels wide,
+// and counts the measurement requests
+class CountingRenderer : public IAGSFontRenderer
+{
+public:
+    bool LoadFromDisk(int, int) override { return true; }
+    void FreeMemory(int) override {}
+    bool SupportsExtendedCharacters(int) override { return false; }
+    int GetTextWidth(const char *text, int) override
+    {
+        WidthCalls++;
+        return static_cast<int>(strlen(text)) * CharWidth;
+    }
+    int GetTextHeight(const char *, int) override { return 8; }
+    void RenderText(const char *, int, BITMAP *, int, int, int) override {}
+    void AdjustYCoordinateForFont(int *, int) override {}
+    void EnsureTextValidForFont(char *, int) override {}
+
+    int CharWidth = 6;
+    int WidthCalls = 0;
+};
+
+// Writes a WFN font which has all the 128 characters drawn as a box 6x8
+static void WriteBoxFont(const String &filename)
+{
+    const uint16_t char_off = 15 + sizeof(uint16_t);
+    const uint16_t table_addr = char_off + 2 * sizeof(uint16_t) + 8;
+    std::unique_ptr<Stream> out(File::CreateFile(filename));
+    out->Write("WGT Font File  ", 15);
+    out->WriteInt16(table_addr);
+    out->WriteInt16(6);
+    out->WriteInt16(8);
+    for (int y = 0; y < 8; ++y)
+        out->WriteInt8(static_cast<int8_t>(0xFC));
+    for (int i = 0; i < 128; ++i)
+        out->WriteInt16(char_off);
+}
+
+class SplitLinesTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        WriteBoxFont("agsfnt0.wfn");
+        AssetMgr.reset(new AssetManager());
+        AssetMgr->AddLibrary(".");
+        ASSERT_TRUE(load_font_size(0, FontInfo()));
+        font_replace_renderer(0, &renderer);
+    }
+
+    void TearDown() override
+    {
+        free_all_fonts();
+        AssetMgr.reset();
+        File::DeleteFile("agsfnt0.wfn");
+    }
+
+    CountingRenderer renderer;
+    CountingRenderer wide_renderer;
+};
+
+static std::vector<String> GetLines(const SplitLines &lines)
+{
+    std::vector<String> result;
+    for (size_t i = 0; i < lines.Count(); ++i)
+        result.push_back(lines[i]);
+    return result;
+}
+
+static std::vector<int> GetWidths(const SplitLines &lines)
+{
+    std::vector<int> result;
+    for (size_t i = 0; i < lines.Count(); ++i)
+        result.push_back(lines.GetWidth(i));
+    return result;
+}
+
+TEST_F(SplitLinesTest, CacheHit) {
+    const char *text = "The quick brown fox[jumps over the lazy dog";
+    SplitLines lines;
+    ASSERT_EQ(split_lines(text, lines, 60, 0), 5u);
+    const auto first_lines = GetLines(lines);
+    const auto first_widths = GetWidths(lines);
+    ASSERT_EQ(first_lines[0], "The quick");
+    ASSERT_EQ(first_lines[3], "over the");
+    ASSERT_EQ(first_widths[0], 54);
+    ASSERT_GT(renderer.WidthCalls, 0);
+
+    // Same request is served from the cache, without measuring the text
+    renderer.WidthCalls = 0;
+    SplitLines lines2;
+    ASSERT_EQ(split_lines(text, lines2, 60, 0), 5u);
+    ASSERT_EQ(renderer.WidthCalls, 0);
+    ASSERT_EQ(GetLines(lines2), first_lines);
+    ASSERT_EQ(GetWidths(lines2), first_widths);
+}
+
+TEST_F(SplitLinesTest, CacheKeys) {
+    const char *text = "The quick brown fox jumps over the lazy dog";
+    SplitLines lines;
+    ASSERT_EQ(split_lines(text, lines, 60, 0), 5u);
+
+    // Different width is a separate entry
+    renderer.WidthCalls = 0;
+    ASSERT_EQ(split_lines(text, lines, 120, 0), 3u);
+    ASSERT_GT(renderer.WidthCalls, 0);
+    ASSERT_EQ(lines[0], "The quick brown fox");
+
+    // Different max lines is a separate entry
+    renderer.WidthCalls = 0;
+    ASSERT_EQ(split_lines(text, lines, 60, 0, 2), 2u);
+    ASSERT_GT(renderer.WidthCalls, 0);
+    ASSERT_EQ(lines[1], "brown fox...");
+
+    // Previous entries are not replaced by the new ones
+    renderer.WidthCalls = 0;
+    ASSERT_EQ(split_lines(text, lines, 60, 0), 5u);
+    ASSERT_EQ(split_lines(text, lines, 120, 0), 3u);
+    ASSERT_EQ(split_lines(text, lines, 60, 0, 2), 2u);
+    ASSERT_EQ(renderer.WidthCalls, 0);
+}
+
+TEST_F(SplitLinesTest, CacheInvalidate) {
+    const char *text = "The quick brown fox jumps over the lazy dog";
+    SplitLines lines;
+    ASSERT_EQ(split_lines(text, lines, 60, 0), 5u);
+
+    clear_text_layout_cache();
+    renderer.WidthCalls = 0;
+    ASSERT_EQ(split_lines(text, lines, 60, 0), 5u);
+    ASSERT_GT(renderer.WidthCalls, 0);
+
+    // Replacing the font's renderer discards the measurements of the old one
+    wide_renderer.CharWidth = 10;
+    font_replace_renderer(0, &wide_renderer);
+    ASSERT_EQ(split_lines(text, lines, 60, 0), 9u);
+    ASSERT_EQ(lines[0], "The");
+    ASSERT_GT(wide_renderer.WidthCalls, 0);
+
+    // Font reload does too, and the lines are measured by the reloaded font
+    ASSERT_TRUE(load_font_size(0, FontInfo()));
+    ASSERT_EQ(split_lines(text, lines, 60, 0), 5u);
+    ASSERT_EQ(lines[0], "The quick");
+    ASSERT_EQ(lines.GetWidth(0), 54);
+}
+
+// Looks for a TrueType font to test with: either the one set by
+// AGS_TEST_TTF environment variable, or a common system font
+static String FindTestTTF()
+{
+    const char *env_font = getenv("AGS_TEST_TTF");
+    if (env_font && env_font[0])
+        return env_font;
+    const char *fonts[] = {
+        "C:/Windows/Fonts/arial.ttf",
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/TTF/DejaVuSans.ttf",
+        "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+        "/System/Library/Fonts/Supplemental/Arial.ttf",
+        "/Library/Fonts/Arial.ttf"
+    };
+    for (const char *font : fonts)
+    {
+        if (File::IsFile(font))
+            return font;
+    }
+    return "";
+}
+
+static std::vector<char> ReadFile(const String &filename)
+{
+    std::unique_ptr<Stream> in(File::OpenFileRead(filename));
+    std::vector<char> data(static_cast<size_t>(in->GetLength()));
+    in->Read(data.data(), data.size());
+    return data;
+}
+
+static bool SameBitmaps(BITMAP *a, BITMAP *b)
+{
+    const int line_len = a->w * ((bitmap_color_depth(a) + 7) / 8);
+    for (int y = 0; y < a->h; ++y)
+    {
+        if (memcmp(a->line[y], b->line[y], line_len) != 0)
+            return false;
+    }
+    return true;
+}
+
+typedef std::unique_ptr<BITMAP, void(*)(BITMAP*)> BitmapPtr;
+
+static const char *TTFTexts[] = {
+    "The quick brown fox jumps over the lazy dog",
+    "0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~",
+    "Caf\xC3\xA9 na\xC3\xAFve \xC3\x9C" "ber",
+    "",
+};
+static const size_t TTFTextCount = sizeof(TTFTexts) / sizeof(TTFTexts[0]);
+
+// Measures all the test texts, and draws them on the new bitmaps
+// of every color depth, with and without anti-aliasing
+template <typename TMeasure, typename TDraw>
+static void DrawTTFTexts(TMeasure measure, TDraw draw,
+    std::vector<int> &widths, std::vector<BitmapPtr> &images)
+{
+    for (const char *text : TTFTexts)
+        widths.push_back(measure(text));
+    for (int depth : { 8, 15, 16, 32 })
+    {
+        const int bg_color = (depth == 8) ? 3 : makecol_depth(depth, 20, 40, 60);
+        const int color = (depth == 8) ? 15 : makecol_depth(depth, 250, 120, 30);
+        for (bool aa : { false, true })
+        {
+            for (const char *text : TTFTexts)
+            {
+                BitmapPtr bmp(create_bitmap_ex(depth, 400, 40), destroy_bitmap);
+                clear_to_color(bmp.get(), bg_color);
+                draw(text, bmp.get(), color, aa);
+                images.push_back(std::move(bmp));
+            }
+        }
+    }
+}
+
+// Compares the text measured and drawn by the TTF renderer, which uses
+// the glyph cache, with the text measured and drawn by alfont itself.
+// NOTE: each font is loaded by the newly initialized font library, because
+// the glyph hinting of one FreeType face may be affected by another face.
+TEST(TTFFontRenderer, MatchesAlfont) {
+    const String font_file = FindTestTTF();
+    if (font_file.IsEmpty())
+    {
+        printf("No TrueType font found, set AGS_TEST_TTF to run this test\n");
+        return;
+    }
+    const std::vector<char> font_data = ReadFile(font_file);
+    {
+        std::unique_ptr<Stream> out(File::CreateFile("agsfnt1.ttf"));
+        out->Write(font_data.data(), font_data.size());
+    }
+    const int old_format = get_uformat();
+    set_uformat(U_UTF8);
+    AssetMgr.reset(new AssetManager());
+    AssetMgr->AddLibrary(".");
+
+    const int font_size = 14;
+    std::vector<int> widths, ref_widths;
+    std::vector<BitmapPtr> images, ref_images;
+
+    init_font_renderer();
+    TTFFontRenderer renderer;
+    FontRenderParams params;
+    const bool loaded = renderer.LoadFromDiskEx(1, font_size, &params, nullptr);
+    if (loaded)
+    {
+        DrawTTFTexts(
+            [&renderer](const char *text) { return renderer.GetTextWidth(text, 1); },
+            [&renderer](const char *text, BITMAP *bmp, int color, bool aa)
+            {
+                AntiAliasText = aa;
+                renderer.RenderText(text, 1, bmp, -2, 10, color);
+            },
+            widths, images);
+        AntiAliasText = false;
+        renderer.FreeMemory(1);
+    }
+    shutdown_font_renderer();
+
+    init_font_renderer();
+    ALFONT_FONT *alfont = alfont_load_font_from_mem(font_data.data(), static_cast<int>(font_data.size()));
+    if (alfont)
+    {
+        alfont_set_font_size_ex(alfont, font_size, ALFONT_FLG_FORCE_RESIZE | ALFONT_FLG_SELECT_NOMINAL_SZ);
+        DrawTTFTexts(
+            [alfont](const char *text) { return alfont_text_length(alfont, text); },
+            [alfont](const char *text, BITMAP *bmp, int color, bool aa)
+            {
+                if (aa && (bitmap_color_depth(bmp) > 8))
+                    alfont_textout_aa(bmp, alfont, text, -2, 10 - 1, color);
+                else
+                    alfont_textout(bmp, alfont, text, -2, 10 - 1, color);
+            },
+            ref_widths, ref_images);
+        alfont_destroy_font(alfont);
+    }
+    shutdown_font_renderer();
+
+    AssetMgr.reset();
+    File::DeleteFile("agsfnt1.ttf");
+    set_uformat(old_format);
+
+    ASSERT_TRUE(loaded);
+    ASSERT_TRUE(alfont);
+    ASSERT_EQ(widths, ref_widths);
+    ASSERT_EQ(images.size(), ref_images.size());
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        const char *text = TTFTexts[i % TTFTextCount];
+        BITMAP *bmp = images[i].get();
+        ASSERT_TRUE(SameBitmaps(bmp, ref_images[i].get())) << "depth "
+            << bitmap_color_depth(bmp) << ", text " << text;
+        // make sure that something was actually drawn
+        BitmapPtr blank(create_bitmap_ex(bitmap_color_depth(bmp), bmp->w, bmp->h), destroy_bitmap);
+        clear_to_color(blank.get(), getpixel(bmp, bmp->w - 1, bmp->h - 1));
+        ASSERT_EQ(SameBitmaps(bmp, blank.get()), text[0] == 0) << text;
+    }
+}
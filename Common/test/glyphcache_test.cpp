@@ -0,0 +1,222 @@
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <allegro.h>
+#include "gtest/gtest.h"
+#include "font/glyphcache.h"
+
+extern "C" {
+    // alfont's blender setup for the anti-aliased glyphs
+    void set_preservedalpha_trans_blender(int r, int g, int b, int a);
+}
+
+// Makes a loader of the synthetic glyphs of the given size, having
+// pseudo-random coverage values, with a share of the fully opaque ones
+static GlyphCache::GlyphLoader MakeLoader(int width, int height, int first_char, int last_char)
+{
+    return [=](int character, Glyph &glyph)
+    {
+        if (character < first_char || character > last_char)
+            return;
+        std::mt19937 rng(character);
+        glyph.Valid = true;
+        glyph.AdvanceX = width + 1;
+        for (GlyphImage *img : { &glyph.Mono, &glyph.AA })
+        {
+            img->Left = static_cast<int>(rng() % 3) - 1;
+            img->Top = static_cast<int>(rng() % 3);
+            img->Width = width;
+            img->Height = height;
+            img->Pixels.resize(width * height);
+            for (auto &px : img->Pixels)
+            {
+                const uint32_t r = rng() % 4;
+                px = (r == 0) ? 0 : (r == 1) ? 255 : static_cast<uint8_t>(rng());
+            }
+        }
+    };
+}
+
+// Draws the text pixel by pixel, same as alfont does
+static void DrawReference(GlyphCache &cache, const char *text, BITMAP *dst, int x, int y, int color, bool aa)
+{
+    for (int ch = ugetxc(&text); ch != 0; ch = ugetxc(&text))
+    {
+        if (x > dst->cr)
+            break;
+        const Glyph &glyph = cache.GetGlyph(ch);
+        if (!glyph.Valid)
+            continue;
+        const GlyphImage &img = aa ? glyph.AA : glyph.Mono;
+        const uint8_t *src = img.Pixels.data();
+        for (int py = 0; py < img.Height; ++py)
+        {
+            for (int px = 0; px < img.Width; ++px)
+            {
+                const int alpha = *src++;
+                if (!alpha)
+                    continue;
+                if (!aa || alpha >= 255)
+                {
+                    solid_mode();
+                }
+                else
+                {
+                    drawing_mode(DRAW_MODE_TRANS, NULL, 0, 0);
+                    set_preservedalpha_trans_blender(0, 0, 0, alpha);
+                }
+                putpixel(dst, x + img.Left + px, y + img.Top + py, color);
+            }
+        }
+        x += glyph.AdvanceX;
+        y += glyph.AdvanceY;
+    }
+    solid_mode();
+}
+
+static void FillRandom(BITMAP *bmp, std::mt19937 &rng)
+{
+    const int depth = bitmap_color_depth(bmp);
+    const int mask = bitmap_mask_color(bmp);
+    for (int y = 0; y < bmp->h; ++y)
+        for (int x = 0; x < bmp->w; ++x)
+            putpixel(bmp, x, y, (rng() % 8 == 0) ? mask :
+                static_cast<int>(rng() & ((depth == 32) ? 0xFFFFFFFF : (1u << depth) - 1)));
+}
+
+static bool SameBitmaps(BITMAP *a, BITMAP *b)
+{
+    const int line_len = a->w * ((bitmap_color_depth(a) + 7) / 8);
+    for (int y = 0; y < a->h; ++y)
+    {
+        if (memcmp(a->line[y], b->line[y], line_len) != 0)
+            return false;
+    }
+    return true;
+}
+
+// Returns UTF-8 text made of the random characters of the given range
+static std::string MakeText(int first_char, int last_char, int count, std::mt19937 &rng)
+{
+    std::string text;
+    char buf[8];
+    for (int i = 0; i < count; ++i)
+    {
+        const int len = usetc(buf, first_char + static_cast<int>(rng() % (last_char - first_char + 1)));
+        text.append(buf, len);
+    }
+    return text;
+}
+
+// Compares the cached glyphs output with the per-pixel drawing,
+// for all the supported color depths, clipped and unclipped
+TEST(GlyphCache, MatchesPixelDrawing) {
+    const int old_format = get_uformat();
+    set_uformat(U_UTF8);
+    std::mt19937 rng(777);
+    // Latin and CJK-like glyphs, and a few missing ones
+    GlyphCache latin(MakeLoader(8, 12, 32, 126));
+    GlyphCache cjk(MakeLoader(16, 16, 0x4E00, 0x4E00 + 3000));
+    const std::string latin_text = MakeText(32, 130, 40, rng);
+    const std::string cjk_text = MakeText(0x4E00, 0x4E00 + 3100, 20, rng);
+
+    for (int depth : { 8, 15, 16, 32 })
+    {
+        std::unique_ptr<BITMAP, void(*)(BITMAP*)> init(create_bitmap_ex(depth, 200, 60), destroy_bitmap);
+        std::unique_ptr<BITMAP, void(*)(BITMAP*)> ref(create_bitmap_ex(depth, 200, 60), destroy_bitmap);
+        std::unique_ptr<BITMAP, void(*)(BITMAP*)> fast(create_bitmap_ex(depth, 200, 60), destroy_bitmap);
+        FillRandom(init.get(), rng);
+        const int color = (depth == 8) ? 15 : makecol_depth(depth, 250, 120, 30);
+        for (bool aa : { false, true })
+        {
+            if (!GlyphCache::CanDraw(fast.get(), aa))
+                continue;
+            for (bool clip : { false, true })
+            {
+                for (auto *test : { &latin, &cjk })
+                {
+                    const char *text = (test == &latin) ? latin_text.c_str() : cjk_text.c_str();
+                    blit(init.get(), ref.get(), 0, 0, 0, 0, 200, 60);
+                    blit(init.get(), fast.get(), 0, 0, 0, 0, 200, 60);
+                    set_clip_rect(ref.get(), 5, 9, clip ? 150 : 199, clip ? 40 : 59);
+                    set_clip_rect(fast.get(), 5, 9, clip ? 150 : 199, clip ? 40 : 59);
+                    DrawReference(*test, text, ref.get(), -3, 0, color, aa);
+                    DrawReference(*test, text, ref.get(), 2, 30, color, aa);
+                    test->DrawText(text, fast.get(), -3, 0, color, aa);
+                    test->DrawText(text, fast.get(), 2, 30, color, aa);
+                    ASSERT_TRUE(SameBitmaps(ref.get(), fast.get())) << "depth " << depth
+                        << ", aa " << aa << ", clip " << clip;
+                    ASSERT_FALSE(SameBitmaps(init.get(), fast.get()));
+                }
+            }
+        }
+    }
+    ASSERT_FALSE(latin.GetGlyph(200).Valid);
+    ASSERT_EQ(latin.GetTextWidth("ab\xC8\x80"), 18);
+    set_uformat(old_format);
+}
+
+// Measures text output of the cached glyphs vs drawing them pixel by pixel
+TEST(GlyphCache, DISABLED_Benchmark) {
+    const int old_format = get_uformat();
+    set_uformat(U_UTF8);
+    const int frames = 50;
+    std::mt19937 rng(1);
+    GlyphCache latin(MakeLoader(8, 12, 32, 126));
+    GlyphCache cjk(MakeLoader(16, 16, 0x4E00, 0x4E00 + 6000));
+    GlyphCache outline(MakeLoader(10, 14, 32, 126));
+    std::vector<std::string> latin_lines, cjk_lines;
+    for (int i = 0; i < 40; ++i)
+    {
+        latin_lines.push_back(MakeText(32, 126, 100, rng));
+        cjk_lines.push_back(MakeText(0x4E00, 0x4E00 + 6000, 50, rng));
+    }
+    std::unique_ptr<BITMAP, void(*)(BITMAP*)> surface(create_bitmap_ex(32, 1024, 768), destroy_bitmap);
+    clear_to_color(surface.get(), makecol32(20, 40, 60));
+    const int color = makecol32(255, 255, 255);
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+
+    auto draw_page = [&](bool cached, GlyphCache &cache, const std::vector<std::string> &lines, bool outlined)
+    {
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            const int y = static_cast<int>(i) * 18;
+            if (outlined)
+            {
+                for (int ox : { -1, 1 })
+                    for (int oy : { -1, 1 })
+                    {
+                        if (cached) outline.DrawText(lines[i].c_str(), surface.get(), ox, y + oy, 0, true);
+                        else DrawReference(outline, lines[i].c_str(), surface.get(), ox, y + oy, 0, true);
+                    }
+            }
+            if (cached) cache.DrawText(lines[i].c_str(), surface.get(), 0, y, color, true);
+            else DrawReference(cache, lines[i].c_str(), surface.get(), 0, y, color, true);
+        }
+    };
+    struct { const char *Name; GlyphCache &Cache; const std::vector<std::string> &Lines; bool Outlined; } cases[] = {
+        { "latin", latin, latin_lines, false },
+        { "cjk", cjk, cjk_lines, false },
+        { "outlined", latin, latin_lines, true },
+    };
+    for (auto &c : cases)
+    {
+        draw_page(true, c.Cache, c.Lines, c.Outlined); // warm up the caches
+        auto t0 = Clock::now();
+        for (int i = 0; i < frames; ++i)
+            draw_page(false, c.Cache, c.Lines, c.Outlined);
+        const double per_pixel = msec(Clock::now() - t0).count() / frames;
+        t0 = Clock::now();
+        for (int i = 0; i < frames; ++i)
+            draw_page(true, c.Cache, c.Lines, c.Outlined);
+        const double cached = msec(Clock::now() - t0).count() / frames;
+        printf("GlyphCache: %s, %d lines; per-pixel %.3f ms, cached %.3f ms\n",
+            c.Name, static_cast<int>(c.Lines.size()), per_pixel, cached);
+    }
+    set_uformat(old_format);
+}
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "debug/profiler.h"
+#include "util/memorystream.h"
+
+using namespace AGS::Common;
+
+TEST(Profiler, Disabled) {
+    Profiler::Reset();
+    Profiler::NextFrame();
+    {
+        AGS_PROFILE_ZONE("Zone");
+        AGS_PROFILE_COUNT("Things", 1);
+    }
+    Profiler::NextFrame();
+    ASSERT_FALSE(Profiler::IsEnabled());
+    ASSERT_EQ(Profiler::GetStats().FrameCount, 0u);
+    ASSERT_TRUE(Profiler::GetStats().Zones.empty());
+    ASSERT_TRUE(Profiler::GetStats().Counters.empty());
+}
+
+#if AGS_PROFILER
+
+static void SleepMs(int ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static const Profiler::ZoneStat *FindZone(const Profiler::FrameStats &stats, const char *name)
+{
+    for (const auto &z : stats.Zones)
+        if (strcmp(z.Name, name) == 0)
+            return &z;
+    return nullptr;
+}
+
+static std::string GetTrace()
+{
+    std::vector<uint8_t> buf;
+    VectorStream out(buf, kStream_Write);
+    Profiler::WriteTrace(&out);
+    return std::string(buf.begin(), buf.end());
+}
+
+TEST(Profiler, FrameStats) {
+    Profiler::Reset();
+    Profiler::SetEnabled(true);
+    Profiler::NextFrame();
+    // Run frames until the first period ends
+    while (Profiler::GetStats().FrameCount == 0u)
+    {
+        {
+            AGS_PROFILE_ZONE("Outer");
+            SleepMs(2);
+            for (int i = 0; i < 2; ++i)
+            {
+                AGS_PROFILE_ZONE("Inner");
+                SleepMs(1);
+            }
+        }
+        AGS_PROFILE_COUNT("Things", 3);
+        Profiler::NextFrame();
+    }
+    const auto &stats = Profiler::GetStats();
+    const auto *outer = FindZone(stats, "Outer");
+    const auto *inner = FindZone(stats, "Inner");
+    ASSERT_NE(outer, nullptr);
+    ASSERT_NE(inner, nullptr);
+    // Zones are sorted by time, and include the time of nested zones
+    ASSERT_EQ(outer, &stats.Zones[0]);
+    ASSERT_GE(outer->TimeMs, 4.f);
+    ASSERT_GE(inner->TimeMs, 2.f);
+    ASSERT_LE(outer->TimeMs, stats.FrameMs);
+    ASSERT_FLOAT_EQ(outer->Calls, 1.f);
+    ASSERT_FLOAT_EQ(inner->Calls, 2.f);
+    ASSERT_EQ(stats.Counters.size(), 1u);
+    ASSERT_STREQ(stats.Counters[0].Name, "Things");
+    ASSERT_FLOAT_EQ(stats.Counters[0].Value, 3.f);
+    Profiler::Reset();
+}
+
+TEST(Profiler, ZoneAcrossFrames) {
+    Profiler::Reset();
+    Profiler::SetEnabled(true);
+    Profiler::NextFrame();
+    {
+        // The zone continues through the frames, as if it was a blocking script
+        AGS_PROFILE_ZONE("Blocking");
+        while (Profiler::GetStats().FrameCount == 0u)
+        {
+            SleepMs(5);
+            Profiler::NextFrame();
+        }
+        // Only the part within the period is counted,
+        // and the zone is not finished yet
+        const auto *zone = FindZone(Profiler::GetStats(), "Blocking");
+        ASSERT_NE(zone, nullptr);
+        ASSERT_LE(zone->TimeMs, Profiler::GetStats().FrameMs);
+        ASSERT_FLOAT_EQ(zone->Calls, 0.f);
+    }
+    Profiler::Reset();
+}
+
+TEST(Profiler, Trace) {
+    Profiler::Reset();
+    Profiler::StartTrace(100, "");
+    ASSERT_TRUE(Profiler::IsEnabled());
+    ASSERT_TRUE(Profiler::IsTracing());
+    {
+        AGS_PROFILE_ZONE("Before"); // not recorded, as the trace starts with the next frame
+    }
+    Profiler::NextFrame();
+    {
+        AGS_PROFILE_ZONE_DETAIL("Script", "on_\"event\"\n");
+        AGS_PROFILE_COUNT("Things", 2);
+    }
+    std::thread worker([]() { AGS_PROFILE_ZONE("Worker"); });
+    worker.join();
+    Profiler::NextFrame();
+
+    const std::string trace = GetTrace();
+    ASSERT_EQ(trace.find("{\"traceEvents\":[\n"), 0u);
+    ASSERT_EQ(trace.find("\"Before\""), std::string::npos);
+    ASSERT_NE(trace.find("{\"name\":\"Script\",\"ph\":\"X\""), std::string::npos);
+    ASSERT_NE(trace.find("\"args\":{\"detail\":\"on_\\\"event\\\"\\u000a\"}"), std::string::npos);
+    ASSERT_NE(trace.find("{\"name\":\"Worker\",\"ph\":\"X\""), std::string::npos);
+    ASSERT_NE(trace.find("{\"name\":\"Frame\",\"ph\":\"X\""), std::string::npos);
+    ASSERT_NE(trace.find("{\"name\":\"Things\",\"ph\":\"C\""), std::string::npos);
+    ASSERT_NE(trace.find("\"args\":{\"value\":2}"), std::string::npos);
+    ASSERT_NE(trace.find("],\"displayTimeUnit\":\"ms\"}\n"), std::string::npos);
+    Profiler::Reset();
+    ASSERT_FALSE(Profiler::IsTracing());
+}
+
+#endif // AGS_PROFILER
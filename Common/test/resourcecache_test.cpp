@@ -0,0 +1,218 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include <chrono>
+#include <stdio.h>
+#include "gtest/gtest.h"
+#include "util/resourcecache.h"
+
+using namespace AGS::Common;
+
+// Test cache stores integers, and each item's size equals to its value
+template <typename TBase>
+class IntCache : public TBase
+{
+public:
+    IntCache(size_t max_size) : TBase(max_size) {}
+protected:
+    size_t CalcSize(const int &item) override { return item > 0 ? item : 0; }
+};
+
+typedef IntCache<ResourceCache<int, int>> IntHashCache;
+typedef IntCache<DenseResourceCache<int, int>> IntDenseCache;
+
+template <typename TCache>
+class ResourceCacheTest : public ::testing::Test {};
+
+typedef ::testing::Types<IntHashCache, IntDenseCache> CacheTypes;
+TYPED_TEST_CASE(ResourceCacheTest, CacheTypes);
+
+TYPED_TEST(ResourceCacheTest, PutGet) {
+    TypeParam cache(100);
+    cache.Put(1, 10);
+    cache.Put(2, 20);
+    cache.Put(5, 0); // invalid item
+    ASSERT_TRUE(cache.Exists(1));
+    ASSERT_TRUE(cache.Exists(2));
+    ASSERT_FALSE(cache.Exists(3));
+    ASSERT_FALSE(cache.Exists(5));
+    ASSERT_EQ(cache.Get(1), 10);
+    ASSERT_EQ(cache.Get(2), 20);
+    ASSERT_EQ(cache.Get(3), 0);
+    ASSERT_EQ(cache.Get(1000), 0);
+    // replace existing item
+    cache.Put(1, 15);
+    ASSERT_EQ(cache.Get(1), 15);
+    ASSERT_EQ(cache.GetCacheSize(), 35u);
+    // remove items
+    ASSERT_EQ(cache.Remove(2), 20);
+    ASSERT_FALSE(cache.Exists(2));
+    cache.Dispose(1);
+    ASSERT_FALSE(cache.Exists(1));
+    cache.Clear();
+    ASSERT_EQ(cache.GetCacheSize(), 0u);
+}
+
+TYPED_TEST(ResourceCacheTest, DisposeOldest) {
+    TypeParam cache(100);
+    for (int i = 0; i < 5; ++i)
+        cache.Put(i, 20);
+    ASSERT_EQ(cache.GetCacheSize(), 100u);
+    // reading item 0 makes it recently used, so 1 becomes the oldest one
+    cache.Get(0);
+    cache.Put(5, 20);
+    ASSERT_TRUE(cache.Exists(0));
+    ASSERT_FALSE(cache.Exists(1));
+    ASSERT_TRUE(cache.Exists(2));
+    // a big item displaces several oldest items
+    cache.Put(6, 50);
+    ASSERT_FALSE(cache.Exists(2));
+    ASSERT_FALSE(cache.Exists(3));
+    ASSERT_FALSE(cache.Exists(4));
+    ASSERT_TRUE(cache.Exists(0));
+    ASSERT_TRUE(cache.Exists(5));
+    ASSERT_EQ(cache.GetCacheSize(), 90u);
+    // lowering the limit disposes items too
+    cache.SetMaxCacheSize(50);
+    ASSERT_EQ(cache.GetCacheSize(), 50u);
+    ASSERT_TRUE(cache.Exists(6));
+}
+
+TYPED_TEST(ResourceCacheTest, LockRelease) {
+    TypeParam cache(100);
+    cache.Put(1, 30);
+    cache.Put(2, 30, TypeParam::kCacheItem_Locked);
+    cache.Lock(1);
+    cache.Put(3, 30);
+    ASSERT_EQ(cache.GetLockedSize(), 60u);
+    // locked items may not be disposed
+    cache.Put(4, 30);
+    ASSERT_TRUE(cache.Exists(1));
+    ASSERT_TRUE(cache.Exists(2));
+    ASSERT_FALSE(cache.Exists(3));
+    ASSERT_TRUE(cache.Exists(4));
+    // released item returns to the list as a recently used one
+    cache.Release(1);
+    ASSERT_EQ(cache.GetLockedSize(), 30u);
+    cache.Put(5, 30);
+    ASSERT_TRUE(cache.Exists(1));
+    ASSERT_FALSE(cache.Exists(4));
+    // dispose all but locked items
+    cache.DisposeFreeItems();
+    ASSERT_FALSE(cache.Exists(1));
+    ASSERT_TRUE(cache.Exists(2));
+    ASSERT_FALSE(cache.Exists(5));
+    ASSERT_EQ(cache.GetCacheSize(), 30u);
+    ASSERT_EQ(cache.GetLockedSize(), 30u);
+    cache.Dispose(2);
+    ASSERT_EQ(cache.GetCacheSize(), 0u);
+    ASSERT_EQ(cache.GetLockedSize(), 0u);
+}
+
+TYPED_TEST(ResourceCacheTest, External) {
+    TypeParam cache(100);
+    cache.Put(1, 50, TypeParam::kCacheItem_External);
+    cache.Put(2, 60, TypeParam::kCacheItem_External);
+    ASSERT_EQ(cache.GetCacheSize(), 0u);
+    ASSERT_EQ(cache.GetExternalSize(), 110u);
+    // external items do not prevent caching normal ones
+    cache.Put(3, 100);
+    ASSERT_TRUE(cache.Exists(3));
+    // and are never disposed, nor released
+    cache.Release(1);
+    cache.Put(4, 100);
+    cache.DisposeFreeItems();
+    ASSERT_TRUE(cache.Exists(1));
+    ASSERT_TRUE(cache.Exists(2));
+    ASSERT_FALSE(cache.Exists(3));
+    ASSERT_FALSE(cache.Exists(4));
+    ASSERT_EQ(cache.Remove(1), 50);
+    ASSERT_EQ(cache.GetExternalSize(), 60u);
+}
+
+TEST(ResourceCache, DenseInvalidKeys) {
+    IntDenseCache cache(100);
+    cache.Put(-1, 10);
+    ASSERT_FALSE(cache.Exists(-1));
+    ASSERT_EQ(cache.Get(-1), 0);
+    ASSERT_EQ(cache.GetCacheSize(), 0u);
+}
+
+// Runs a sprite-like access pattern: every frame reads a stable set of
+// sprites (room and gui graphics), and a number of animation frames that
+// slowly progress through the sprite range; missing sprites are added.
+template <typename TCache>
+static double RunFramePattern(TCache &cache, int frames, size_t &misses)
+{
+    const int stable_count = 200;
+    const int anim_count = 40;
+    const int anim_frames = 8;
+    const int sprite_count = 20000;
+    typedef std::chrono::high_resolution_clock Clock;
+    misses = 0;
+    auto t0 = Clock::now();
+    for (int f = 0; f < frames; ++f)
+    {
+        for (int i = 0; i < stable_count; ++i)
+        {
+            if (cache.Get(i + 1) == 0)
+            {
+                cache.Put(i + 1, 1 + i % 16);
+                misses++;
+            }
+        }
+        const int anim_base = stable_count + 1 + (f / 50) * anim_count * anim_frames;
+        for (int i = 0; i < anim_count; ++i)
+        {
+            const int key = (anim_base + i * anim_frames + (f / 4) % anim_frames) % sprite_count;
+            if (cache.Get(key) == 0)
+            {
+                cache.Put(key, 1 + key % 16);
+                misses++;
+            }
+        }
+    }
+    auto t1 = Clock::now();
+    return std::chrono::duration<double, std::micro>(t1 - t0).count();
+}
+
+// Same management rules must result in the same cache behavior
+TEST(ResourceCache, DenseMatchesHashed) {
+    const int frames = 2000;
+    const size_t max_size = 4000;
+    size_t misses_hash, misses_dense;
+    IntHashCache hash_cache(max_size);
+    IntDenseCache dense_cache(max_size);
+    RunFramePattern(hash_cache, frames, misses_hash);
+    RunFramePattern(dense_cache, frames, misses_dense);
+    ASSERT_GT(misses_hash, 200u); // more than the first frame
+    ASSERT_EQ(misses_hash, misses_dense);
+    ASSERT_EQ(hash_cache.GetCacheSize(), dense_cache.GetCacheSize());
+}
+
+// Compares the hashed and the dense cache implementations on a frame-typical
+// access pattern; the cache limit is set to hold only part of the sprites.
+TEST(ResourceCache, DISABLED_DenseBenchmark) {
+    const int frames = 20000;
+    const size_t max_size = 4000;
+    size_t misses_hash, misses_dense;
+    IntHashCache hash_cache(max_size);
+    IntDenseCache dense_cache(max_size);
+    const double dur_hash = RunFramePattern(hash_cache, frames, misses_hash);
+    const double dur_dense = RunFramePattern(dense_cache, frames, misses_dense);
+    // same management rules must result in the same cache behavior
+    ASSERT_EQ(misses_hash, misses_dense);
+    ASSERT_EQ(hash_cache.GetCacheSize(), dense_cache.GetCacheSize());
+    printf("ResourceCache: %d frames, %zu misses; hashed %.3f us/frame, dense %.3f us/frame\n",
+        frames, misses_hash, dur_hash / frames, dur_dense / frames);
+}
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include "gtest/gtest.h"
+#include "ac/wordsdictionary.h"
+#include "util/string_compat.h"
+
+static void SetWords(WordsDictionary &dict, const std::vector<std::pair<const char*, short>> &words)
+{
+    dict.allocate_memory(static_cast<int>(words.size()));
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        snprintf(dict.word[i], MAX_PARSER_WORD_LENGTH, "%s", words[i].first);
+        dict.wordnum[i] = words[i].second;
+    }
+}
+
+TEST(WordsDictionary, Sort) {
+    WordsDictionary dict;
+    SetWords(dict, { { "take", 5 }, { "Apple", 7 }, { "get", 5 }, { "ignore", 0 },
+        { "banana", 7 }, { "Grab", 5 }, { "rol", RESTOFLINE }, { "anyword", ANYWORD } });
+    dict.sort();
+    const char *expect_words[] = { "ignore", "get", "Grab", "take", "Apple", "banana", "anyword", "rol" };
+    const short expect_nums[] = { 0, 5, 5, 5, 7, 7, ANYWORD, RESTOFLINE };
+    ASSERT_EQ(8, dict.num_words);
+    for (int i = 0; i < dict.num_words; ++i)
+    {
+        ASSERT_STREQ(expect_words[i], dict.word[i]);
+        ASSERT_EQ(expect_nums[i], dict.wordnum[i]);
+    }
+}
+
+TEST(WordsDictionary, FindIndex) {
+    WordsDictionary dict;
+    SetWords(dict, { { "look", 1 }, { "Pick Up", 2 }, { "pick up the", 3 }, { "LOOK", 4 } });
+    // works without the index too
+    ASSERT_EQ(1, dict.find_index("pick up"));
+    ASSERT_TRUE(dict.is_multiword_prefix("anything"));
+    dict.build_index();
+    ASSERT_EQ(0, dict.find_index("look"));
+    ASSERT_EQ(0, dict.find_index("Look"));
+    ASSERT_EQ(1, dict.find_index("PICK UP"));
+    ASSERT_EQ(2, dict.find_index("pick up the"));
+    ASSERT_EQ(-1, dict.find_index("pick"));
+    ASSERT_EQ(-1, dict.find_index(""));
+    ASSERT_TRUE(dict.is_multiword_prefix("pick"));
+    ASSERT_TRUE(dict.is_multiword_prefix("PICK UP"));
+    ASSERT_FALSE(dict.is_multiword_prefix("pick up the"));
+    ASSERT_FALSE(dict.is_multiword_prefix("look"));
+    dict.free_memory();
+    ASSERT_EQ(-1, dict.find_index("look"));
+}
+
+// Measures sorting and lookup in a large dictionary
+TEST(WordsDictionary, DISABLED_Benchmark) {
+    const int count = 15000;
+    WordsDictionary dict;
+    dict.allocate_memory(count);
+    for (int i = 0; i < count; ++i)
+    {
+        snprintf(dict.word[i], MAX_PARSER_WORD_LENGTH, (i % 10 == 0) ? "word %d" : "Word%d", (i * 7919) % count);
+        dict.wordnum[i] = static_cast<short>((i * 31) % 2000);
+    }
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+    auto t0 = Clock::now();
+    dict.sort();
+    const double sort_time = msec(Clock::now() - t0).count();
+    for (int i = 1; i < count; ++i)
+    {
+        ASSERT_TRUE((dict.wordnum[i - 1] < dict.wordnum[i]) ||
+            ((dict.wordnum[i - 1] == dict.wordnum[i]) && (ags_stricmp(dict.word[i - 1], dict.word[i]) <= 0)));
+    }
+
+    char buf[MAX_PARSER_WORD_LENGTH];
+    int found = 0;
+    t0 = Clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        snprintf(buf, sizeof(buf), "WORD%d", i);
+        found += dict.find_index(buf) >= 0;
+    }
+    const double find_time = msec(Clock::now() - t0).count();
+    ASSERT_EQ(count - count / 10, found);
+    printf("WordsDictionary: %d words, sort %.3f ms, lookup %.4f us per word\n",
+        count, sort_time, find_time * 1000.0 / count);
+}
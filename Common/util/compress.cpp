@@ -24,6 +24,7 @@
 #include "gfx/bitmap.h"
 #include "util/lzw.h"
 #include "util/memorystream.h"
+#include "util/png.h"
 #if AGS_PLATFORM_ENDIAN_BIG
 #include "util/bbop.h"
 #endif
@@ -41,10 +41,12 @@ void _delete(int);
 #define root (node+1+N+N+N)
 #define NIL -1
 
-uint8_t *lzbuffer;
-int *node;
-int pos;
-size_t outbytes = 0;
+// The (de)compression state is per thread, so that the data
+// could be packed and unpacked on multiple threads at once
+static thread_local uint8_t *lzbuffer;
+static thread_local int *node;
+static thread_local int pos;
+static thread_local size_t outbytes = 0;
 
 int insert(int i, int run)
 {
@@ -194,10 +196,17 @@ bool lzwcompress(Stream *lzw_in, Stream *out)
 }
 
 bool lzwexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz)
+{
+  size_t out_sz;
+  return lzwexpand(src, src_sz, dst, dst_sz, out_sz);
+}
+
+bool lzwexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz, size_t &out_sz)
 {
   int bits, ch, i, j, len, mask;
   uint8_t *dst_ptr = dst;
   const uint8_t *src_ptr = src;
+  out_sz = 0;
 
   if (dst_sz == 0)
     return false; // nowhere to expand to
@@ -247,5 +256,6 @@ bool lzwexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz)
   }
 
   free(lzbuffer);
+  out_sz = dst_ptr - dst;
   return (src_ptr - src) == src_sz;
 }
@@ -27,5 +27,7 @@ bool lzwcompress(Common::Stream *lzw_in, Common::Stream *out);
 // Expands lzw-compressed data from src to dst.
 // the dst buffer should be large enough, or the uncompression will not be complete.
 bool lzwexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz);
+// Expands lzw-compressed data, and returns the number of bytes written to dst in out_sz.
+bool lzwexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz, size_t &out_sz);
 
 #endif // __AGS_CN_UTIL__LZW_H
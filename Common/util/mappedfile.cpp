@@ -0,0 +1,123 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "util/mappedfile.h"
+#include <algorithm>
+#include <limits>
+#include "core/platform.h"
+
+#if AGS_PLATFORM_OS_WINDOWS || AGS_PLATFORM_OS_EMSCRIPTEN
+#define AGS_NO_MEMORY_MAPPING
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AGS
+{
+namespace Common
+{
+
+// Largest file to map; on 32-bit systems the address space is scarce,
+// and it's better to leave it for the game data
+static const uint64_t MaxMappedSize = (sizeof(void*) >= 8) ?
+    std::numeric_limits<size_t>::max() : (256u * 1024u * 1024u);
+
+MappedFile::MappedFile(const String &path, const uint8_t *data, size_t size)
+    : _path(path)
+    , _data(data)
+    , _size(size)
+{
+}
+
+MappedFile::~MappedFile()
+{
+#if !defined(AGS_NO_MEMORY_MAPPING)
+    munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+}
+
+/* static */ bool MappedFile::IsSupported()
+{
+#if defined(AGS_NO_MEMORY_MAPPING)
+    return false;
+#else
+    return true;
+#endif
+}
+
+/* static */ std::shared_ptr<MappedFile> MappedFile::Open(const String &filename)
+{
+#if defined(AGS_NO_MEMORY_MAPPING)
+    (void)filename;
+    return nullptr;
+#else
+    int fd = open(filename.GetCStr(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    // Empty files cannot be mapped, and too large ones may not fit into
+    // the address space; these are left for the regular file streams
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0) ||
+        (static_cast<uint64_t>(st.st_size) > MaxMappedSize))
+    {
+        close(fd);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid after closing the file
+    if (data == MAP_FAILED)
+        return nullptr;
+    return std::shared_ptr<MappedFile>(new MappedFile(filename, static_cast<const uint8_t*>(data), size));
+#endif
+}
+
+
+// Helpers returning the start and size of the section, clamped to the file
+static const uint8_t *GetSectionData(const MappedFile *file, soff_t start_pos)
+{
+    if (!file)
+        return nullptr;
+    start_pos = std::min<soff_t>(std::max<soff_t>(0, start_pos), file->GetSize());
+    return file->GetData() + start_pos;
+}
+
+static size_t GetSectionSize(const MappedFile *file, soff_t start_pos, soff_t end_pos)
+{
+    if (!file)
+        return 0u;
+    start_pos = std::min<soff_t>(std::max<soff_t>(0, start_pos), file->GetSize());
+    end_pos = std::min<soff_t>(std::max<soff_t>(start_pos, end_pos), file->GetSize());
+    return static_cast<size_t>(end_pos - start_pos);
+}
+
+MappedSectionStream::MappedSectionStream(std::shared_ptr<MappedFile> file, soff_t start_pos, soff_t end_pos,
+        DataEndianess stream_endianess)
+    : MemoryStream(GetSectionData(file.get(), start_pos), GetSectionSize(file.get(), start_pos, end_pos), stream_endianess)
+    , _file(file)
+{
+    if (file)
+        _path = file->GetPath();
+}
+
+void MappedSectionStream::Close()
+{
+    MemoryStream::Close();
+    _file.reset();
+}
+
+} // namespace Common
+} // namespace AGS
@@ -0,0 +1,79 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// MappedFile is a read-only memory mapping of a whole file.
+// Memory mapping is currently supported only on POSIX systems; on other
+// platforms, or if the mapping fails, MappedFile::Open returns null,
+// and the caller is expected to use the regular file streams instead.
+//
+// MappedSectionStream is a read-only MemoryStream over a section of the
+// mapped file; it shares the ownership of the mapping, so that the mapping
+// stays valid for as long as there are streams working over it.
+//
+//=============================================================================
+#ifndef __AGS_CN_UTIL__MAPPEDFILE_H
+#define __AGS_CN_UTIL__MAPPEDFILE_H
+
+#include <memory>
+#include "util/memorystream.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Common
+{
+
+class MappedFile
+{
+public:
+    ~MappedFile();
+
+    // Tells if memory mapping is supported on this platform
+    static bool IsSupported();
+    // Maps the whole file for reading; returns null on failure
+    static std::shared_ptr<MappedFile> Open(const String &filename);
+
+    const String &GetPath() const { return _path; }
+    const uint8_t *GetData() const { return _data; }
+    size_t GetSize() const { return _size; }
+
+private:
+    MappedFile(const String &path, const uint8_t *data, size_t size);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    String _path;
+    const uint8_t *_data = nullptr;
+    size_t _size = 0u;
+};
+
+
+class MappedSectionStream : public MemoryStream
+{
+public:
+    // Constructs a stream over the range of the mapped file;
+    // the range is clamped to the mapped file's size
+    MappedSectionStream(std::shared_ptr<MappedFile> file, soff_t start_pos, soff_t end_pos,
+        DataEndianess stream_endianess = kLittleEndian);
+
+    void    Close() override;
+
+private:
+    std::shared_ptr<MappedFile> _file;
+};
+
+} // namespace Common
+} // namespace AGS
+
+#endif // __AGS_CN_UTIL__MAPPEDFILE_H
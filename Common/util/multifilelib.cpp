@@ -44,7 +44,7 @@ namespace MFLUtil
     MFLError ReadV21(AssetLibInfo &lib, Stream *in);
     MFLError ReadV30(AssetLibInfo &lib, Stream *in, MFLVersion lib_version);
 
-    void     WriteV30(const AssetLibInfo &lib, Stream *out);
+    void     WriteV30(const AssetLibInfo &lib, MFLVersion lib_version, Stream *out);
 
     // Encryption / decryption 
     int      GetNextPseudoRand(int &rand_val);
@@ -176,7 +176,7 @@ MFLUtil::MFLError MFLUtil::ReadSigsAndVersion(Stream *in, MFLVersion *p_lib_vers
     if ((lib_version != kMFLVersion_SingleLib) && (lib_version != kMFLVersion_MultiV10) &&
         (lib_version != kMFLVersion_MultiV11) && (lib_version != kMFLVersion_MultiV15) &&
         (lib_version != kMFLVersion_MultiV20) && (lib_version != kMFLVersion_MultiV21) &&
-        lib_version != kMFLVersion_MultiV30)
+        (lib_version != kMFLVersion_MultiV30) && (lib_version != kMFLVersion_MultiV31))
         return kMFLErrLibVersion; // unsupported version
 
     if (p_lib_version)
@@ -347,7 +347,7 @@ MFLUtil::MFLError MFLUtil::ReadV21(AssetLibInfo &lib, Stream *in)
     return kMFLNoError;
 }
 
-MFLUtil::MFLError MFLUtil::ReadV30(AssetLibInfo &lib, Stream *in, MFLVersion /* lib_version */)
+MFLUtil::MFLError MFLUtil::ReadV30(AssetLibInfo &lib, Stream *in, MFLVersion lib_version)
 {
     // NOTE: removed encryption like in v21, because it makes little sense
     // with open-source program. But if really wanted it may be restored
@@ -370,6 +370,11 @@ MFLUtil::MFLError MFLUtil::ReadV30(AssetLibInfo &lib, Stream *in, MFLVersion /*
         asset.LibUid = (uint8_t)in->ReadInt8();
         asset.Offset = in->ReadInt64();
         asset.Size = in->ReadInt64();
+        if (lib_version >= kMFLVersion_MultiV31)
+        {
+            asset.Flags = static_cast<uint32_t>(in->ReadInt32());
+            asset.UncompressedSize = in->ReadInt64();
+        }
     }
     return kMFLNoError;
 }
@@ -383,11 +388,11 @@ void MFLUtil::WriteHeader(const AssetLibInfo &lib, MFLVersion lib_version, int l
     // First datafile in chain: write the table of contents
     if (lib_index == 0)
     {
-        WriteV30(lib, out);
+        WriteV30(lib, lib_version, out);
     }
 }
 
-void MFLUtil::WriteV30(const AssetLibInfo &lib, Stream *out)
+void MFLUtil::WriteV30(const AssetLibInfo &lib, MFLVersion lib_version, Stream *out)
 {
     out->WriteInt32(0); // reserved options
     // filenames for all library parts
@@ -405,6 +410,11 @@ void MFLUtil::WriteV30(const AssetLibInfo &lib, Stream *out)
         out->WriteInt8(static_cast<uint8_t>(asset.LibUid));
         out->WriteInt64(asset.Offset);
         out->WriteInt64(asset.Size);
+        if (lib_version >= kMFLVersion_MultiV31)
+        {
+            out->WriteInt32(static_cast<int32_t>(asset.Flags));
+            out->WriteInt64(asset.UncompressedSize);
+        }
     }
 }
 
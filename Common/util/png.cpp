@@ -16,11 +16,7 @@
 //
 //=============================================================================
 #include "util/png.h"
-#include <stdlib.h>
-#include "util/bbop.h"
 #include "util/stream.h"
-#include <algorithm>
-#include "zlib1213/zlib.h"
 
 using namespace AGS::Common;
 
@@ -29,80 +25,53 @@ using namespace AGS::Common;
 #pragma unmanaged
 #endif
 
-bool pngcompress(Stream* input, Stream* output) {
-    z_stream stream;
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
-    stream.avail_in = 0;
-    stream.next_in = Z_NULL;
-
-    int ret = deflateInit(&stream, Z_BEST_COMPRESSION);
-    if (ret != Z_OK) {
-        std::cerr << "Error initializing compression" << std::endl;
+bool pngcompress(Stream *input, Stream *output, int level)
+{
+    z_stream stream = {};
+    if (deflateInit(&stream, level) != Z_OK)
         return false;
-    }
-
-    char inbuf[1024];
-    char outbuf[1024];
-
-    input.Open();
-    output.Open();
-
-    stream.avail_in = input.Read(inbuf, sizeof(inbuf));
 
-    while (stream.avail_in > 0) {
-        stream.next_in = (Bytef*)inbuf;
-        stream.avail_out = sizeof(outbuf);
-        stream.next_out = (Bytef*)outbuf;
-
-        ret = deflate(&stream, Z_NO_FLUSH);
-        if (ret != Z_OK) {
-            std::cerr << "Error compressing data" << std::endl;
-            break;
+    Bytef inbuf[16 * 1024];
+    Bytef outbuf[16 * 1024];
+    int ret = Z_OK;
+    do
+    {
+        stream.avail_in = static_cast<uInt>(input->Read(inbuf, sizeof(inbuf)));
+        stream.next_in = inbuf;
+        const int flush = (stream.avail_in < sizeof(inbuf)) ? Z_FINISH : Z_NO_FLUSH;
+        do
+        {
+            stream.avail_out = sizeof(outbuf);
+            stream.next_out = outbuf;
+            ret = deflate(&stream, flush);
+            if (ret == Z_STREAM_ERROR)
+            {
+                deflateEnd(&stream);
+                return false;
+            }
+            output->Write(outbuf, sizeof(outbuf) - stream.avail_out);
         }
-
-        int have = sizeof(outbuf) - stream.avail_out;
-        output.Write(outbuf, have);
-
-        stream.avail_in = input.Read(inbuf, sizeof(inbuf));
+        while (stream.avail_out == 0);
     }
+    while (ret != Z_STREAM_END);
 
-    (void)deflateEnd(&stream);
-
-    input.Close();
-    output.Close();
-
+    deflateEnd(&stream);
     return true;
 }
 
-bool pngexpand(const uint8_t* src, size_t src_sz, uint8_t* dst, size_t dst_sz) {
-    z_stream stream;
-    stream.zalloc = Z_NULL;
-    stream.zfree = Z_NULL;
-    stream.opaque = Z_NULL;
-    stream.avail_in = 0;
-    stream.next_in = Z_NULL;
-
-    int ret = deflateInit(&stream, Z_BEST_COMPRESSION);
-    if (ret != Z_OK) {
-        std::cerr << "Error initializing compression" << std::endl;
+bool pngexpand(const uint8_t *src, size_t src_sz, uint8_t *dst, size_t dst_sz)
+{
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK)
         return false;
-    }
-
-    stream.next_in = src;
-    stream.avail_in = src_sz;
-    stream.next_out = dst;
-    stream.avail_out = dst_sz;
 
-    ret = deflate(&stream, Z_FINISH);
-    if (ret != Z_STREAM_END) {
-        std::cerr << "Error compressing data" << std::endl;
-        (void)deflateEnd(&stream);
-        return false;
-    }
-
-    (void)deflateEnd(&stream);
-
-    return true;
-}
\ No newline at end of file
+    stream.next_in = const_cast<Bytef*>(src);
+    stream.avail_in = static_cast<uInt>(src_sz);
+    // zlib does not accept null output, even if there's nothing to expand
+    Bytef dummy;
+    stream.next_out = dst ? dst : &dummy;
+    stream.avail_out = static_cast<uInt>(dst_sz);
+    const int ret = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    return (ret == Z_STREAM_END) && (stream.avail_out == 0);
+}
@@ -24,9 +24,10 @@
 namespace AGS { namespace Common { class Stream; } }
 using namespace AGS; // FIXME later
 
-bool pngcompress(Common::Stream* input, Common::Stream* output);
-// Expands lzw-compressed data from src to dst.
-// the dst buffer should be large enough, or the uncompression will not be complete.
+// Compresses the input stream using zlib's deflate, with the given compression level
+bool pngcompress(Common::Stream* input, Common::Stream* output, int level = Z_BEST_COMPRESSION);
+// Expands deflate-compressed data from src to dst.
+// Returns false unless the data is unpacked to exactly dst_sz bytes.
 bool pngexpand(const uint8_t* src, size_t src_sz, uint8_t* dst, size_t dst_sz);
 
 #endif // __AGS_CN_UTIL__PNG_H
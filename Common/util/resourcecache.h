@@ -26,17 +26,13 @@
 // TODO: support data Priority, which tells which items may be disposed
 // when adding new item and surpassing the cache limit.
 //
-// TODO: as an option, consider supporting a specialized container type that
-// has an associative container's interface, but is optimized for having most
-// keys allocated in large continious sequences by default.
-// This may be suitable for e.g. sprites, and may (or may not?) save some mem.
-//
-// Only for the reference: one of the ideas is for container to have a table
-// of arrays of fixed size internally. When getting an item the hash would be
-// first divided on array size to find the array the item resides in, then the
-// item is taken from item from slot index = (hash - arrsize * arrindex).
-// Find out if there is already a hash table kind that follows similar
-// principle.
+// DenseResourceCache is a variant of ResourceCache for the non-negative
+// integer keys, which are mostly allocated in large continuous sequences
+// (e.g. sprite indexes). It keeps items in a plain array of slots indexed
+// by key, and links them in MRU order using slot indexes, which avoids
+// allocating a hash node and a list node per item, and makes lookups a
+// simple array access. Has the same interface and management rules as the
+// ResourceCache.
 //
 //=============================================================================
 #ifndef __AGS_CN_UTIL__RESOURCECACHE_H
@@ -44,6 +40,7 @@
 
 #include <list>
 #include <unordered_map>
+#include <vector>
 #include "util/string.h"
 
 namespace AGS
@@ -203,14 +200,15 @@ public:
     // Disposes all items that are not locked or external
     void DisposeFreeItems()
     {
-        for (auto mru_it = _sectionLocked; mru_it != _mru.end(); ++mru_it)
+        // free items are the ones before the locked section
+        for (auto mru_it = _mru.begin(); mru_it != _sectionLocked;)
         {
             auto it = _storage.find(*mru_it);
             assert(it != _storage.end());
             auto &item = it->second;
             _cacheSize -= item.Size;
             _storage.erase(it);
-            _mru.erase(mru_it);
+            mru_it = _mru.erase(mru_it);
         }
     }
 
@@ -376,7 +374,310 @@ private:
     // Key-to-mru lookup map
     TStorage _storage;
     // Dummy value, return in case of a missing key
-    TValue  _dummy;
+    TValue  _dummy = TValue();
+};
+
+
+template <typename TKey, typename TValue, typename TSize = size_t>
+class DenseResourceCache
+{
+public:
+    // Flags determine management rules for the particular item
+    enum ItemFlags
+    {
+        // Locked items are temporarily saved from disposal when freeing cache space;
+        // they still count towards the cache size though.
+        kCacheItem_Locked   = 0x0001,
+        // External items are managed strictly by the external user;
+        // do not count towards the cache size, do not prevent caching normal items.
+        // They cannot be locked or released (considered permanently locked),
+        // only removed by request.
+        kCacheItem_External = 0x0002,
+    };
+
+    DenseResourceCache(TSize max_size = 0u)
+        : _maxSize(max_size)
+    {}
+
+    // Get the MRU cache size limit
+    inline size_t GetMaxCacheSize() const { return _maxSize; }
+    // Get the current total MRU cache size
+    inline size_t GetCacheSize() const { return _cacheSize; }
+    // Get the summed size of locked items (included in total cache size)
+    inline size_t GetLockedSize() const { return _lockedSize; }
+    // Get the summed size of external items (excluded from total cache size)
+    inline size_t GetExternalSize() const { return _externalSize; }
+
+    // Set the MRU cache size limit
+    void SetMaxCacheSize(TSize size)
+    {
+        _maxSize = size;
+        FreeMem(0u); // makes sure it does not exceed max size
+    }
+
+    // Tells if particular key is in the cache
+    bool Exists(const TKey &key) const
+    {
+        return FindSlot(key) != NoSlot;
+    }
+
+    // Gets the item with the given key if it exists;
+    // reorders the item as recently used.
+    const TValue &Get(const TKey &key)
+    {
+        const uint32_t slot = FindSlot(key);
+        if (slot == NoSlot)
+            return _dummy; // no such key
+
+        // Unless locked, move the item to the beginning of the MRU list
+        const auto &item = _slots[slot];
+        if (((item.Flags & kCacheItem_Locked) == 0) && (_mruFirst != slot))
+        {
+            Unlink(slot);
+            LinkFirst(slot);
+        }
+        return item.Value;
+    }
+
+    // Add particular item into the cache, disposes existing item if such key is already taken.
+    // If a new item will exceed the cache size limit, cache will remove oldest items
+    // in order to free mem.
+    void Put(const TKey &key, const TValue &value, uint32_t flags = 0u)
+    {
+        PutImpl(key, TValue(value), flags); // make a temp local copy for safe std::move
+    }
+
+    void Put(const TKey &key, TValue &&value, uint32_t flags = 0u)
+    {
+        PutImpl(key, std::move(value), flags);
+    }
+
+    // Locks the item with the given key,
+    // temporarily excluding it from MRU disposal rules
+    void Lock(const TKey &key)
+    {
+        const uint32_t slot = FindSlot(key);
+        if (slot == NoSlot)
+            return; // no such key
+        auto &item = _slots[slot];
+        if ((item.Flags & kCacheItem_Locked) != 0)
+            return; // already locked
+
+        // Lock item and exclude from the MRU list
+        item.Flags |= kCacheItem_Locked;
+        Unlink(slot);
+        _lockedSize += item.Size;
+    }
+
+    // Releases (unlocks) the item with the given key,
+    // adds it back to MRU disposal rules
+    void Release(const TKey &key)
+    {
+        const uint32_t slot = FindSlot(key);
+        if (slot == NoSlot)
+            return; // no such key
+
+        auto &item = _slots[slot];
+        if ((item.Flags & kCacheItem_External) != 0)
+            return; // never release external data, must be removed by user
+        if ((item.Flags & kCacheItem_Locked) == 0)
+            return; // not locked
+
+        // Unlock, and put the item to the beginning of the MRU list
+        item.Flags &= ~kCacheItem_Locked;
+        LinkFirst(slot);
+        _lockedSize -= item.Size;
+    }
+
+    // Deletes the cached item
+    void Dispose(const TKey &key)
+    {
+        const uint32_t slot = FindSlot(key);
+        if (slot == NoSlot)
+            return; // no such key
+        RemoveImpl(slot);
+    }
+
+    // Removes the item from the cache and returns to the caller.
+    TValue Remove(const TKey &key)
+    {
+        const uint32_t slot = FindSlot(key);
+        if (slot == NoSlot)
+            return TValue(); // no such key
+        TValue value = std::move(_slots[slot].Value);
+        RemoveImpl(slot);
+        return value;
+    }
+
+    // Disposes all items that are not locked or external
+    void DisposeFreeItems()
+    {
+        while (_mruFirst != NoSlot)
+            RemoveImpl(_mruFirst);
+    }
+
+    // Clear the cache, dispose all items
+    void Clear()
+    {
+        _slots.clear();
+        _mruFirst = NoSlot;
+        _mruLast = NoSlot;
+        _cacheSize = 0u;
+        _lockedSize = 0u;
+        _externalSize = 0u;
+    }
+
+protected:
+    // Calculates item size; expects to return 0 if an item is invalid
+    // and should not be added to the cache.
+    virtual TSize CalcSize(const TValue &item) = 0;
+
+private:
+    // Slot index type, and a special value meaning "no slot"
+    static const uint32_t NoSlot = UINT32_MAX;
+    // Internal flag telling that the slot has an item
+    static const uint32_t kCacheItem_InUse = 0x80000000;
+
+    struct TItem
+    {
+        TValue       Value;
+        TSize        Size = 0u;
+        uint32_t     Flags = 0u; // flags determine management rules for this item
+        uint32_t     MruPrev = NoSlot; // previous (more recently used) item
+        uint32_t     MruNext = NoSlot; // next (less recently used) item
+    };
+
+    // Returns slot index of an existing item, or NoSlot
+    uint32_t FindSlot(const TKey &key) const
+    {
+        const size_t slot = static_cast<size_t>(key);
+        if ((slot >= _slots.size()) || ((_slots[slot].Flags & kCacheItem_InUse) == 0))
+            return NoSlot;
+        return static_cast<uint32_t>(slot);
+    }
+    // Puts item into the beginning of the MRU list
+    void LinkFirst(uint32_t slot)
+    {
+        auto &item = _slots[slot];
+        item.MruPrev = NoSlot;
+        item.MruNext = _mruFirst;
+        if (_mruFirst != NoSlot)
+            _slots[_mruFirst].MruPrev = slot;
+        else
+            _mruLast = slot;
+        _mruFirst = slot;
+    }
+    // Excludes item from the MRU list
+    void Unlink(uint32_t slot)
+    {
+        auto &item = _slots[slot];
+        if (item.MruPrev != NoSlot)
+            _slots[item.MruPrev].MruNext = item.MruNext;
+        else if (_mruFirst == slot)
+            _mruFirst = item.MruNext;
+        if (item.MruNext != NoSlot)
+            _slots[item.MruNext].MruPrev = item.MruPrev;
+        else if (_mruLast == slot)
+            _mruLast = item.MruPrev;
+        item.MruPrev = item.MruNext = NoSlot;
+    }
+    // Add particular item into the cache.
+    // If a new item will exceed the cache size limit, cache will remove oldest items
+    // in order to free mem.
+    void PutImpl(const TKey &key, TValue &&value, uint32_t flags)
+    {
+        if (_maxSize == 0)
+            return; // cache is disabled
+        const size_t slot = static_cast<size_t>(key);
+        if (slot >= NoSlot)
+            return; // key is out of supported range (or negative)
+        // Remove previous cached item
+        if (FindSlot(key) != NoSlot)
+            RemoveImpl(static_cast<uint32_t>(slot));
+
+        // Request item's size, and test if it's a valid item
+        TSize size = CalcSize(value);
+        if (size == 0u)
+            return; // invalid item
+
+        if ((flags & kCacheItem_External) == 0)
+        {
+            // clear up space before adding
+            if (_cacheSize + size > _maxSize)
+                FreeMem(size);
+            _cacheSize += size;
+            if ((flags & kCacheItem_Locked) != 0)
+                _lockedSize += size;
+        }
+        else
+        {
+            // always mark external data as locked, easier to handle
+            flags |= kCacheItem_Locked;
+            _externalSize += size;
+        }
+
+        if (slot >= _slots.size())
+            _slots.resize(slot + 1);
+        auto &item = _slots[slot];
+        item.Value = std::move(value);
+        item.Size = size;
+        item.Flags = (flags & ~kCacheItem_InUse) | kCacheItem_InUse;
+        // only normal unlocked items are added to MRU list at all
+        if ((flags & kCacheItem_Locked) == 0)
+            LinkFirst(static_cast<uint32_t>(slot));
+    }
+    // Removes the item from the container
+    void RemoveImpl(uint32_t slot)
+    {
+        auto &item = _slots[slot];
+        // normal items are removed from MRU, and discounted from cache size
+        if ((item.Flags & kCacheItem_External) == 0)
+        {
+            _cacheSize -= item.Size;
+            if ((item.Flags & kCacheItem_Locked) != 0)
+                _lockedSize -= item.Size;
+            else
+                Unlink(slot);
+        }
+        else
+        {
+            _externalSize -= item.Size;
+        }
+        item = TItem();
+    }
+    // Keep disposing oldest elements until cache has at least the given free space
+    void FreeMem(size_t space)
+    {
+        while ((_mruLast != NoSlot) && (_cacheSize + space > _maxSize))
+        {
+            RemoveImpl(_mruLast);
+        }
+    }
+
+
+    // Size of tracked data stored in this cache;
+    // note that this is an abstract value, which may or not refer to an
+    // actual size in bytes, and depends on the implementation.
+    TSize _cacheSize = 0u;
+    // Size of data locked (forbidden from disposal),
+    // this size is *included* in _cacheSize; provided for stats.
+    TSize _lockedSize = 0u;
+    // Size of the external data, that is - data that does not count towards
+    // cache limit, and which is not our reponsibility; provided for stats.
+    TSize _externalSize = 0u;
+    // Maximal size of tracked data.
+    // When the inserted item increases the cache size past this limit,
+    // the cache will try to free the space by removing oldest items.
+    // "External" data does not count towards this limit.
+    TSize _maxSize = 0u;
+    // Item slots, indexed by key
+    std::vector<TItem> _slots;
+    // MRU list ends: most and least recently used unlocked items;
+    // locked and external items are not included in the list.
+    uint32_t _mruFirst = NoSlot;
+    uint32_t _mruLast = NoSlot;
+    // Dummy value, return in case of a missing key
+    TValue  _dummy = TValue();
 };
 
 } // namespace Common
@@ -701,6 +701,10 @@ builtin struct Room {
   /// Checks if the specified room exists
   import static bool Exists(int room);   // $AUTOCOMPLETESTATICONLY$
 #endif
+#ifdef SCRIPT_API_v361
+  /// Starts loading the specified room in background, so that entering it later is faster
+  import static void Preload(int room);   // $AUTOCOMPLETESTATICONLY$
+#endif
 };
 
 builtin struct Parser {
@@ -1625,6 +1629,7 @@ enum EventType {
 #ifdef SCRIPT_API_v361
   eEventLeaveRoomAfterFadeout = 11,
   eEventGameSaved = 12,
+  eEventGameSaveCompleted = 13,
 #endif
 };
 
@@ -2869,6 +2874,8 @@ builtin struct Game {
 #ifdef SCRIPT_API_v361
   /// Resets all of the "DoOnceOnly" token states
   import static bool   ResetDoOnceOnly();
+  /// Starts loading the sprite in background, so that it's ready by the time it's displayed.
+  import static void   PrefetchSprite(int spriteSlot);
 #endif
 };
 
@@ -242,6 +242,7 @@ void Character_ChangeRoomSetLoop(CharacterInfo *chaa, int room, int x, int y, in
         }
         chaa->prevroom = chaa->room;
         chaa->room = room;
+        invalidate_room_characters();
 
 		debug_script_log("%s moved to room %d, location %d,%d, loop %d",
 			chaa->scrname, room, chaa->x, chaa->y, chaa->loop);
@@ -2142,6 +2143,7 @@ void animate_character(CharacterInfo *chap, int loopn, int sppd, int rept,
         chap->scrname, chap->view+1, loopn, sppd, rept, sframe);
 
     Character_StopMoving(chap);
+    prefetch_view_loop(chap->view, loopn);
 
     chap->set_animating(rept != 0, direction == 0, sppd);
     chap->loop=loopn;
@@ -2235,48 +2237,86 @@ void update_character_scale(int charid)
     chex.zoom = zoom;
 }
 
+// Characters in the displayed room
+static std::vector<int> room_chars;
+static int room_chars_room = -1;
+static unsigned int room_chars_frame = 0u;
+static bool room_chars_valid = false;
+
+const std::vector<int> &get_room_characters() {
+    // The list is also rebuilt every frame, because the character's room
+    // may be changed by the plugins, or when restoring a save
+    if (room_chars_valid && (room_chars_room == displayed_room) && (room_chars_frame == loopcounter))
+        return room_chars;
+    room_chars.clear();
+    for (int cc = 0; cc < game.numcharacters; ++cc) {
+        if (game.chars[cc].room == displayed_room)
+            room_chars.push_back(cc);
+    }
+    room_chars_room = displayed_room;
+    room_chars_frame = loopcounter;
+    room_chars_valid = true;
+    return room_chars;
+}
+
+void invalidate_room_characters() {
+    room_chars_valid = false;
+}
+
 int is_pos_on_character(int xx,int yy) {
-    int cc,sppic,lowestyp=0,lowestwas=-1;
-    for (cc=0;cc<game.numcharacters;cc++) {
-        if (game.chars[cc].room!=displayed_room) continue;
-        if (game.chars[cc].on==0) continue;
-        if (game.chars[cc].flags & CHF_NOINTERACT) continue;
-        if (game.chars[cc].view < 0) continue;
+    // First select characters which bounding box contains the position,
+    // then test their images starting with the one drawn on top;
+    // this way only the images of the characters under the cursor are retrieved.
+    static std::vector<SpriteHitCandidate> candidates;
+    candidates.clear();
+    for (int cc : get_room_characters()) {
         CharacterInfo*chin=&game.chars[cc];
-
+        if (chin->on==0) continue;
+        if (chin->flags & CHF_NOINTERACT) continue;
         if ((chin->view < 0) || 
             (chin->loop >= views[chin->view].numLoops) ||
             (chin->frame >= views[chin->view].loops[chin->loop].numFrames))
         {
             continue;
         }
+        // characters with negative baseline are never selected
+        int use_base = chin->get_baseline();
+        if (use_base < 0) continue;
 
-        sppic=views[chin->view].loops[chin->loop].frames[chin->frame].pic;
+        const ViewFrame &vf = views[chin->view].loops[chin->loop].frames[chin->frame];
         int usewid = charextra[cc].width;
         int usehit = charextra[cc].height;
-        if (usewid==0) usewid=game.SpriteInfos[sppic].Width;
-        if (usehit==0) usehit= game.SpriteInfos[sppic].Height;
-        int xxx = chin->x - game_to_data_coord(usewid) / 2;
-        int yyy = chin->get_effective_y() - game_to_data_coord(usehit);
-        int mirrored = views[chin->view].loops[chin->loop].frames[chin->frame].flags & VFLG_FLIPSPRITE;
+        if (usewid==0) usewid=game.SpriteInfos[vf.pic].Width;
+        if (usehit==0) usehit= game.SpriteInfos[vf.pic].Height;
+        SpriteHitCandidate c;
+        c.Id = cc;
+        c.Baseline = use_base;
+        c.X = chin->x - game_to_data_coord(usewid) / 2;
+        c.Y = chin->get_effective_y() - game_to_data_coord(usehit);
+        c.Width = game_to_data_coord(usewid);
+        c.Height = game_to_data_coord(usehit);
+        c.Flipped = (vf.flags & VFLG_FLIPSPRITE) != 0;
+        // zero size means that the size is taken from the image, see is_pos_in_sprite
+        if ((c.Width > 0) && (c.Height > 0) &&
+            !isposinbox(xx, yy, c.X, c.Y, c.X + c.Width, c.Y + c.Height))
+            continue;
+        candidates.push_back(c);
+    }
 
+    sort_hit_candidates(candidates);
+    for (const auto &c : candidates) {
         bool is_original;
-        Bitmap *theImage = GetCharacterImage(cc, &is_original);
-        if (!is_original)
-            mirrored = 0; // transformed image is already flipped
-
-        if (is_pos_in_sprite(xx,yy,xxx,yyy, theImage,
-            game_to_data_coord(usewid),
-            game_to_data_coord(usehit), mirrored, is_original) == FALSE)
+        Bitmap *theImage = GetCharacterImage(c.Id, &is_original);
+        // transformed image is already flipped
+        int mirrored = (c.Flipped && is_original) ? 1 : 0;
+        if (is_pos_in_sprite(xx, yy, c.X, c.Y, theImage,
+            c.Width, c.Height, mirrored, is_original) == FALSE)
             continue;
-
-        int use_base = chin->get_baseline();
-        if (use_base < lowestyp) continue;
-        lowestyp=use_base;
-        lowestwas=cc;
+        char_lowest_yp = c.Baseline;
+        return c.Id;
     }
-    char_lowest_yp = lowestyp;
-    return lowestwas;
+    char_lowest_yp = 0;
+    return -1;
 }
 
 void get_char_blocking_rect(int charid, int *x1, int *y1, int *width, int *y2) {
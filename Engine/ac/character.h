@@ -18,6 +18,7 @@
 #ifndef __AGS_EE_AC__CHARACTER_H
 #define __AGS_EE_AC__CHARACTER_H
 
+#include <vector>
 #include "ac/characterinfo.h"
 #include "ac/characterextras.h"
 #include "ac/dynobj/scriptobject.h"
@@ -196,6 +197,11 @@ CharacterInfo *GetCharacterAtScreen(int xx, int yy);
 void update_character_scale(int charid);
 // Get character ID at the given room coordinates
 int is_pos_on_character(int xx,int yy);
+// Gets the list of characters in the displayed room; the list is cached,
+// and rebuilt each game frame, or after invalidate_room_characters is called
+const std::vector<int> &get_room_characters();
+// Tells that some character could have changed its room
+void invalidate_room_characters();
 void get_char_blocking_rect(int charid, int *x1, int *y1, int *width, int *y2);
 // Check whether the source char has walked onto character ww
 int is_char_on_another (int sourceChar, int ww, int*fromxptr, int*cwidptr);
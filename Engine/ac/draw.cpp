@@ -48,6 +48,7 @@
 #include "ac/dynobj/scriptsystem.h"
 #include "debug/debugger.h"
 #include "debug/debug_log.h"
+#include "debug/profiler.h"
 #include "font/fonts.h"
 #include "gui/guimain.h"
 #include "gui/guiobject.h"
@@ -311,6 +312,14 @@ std::vector<ObjTexture> walkbehindobj;
 std::vector<ObjTexture> guibg;
 // GUI render texture, for rendering all controls on same texture buffer
 std::vector<IDriverDependantBitmap*> gui_render_tex;
+// Tells that GUI render texture has to be recomposed, because
+// the GUI itself or any of its controls have changed since the last time
+std::vector<bool> gui_render_dirty;
+// Number of GUIs recomposed on their render textures during the last frame
+static size_t gui_recompose_count = 0u;
+// Last seen render target reset count of the graphics driver; when it changes,
+// the GUI render textures have lost their contents and must be recomposed
+static uint32_t gui_render_reset_count = 0u;
 // GUI control surfaces
 std::vector<ObjTexture> guiobjbg;
 // first control texture index of each GUI
@@ -719,6 +728,7 @@ void init_game_drawdata()
 
     guibg.resize(game.numgui);
     gui_render_tex.resize(game.numgui);
+    gui_render_dirty.resize(game.numgui, true);
     size_t guio_num = 0;
     // Prepare GUI cache lists and build the quick reference for controls cache
     guiobjddbref.resize(game.numgui);
@@ -741,6 +751,7 @@ void dispose_game_drawdata()
     texturecache_clear();
     guibg.clear();
     gui_render_tex.clear();
+    gui_render_dirty.clear();
     guiobjbg.clear();
     guiobjddbref.clear();
 }
@@ -1152,6 +1163,7 @@ void render_to_screen()
             System_SetVSyncInternal(new_vsync);
     }
 
+    AGS_PROFILE_ZONE("Present");
     bool succeeded = false;
     while (!succeeded && !want_exit && !abort_engine)
     {
@@ -2277,8 +2289,13 @@ void draw_fps(const Rect &viewport)
     }
     wouttext_outline(fpsDisplay, 1, 1, font, text_color, fps_buffer);
 
-    char loop_buffer[60];
-    snprintf(loop_buffer, sizeof(loop_buffer), "Loop %u", loopcounter);
+    char loop_buffer[80];
+    const size_t draw_calls = gfxDriver->GetDrawCallCount();
+    if (draw_calls > 0)
+        snprintf(loop_buffer, sizeof(loop_buffer), "Loop %u, draw calls %zu, GUI redraws %zu",
+            loopcounter, draw_calls, gui_recompose_count);
+    else
+        snprintf(loop_buffer, sizeof(loop_buffer), "Loop %u, GUI redraws %zu", loopcounter, gui_recompose_count);
     wouttext_outline(fpsDisplay, viewport.GetWidth() / 2, 1, font, text_color, loop_buffer);
 
     if (ddb)
@@ -2290,6 +2307,54 @@ void draw_fps(const Rect &viewport)
     invalidate_sprite_glob(1, yp, ddb);
 }
 
+#if AGS_PROFILER
+void draw_profiler_stats(const Rect &viewport)
+{
+    static IDriverDependantBitmap* ddb = nullptr;
+    static Bitmap *statsDisplay = nullptr;
+    const int font = FONT_NORMAL;
+    const auto &stats = Profiler::GetStats();
+    const int line_height = get_font_linespacing(font);
+    const int line_count = 1 + stats.Zones.size() + stats.Counters.size();
+    const int width = viewport.GetWidth() / 2;
+    const int height = std::min(viewport.GetHeight(), line_count * line_height + 2);
+    if (!statsDisplay || (statsDisplay->GetWidth() != width) || (statsDisplay->GetHeight() != height))
+    {
+        if (ddb)
+            gfxDriver->DestroyDDB(ddb);
+        ddb = nullptr;
+        delete statsDisplay;
+        statsDisplay = CreateCompatBitmap(width, height);
+    }
+    statsDisplay->ClearTransparent();
+
+    color_t text_color = statsDisplay->GetCompatibleColor(14);
+    int yp = 1;
+    wouttext_outline(statsDisplay, 1, yp, font, text_color,
+        String::FromFormat("Frame: %.2f ms", stats.FrameMs).GetCStr());
+    for (const auto &zone : stats.Zones)
+    {
+        yp += line_height;
+        wouttext_outline(statsDisplay, 1, yp, font, text_color,
+            String::FromFormat("%s: %.2f ms (x%.1f)", zone.Name, zone.TimeMs, zone.Calls).GetCStr());
+    }
+    for (const auto &counter : stats.Counters)
+    {
+        yp += line_height;
+        wouttext_outline(statsDisplay, 1, yp, font, text_color,
+            String::FromFormat("%s: %.1f", counter.Name, counter.Value).GetCStr());
+    }
+
+    if (ddb)
+        gfxDriver->UpdateDDBFromBitmap(ddb, statsDisplay, false);
+    else
+        ddb = gfxDriver->CreateDDBFromBitmap(statsDisplay, false);
+    int xp = viewport.GetWidth() - width;
+    gfxDriver->DrawSprite(xp, 0, ddb);
+    invalidate_sprite_glob(xp, 0, ddb);
+}
+#endif // AGS_PROFILER
+
 // Draw GUI controls as separate sprites, each on their own texture
 static void construct_guictrl_tex(GUIMain &gui)
 {
@@ -2352,6 +2417,7 @@ static void draw_gui_controls_batch(int gui_id)
 // Draw GUI and overlays of all kinds, anything outside the room space
 void draw_gui_and_overlays()
 {
+    AGS_PROFILE_ZONE("GUI");
     // Draw gui controls on separate textures if:
     // - it is a 3D renderer (software one may require adjustments -- needs testing)
     // - not legacy alpha blending (may we implement specific texture blend?)
@@ -2376,6 +2442,7 @@ void draw_gui_and_overlays()
     }
 
     // Add GUIs
+    gui_recompose_count = 0u;
     our_eip=35;
     if (((debug_flags & DBG_NOIFACE)==0) && (displayed_room >= 0)) {
         if (playerchar->activeinv >= MAX_INV) {
@@ -2399,6 +2466,8 @@ void draw_gui_and_overlays()
                 const bool draw_with_controls = !draw_controls_as_textures;
                 if (gui.HasChanged() || (draw_with_controls && gui.HasControlsChanged()))
                 {
+                    AGS_PROFILE_ZONE("GUI redraw");
+                    AGS_PROFILE_COUNT("GUI redraws", 1);
                     auto &gbg = guibg[index];
                     recycle_bitmap(gbg.Bmp, game.GetColorDepth(), gui.Width, gui.Height, true);
                     if (draw_with_controls)
@@ -2427,10 +2496,18 @@ void draw_gui_and_overlays()
 
                 our_eip = 374;
 
+                gui_render_dirty[index] = true;
                 gui.ClearChanged();
             }
         }
         our_eip = 38;
+        // Recompose all GUIs if the render targets were recreated by the driver
+        const uint32_t rt_reset_count = gfxDriver->GetRenderTargetResetCount();
+        if (gui_render_reset_count != rt_reset_count)
+        {
+            gui_render_dirty.assign(gui_render_dirty.size(), true);
+            gui_render_reset_count = rt_reset_count;
+        }
         // Draw the GUIs
         for (int index = 0; index < game.numgui; ++index)
         {
@@ -2449,10 +2526,21 @@ void draw_gui_and_overlays()
             if (!gui_ddb) continue;
             if (draw_controls_as_textures)
             {
-                gui_render_tex[index] = recycle_render_target(gui_render_tex[index],
+                auto *&gui_rtex = gui_render_tex[index];
+                // New render texture must always be composed
+                if (!gui_rtex || (gui_rtex->GetWidth() != gui_ddb->GetWidth()) ||
+                    (gui_rtex->GetHeight() != gui_ddb->GetHeight()))
+                    gui_render_dirty[index] = true;
+                gui_rtex = recycle_render_target(gui_rtex,
                     gui_ddb->GetWidth(), gui_ddb->GetHeight(), gui_ddb->GetColorDepth(), false);
-                // Render control textures onto the GUI texture
-                draw_gui_controls_batch(index);
+                // Render control textures onto the GUI texture, but only if anything
+                // has changed; otherwise the render texture keeps last composed image
+                if (gui_render_dirty[index])
+                {
+                    draw_gui_controls_batch(index);
+                    gui_render_dirty[index] = false;
+                    gui_recompose_count++;
+                }
                 // Replace gui bg ddb with a render target texture,
                 // and push it to the sprite list instead
                 gui_ddb = gui_render_tex[index];
@@ -2653,6 +2741,7 @@ static void construct_overlays()
 
 void construct_game_scene(bool full_redraw)
 {
+    AGS_PROFILE_ZONE("Scene");
     gfxDriver->ClearDrawLists();
 
     if (play.fast_forward)
@@ -2787,6 +2876,10 @@ void construct_engine_overlay()
 
     if (display_fps != kFPS_Hide)
         draw_fps(viewport);
+#if AGS_PROFILER
+    if (display_profiler)
+        draw_profiler_stats(viewport);
+#endif
 
     gfxDriver->EndSpriteBatch();
 }
@@ -13,6 +13,7 @@
 //=============================================================================
 #include "ac/dynobj/cc_character.h"
 #include "ac/dynobj/dynobj_manager.h"
+#include "ac/character.h"
 #include "ac/characterinfo.h"
 #include "ac/global_character.h"
 #include "ac/gamesetupstruct.h"
@@ -221,7 +222,7 @@ void CCCharacter::WriteInt32(void *address, intptr_t offset, int32_t val)
     case 0: ci->defview = val; break;
     case 4: ci->talkview = val; break;
     case 8: ci->view = val; break;
-    case 12: ci->room = val; break;
+    case 12: ci->room = val; invalidate_room_characters(); break;
     case 16: ci->prevroom = val; break;
     case 20: ci->x = val; break;
     case 24:  ci->y = val; break;
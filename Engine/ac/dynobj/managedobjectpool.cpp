@@ -14,6 +14,7 @@
 #include <vector>
 #include <string.h>
 #include "ac/dynobj/managedobjectpool.h"
+#include "ac/timer.h"
 #include "debug/out.h"
 #include "util/string_utils.h"               // fputstring, etc
 #include "script/cc_common.h"
@@ -25,13 +26,17 @@ const auto OBJECT_CACHE_MAGIC_NUMBER = 0xa30b;
 const auto SERIALIZE_BUFFER_SIZE = 10240;
 const auto GARBAGE_COLLECTION_INTERVAL = 1024;
 const auto RESERVED_SIZE = 2048;
+// how often to test the time budget, in number of processed gc candidates
+const auto GARBAGE_COLLECTION_CLOCK_CHECK = 64;
 
 int ManagedObjectPool::Remove(ManagedObject &o, bool force) {
     const bool can_remove = o.callback->Dispose(o.addr, force) != 0;
-    if (!(can_remove || force))
+    if (!(can_remove || force)) {
+        AddGCCandidate(o); // retry on the next garbage collection
         return 0;
+    }
 
-    available_ids.push(o.handle);
+    available_ids.push_back(o.handle);
     handleByAddress.erase(o.addr);
     ManagedObjectLog("Line %d Disposed managed object handle=%d", currentline, o.handle);
     o = ManagedObject();
@@ -66,8 +71,11 @@ int32_t ManagedObjectPool::SubRef(int32_t handle) {
     o.refCount--;
     const auto newRefCount = o.refCount;
     const auto canBeDisposed = (o.addr != disableDisposeForObject);
-    if (canBeDisposed && o.refCount <= 0) {
-        Remove(o);
+    if (o.refCount <= 0) {
+        if (canBeDisposed)
+            Remove(o);
+        else
+            AddGCCandidate(o);
     }
     // object could be removed at this point, don't use any values.
     ManagedObjectLog("Line %d SubRef: handle=%d new refcount=%d canBeDisposed=%d", currentline, handle, newRefCount, canBeDisposed);
@@ -112,23 +120,55 @@ int ManagedObjectPool::RemoveObject(void *address) {
     return Remove(o, true);
 }
 
+void ManagedObjectPool::AddGCCandidate(ManagedObject &o)
+{
+    if (o.gcCandidate) { return; }
+    o.gcCandidate = true;
+    gcCandidates.push_back(o.handle);
+}
+
 void ManagedObjectPool::RunGarbageCollectionIfAppropriate()
 {
     if (objectCreationCounter <= GARBAGE_COLLECTION_INTERVAL) { return; }
-    RunGarbageCollection();
-    objectCreationCounter = 0;
+    // if collection did not finish in time, it will continue on the next call
+    if (RunGarbageCollection(gcTimeBudget)) {
+        objectCreationCounter = 0;
+    }
 }
 
-void ManagedObjectPool::RunGarbageCollection()
+void ManagedObjectPool::SetGarbageCollectionBudget(std::chrono::microseconds time_budget)
 {
-    for (int i = 1; i < nextHandle; i++) {
-        auto & o = objects[i];
-        if (!o.isUsed()) { continue; }
-        if (o.refCount < 1) {
-            Remove(o);
+    gcTimeBudget = time_budget;
+}
+
+bool ManagedObjectPool::RunGarbageCollection(std::chrono::microseconds time_budget)
+{
+    const auto start = AGS_FastClock::now();
+    // NOTE: disposing objects may add new candidates to the list, so iterate by index
+    while (gcNextCandidate < gcCandidates.size()) {
+        const int32_t handle = gcCandidates[gcNextCandidate++];
+        auto & o = objects[handle];
+        if (o.isUsed() && o.gcCandidate) {
+            if (o.refCount >= 1) {
+                o.gcCandidate = false; // referenced again
+            } else if (!Remove(o)) {
+                gcPending.push_back(handle); // disposal refused, try next time
+            }
+        }
+
+        if ((time_budget > std::chrono::microseconds::zero()) &&
+            (gcNextCandidate % GARBAGE_COLLECTION_CLOCK_CHECK == 0) &&
+            (AGS_FastClock::now() - start > time_budget)) {
+            ManagedObjectLog("Garbage collection paused, %zu candidates left", gcCandidates.size() - gcNextCandidate);
+            return false;
         }
     }
+
+    gcCandidates.swap(gcPending);
+    gcPending.clear();
+    gcNextCandidate = 0;
     ManagedObjectLog("Ran garbage collection");
+    return true;
 }
 
 int ManagedObjectPool::Add(int handle, void *address, IScriptObject *callback, ScriptValueType obj_type)
@@ -139,6 +179,8 @@ int ManagedObjectPool::Add(int handle, void *address, IScriptObject *callback, S
     o = ManagedObject(obj_type, handle, address, callback);
 
     handleByAddress.insert({address, handle});
+    // new objects are not referenced yet
+    AddGCCandidate(o);
     ManagedObjectLog("Allocated managed object type=%s, handle=%d, addr=%08X", callback->GetType(), handle, address);
     return handle;
 }
@@ -148,8 +190,8 @@ int ManagedObjectPool::AddObject(void *address, IScriptObject *callback, ScriptV
     int32_t handle;
 
     if (!available_ids.empty()) {
-        handle = available_ids.front();
-        available_ids.pop();
+        handle = available_ids.back();
+        available_ids.pop_back();
     } else {
         handle = nextHandle++;
         if ((size_t)handle >= objects.size()) {
@@ -277,7 +319,7 @@ int ManagedObjectPool::ReadFromDisk(Stream *in, ICCObjectCollectionReader *reade
     }
 
     // re-adjust next handles. (in case saved in random order)
-    available_ids = std::queue<int32_t>();
+    available_ids.clear();
     nextHandle = 1;
 
     for (const auto &o : objects) {
@@ -285,9 +327,10 @@ int ManagedObjectPool::ReadFromDisk(Stream *in, ICCObjectCollectionReader *reade
             nextHandle = o.handle + 1;
         }
     }
-    for (int i = 1; i < nextHandle; i++) {
+    // push in reverse, so that the lower handles are reused first
+    for (int i = nextHandle - 1; i >= 1; i--) {
         if (!objects[i].isUsed()) {
-            available_ids.push(i);
+            available_ids.push_back(i);
         }
     }
 
@@ -301,7 +344,10 @@ void ManagedObjectPool::reset() {
         if (!o.isUsed()) { continue; }
         Remove(o, true);
     }
-    available_ids = std::queue<int32_t>();
+    available_ids.clear();
+    gcCandidates.clear();
+    gcPending.clear();
+    gcNextCandidate = 0;
     nextHandle = 1;
 }
 
@@ -15,8 +15,8 @@
 #ifndef __CC_MANAGEDOBJECTPOOL_H
 #define __CC_MANAGEDOBJECTPOOL_H
 
+#include <chrono>
 #include <vector>
-#include <queue>
 #include <unordered_map>
 
 #include "core/platform.h"
@@ -35,25 +35,40 @@ private:
         void *addr;
         IScriptObject *callback;
         int refCount;
+        bool gcCandidate; // is registered in the garbage collection candidates
 
         bool isUsed() const { return obj_type != kScValUndefined; }
 
         ManagedObject() 
-            : obj_type(kScValUndefined), handle(0), addr(nullptr), callback(nullptr), refCount(0) {}
+            : obj_type(kScValUndefined), handle(0), addr(nullptr), callback(nullptr), refCount(0), gcCandidate(false) {}
         ManagedObject(ScriptValueType obj_type, int32_t handle, void *addr, IScriptObject * callback) 
-            : obj_type(obj_type), handle(handle), addr(addr), callback(callback), refCount(0) {}
+            : obj_type(obj_type), handle(handle), addr(addr), callback(callback), refCount(0), gcCandidate(false) {}
     };
 
     int objectCreationCounter;  // used to do garbage collection every so often
 
     int32_t nextHandle {}; // TODO: manage nextHandle's going over INT32_MAX !
-    std::queue<int32_t> available_ids;
+    // Free handles, reused in the LIFO order, so that the recently
+    // released handles (which are likely still in cache) are taken first
+    std::vector<int32_t> available_ids;
     std::vector<ManagedObject> objects;
     std::unordered_map<void*, int32_t> handleByAddress;
+    // Handles of objects which had their ref count at zero at some point;
+    // garbage collection only has to check these, and not the whole pool.
+    // May contain handles of the objects which are referenced again, or
+    // already disposed, these are skipped during collection.
+    std::vector<int32_t> gcCandidates;
+    std::vector<int32_t> gcPending; // candidates which could not be disposed yet
+    size_t gcNextCandidate {}; // continue incremental collection from this index
+    // Max time spent in one garbage collection step, zero means no limit
+    std::chrono::microseconds gcTimeBudget {};
 
     int  Add(int handle, void *address, IScriptObject *callback, ScriptValueType obj_type);
     int  Remove(ManagedObject &o, bool force = false);
-    void RunGarbageCollection();
+    void AddGCCandidate(ManagedObject &o);
+    // Checks the candidates and disposes unreferenced objects;
+    // returns whether all the candidates were processed
+    bool RunGarbageCollection(std::chrono::microseconds time_budget = std::chrono::microseconds::zero());
 
 public:
 
@@ -65,6 +80,9 @@ public:
     ScriptValueType HandleToAddressAndManager(int32_t handle, void *&object, IScriptObject *&manager);
     int RemoveObject(void *address);
     void RunGarbageCollectionIfAppropriate();
+    // Sets the max time which a single garbage collection step may take;
+    // the remaining objects are checked in the next steps. Zero means no limit.
+    void SetGarbageCollectionBudget(std::chrono::microseconds time_budget);
     int AddObject(void *address, IScriptObject *callback, ScriptValueType obj_type);
     int AddUnserializedObject(void *address, IScriptObject *callback, ScriptValueType obj_type, int handle);
     void WriteToDisk(Common::Stream *out);
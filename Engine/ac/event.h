@@ -34,6 +34,7 @@
 #define GE_ENTER_ROOM_AFTERFADE 10
 #define GE_LEAVE_ROOM_AFTERFADE 11
 #define GE_SAVE_GAME     12
+#define GE_SAVE_GAME_COMPLETED 13
 
 // Game event types:
 // common script callback
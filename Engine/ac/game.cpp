@@ -39,6 +39,7 @@
 #include "ac/overlay.h"
 #include "ac/path_helper.h"
 #include "ac/sys_events.h"
+#include "ac/room.h"
 #include "ac/roomstatus.h"
 #include "ac/sprite.h"
 #include "ac/spritecache.h"
@@ -484,6 +485,7 @@ void unload_game_file()
     scrGui.clear();
 
     resetRoomStatuses();
+    reset_room_preloader();
 
     // Free game state and game struct
     play = GameState();
@@ -822,6 +824,11 @@ int Game_BlockingWaitSkipped()
     return play.GetWaitSkipResult();
 }
 
+void Game_PrefetchSprite(int sprnum)
+{
+    spriteset.Prefetch(sprnum);
+}
+
 //=============================================================================
 
 // save game functions
@@ -909,6 +916,9 @@ Bitmap *create_savegame_screenshot()
     return CopyScreenIntoBitmap(usewid, usehit);
 }
 
+// slot of the save being written in background
+static int background_save_slot = -1;
+
 void save_game(int slotn, const char*descript) {
 
     // dont allow save in rep_exec_always, because we dont save
@@ -932,17 +942,60 @@ void save_game(int slotn, const char*descript) {
     if (game.options[OPT_SAVESCREENSHOT] != 0)
         screenShot.reset(create_savegame_screenshot());
 
-    std::unique_ptr<Stream> out(StartSavegame(nametouse, descript, screenShot.get()));
-    if (out == nullptr)
+    // report the previous background save first, as its slot is overwritten here
+    WaitBackgroundSave();
+    update_background_save();
+
+    bool in_background = false;
+    if (usetup.IncrementalSaves || usetup.BackgroundSaves ||
+        (usetup.SaveCompression != kSvgCompress_None))
     {
-        Display("ERROR: Unable to open savegame file for writing!");
-        return;
+        SavegameWriteOptions opts;
+        opts.Compression = usetup.SaveCompression;
+        opts.Incremental = usetup.IncrementalSaves;
+        opts.MaxChain = static_cast<size_t>(usetup.IncrementalSaveChain);
+        opts.Background = usetup.BackgroundSaves;
+        HSaveError err = WriteSavegame(nametouse, descript, screenShot.get(), opts);
+        if (!err)
+        {
+            Debug::Printf(kDbgMsg_Error, "Unable to write savegame.\n%s", err->FullMessage().GetCStr());
+            Display("ERROR: Unable to open savegame file for writing!");
+            return;
+        }
+        in_background = opts.Background;
     }
+    else
+    {
+        std::unique_ptr<Stream> out(StartSavegame(nametouse, descript, screenShot.get()));
+        if (out == nullptr)
+        {
+            Display("ERROR: Unable to open savegame file for writing!");
+            return;
+        }
 
-    // Save dynamic game data
-    SaveGameState(out.get());
+        // Save dynamic game data
+        SaveGameState(out.get());
+    }
     // call "After Save" event callback
     run_on_event(GE_SAVE_GAME, RuntimeScriptValue().SetInt32(slotn));
+    if (in_background)
+        background_save_slot = slotn;
+    else
+        run_on_event(GE_SAVE_GAME_COMPLETED, RuntimeScriptValue().SetInt32(slotn));
+}
+
+void update_background_save()
+{
+    HSaveError err;
+    if (!PollBackgroundSave(err))
+        return;
+    if (!err)
+    {
+        Debug::Printf(kDbgMsg_Error, "Unable to write savegame.\n%s", err->FullMessage().GetCStr());
+        Display("ERROR: Unable to write savegame file!");
+        return;
+    }
+    run_on_event(GE_SAVE_GAME_COMPLETED, RuntimeScriptValue().SetInt32(background_save_slot));
 }
 
 int gameHasBeenRestored = 0;
@@ -950,6 +1003,7 @@ int oldeip;
 
 bool read_savedgame_description(const String &savedgame, String &description)
 {
+    WaitBackgroundSave();
     SavegameDescription desc;
     HSaveError err = OpenSavegame(savedgame, desc, kSvgDesc_UserText);
     if (!err)
@@ -963,6 +1017,7 @@ bool read_savedgame_description(const String &savedgame, String &description)
 
 std::unique_ptr<Bitmap> read_savedgame_screenshot(const String &savedgame)
 {
+    WaitBackgroundSave();
     SavegameDescription desc;
     HSaveError err = OpenSavegame(savedgame, desc, kSvgDesc_UserImage);
     if (!err)
@@ -999,6 +1054,7 @@ HSaveError load_game(const String &path, int slotNumber, bool &data_overwritten)
 {
     data_overwritten = false;
     gameHasBeenRestored++;
+    WaitBackgroundSave();
 
     oldeip = our_eip;
     our_eip = 2050;
@@ -1050,7 +1106,7 @@ HSaveError load_game(const String &path, int slotNumber, bool &data_overwritten)
     }
 
     // do the actual restore
-    err = RestoreGameState(src.InputStream.get(), src.Version);
+    err = RestoreGameState(src.InputStream.get(), src.Version, path);
     data_overwritten = true;
     if (!err)
         return err;
@@ -1863,6 +1919,11 @@ RuntimeScriptValue Sc_Game_BlockingWaitSkipped(const RuntimeScriptValue *params,
     API_SCALL_INT(Game_BlockingWaitSkipped);
 }
 
+RuntimeScriptValue Sc_Game_PrefetchSprite(const RuntimeScriptValue *params, int32_t param_count)
+{
+    API_SCALL_VOID_PINT(Game_PrefetchSprite);
+}
+
 void RegisterGameAPI()
 {
     ScFnRegister game_api[] = {
@@ -1920,6 +1981,7 @@ void RegisterGameAPI()
         { "Game::PlayVoiceClip",                          Sc_Game_PlayVoiceClip, PlayVoiceClip },
         { "Game::SimulateKeyPress",                       API_FN_PAIR(Game_SimulateKeyPress) },
         { "Game::get_BlockingWaitSkipped",                API_FN_PAIR(Game_BlockingWaitSkipped) },
+        { "Game::PrefetchSprite^1",                       API_FN_PAIR(Game_PrefetchSprite) },
         { "Game::get_SpeechVoxFilename",                  API_FN_PAIR(Game_GetSpeechVoxFilename) },
         { "Game::get_Camera",                             API_FN_PAIR(Game_GetCamera) },
         { "Game::get_CameraCount",                        API_FN_PAIR(Game_GetCameraCount) },
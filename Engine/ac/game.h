@@ -159,6 +159,8 @@ void free_do_once_tokens();
 // Free all the memory associated with the game
 void unload_game_file();
 void save_game(int slotn, const char*descript);
+// Reports completion of the save written in background
+void update_background_save();
 bool read_savedgame_description(const Common::String &savedgame, Common::String &description);
 std::unique_ptr<Common::Bitmap> read_savedgame_screenshot(const Common::String &savedgame);
 // Tries to restore saved game and displays an error on failure; if the error occured
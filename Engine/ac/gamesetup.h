@@ -15,6 +15,7 @@
 #define __AC_GAMESETUP_H
 
 #include "ac/sys_events.h"
+#include "game/savegame.h"
 #include "main/graphics_mode.h"
 #include "util/string.h"
 
@@ -102,13 +103,32 @@ struct GameSetup
     size_t SoundLoadAtOnceSize = DefSoundLoadAtOnce; // threshold for loading sounds immediately, in KB
     size_t SoundCacheSize = DefSoundCache; // sound cache limit, in KB
     bool  clear_cache_on_room_change; // for low-end devices: clear resource caches on room change
+    // time limit for a single run of the script objects' garbage collection,
+    // in microseconds, 0 for no limit
+    int   GCTimeBudget = 1000;
+    // number of rooms which the player may enter next to load in background, 0 to disable
+    int   PreloadRooms = 0;
     bool  load_latest_save; // load latest saved game on launch
+    // write only the changes since the previous save, keeping it as a base
+    bool  IncrementalSaves = false;
+    // number of incremental saves in a row before the next full one
+    int   IncrementalSaveChain = 8;
+    // compression of the savegame's game data
+    AGS::Engine::SavegameCompression SaveCompression = AGS::Engine::kSvgCompress_None;
+    // compress and write savegames on a background thread
+    bool  BackgroundSaves = false;
     ScreenRotation rotation;
     bool  show_fps;
+    bool  ShowProfiler = false; // display the frame profiler's stats
+    int   ProfilerTraceFrames = 0; // number of frames to record the profiler trace for
     bool  multitasking = false; // whether run on background, when game is switched out
 
     DisplayModeSetup Screen;
     String software_render_driver;
+    // number of threads for drawing sprites in the software renderer, 0 or 1 to not use threads
+    int   SoftwareRenderThreads = 0;
+    // pack small sprite textures into the shared atlas pages (where supported by the renderer)
+    bool  SpriteAtlas = false;
 
     // User's overrides and hacks
     int   override_script_os; // pretend engine is running on this eScriptSystemOSID
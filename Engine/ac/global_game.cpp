@@ -45,6 +45,7 @@
 #include "debug/debugger.h"
 #include "debug/debug_log.h"
 #include "font/fonts.h"
+#include "game/savegame.h"
 #include "gui/guidialog.h"
 #include "main/engine.h"
 #include "main/game_start.h"
@@ -65,6 +66,7 @@
 #include "platform/base/sys_main.h"
 
 using namespace AGS::Common;
+using namespace AGS::Engine;
 
 extern GameState play;
 extern ExecutingScript*curscript;
@@ -123,14 +125,15 @@ void RestoreGameSlot(int slnum) {
 void DeleteSaveSlot (int slnum) {
     String nametouse;
     nametouse = get_save_game_path(slnum);
-    File::DeleteFile(nametouse);
+    WaitBackgroundSave();
+    DeleteSavegame(nametouse);
     if ((slnum >= 1) && (slnum <= MAXSAVEGAMES)) {
         String thisname;
         for (int i = MAXSAVEGAMES; i > slnum; i--) {
             thisname = get_save_game_path(i);
             if (Common::File::IsFile(thisname)) {
                 // Rename the highest save game to fill in the gap
-                File::RenameFile(thisname, nametouse);
+                RenameSavegame(thisname, nametouse);
                 break;
             }
         }
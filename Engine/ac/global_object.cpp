@@ -70,36 +70,45 @@ int GetObjectIDAtScreen(int scrx, int scry)
 
 int GetObjectIDAtRoom(int roomx, int roomy)
 {
-    int bestshotyp=-1,bestshotwas=-1;
-    // Iterate through all objects in the room
+    // Select objects which bounding box contains the position, and test
+    // their images starting with the one drawn on top
+    static std::vector<SpriteHitCandidate> candidates;
+    candidates.clear();
     for (uint32_t aa=0;aa<croom->numobj;aa++) {
         if (objs[aa].on != 1) continue;
         if (objs[aa].flags & OBJF_NOINTERACT)
             continue;
-        int xxx=objs[aa].x,yyy=objs[aa].y;
-        int isflipped = 0;
-        int spWidth = game_to_data_coord(objs[aa].get_width());
-        int spHeight = game_to_data_coord(objs[aa].get_height());
-        if (objs[aa].view != RoomObject::NoView)
-            isflipped = views[objs[aa].view].loops[objs[aa].loop].frames[objs[aa].frame].flags & VFLG_FLIPSPRITE;
+        SpriteHitCandidate c;
+        c.Id = aa;
+        c.Baseline = objs[aa].get_baseline();
+        if (c.Baseline < -1) continue;
+        c.Width = game_to_data_coord(objs[aa].get_width());
+        c.Height = game_to_data_coord(objs[aa].get_height());
+        c.X = objs[aa].x;
+        c.Y = objs[aa].y - c.Height;
+        c.Flipped = (objs[aa].view != RoomObject::NoView) &&
+            (views[objs[aa].view].loops[objs[aa].loop].frames[objs[aa].frame].flags & VFLG_FLIPSPRITE) != 0;
+        // zero size means that the size is taken from the image, see is_pos_in_sprite
+        if ((c.Width > 0) && (c.Height > 0) &&
+            !isposinbox(roomx, roomy, c.X, c.Y, c.X + c.Width, c.Y + c.Height))
+            continue;
+        candidates.push_back(c);
+    }
 
+    sort_hit_candidates(candidates);
+    for (const auto &c : candidates) {
         bool is_original;
-        Bitmap *theImage = GetObjectImage(aa, &is_original);
-        if (!is_original)
-            isflipped = 0; // transformed image is already flipped
-
-        if (is_pos_in_sprite(roomx, roomy, xxx, yyy - spHeight, theImage,
-            spWidth, spHeight, isflipped, is_original) == FALSE)
+        Bitmap *theImage = GetObjectImage(c.Id, &is_original);
+        // transformed image is already flipped
+        int isflipped = (c.Flipped && is_original) ? 1 : 0;
+        if (is_pos_in_sprite(roomx, roomy, c.X, c.Y, theImage,
+            c.Width, c.Height, isflipped, is_original) == FALSE)
             continue;
-
-        int usebasel = objs[aa].get_baseline();   
-        if (usebasel < bestshotyp) continue;
-
-        bestshotwas = aa;
-        bestshotyp = usebasel;
+        obj_lowest_yp = c.Baseline;
+        return c.Id;
     }
-    obj_lowest_yp = bestshotyp;
-    return bestshotwas;
+    obj_lowest_yp = -1;
+    return -1;
 }
 
 void SetObjectTint(int obj, int red, int green, int blue, int opacity, int luminance) {
@@ -249,6 +258,7 @@ void AnimateObjectImpl(int obn, int loopn, int spdd, int rept, int direction, in
     debug_script_log("Obj %d start anim view %d loop %d, speed %d, repeat %d, frame %d",
         obn, obj.view + 1, loopn, spdd, rept, sframe);
 
+    prefetch_view_loop(obj.view, loopn);
     obj.set_animating(rept, direction == 0, spdd);
     obj.loop = (uint16_t)loopn;
     obj.frame = (uint16_t)SetFirstAnimFrame(obj.view, loopn, sframe, direction);
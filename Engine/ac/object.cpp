@@ -11,6 +11,7 @@
 // http://www.opensource.org/licenses/artistic-license-2.0.php
 //
 //=============================================================================
+#include <algorithm>
 #include "ac/object.h"
 #include "ac/common.h"
 #include "ac/gamesetupstruct.h"
@@ -598,6 +599,12 @@ int is_pos_in_sprite(int xx, int yy, int arx, int ary, Bitmap *sprit,
     return TRUE;
 }
 
+void sort_hit_candidates(std::vector<SpriteHitCandidate> &candidates) {
+    std::sort(candidates.begin(), candidates.end(),
+        [](const SpriteHitCandidate &a, const SpriteHitCandidate &b)
+        { return (a.Baseline != b.Baseline) ? (a.Baseline > b.Baseline) : (a.Id > b.Id); });
+}
+
 // X and Y co-ordinates must be in native format (TODO: find out if this comment is still true)
 int check_click_on_object(int roomx, int roomy, int mood)
 {
@@ -20,6 +20,7 @@
 #ifndef __AGS_EE_AC__OBJECT_H
 #define __AGS_EE_AC__OBJECT_H
 
+#include <vector>
 #include "ac/common_defines.h"
 #include "ac/dynobj/scriptobject.h"
 
@@ -114,6 +115,19 @@ int     SetFirstAnimFrame(int view, int loop, int sframe, int direction);
 // returns whether the animation should continue.
 bool    CycleViewAnim(int view, uint16_t &loop, uint16_t &frame, bool forwards, int repeat);
 void    CheckViewFrameForObject(RoomObject *obj);
+// Sprite which passed the bounding box test, and has to be tested per pixel
+struct SpriteHitCandidate
+{
+    int  Id;
+    int  Baseline;
+    int  X, Y;          // sprite's position in room coordinates
+    int  Width, Height; // sprite's size in room coordinates
+    bool Flipped;
+};
+// Sorts the hit candidates in the order in which they should be tested:
+// those drawn on top first, that is with higher baseline, or the later
+// of the ones with equal baseline
+void    sort_hit_candidates(std::vector<SpriteHitCandidate> &candidates);
 
 #endif // __AGS_EE_AC__OBJECT_H
 
@@ -56,15 +56,12 @@ int Said (const char *checkwords) {
 //=============================================================================
 
 int find_word_in_dictionary (const char *lookfor) {
-    int j;
     if (game.dict == nullptr)
         return -1;
 
-    for (j = 0; j < game.dict->num_words; j++) {
-        if (ags_stricmp(lookfor, game.dict->word[j]) == 0) {
-            return game.dict->wordnum[j];
-        }
-    }
+    int index = game.dict->find_index(lookfor);
+    if (index >= 0)
+        return game.dict->wordnum[index];
     if (lookfor[0] != 0) {
         // If the word wasn't found, but it ends in 'S', see if there's
         // a non-plural version
@@ -89,6 +86,8 @@ int is_valid_word_char(char theChar) {
 int FindMatchingMultiWordWord(char *thisword, const char **text) {
     // see if there are any multi-word words
     // that match -- if so, use them
+    if (game.dict == nullptr)
+        return -1;
     const char *tempptr = *text;
     char tempword[150] = "";
     if (thisword != nullptr)
@@ -114,6 +113,9 @@ int FindMatchingMultiWordWord(char *thisword, const char **text) {
             bestMatchFound = word;
             tempptrAtBestMatch = tempptr;
         }
+        // no need to go on if no multi-word words begin with these words
+        if (!game.dict->is_multiword_prefix(tempword))
+            break;
 
     } while (tempptr[0] == ' ');
 
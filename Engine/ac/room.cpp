@@ -52,6 +52,8 @@
 #include "debug/debug_log.h"
 #include "debug/debugger.h"
 #include "debug/out.h"
+#include "game/room_file.h"
+#include "game/room_preloader.h"
 #include "game/room_version.h"
 #include "platform/base/agsplatformdriver.h"
 #include "plugin/agsplugin_evts.h"
@@ -60,6 +62,7 @@
 #include "script/script.h"
 #include "script/script_runtime.h"
 #include "ac/spritecache.h"
+#include "util/memorystream.h"
 #include "util/stream.h"
 #include "gfx/graphicsdriver.h"
 #include "core/assetmanager.h"
@@ -101,6 +104,8 @@ extern CCObject ccDynamicObject;
 RGB_MAP rgb_table;  // for 256-col antialiasing
 int new_room_flags=0;
 int gs_to_newroom=-1;
+// Loads the rooms in background, before the player enters them
+static RoomPreloader room_preloader;
 
 ScriptDrawingSurface* Room_GetDrawingSurfaceForBackground(int backgroundNumber)
 {
@@ -205,6 +210,16 @@ bool Room_Exists(int room)
     return AssetMgr->DoesAssetExist(room_filename);
 }
 
+void Room_Preload(int room)
+{
+    if (!Room_Exists(room))
+    {
+        debug_script_warn("Room.Preload: room %d does not exist", room);
+        return;
+    }
+    preload_room(room);
+}
+
 ScriptDrawingSurface *GetDrawingSurfaceForWalkableArea()
 {
     return Room_GetDrawingSurfaceForMask(kRoomAreaWalkable);
@@ -460,6 +475,86 @@ static void reset_temp_room()
     troom = RoomStatus();
 }
 
+// Gets the name of the room's file
+static String get_room_filename(int room)
+{
+    String room_filename = String::FromFormat("room%d.crm", room);
+    if (room == 0) {
+        // support both room0.crm and intro.crm
+        // 2.70: Renamed intro.crm to room0.crm, to stop it causing confusion
+        if ((loaded_game_file_version < kGameVersion_270 && AssetMgr->DoesAssetExist("intro.crm")) ||
+            (loaded_game_file_version >= kGameVersion_270 && !AssetMgr->DoesAssetExist(room_filename)))
+        {
+            room_filename = "intro.crm";
+        }
+    }
+    return room_filename;
+}
+
+// Reads the room file in background; leaves compiled script and
+// data fixups for the game thread. Errors are not reported here, as the room
+// will be loaded again when entered, and fail there.
+static bool read_room_in_background(PreloadedRoom &room)
+{
+    RoomDataSource src;
+    HRoomFileError err = OpenRoomFileFromAsset(room.Filename, src);
+    if (err)
+        err = ReadRoomData(&room.Data, src.InputStream.get(), src.DataVersion, room.ScriptData);
+    return err ? true : false;
+}
+
+// Makes the preloaded room the current one, finishing its loading
+static void load_preloaded_room(PreloadedRoom &room)
+{
+    thisroom = std::move(room.Data);
+    HRoomFileError err = HRoomFileError::None();
+    if (!room.ScriptData.empty())
+    {
+        MemoryStream in(room.ScriptData.data(), room.ScriptData.size());
+        thisroom.CompiledScript.reset(ccScript::CreateFromStream(&in));
+        if (!thisroom.CompiledScript)
+            err = new RoomFileError(kRoomFileErr_ScriptLoadFailed, cc_get_error().ErrorString);
+    }
+    if (err)
+        err = UpdateRoomData(&thisroom, static_cast<RoomFileVersion>(thisroom.DataVersion),
+            game.IsLegacyHiRes(), game.SpriteInfos);
+    if (!err)
+        quitprintf("Unable to load the room file '%s'.\n%s.", room.Filename.GetCStr(), err->FullMessage().GetCStr());
+}
+
+void preload_room(int room)
+{
+    if (room < 0 || room >= MAX_ROOMS)
+        return;
+    if (room == displayed_room)
+        return;
+    if (room_preloader.GetCapacity() == 0u)
+    {
+        room_preloader.SetLoader(read_room_in_background);
+        // rooms requested by the script are preloaded even if not enabled in config
+        room_preloader.SetCapacity(usetup.PreloadRooms > 0 ? usetup.PreloadRooms : 1);
+    }
+    room_preloader.Preload(room, get_room_filename(room));
+}
+
+void reset_room_preloader()
+{
+    room_preloader.Reset();
+    room_preloader.ResetHistory();
+}
+
+// Preloads the rooms which the player is likely to go to next
+static void preload_next_rooms(int room, int prev_room)
+{
+    if (usetup.PreloadRooms <= 0)
+        return;
+    for (int next_room : room_preloader.PredictNext(room, prev_room, usetup.PreloadRooms))
+    {
+        if (Room_Exists(next_room))
+            preload_room(next_room);
+    }
+}
+
 // forchar = playerchar on NewRoom, or NULL if restore saved game
 void load_new_room(int newnum, CharacterInfo*forchar) {
 
@@ -474,22 +569,24 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     // lead to unexpected errors.
     set_color_depth(8);
     displayed_room=newnum;
+    invalidate_room_characters();
 
-    room_filename.Format("room%d.crm", newnum);
-    if (newnum == 0) {
-        // support both room0.crm and intro.crm
-        // 2.70: Renamed intro.crm to room0.crm, to stop it causing confusion
-        if ((loaded_game_file_version < kGameVersion_270 && AssetMgr->DoesAssetExist("intro.crm")) ||
-            (loaded_game_file_version >= kGameVersion_270 && !AssetMgr->DoesAssetExist(room_filename)))
-        {
-            room_filename = "intro.crm";
-        }
-    }
+    room_filename = get_room_filename(newnum);
 
-    // load the room from disk
+    // load the room from disk, unless it was loaded in background
     our_eip=200;
     thisroom.GameID = NO_GAME_ID_IN_ROOM_FILE;
-    load_room(room_filename, &thisroom, game.IsLegacyHiRes(), game.SpriteInfos);
+    std::unique_ptr<PreloadedRoom> preloaded = room_preloader.Take(newnum, room_filename);
+    if (preloaded)
+    {
+        debug_script_log("Using preloaded room %d", newnum);
+        load_preloaded_room(*preloaded);
+        preloaded.reset();
+    }
+    else
+    {
+        load_room(room_filename, &thisroom, game.IsLegacyHiRes(), game.SpriteInfos);
+    }
 
     if ((thisroom.GameID != NO_GAME_ID_IN_ROOM_FILE) &&
         (thisroom.GameID != game.uniqueid)) {
@@ -658,6 +755,13 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     }
     // Reset contentFormat hint to avoid doing fixups later
     croom->contentFormat = kRoomStatSvgVersion_Current;
+    // Start decoding visible objects' sprites in background,
+    // while the rest of the room is being prepared
+    for (uint32_t cc = 0; cc < croom->numobj; ++cc)
+    {
+        if (croom->obj[cc].on)
+            spriteset.Prefetch(croom->obj[cc].num);
+    }
 
     if (thisroom.EventHandlers == nullptr)
     {// legacy interactions
@@ -723,6 +827,8 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
 
         forchar->prevroom=forchar->room;
         forchar->room=newnum;
+        invalidate_room_characters();
+        room_preloader.NoteRoomChange(forchar->prevroom, newnum);
         // only stop moving if it's a new room, not a restore game
         for (int cc=0;cc<game.numcharacters;cc++)
             StopMoving(cc);
@@ -902,6 +1008,7 @@ void load_new_room(int newnum, CharacterInfo*forchar) {
     debug_script_log("Now in room %d", displayed_room);
     GUI::MarkAllGUIForUpdate(true, true);
     pl_run_plugin_hooks(AGSE_ENTERROOM, displayed_room);
+    preload_next_rooms(displayed_room, playerchar->prevroom);
 }
 
 // new_room: changes the current room number, and loads the new room from disk
@@ -958,6 +1065,7 @@ void set_room_placeholder()
     thisroom.RegionMask = dummy_bg;
     thisroom.WalkAreaMask = dummy_bg;
     thisroom.WalkBehindMask = dummy_bg;
+    invalidate_walkable_areas_temp();
 
     reset_temp_room();
     croom = &troom;
@@ -1215,6 +1323,11 @@ RuntimeScriptValue Sc_Room_Exists(const RuntimeScriptValue *params, int32_t para
     API_SCALL_BOOL_PINT(Room_Exists);
 }
 
+RuntimeScriptValue Sc_Room_Preload(const RuntimeScriptValue *params, int32_t param_count)
+{
+    API_SCALL_VOID_PINT(Room_Preload);
+}
+
 void RegisterRoomAPI()
 {
     ScFnRegister room_api[] = {
@@ -1236,6 +1349,7 @@ void RegisterRoomAPI()
         { "Room::get_TopEdge",                        API_FN_PAIR(Room_GetTopEdge) },
         { "Room::get_Width",                          API_FN_PAIR(Room_GetWidth) },
         { "Room::Exists",                             API_FN_PAIR(Room_Exists) },
+        { "Room::Preload",                            API_FN_PAIR(Room_Preload) },
     };
 
     ccAddExternalFunctions(room_api);
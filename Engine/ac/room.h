@@ -52,6 +52,10 @@ void  new_room(int newnum,CharacterInfo*forchar);
 // Sets up a placeholder room object; this is used to avoid occasional crashes
 // in case an API function was called that needs to access a room, while no real room is loaded
 void  set_room_placeholder();
+// Queues the room for loading in background, so that entering it is faster
+void  preload_room(int room);
+// Stops background room loading and forgets preloaded rooms
+void  reset_room_preloader();
 int   find_highest_room_entered();
 void  first_room_initialization();
 void  check_new_room();
@@ -261,6 +261,11 @@ bool isRoomStatusValid(int room)
     return (room_statuses[room] != nullptr);
 }
 
+void resetRoomStatus(int room)
+{
+    room_statuses[room].reset();
+}
+
 void resetRoomStatuses()
 {
     for (int i = 0; i < MAX_ROOMS; i++)
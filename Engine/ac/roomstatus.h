@@ -99,6 +99,8 @@ RoomStatus* getRoomStatus(int room);
 // to initialise the status because a player can only have been in
 // a room if the status is already initialised.
 bool isRoomStatusValid(int room);
+// Resets the state of a single room
+void resetRoomStatus(int room);
 void resetRoomStatuses();
 
 #endif // __AGS_EE_AC__ROOMSTATUS_H
@@ -16,6 +16,7 @@
 #include "ac/route_finder_impl.h"
 #include "ac/route_finder_impl_legacy.h"
 #include "debug/out.h"
+#include "debug/profiler.h"
 
 using AGS::Common::Bitmap;
 
@@ -154,6 +155,8 @@ void set_route_move_speed(int speed_x, int speed_y)
 
 int find_route(short srcx, short srcy, short xx, short yy, Bitmap *onscreen, int movlst, int nocross, int ignore_walls)
 {
+    AGS_PROFILE_ZONE("Route finding");
+    AGS_PROFILE_COUNT("Routes", 1);
     return route_finder_impl->find_route(srcx, srcy, xx, yy, onscreen, movlst, nocross, ignore_walls);
 }
 
@@ -48,6 +48,17 @@ static fixed move_speed_x, move_speed_y;
 static Navigation nav;
 static Bitmap *wallscreen;
 static int lastcx, lastcy;
+// Description of the mask which navigation grid is currently bound to;
+// the grid refers to the mask's rows directly, so it only has to be
+// rebuilt when the mask is reallocated or resized.
+static struct
+{
+  const Bitmap *Mask = nullptr;
+  int Width = 0;
+  int Height = 0;
+  const unsigned char *FirstRow = nullptr;
+  const unsigned char *LastRow = nullptr;
+} nav_mask;
 
 void init_pathfinder()
 {
@@ -55,6 +66,7 @@ void init_pathfinder()
 
 void shutdown_pathfinder()
 {
+  nav_mask = {};
 }
 
 void set_wallscreen(Bitmap *wallscreen_) 
@@ -64,11 +76,26 @@ void set_wallscreen(Bitmap *wallscreen_)
 
 static void sync_nav_wallscreen()
 {
-  // FIXME: this is dumb, but...
-  nav.Resize(wallscreen->GetWidth(), wallscreen->GetHeight());
+  const int width = wallscreen->GetWidth();
+  const int height = wallscreen->GetHeight();
+  const unsigned char *first_row = wallscreen->GetScanLine(0);
+  const unsigned char *last_row = wallscreen->GetScanLine(height - 1);
+  // Navigation reads the mask through the row pointers, so changes to the
+  // mask's pixels are seen without resync; only rebind if the mask is
+  // a different bitmap, or its pixel buffer was reallocated.
+  if ((nav_mask.Mask == wallscreen) && (nav_mask.Width == width) && (nav_mask.Height == height) &&
+      (nav_mask.FirstRow == first_row) && (nav_mask.LastRow == last_row))
+    return;
 
-  for (int y=0; y<wallscreen->GetHeight(); y++)
+  nav.Resize(width, height);
+  for (int y = 0; y < height; y++)
     nav.SetMapRow(y, wallscreen->GetScanLine(y));
+
+  nav_mask.Mask = wallscreen;
+  nav_mask.Width = width;
+  nav_mask.Height = height;
+  nav_mask.FirstRow = first_row;
+  nav_mask.LastRow = last_row;
 }
 
 int can_see_from(int x1, int y1, int x2, int y2)
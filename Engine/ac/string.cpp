@@ -303,12 +303,13 @@ size_t break_up_text_into_lines(const char *todis, bool apply_direction, SplitLi
                 lines[rr].ReverseUTF8() :
                 lines[rr].Reverse();
             line_length = get_text_width_outlined(lines[rr].GetCStr(), fonnt);
+            lines.SetWidth(rr, line_length);
             if (line_length > longestline)
                 longestline = line_length;
         }
     else
         for (size_t rr = 0; rr < lines.Count(); rr++) {
-            line_length = get_text_width_outlined(lines[rr].GetCStr(), fonnt);
+            line_length = lines.GetWidth(rr);
             if (line_length > longestline)
                 longestline = line_length;
         }
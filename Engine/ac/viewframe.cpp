@@ -116,6 +116,15 @@ void precache_view(int view)
     }
 }
 
+void prefetch_view_loop(int view, int loop)
+{
+    if (view < 0 || view >= game.numviews || loop < 0 || loop >= views[view].numLoops)
+        return;
+
+    for (int j = 0; j < views[view].loops[loop].numFrames; j++)
+        spriteset.Prefetch(views[view].loops[loop].frames[j].pic);
+}
+
 int CalcFrameSoundVolume(int obj_vol, int anim_vol, int scale)
 {
     // We view the audio property relation as the relation of the entities:
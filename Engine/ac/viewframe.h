@@ -40,6 +40,8 @@ int  ViewFrame_GetLoop(ScriptViewFrame *svf);
 int  ViewFrame_GetFrame(ScriptViewFrame *svf);
 
 void precache_view(int view);
+// Queues all the frames of the given view loop for the background loading
+void prefetch_view_loop(int view, int loop);
 // Calculate the frame sound volume from different factors;
 // pass scale as 100 if volume scaling is disabled
 // NOTE: historically scales only in 0-100 range :/
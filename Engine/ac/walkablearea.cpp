@@ -12,6 +12,9 @@
 //
 //=============================================================================
 
+#include <string.h>
+#include <algorithm>
+#include <vector>
 #include "ac/common.h"
 #include "ac/object.h"
 #include "ac/character.h"
@@ -35,6 +38,40 @@ extern RoomStatus*croom;
 extern RoomObject*objs;
 
 Bitmap *walkareabackup=nullptr, *walkable_areas_temp = nullptr;
+// Tells that walkable_areas_temp has to be fully copied from the room mask
+static bool walkable_areas_temp_invalid = true;
+// Marks rows of walkable_areas_temp which were modified after the last copy
+static std::vector<uint8_t> walkable_areas_temp_dirty;
+
+void invalidate_walkable_areas_temp()
+{
+    walkable_areas_temp_invalid = true;
+}
+
+// Makes walkable_areas_temp match the room's walkable mask again;
+// if the mask itself did not change, then only restores modified rows
+static void sync_walkable_areas_temp()
+{
+    Bitmap *mask = thisroom.WalkAreaMask.get();
+    const int height = walkable_areas_temp->GetHeight();
+    if (walkable_areas_temp_invalid || (walkable_areas_temp_dirty.size() != (size_t)height))
+    {
+        walkable_areas_temp->Blit(mask, 0, 0, 0, 0, mask->GetWidth(), mask->GetHeight());
+        walkable_areas_temp_dirty.assign(height, 0);
+        walkable_areas_temp_invalid = false;
+        return;
+    }
+
+    const int copy_height = std::min(height, mask->GetHeight());
+    const size_t copy_len = std::min(walkable_areas_temp->GetLineLength(), mask->GetLineLength());
+    for (int y = 0; y < copy_height; ++y)
+    {
+        if (!walkable_areas_temp_dirty[y])
+            continue;
+        memcpy(walkable_areas_temp->GetScanLineForWriting(y), mask->GetScanLine(y), copy_len);
+        walkable_areas_temp_dirty[y] = 0;
+    }
+}
 
 void redo_walkable_areas()
 {
@@ -49,6 +86,7 @@ void redo_walkable_areas()
                 walls_scanline[w] = 0;
         }
     }
+    invalidate_walkable_areas_temp();
 }
 
 int get_walkable_area_pixel(int x, int y)
@@ -118,6 +156,13 @@ void remove_walkable_areas_from_temp(int fromx, int cwidth, int starty, int endy
         endy = walkable_areas_temp->GetHeight() - 1;
     if (starty < 0)
         starty = 0;
+    if ((cwidth <= 0) || (starty > endy))
+        return; // nothing to remove
+
+    if (walkable_areas_temp_dirty.size() > (size_t)endy)
+        std::fill(walkable_areas_temp_dirty.begin() + starty, walkable_areas_temp_dirty.begin() + endy + 1, 1);
+    else
+        invalidate_walkable_areas_temp(); // temp mask was not synced yet
 
     for (; cwidth > 0; cwidth --) {
         for (yyy = starty; yyy <= endy; yyy++)
@@ -135,7 +180,7 @@ int is_point_in_rect(int x, int y, int left, int top, int right, int bottom) {
 
 Bitmap *prepare_walkable_areas (int sourceChar) {
     // copy the walkable areas to the temp bitmap
-    walkable_areas_temp->Blit(thisroom.WalkAreaMask.get(), 0,0,0,0,thisroom.WalkAreaMask->GetWidth(),thisroom.WalkAreaMask->GetHeight());
+    sync_walkable_areas_temp();
     // if the character who's moving doesn't block, don't bother checking
     if (sourceChar < 0) ;
     else if (game.chars[sourceChar].flags & CHF_NOBLOCKING)
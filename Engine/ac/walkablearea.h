@@ -19,6 +19,9 @@
 #define __AGS_EE_AC__WALKABLEAREA_H
 
 void  redo_walkable_areas();
+// Tells that the room's walkable mask was modified and has to be copied
+// into the pathfinder's temp mask anew (redo_walkable_areas does this too)
+void  invalidate_walkable_areas_temp();
 int   get_walkable_area_pixel(int x, int y);
 int   get_area_scaling (int onarea, int xx, int yy);
 void  scale_sprite_size(int sppic, int zoom_level, int *newwidth, int *newheight);
@@ -13,6 +13,7 @@
 //=============================================================================
 #include "ac/walkbehind.h"
 #include <algorithm>
+#include <string.h>
 #include "ac/draw.h"
 #include "ac/gamestate.h"
 #include "ac/roomstatus.h"
@@ -28,14 +29,15 @@ extern GameState play;
 extern IGraphicsDriver *gfxDriver;
 extern RoomStatus *croom;
 
-// An info on vertical column of walk-behind mask, which may contain WB area
-struct WalkBehindColumn
+// A horizontal run of the walk-behind area's pixels on a mask's scanline
+struct WalkBehindSpan
 {
-    bool Exists = false; // whether any WB area is in this column
-    int Y1 = 0, Y2 = 0; // WB top and bottom Y coords
+    int X1 = 0, X2 = 0; // first and past-last X coords
+    int Area = 0; // walk-behind area index
 };
 
-std::vector<WalkBehindColumn> walkBehindCols; // precalculated WB positions
+std::vector<WalkBehindSpan> walkBehindSpans; // precalculated WB spans, ordered by rows and X
+std::vector<size_t> walkBehindRows; // index of the first span of each mask's row, plus the end
 Rect walkBehindAABB[MAX_WALK_BEHINDS]; // WB bounding box
 int walkBehindsCachedForBgNum = 0; // WB textures are for this background
 bool noWalkBehindsAtAll = false; // quick report that no WBs in this room
@@ -45,7 +47,6 @@ bool walk_behind_baselines_changed = false;
 // Generates walk-behinds as separate sprites
 void walkbehinds_generate_sprites()
 {
-    const Bitmap *mask = thisroom.WalkBehindMask.get();
     const Bitmap *bg = thisroom.BgFrames[play.bg_frame].Graphic.get();
     
     const int coldepth = bg->GetColorDepth();
@@ -57,31 +58,18 @@ void walkbehinds_generate_sprites()
         if (pos.Right > 0)
         {
             wbbmp.CreateTransparent(pos.GetWidth(), pos.GetHeight(), coldepth);
-            // Copy over all solid pixels belonging to this WB area
-            const int sx = pos.Left, ex = pos.Right, sy = pos.Top, ey = pos.Bottom;
-            for (int y = sy; y <= ey; ++y)
+            // Copy over all spans belonging to this WB area
+            const int bpp = bg->GetBPP();
+            for (int y = pos.Top; y <= pos.Bottom; ++y)
             {
-                const uint8_t *check_line = mask->GetScanLine(y);
                 const uint8_t *src_line = bg->GetScanLine(y);
-                uint8_t *dst_line = wbbmp.GetScanLineForWriting(y - sy);
-                for (int x = sx; x <= ex; ++x)
+                uint8_t *dst_line = wbbmp.GetScanLineForWriting(y - pos.Top);
+                for (size_t i = walkBehindRows[y]; i < walkBehindRows[y + 1]; ++i)
                 {
-                    if (check_line[x] != wb) continue;
-                    switch (coldepth)
-                    {
-                    case 8:
-                        dst_line[(x - sx)] = src_line[x];
-                        break;
-                    case 16:
-                        reinterpret_cast<uint16_t*>(dst_line)[(x - sx)] =
-                            reinterpret_cast<const uint16_t*>(src_line)[x];
-                        break;
-                    case 32:
-                        reinterpret_cast<uint32_t*>(dst_line)[(x - sx)] =
-                            reinterpret_cast<const uint32_t*>(src_line)[x];
-                        break;
-                    default: assert(0); break;
-                    }
+                    const auto &span = walkBehindSpans[i];
+                    if (span.Area != wb) continue;
+                    memcpy(dst_line + (span.X1 - pos.Left) * bpp, src_line + span.X1 * bpp,
+                        (span.X2 - span.X1) * bpp);
                 }
             }
             // Add to walk-behinds image list
@@ -92,95 +80,92 @@ void walkbehinds_generate_sprites()
     walkBehindsCachedForBgNum = play.bg_frame;
 }
 
-// Edits the given game object's sprite, cutting out pixels covered by walk-behinds;
-// returns whether any pixels were updated;
-bool walkbehinds_cropout(Bitmap *sprit, int sprx, int spry, int basel)
+// Cuts out the sprite's pixels covered by the walk-behind spans
+// which baseline is above the given one
+template <typename TPixel>
+static bool cropout_spans(Bitmap *sprit, int sprx, int spry, int basel)
 {
-    if (noWalkBehindsAtAll)
-        return false;
-
-    const int maskcol = sprit->GetMaskColor();
-    const int spcoldep = sprit->GetColorDepth();
-
+    const TPixel maskcol = static_cast<TPixel>(sprit->GetMaskColor());
+    const int sp_width = sprit->GetWidth();
+    // only pass along the sprite's rows that lie inside the mask
+    const int y1 = std::max(0, 0 - spry);
+    const int y2 = std::min(sprit->GetHeight(), thisroom.WalkBehindMask->GetHeight() - spry);
     bool pixels_changed = false;
-    // pass along the sprite's pixels, but skip those that lie outside the mask
-    for (int x = std::max(0, 0 - sprx);
-        (x < sprit->GetWidth()) && (x + sprx < thisroom.WalkBehindMask->GetWidth()); ++x)
+    for (int y = y1; y < y2; ++y)
     {
-        // select the WB column at this x
-        const auto &wbcol = walkBehindCols[x + sprx];
-        // skip if no area, or sprite lies outside of all areas in this column
-        if ((!wbcol.Exists) ||
-            (wbcol.Y2 <= spry) ||
-            (wbcol.Y1 > spry + sprit->GetHeight()))
-            continue;
-
-        // ensure we only check within the valid areas (between Y1 and Y2)
-        // we assume that Y1 and Y2 are always within the mask
-        for (int y = std::max(0, wbcol.Y1 - spry);
-            (y < sprit->GetHeight()) && (y + spry < wbcol.Y2); ++y)
+        for (size_t i = walkBehindRows[y + spry]; i < walkBehindRows[y + spry + 1]; ++i)
         {
-            const int wb = thisroom.WalkBehindMask->GetScanLine(y + spry)[x + sprx];
-            if (wb < 1) continue; // "no area"
-            if (croom->walkbehind_base[wb] <= basel) continue;
+            const auto &span = walkBehindSpans[i];
+            const int x1 = std::max(0, span.X1 - sprx);
+            const int x2 = std::min(sp_width, span.X2 - sprx);
+            if (x1 >= sp_width) break; // spans are ordered by X
+            if ((x1 >= x2) || (croom->walkbehind_base[span.Area] <= basel)) continue;
 
+            TPixel *dst_line = reinterpret_cast<TPixel*>(sprit->GetScanLineForWriting(y));
+            std::fill(dst_line + x1, dst_line + x2, maskcol);
             pixels_changed = true;
-            uint8_t *dst_line = sprit->GetScanLineForWriting(y);
-            switch (spcoldep)
-            {
-            case 8:
-                dst_line[x] = maskcol;
-                break;
-            case 16:
-                reinterpret_cast<uint16_t*>(dst_line)[x] = maskcol;
-                break;
-            case 32:
-                reinterpret_cast<uint32_t*>(dst_line)[x] = maskcol;
-                break;
-            default:
-                assert(0);
-                break;
-            }
         }
     }
     return pixels_changed;
 }
 
+// Edits the given game object's sprite, cutting out pixels covered by walk-behinds;
+// returns whether any pixels were updated;
+bool walkbehinds_cropout(Bitmap *sprit, int sprx, int spry, int basel)
+{
+    if (noWalkBehindsAtAll)
+        return false;
+
+    switch (sprit->GetColorDepth())
+    {
+    case 8: return cropout_spans<uint8_t>(sprit, sprx, spry, basel);
+    case 16: return cropout_spans<uint16_t>(sprit, sprx, spry, basel);
+    case 32: return cropout_spans<uint32_t>(sprit, sprx, spry, basel);
+    default: assert(0); return false;
+    }
+}
+
 void walkbehinds_recalc()
 {
     // Reset all data
-    walkBehindCols.clear();
+    walkBehindSpans.clear();
+    walkBehindRows.clear();
     for (int wb = 0; wb < MAX_WALK_BEHINDS; ++wb)
     {
         walkBehindAABB[wb] = Rect(INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN);
     }
-    noWalkBehindsAtAll = true;
 
     // Recalculate everything; note that mask is always 8-bit
     const Bitmap *mask = thisroom.WalkBehindMask.get();
-    walkBehindCols.resize(mask->GetWidth());
-    for (int col = 0; col < mask->GetWidth(); ++col)
+    const int width = mask->GetWidth();
+    const int height = mask->GetHeight();
+    walkBehindRows.resize(height + 1);
+    for (int y = 0; y < height; ++y)
     {
-        auto &wbcol = walkBehindCols[col];
-        for (int y = 0; y < mask->GetHeight(); ++y)
+        walkBehindRows[y] = walkBehindSpans.size();
+        const uint8_t *line = mask->GetScanLine(y);
+        for (int x = 0; x < width;)
         {
-            int wb = mask->GetScanLine(y)[col];
+            // find the end of the run of the same pixels
+            const int wb = line[x];
+            const int x1 = x;
+            for (++x; (x < width) && (line[x] == wb); ++x);
             // Valid areas start with index 1, 0 = no area
-            if ((wb >= 1) && (wb < MAX_WALK_BEHINDS))
-            {
-                if (!wbcol.Exists)
-                {
-                    wbcol.Y1 = y;
-                    wbcol.Exists = true;
-                    noWalkBehindsAtAll = false;
-                }
-                wbcol.Y2 = y + 1; // +1 to allow bottom line of screen to work (CHECKME??)
-                // resize the bounding rect
-                walkBehindAABB[wb].Left = std::min(col, walkBehindAABB[wb].Left);
-                walkBehindAABB[wb].Top = std::min(y, walkBehindAABB[wb].Top);
-                walkBehindAABB[wb].Right = std::max(col, walkBehindAABB[wb].Right);
-                walkBehindAABB[wb].Bottom = std::max(y, walkBehindAABB[wb].Bottom);
-            }
+            if ((wb < 1) || (wb >= MAX_WALK_BEHINDS))
+                continue;
+
+            WalkBehindSpan span;
+            span.X1 = x1;
+            span.X2 = x;
+            span.Area = wb;
+            walkBehindSpans.push_back(span);
+            // resize the bounding rect
+            walkBehindAABB[wb].Left = std::min(x1, walkBehindAABB[wb].Left);
+            walkBehindAABB[wb].Top = std::min(y, walkBehindAABB[wb].Top);
+            walkBehindAABB[wb].Right = std::max(x - 1, walkBehindAABB[wb].Right);
+            walkBehindAABB[wb].Bottom = std::max(y, walkBehindAABB[wb].Bottom);
         }
     }
+    walkBehindRows[height] = walkBehindSpans.size();
+    noWalkBehindsAtAll = walkBehindSpans.empty();
 }
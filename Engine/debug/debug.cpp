@@ -88,6 +88,7 @@ int first_debug_line = 0, last_debug_line = 0, display_console = 0;
 
 float fps = std::numeric_limits<float>::quiet_NaN();
 FPSDisplayMode display_fps = kFPS_Hide;
+bool display_profiler = false;
 
 void send_message_to_debugger(IAGSEditorDebugger *ide_debugger,
     const std::vector<std::pair<String, String>>& tag_values, const String& command)
@@ -56,6 +56,7 @@ enum FPSDisplayMode
 
 extern float fps;
 extern FPSDisplayMode display_fps;
+extern bool display_profiler;
 extern int debug_flags;
 
 #endif // __AC_DEBUGGER_H
@@ -0,0 +1,221 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "game/room_preloader.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace AGS
+{
+namespace Engine
+{
+
+struct RoomPreloader::WorkerState
+{
+    std::thread Thread;
+    std::mutex Mutex;
+    std::condition_variable CV;
+    std::deque<Request> Queue;
+    int Current = -1; // room being loaded right now
+    // Loaded rooms, oldest first
+    std::deque<std::unique_ptr<PreloadedRoom>> Ready;
+    bool Exit = false;
+};
+
+RoomPreloader::RoomPreloader()
+    : _worker(new WorkerState())
+{
+}
+
+RoomPreloader::~RoomPreloader()
+{
+    Reset();
+}
+
+void RoomPreloader::SetLoader(LoadFn loader)
+{
+    Reset();
+    _loader = loader;
+}
+
+void RoomPreloader::SetCapacity(size_t count)
+{
+    std::lock_guard<std::mutex> lk(_worker->Mutex);
+    _capacity = count;
+    FreePlace(0u);
+}
+
+void RoomPreloader::Preload(int room, const String &filename)
+{
+#if !defined(AGS_DISABLE_THREADS)
+    if (!_loader || _capacity == 0u)
+        return;
+    std::lock_guard<std::mutex> lk(_worker->Mutex);
+    if (HasRoom(room))
+        return;
+    FreePlace(1u);
+    const size_t used = _worker->Queue.size() + _worker->Ready.size() + (_worker->Current >= 0 ? 1u : 0u);
+    if (used >= _capacity)
+        return; // all the place is taken by the room being loaded now
+    // make an unshared copy, because the worker thread will own it
+    _worker->Queue.push_back({ room, String(filename.GetCStr()) });
+    if (!_worker->Thread.joinable())
+        _worker->Thread = std::thread(&RoomPreloader::LoaderThread, this);
+    _worker->CV.notify_one();
+#else
+    (void)room; (void)filename; // no background loading, rooms are loaded when entered
+#endif
+}
+
+bool RoomPreloader::IsPreloaded(int room) const
+{
+    std::lock_guard<std::mutex> lk(_worker->Mutex);
+    return HasRoom(room);
+}
+
+std::unique_ptr<PreloadedRoom> RoomPreloader::Take(int room, const String &filename)
+{
+    if (!_worker->Thread.joinable())
+        return nullptr;
+    std::unique_lock<std::mutex> lk(_worker->Mutex);
+    // If the room was not started yet, then loading it right away is faster
+    // than waiting for the worker to get to it
+    auto it_queue = std::find_if(_worker->Queue.begin(), _worker->Queue.end(),
+        [room](const Request &req) { return req.Room == room; });
+    if (it_queue != _worker->Queue.end())
+        _worker->Queue.erase(it_queue);
+    _worker->CV.wait(lk, [this, room]() { return _worker->Current != room; });
+    for (auto it = _worker->Ready.begin(); it != _worker->Ready.end(); ++it)
+    {
+        if ((*it)->Room == room)
+        {
+            std::unique_ptr<PreloadedRoom> data = std::move(*it);
+            _worker->Ready.erase(it);
+            if (data->Filename.Compare(filename) != 0)
+                return nullptr; // room file has changed meanwhile
+            return data;
+        }
+    }
+    return nullptr;
+}
+
+void RoomPreloader::Reset()
+{
+    if (_worker->Thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lk(_worker->Mutex);
+            _worker->Exit = true;
+        }
+        _worker->CV.notify_all();
+        _worker->Thread.join();
+    }
+    _worker->Queue.clear();
+    _worker->Ready.clear();
+    _worker->Exit = false;
+}
+
+void RoomPreloader::NoteRoomChange(int from_room, int to_room)
+{
+    if (from_room < 0 || to_room < 0 || from_room == to_room)
+        return;
+    _history[from_room][to_room]++;
+}
+
+std::vector<int> RoomPreloader::PredictNext(int room, int prev_room, size_t max_count) const
+{
+    std::vector<int> rooms;
+    auto it_from = _history.find(room);
+    if (it_from != _history.end())
+    {
+        std::vector<std::pair<int, uint32_t>> counts(it_from->second.begin(), it_from->second.end());
+        // most frequent first; the lower room number first if equally frequent
+        std::stable_sort(counts.begin(), counts.end(),
+            [](const std::pair<int, uint32_t> &a, const std::pair<int, uint32_t> &b)
+            { return a.second > b.second; });
+        for (const auto &c : counts)
+            rooms.push_back(c.first);
+    }
+    if (prev_room >= 0 && prev_room != room &&
+        std::find(rooms.begin(), rooms.end(), prev_room) == rooms.end())
+        rooms.push_back(prev_room);
+    if (rooms.size() > max_count)
+        rooms.resize(max_count);
+    return rooms;
+}
+
+void RoomPreloader::ResetHistory()
+{
+    _history.clear();
+}
+
+bool RoomPreloader::HasRoom(int room) const
+{
+    if (_worker->Current == room)
+        return true;
+    for (const auto &req : _worker->Queue)
+        if (req.Room == room)
+            return true;
+    for (const auto &ready : _worker->Ready)
+        if (ready->Room == room)
+            return true;
+    return false;
+}
+
+void RoomPreloader::FreePlace(size_t count)
+{
+    const size_t busy = (_worker->Current >= 0) ? 1u : 0u;
+    while ((_worker->Queue.size() + _worker->Ready.size() + busy + count > _capacity) &&
+           (!_worker->Ready.empty() || !_worker->Queue.empty()))
+    {
+        // Loaded rooms are dropped first, because the pending ones
+        // were requested more recently
+        if (!_worker->Ready.empty())
+            _worker->Ready.pop_front();
+        else
+            _worker->Queue.pop_front();
+    }
+}
+
+void RoomPreloader::LoaderThread()
+{
+    std::unique_lock<std::mutex> lk(_worker->Mutex);
+    while (true)
+    {
+        _worker->CV.wait(lk, [this]() { return _worker->Exit || !_worker->Queue.empty(); });
+        if (_worker->Exit)
+            break;
+        // the request strings are moved out under the lock, as the String's
+        // reference counter is not thread-safe
+        std::unique_ptr<PreloadedRoom> data(new PreloadedRoom());
+        data->Room = _worker->Queue.front().Room;
+        data->Filename = std::move(_worker->Queue.front().Filename);
+        _worker->Queue.pop_front();
+        _worker->Current = data->Room;
+        lk.unlock();
+
+        const bool result = _loader(*data);
+
+        lk.lock();
+        _worker->Current = -1;
+        if (result)
+            _worker->Ready.push_back(std::move(data));
+        _worker->CV.notify_all(); // wake up anyone waiting for this room
+    }
+}
+
+} // namespace Engine
+} // namespace AGS
@@ -0,0 +1,118 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Background loading of the rooms which the player is likely to enter next.
+//
+// The room files are read and their backgrounds and masks are decoded on
+// a worker thread. Anything that depends on the game state or the graphics
+// driver (compiled script, data fixups, conversion to the display format)
+// is left for the game thread, which takes the preloaded data when the room
+// is actually loaded.
+//
+// Next rooms are predicted from the room changes seen earlier in this game
+// session, and the room the player came from.
+//
+//=============================================================================
+#ifndef __AGS_EE_GAME__ROOMPRELOADER_H
+#define __AGS_EE_GAME__ROOMPRELOADER_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "game/roomstruct.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Engine
+{
+
+using Common::String;
+
+// Room data read in background
+struct PreloadedRoom
+{
+    int     Room = -1;
+    String  Filename;
+    Common::RoomStruct Data;
+    // Serialized compiled script, which must be created on the game thread
+    std::vector<uint8_t> ScriptData;
+};
+
+class RoomPreloader
+{
+public:
+    // Reads the room, which Room and Filename are already set;
+    // is called on the worker thread
+    typedef std::function<bool(PreloadedRoom &room)> LoadFn;
+
+    RoomPreloader();
+    ~RoomPreloader();
+
+    // Assigns the room reading function
+    void   SetLoader(LoadFn loader);
+    // Sets the max number of rooms kept in memory, including the ones
+    // pending to load; 0 disables preloading
+    void   SetCapacity(size_t count);
+    size_t GetCapacity() const { return _capacity; }
+
+    // Queues the room for loading in background, unless it's already
+    // pending or loaded. Discards the oldest rooms if there's no free place.
+    void   Preload(int room, const String &filename);
+    // Tells if the room is pending or loaded
+    bool   IsPreloaded(int room) const;
+    // Takes the room data out of the preloader, waits for it if it's being
+    // loaded right now. Returns null if the room was not loaded yet,
+    // or failed to load, in which case the room is removed from the queue.
+    std::unique_ptr<PreloadedRoom> Take(int room, const String &filename);
+    // Stops the worker and discards all the rooms
+    void   Reset();
+
+    // Remembers the room change, for predicting the next rooms
+    void   NoteRoomChange(int from_room, int to_room);
+    // Predicts the rooms the player is likely to go to from the given room,
+    // most likely first: the rooms most often entered from this one earlier,
+    // followed by the room the player came from.
+    std::vector<int> PredictNext(int room, int prev_room, size_t max_count) const;
+    // Forgets all the room changes
+    void   ResetHistory();
+
+private:
+    struct Request
+    {
+        int    Room;
+        String Filename;
+    };
+    struct WorkerState;
+
+    // Worker thread's function
+    void LoaderThread();
+    // Tells if the room is found in any of the lists; must be called under lock
+    bool HasRoom(int room) const;
+    // Discards the oldest rooms until there's place for count more;
+    // must be called under lock
+    void FreePlace(size_t count);
+
+    LoadFn _loader;
+    size_t _capacity = 0u;
+    std::unique_ptr<WorkerState> _worker;
+    // Number of changes to each room, per room they were made from
+    std::map<int, std::map<int, uint32_t>> _history;
+};
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_GAME__ROOMPRELOADER_H
@@ -11,6 +11,8 @@
 // http://www.opensource.org/licenses/artistic-license-2.0.php
 //
 //=============================================================================
+#include <chrono>
+#include <future>
 #include "ac/character.h"
 #include "ac/common.h"
 #include "ac/draw.h"
@@ -41,6 +43,8 @@
 #include "gfx/graphicsdriver.h"
 #include "game/savegame.h"
 #include "game/savegame_components.h"
+#include "game/savegame_compress.h"
+#include "game/savegame_delta.h"
 #include "game/savegame_internal.h"
 #include "main/game_run.h"
 #include "main/engine.h"
@@ -53,6 +57,7 @@
 #include "script/cc_common.h"
 #include "util/alignedstream.h"
 #include "util/file.h"
+#include "util/memorystream.h"
 #include "util/stream.h"
 #include "util/string_utils.h"
 #include "media/audio/audio_system.h"
@@ -705,8 +710,62 @@ HSaveError DoAfterRestore(const PreservedParams &pp, RestoredData &r_data)
     return HSaveError::None();
 }
 
-HSaveError RestoreGameState(Stream *in, SavegameVersion svg_version)
+// Reads the delta save's components, merges them with the ones of its bases,
+// and writes the resulting full list of components into the memory buffer
+static HSaveError ResolveDeltaSave(Stream *in, SavegameVersion svg_version, const String &filename,
+    std::vector<uint8_t> &data)
 {
+    SavegameDelta::ComponentList list;
+    HSaveError err = SavegameDelta::ReadComponentList(in, svg_version, list);
+    if (!err)
+        return err;
+    err = SavegameDelta::ResolveChain(filename, list,
+        [](const String &base_file, SavegameDelta::ComponentList &base_list)
+        {
+            SavegameSource src;
+            SavegameDescription desc;
+            HSaveError err = OpenSavegame(base_file, src, desc, kSvgDesc_None);
+            if (!err)
+                return err;
+            std::vector<uint8_t> buf;
+            std::unique_ptr<Stream> buf_in;
+            Stream *in;
+            err = OpenSaveData(src.InputStream.get(), buf, buf_in, in);
+            if (!err)
+                return err;
+            return SavegameDelta::ReadComponentList(in, src.Version, base_list);
+        });
+    if (!err)
+        return err;
+    VectorStream out(data, kStream_Write);
+    SavegameDelta::WriteComponentList(list, &out);
+    return HSaveError::None();
+}
+
+HSaveError RestoreGameState(Stream *in, SavegameVersion svg_version, const String &filename)
+{
+    // Compressed data must be unpacked, and delta save must be merged
+    // with its bases before reading
+    std::vector<uint8_t> unpacked_data, merged_data;
+    std::unique_ptr<Stream> unpacked_in, merged_in;
+    SavegameDelta::ChainLink link;
+    if (svg_version >= kSvgVersion_Components)
+    {
+        HSaveError err = OpenSaveData(in, unpacked_data, unpacked_in, in);
+        if (!err)
+            return err;
+    }
+    if (svg_version >= kSvgVersion_Components &&
+        SavegameDelta::PeekChainLink(in, svg_version, link) && !link.BaseSuffix.IsEmpty())
+    {
+        HSaveError err = ResolveDeltaSave(in, svg_version, filename, merged_data);
+        if (!err)
+            return err;
+        merged_in.reset(new MemoryStream(merged_data.data(), merged_data.size()));
+        in = merged_in.get();
+        svg_version = kSvgVersion_Current;
+    }
+
     PreservedParams pp;
     RestoredData r_data;
     DoBeforeRestore(pp);
@@ -797,6 +856,227 @@ void SaveGameState(Stream *out)
     SavegameComponents::WriteAllCommon(out);
 }
 
+// Tracks the changes in between the incremental saves
+static SavegameDelta::Tracker SaveTracker;
+
+// Returns the suffix which makes the name of the delta chain's base save file
+static String MakeBaseSuffix(size_t index)
+{
+    return String::FromFormat(".d%zu", index);
+}
+
+// Tests if the file still has the last save written by the tracker
+static bool IsLastTrackedSave(const String &filename)
+{
+    SavegameSource src;
+    SavegameDescription desc;
+    if (!OpenSavegame(filename, src, desc, kSvgDesc_None))
+        return false;
+    std::vector<uint8_t> buf;
+    std::unique_ptr<Stream> buf_in;
+    Stream *in;
+    if (!OpenSaveData(src.InputStream.get(), buf, buf_in, in))
+        return false;
+    SavegameDelta::ChainLink link;
+    return SavegameDelta::PeekChainLink(in, src.Version, link) &&
+        link.SaveId == SaveTracker.GetSaveId();
+}
+
+// Deletes the base saves of the save's delta chain
+static void DeleteBaseSaves(const String &filename)
+{
+    for (size_t i = 0; i < SavegameDelta::MaxChainLength; ++i)
+    {
+        String base_file = String::FromFormat("%s%s", filename.GetCStr(), MakeBaseSuffix(i).GetCStr());
+        if (File::IsFile(base_file))
+            File::DeleteFile(base_file);
+    }
+}
+
+// Savegame prepared for writing into the file. NOTE: strings here must not
+// share their buffers with any other ones, because the job may be done
+// on another thread.
+struct SavegameJob
+{
+    String Filename;
+    // Delta's base, moved aside from the save's place;
+    // it's moved back if the save could not be written
+    String BaseFile;
+    // Whether to delete the previous delta chain after writing
+    bool   DeleteBases = false;
+    SavegameCompression Compression = kSvgCompress_None;
+    std::vector<uint8_t> Header; // signature and description
+    std::vector<uint8_t> Data; // list of components
+};
+
+// Serializes the game state for the incremental save, selects the changed
+// components, and moves the previous save aside if the delta is written
+static HSaveError PrepareIncrementalSave(SavegameJob &job, const String &filename, size_t max_chain)
+{
+    SavegameDelta::ComponentList comps;
+    SavegameDelta::RoomStateMap rooms;
+    HSaveError err = SavegameComponents::SerializeAll(comps, rooms);
+    if (!err)
+        return err;
+
+    // The save may be written as a delta if the file still has our last save;
+    // in which case the last save is moved aside to become the delta's base
+    String base_suffix, base_file;
+    if (SaveTracker.CanWriteDelta(filename, max_chain) && IsLastTrackedSave(filename))
+    {
+        base_suffix = MakeBaseSuffix(SaveTracker.GetChainLength());
+        base_file = String::FromFormat("%s%s", filename.GetCStr(), base_suffix.GetCStr());
+        if (File::IsFile(base_file))
+            File::DeleteFile(base_file);
+        if (!File::RenameFile(filename, base_file))
+            base_file.Empty();
+    }
+    if (!base_file.IsEmpty())
+        SaveTracker.MakeDelta(base_suffix, comps, rooms);
+    else
+        SaveTracker.MakeFull(filename, comps, rooms, MAX_ROOMS);
+    job.BaseFile = base_file;
+    // Full save starts a new chain, previous bases are no longer needed
+    job.DeleteBases = base_file.IsEmpty();
+    VectorStream out(job.Data, kStream_Write);
+    SavegameDelta::WriteComponentList(comps, &out);
+    return HSaveError::None();
+}
+
+// Compresses and writes the prepared savegame
+static HSaveError WriteSavegameJob(const SavegameJob &job)
+{
+    std::unique_ptr<Stream> out(File::CreateFile(job.Filename));
+    if (!out)
+    {
+        if (!job.BaseFile.IsEmpty())
+            File::RenameFile(job.BaseFile, job.Filename);
+        return new SavegameError(kSvgErr_FileOpenFailed, String::FromFormat("Requested filename: %s.", job.Filename.GetCStr()));
+    }
+    out->Write(job.Header.data(), job.Header.size());
+    HSaveError err = WriteSaveData(job.Data, job.Compression, out.get());
+    out.reset();
+    if (!err)
+    {
+        // don't leave the broken save, bring back the base if there was one
+        File::DeleteFile(job.Filename);
+        if (!job.BaseFile.IsEmpty())
+            File::RenameFile(job.BaseFile, job.Filename);
+        return err;
+    }
+    if (job.DeleteBases)
+        DeleteBaseSaves(job.Filename);
+    return HSaveError::None();
+}
+
+// The save being written in background
+static std::future<HSaveError> BackgroundSave;
+// Whether the background save's result should be committed to the tracker
+static bool BackgroundSaveTracked = false;
+// Whether the background save has completed, and its result
+static bool BackgroundSaveCompleted = false;
+static HSaveError BackgroundSaveResult;
+
+// Waits for the background save, and remembers its result
+static void FinishBackgroundSave()
+{
+    if (!BackgroundSave.valid())
+        return;
+    HSaveError err = BackgroundSave.get();
+    if (BackgroundSaveTracked)
+        SaveTracker.Commit(static_cast<bool>(err));
+    BackgroundSaveCompleted = true;
+    BackgroundSaveResult = err;
+}
+
+HSaveError WriteSavegame(const String &filename, const String &user_text, const Bitmap *user_image,
+    const SavegameWriteOptions &opts)
+{
+    // Only one save may be written at a time
+    FinishBackgroundSave();
+
+    std::shared_ptr<SavegameJob> job(new SavegameJob());
+    job->Filename = filename.GetCStr(); // make an unshared copy
+    job->Compression = opts.Compression;
+    {
+        VectorStream out(job->Header, kStream_Write);
+        out.Write(SavegameSource::Signature.GetCStr(), SavegameSource::Signature.GetLength());
+        // CHECKME: what is this plugin hook suppose to mean, and if it is called here correctly
+        pl_run_plugin_hooks(AGSE_PRESAVEGAME, 0);
+        WriteDescription(&out, user_text, user_image);
+    }
+
+    DoBeforeSave();
+    HSaveError err;
+    if (opts.Incremental)
+    {
+        err = PrepareIncrementalSave(*job, filename, opts.MaxChain);
+        job->BaseFile = job->BaseFile.GetCStr(); // make an unshared copy
+    }
+    else
+    {
+        VectorStream out(job->Data, kStream_Write);
+        err = SavegameComponents::WriteAllCommon(&out);
+    }
+    if (!err)
+        return err;
+
+    if (opts.Background)
+    {
+        BackgroundSaveTracked = opts.Incremental;
+        BackgroundSave = std::async(std::launch::async, [job]() { return WriteSavegameJob(*job); });
+        return HSaveError::None();
+    }
+    err = WriteSavegameJob(*job);
+    if (opts.Incremental)
+        SaveTracker.Commit(static_cast<bool>(err));
+    return err;
+}
+
+bool IsSavingInBackground()
+{
+    return BackgroundSave.valid();
+}
+
+void WaitBackgroundSave()
+{
+    FinishBackgroundSave();
+}
+
+bool PollBackgroundSave(HSaveError &err)
+{
+    if (BackgroundSave.valid() &&
+        BackgroundSave.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        FinishBackgroundSave();
+    if (!BackgroundSaveCompleted)
+        return false;
+    err = BackgroundSaveResult;
+    BackgroundSaveCompleted = false;
+    BackgroundSaveResult = HSaveError::None();
+    return true;
+}
+
+void DeleteSavegame(const String &filename)
+{
+    File::DeleteFile(filename);
+    DeleteBaseSaves(filename);
+}
+
+bool RenameSavegame(const String &old_name, const String &new_name)
+{
+    DeleteBaseSaves(new_name);
+    if (!File::RenameFile(old_name, new_name))
+        return false;
+    for (size_t i = 0; i < SavegameDelta::MaxChainLength; ++i)
+    {
+        const String suffix = MakeBaseSuffix(i);
+        String old_base = String::FromFormat("%s%s", old_name.GetCStr(), suffix.GetCStr());
+        if (File::IsFile(old_base))
+            File::RenameFile(old_base, String::FromFormat("%s%s", new_name.GetCStr(), suffix.GetCStr()));
+    }
+    return true;
+}
+
 void ReadPluginSaveData(Stream *in)
 {
     auto pluginFileHandle = AGSE_RESTOREGAME;
@@ -92,6 +92,28 @@ String GetSavegameErrorText(SavegameErrorType err);
 typedef TypedCodeError<SavegameErrorType, GetSavegameErrorText> SavegameError;
 typedef ErrorHandle<SavegameError> HSaveError;
 
+// Compression of the savegame's game data
+enum SavegameCompression
+{
+    kSvgCompress_None,
+    kSvgCompress_Zlib,
+    kSvgCompress_LZW,
+    kNumSvgCompressions
+};
+
+// Savegame writing options
+struct SavegameWriteOptions
+{
+    SavegameCompression Compression = kSvgCompress_None;
+    // Write only the changes since the previous save into the same file,
+    // keeping the previous save aside as a base; otherwise a full save is
+    // written. MaxChain limits the number of such saves in a row.
+    bool   Incremental = false;
+    size_t MaxChain = 0u;
+    // Compress and write the save on a background thread
+    bool   Background = false;
+};
+
 // SavegameSource defines a successfully opened savegame stream
 struct SavegameSource
 {
@@ -158,14 +180,32 @@ HSaveError     OpenSavegame(const String &filename, SavegameSource &src,
 // Opens savegame and reads the savegame description
 HSaveError     OpenSavegame(const String &filename, SavegameDescription &desc, SavegameDescElem elems = kSvgDesc_All);
 
-// Reads the game data from the save stream and reinitializes game state
-HSaveError     RestoreGameState(Stream *in, SavegameVersion svg_version);
+// Reads the game data from the save stream and reinitializes game state;
+// filename is required to find the base saves if this is a delta save
+HSaveError     RestoreGameState(Stream *in, SavegameVersion svg_version, const String &filename);
 
 // Opens savegame for writing and puts in savegame description
 Stream*        StartSavegame(const String &filename, const String &user_text, const Bitmap *user_image);
 
 // Prepares game for saving state and writes game data into the save stream
 void           SaveGameState(Stream *out);
+// Prepares game for saving state, takes a snapshot of it, and writes the
+// savegame according to the options. If the save is written in background,
+// returns as soon as the snapshot is taken, and the result of writing is
+// reported by PollBackgroundSave later.
+HSaveError     WriteSavegame(const String &filename, const String &user_text,
+                             const Bitmap *user_image, const SavegameWriteOptions &opts);
+// Tells if there's a save being written in background
+bool           IsSavingInBackground();
+// Waits until the save being written in background is complete
+void           WaitBackgroundSave();
+// Tests if the save written in background has completed since the last
+// call, and gets its result
+bool           PollBackgroundSave(HSaveError &err);
+// Deletes the savegame file along with its delta chain's base saves
+void           DeleteSavegame(const String &filename);
+// Renames the savegame file along with its delta chain's base saves
+bool           RenameSavegame(const String &old_name, const String &new_name);
 
 } // namespace Engine
 } // namespace AGS
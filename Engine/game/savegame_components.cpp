@@ -49,6 +49,7 @@
 #include "script/cc_common.h"
 #include "script/script.h"
 #include "util/filestream.h" // TODO: needed only because plugins expect file handle
+#include "util/memorystream.h"
 #include "media/audio/audio_system.h"
 
 using namespace Common;
@@ -1022,6 +1023,47 @@ HSaveError ReadRoomStates(Stream *in, int32_t cmp_ver, const PreservedParams& /*
     return HSaveError::None();
 }
 
+HSaveError ReadRoomStatesDelta(Stream *in, int32_t cmp_ver, const PreservedParams& /*pp*/, RestoredData& /*r_data*/)
+{
+    HSaveError err;
+    int roomstat_count = in->ReadInt32();
+    for (; roomstat_count > 0; --roomstat_count)
+    {
+        int id = in->ReadInt32();
+        if (!AssertCompatRange(err, id, 0, MAX_ROOMS - 1, "room index"))
+            return err;
+        // The room state either replaces the one from the base save, or is removed
+        bool has_state = in->ReadInt8() != 0;
+        resetRoomStatus(id);
+        if (!has_state)
+            continue;
+        if (!AssertFormatTagStrict(err, in, "RoomState", true))
+            return err;
+        RoomStatus *roomstat = getRoomStatus(id);
+        roomstat->ReadFromSavegame(in, (RoomStatSvgVersion)cmp_ver);
+        if (!AssertFormatTagStrict(err, in, "RoomState", false))
+            return err;
+    }
+    return HSaveError::None();
+}
+
+// Serializes room states one by one, for the incremental saves
+void SerializeRoomStates(SavegameDelta::RoomStateMap &rooms)
+{
+    for (int i = 0; i < MAX_ROOMS; ++i)
+    {
+        if (isRoomStatusValid(i))
+        {
+            RoomStatus *roomstat = getRoomStatus(i);
+            if (roomstat->beenhere)
+            {
+                VectorStream out(rooms[i], kStream_Write);
+                roomstat->WriteToSavegame(&out);
+            }
+        }
+    }
+}
+
 HSaveError WriteThisRoom(Stream *out)
 {
     out->WriteInt32(displayed_room);
@@ -1140,6 +1182,15 @@ HSaveError ReadManagedPool(Stream *in, int32_t /*cmp_ver*/, const PreservedParam
     return HSaveError::None();
 }
 
+HSaveError ReadSavegameChain(Stream *in, int32_t /*cmp_ver*/, const PreservedParams& /*pp*/, RestoredData& /*r_data*/)
+{
+    // The delta chain is resolved before reading the components,
+    // so here the link is only skipped
+    SavegameDelta::ChainLink link;
+    SavegameDelta::ReadChainLink(link, in);
+    return HSaveError::None();
+}
+
 HSaveError WritePluginData(Stream *out)
 {
     WritePluginSaveData(out);
@@ -1166,6 +1217,13 @@ struct ComponentHandler
 // Array of supported components
 ComponentHandler ComponentHandlers[] =
 {
+    {
+        "Savegame Chain", // must correspond to SavegameDelta::ChainLinkName
+        0,
+        0,
+        nullptr, // written only by the incremental save
+        ReadSavegameChain
+    },
     {
         "Game State",
         kGSSvgVersion_350_10,
@@ -1257,6 +1315,13 @@ ComponentHandler ComponentHandlers[] =
         WriteRoomStates,
         ReadRoomStates
     },
+    {
+        "Room States Delta",
+        kRoomStatSvgVersion_36041, // must correspond to "Room States"
+        kRoomStatSvgVersion_Initial,
+        nullptr, // written only by the incremental save
+        ReadRoomStatesDelta
+    },
     {
         "Loaded Room State",
         kRoomStatSvgVersion_36041, // must correspond to "Room States"
@@ -1405,6 +1470,8 @@ HSaveError WriteAllCommon(Stream *out)
     WriteFormatTag(out, ComponentListTag, true);
     for (int type = 0; !ComponentHandlers[type].Name.IsEmpty(); ++type)
     {
+        if (!ComponentHandlers[type].Serialize)
+            continue;
         HSaveError err = WriteComponent(out, ComponentHandlers[type]);
         if (!err)
         {
@@ -1417,6 +1484,40 @@ HSaveError WriteAllCommon(Stream *out)
     return HSaveError::None();
 }
 
+HSaveError SerializeAll(SavegameDelta::ComponentList &comps, SavegameDelta::RoomStateMap &rooms)
+{
+    comps.clear();
+    rooms.clear();
+    for (int type = 0; !ComponentHandlers[type].Name.IsEmpty(); ++type)
+    {
+        const ComponentHandler &hdlr = ComponentHandlers[type];
+        if (!hdlr.Serialize)
+            continue;
+        SavegameDelta::Component comp;
+        comp.Name = hdlr.Name;
+        comp.Version = hdlr.Version;
+        if (hdlr.Serialize == WriteRoomStates)
+        {
+            // Room states are kept separately, so that their changes could be
+            // tracked per room; the component's data is filled by the caller
+            SerializeRoomStates(rooms);
+        }
+        else
+        {
+            VectorStream out(comp.Data, kStream_Write);
+            HSaveError err = hdlr.Serialize(&out);
+            if (!err)
+            {
+                return new SavegameError(kSvgErr_ComponentSerialization,
+                    String::FromFormat("Component: (#%d) %s", type, hdlr.Name.GetCStr()),
+                    err);
+            }
+        }
+        comps.push_back(std::move(comp));
+    }
+    return HSaveError::None();
+}
+
 } // namespace SavegameBlocks
 } // namespace Engine
 } // namespace AGS
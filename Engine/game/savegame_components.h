@@ -15,6 +15,7 @@
 #define __AGS_EE_GAME__SAVEGAMECOMPONENTS_H
 
 #include "game/savegame.h"
+#include "game/savegame_delta.h"
 #include "util/stream.h"
 
 namespace AGS
@@ -37,6 +38,10 @@ namespace SavegameComponents
     HSaveError    ReadAll(Stream *in, SavegameVersion svg_version, const PreservedParams &pp, RestoredData &r_data);
     // Writes a full list of common components to the stream
     HSaveError    WriteAllCommon(Stream *out);
+    // Serializes common components into the list, for the incremental saves;
+    // room states are serialized per room, and "Room States" component is
+    // added to the list with empty data
+    HSaveError    SerializeAll(SavegameDelta::ComponentList &comps, SavegameDelta::RoomStateMap &rooms);
 
     // Utility functions for reading and writing legacy interactions,
     // or their "times run" counters separately.
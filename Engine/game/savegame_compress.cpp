@@ -0,0 +1,118 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "game/savegame_compress.h"
+#include "util/compress.h"
+#include "util/lzw.h"
+#include "util/memorystream.h"
+#include "util/png.h"
+#include "util/stream.h"
+
+using namespace AGS::Common;
+
+namespace AGS
+{
+namespace Engine
+{
+
+static const String CompressedDataTag = "<Compressed>";
+// The upper limit of the unpacked game data size, guards against allocating
+// arbitrary amounts of memory when reading a broken or malicious save
+static const soff_t MaxUnpackedSaveSize = 1024 * 1024 * 1024;
+// Neither deflate nor our LZW may expand the data more than this many times
+static const soff_t MaxSaveCompressionRatio = 1032;
+
+HSaveError WriteSaveData(const std::vector<uint8_t> &data, SavegameCompression compression, Stream *out)
+{
+    if (compression == kSvgCompress_None)
+    {
+        out->Write(data.data(), data.size());
+        return HSaveError::None();
+    }
+    out->Write(CompressedDataTag.GetCStr(), CompressedDataTag.GetLength());
+    out->WriteInt32(compression);
+    out->WriteInt64(data.size());
+    soff_t ref_pos = out->GetPosition();
+    out->WriteInt64(0); // placeholder for the packed data size
+    if (compression == kSvgCompress_Zlib)
+    {
+        MemoryStream mem_in(data.data(), data.size());
+        if (!pngcompress(&mem_in, out, Z_DEFAULT_COMPRESSION))
+            return new SavegameError(kSvgErr_ComponentSerialization, "Failed to compress the game data.");
+    }
+    else
+    {
+        lzw_compress(data.data(), data.size(), 1, out);
+    }
+    soff_t end_pos = out->GetPosition();
+    out->Seek(ref_pos, kSeekBegin);
+    out->WriteInt64(end_pos - ref_pos - sizeof(int64_t));
+    out->Seek(end_pos, kSeekBegin);
+    return HSaveError::None();
+}
+
+HSaveError OpenSaveData(Stream *in, std::vector<uint8_t> &buf, std::unique_ptr<Stream> &buf_in, Stream *&data_in)
+{
+    data_in = in;
+    const soff_t pos = in->GetPosition();
+    String tag = String::FromStreamCount(in, CompressedDataTag.GetLength());
+    if (tag.Compare(CompressedDataTag) != 0)
+    {
+        in->Seek(pos, kSeekBegin);
+        return HSaveError::None();
+    }
+
+    const SavegameCompression compression = static_cast<SavegameCompression>(in->ReadInt32());
+    const soff_t data_size = in->ReadInt64();
+    const soff_t packed_size = in->ReadInt64();
+    if (data_size < 0 || packed_size < 0 || packed_size > in->GetLength() - in->GetPosition() ||
+        data_size > MaxUnpackedSaveSize || data_size > packed_size * MaxSaveCompressionRatio)
+        return new SavegameError(kSvgErr_InconsistentFormat,
+            String::FromFormat("Invalid compressed data size: %jd, packed: %jd.",
+                static_cast<intmax_t>(data_size), static_cast<intmax_t>(packed_size)));
+    buf.resize(static_cast<size_t>(data_size));
+    switch (compression)
+    {
+    case kSvgCompress_Zlib:
+    {
+        if (buf.empty())
+            break;
+        std::vector<uint8_t> packed(static_cast<size_t>(packed_size));
+        in->Read(packed.data(), packed.size());
+        if (!pngexpand(packed.data(), packed.size(), buf.data(), buf.size()))
+            return new SavegameError(kSvgErr_InconsistentFormat, "Failed to unpack the game data.");
+        break;
+    }
+    case kSvgCompress_LZW:
+    {
+        if (buf.empty())
+            break;
+        std::vector<uint8_t> packed(static_cast<size_t>(packed_size));
+        in->Read(packed.data(), packed.size());
+        size_t unpacked_size = 0;
+        if (!lzwexpand(packed.data(), packed.size(), buf.data(), buf.size(), unpacked_size) ||
+            unpacked_size != buf.size())
+            return new SavegameError(kSvgErr_InconsistentFormat, "Failed to unpack the game data.");
+        break;
+    }
+    default:
+        return new SavegameError(kSvgErr_InconsistentFormat,
+            String::FromFormat("Unsupported compression type: %d.", compression));
+    }
+    buf_in.reset(new MemoryStream(buf.data(), buf.size()));
+    data_in = buf_in.get();
+    return HSaveError::None();
+}
+
+} // namespace Engine
+} // namespace AGS
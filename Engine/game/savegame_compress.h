@@ -0,0 +1,44 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Compression of the savegame's game data (the list of components).
+//
+// Compressed data begins with a tag, followed by the compression type,
+// sizes of the unpacked and packed data, and the packed data itself.
+// Uncompressed data is written as is, so older saves are read too.
+//
+//=============================================================================
+#ifndef __AGS_EE_GAME__SAVEGAMECOMPRESS_H
+#define __AGS_EE_GAME__SAVEGAMECOMPRESS_H
+
+#include <memory>
+#include <vector>
+#include "game/savegame.h"
+
+namespace AGS
+{
+namespace Engine
+{
+
+// Writes the list of components into the save, compressing it if requested
+HSaveError WriteSaveData(const std::vector<uint8_t> &data, SavegameCompression compression, Stream *out);
+// Prepares the savegame's list of components for reading: if it's compressed,
+// then unpacks it into the buffer and opens a stream over it. Assigns data_in
+// either to the input stream or to the unpacked data stream.
+HSaveError OpenSaveData(Stream *in, std::vector<uint8_t> &buf, std::unique_ptr<Stream> &buf_in, Stream *&data_in);
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_GAME__SAVEGAMECOMPRESS_H
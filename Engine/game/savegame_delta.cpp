@@ -0,0 +1,404 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "game/savegame_delta.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string.h>
+#include "util/memorystream.h"
+#include "util/path.h"
+#include "util/stream.h"
+#include "util/string_utils.h"
+
+using namespace AGS::Common;
+
+namespace AGS
+{
+namespace Engine
+{
+
+namespace SavegameDelta
+{
+
+const String ChainLinkName       = "Savegame Chain";
+const String RoomStatesName      = "Room States";
+const String RoomStatesDeltaName = "Room States Delta";
+// NOTE: must match the tags used in savegame_components.cpp
+static const String ComponentListTag = "Components";
+static const String RoomStateTag     = "RoomState";
+
+static void WriteTag(Stream *out, const String &tag, bool open)
+{
+    String full_tag = String::FromFormat(open ? "<%s>" : "</%s>", tag.GetCStr());
+    out->Write(full_tag.GetCStr(), full_tag.GetLength());
+}
+
+static bool ReadTag(Stream *in, String &tag, bool open)
+{
+    if (in->ReadByte() != '<')
+        return false;
+    if (!open && in->ReadByte() != '/')
+        return false;
+    tag.Empty();
+    while (!in->EOS())
+    {
+        char c = in->ReadByte();
+        if (c == '>')
+            return true;
+        tag.AppendChar(c);
+    }
+    return false; // reached EOS before closing symbol
+}
+
+static bool AssertTag(Stream *in, const String &tag, bool open)
+{
+    String read_tag;
+    return ReadTag(in, read_tag, open) && read_tag.Compare(tag) == 0;
+}
+
+void WriteChainLink(const ChainLink &link, Stream *out)
+{
+    out->WriteInt64(static_cast<int64_t>(link.SaveId));
+    StrUtil::WriteString(link.BaseSuffix, out);
+    out->WriteInt64(static_cast<int64_t>(link.BaseId));
+}
+
+void ReadChainLink(ChainLink &link, Stream *in)
+{
+    link.SaveId = static_cast<uint64_t>(in->ReadInt64());
+    link.BaseSuffix = StrUtil::ReadString(in);
+    link.BaseId = static_cast<uint64_t>(in->ReadInt64());
+}
+
+static void WriteRoomState(const std::vector<uint8_t> &data, Stream *out)
+{
+    WriteTag(out, RoomStateTag, true);
+    out->Write(data.data(), data.size());
+    WriteTag(out, RoomStateTag, false);
+}
+
+void WriteRoomStates(const RoomStateMap &rooms, int room_count, Stream *out)
+{
+    out->WriteInt32(room_count);
+    auto it = rooms.begin();
+    for (int i = 0; i < room_count; ++i)
+    {
+        for (; it != rooms.end() && it->first < i; ++it);
+        if (it != rooms.end() && it->first == i)
+        {
+            out->WriteInt32(i);
+            WriteRoomState(it->second, out);
+        }
+        else
+        {
+            out->WriteInt32(-1);
+        }
+    }
+}
+
+// Reads component's header, returns the size of its data
+static bool ReadComponentHeader(Stream *in, SavegameVersion svg_version, Component &comp, soff_t &data_size)
+{
+    if (!ReadTag(in, comp.Name, true))
+        return false;
+    comp.Version = in->ReadInt32();
+    data_size = svg_version >= kSvgVersion_Cmp_64bit ? in->ReadInt64() : in->ReadInt32();
+    return true;
+}
+
+HSaveError ReadComponentList(Stream *in, SavegameVersion svg_version, ComponentList &list)
+{
+    list.clear();
+    if (!AssertTag(in, ComponentListTag, true))
+        return new SavegameError(kSvgErr_ComponentListOpeningTagFormat);
+    while (!in->EOS())
+    {
+        // Look out for the end of the component list
+        soff_t off = in->GetPosition();
+        if (AssertTag(in, ComponentListTag, false))
+            return HSaveError::None();
+        in->Seek(off, kSeekBegin);
+
+        Component comp;
+        soff_t data_size;
+        if (!ReadComponentHeader(in, svg_version, comp, data_size))
+            return new SavegameError(kSvgErr_ComponentOpeningTagFormat);
+        if (data_size < 0 || data_size > in->GetLength() - in->GetPosition())
+            return new SavegameError(kSvgErr_ComponentSizeMismatch,
+                String::FromFormat("Component: %s, size: %jd", comp.Name.GetCStr(), static_cast<intmax_t>(data_size)));
+        comp.Data.resize(static_cast<size_t>(data_size));
+        in->Read(comp.Data.data(), comp.Data.size());
+        if (!AssertTag(in, comp.Name, false))
+            return new SavegameError(kSvgErr_ComponentClosingTagFormat);
+        list.push_back(std::move(comp));
+    }
+    return new SavegameError(kSvgErr_ComponentListClosingTagMissing);
+}
+
+void WriteComponentList(const ComponentList &list, Stream *out)
+{
+    WriteTag(out, ComponentListTag, true);
+    for (const auto &comp : list)
+    {
+        WriteTag(out, comp.Name, true);
+        out->WriteInt32(comp.Version);
+        out->WriteInt64(comp.Data.size());
+        out->Write(comp.Data.data(), comp.Data.size());
+        WriteTag(out, comp.Name, false);
+    }
+    WriteTag(out, ComponentListTag, false);
+}
+
+bool PeekChainLink(Stream *in, SavegameVersion svg_version, ChainLink &link)
+{
+    const soff_t pos = in->GetPosition();
+    Component comp;
+    soff_t data_size;
+    bool found = AssertTag(in, ComponentListTag, true) &&
+        ReadComponentHeader(in, svg_version, comp, data_size) &&
+        comp.Name.Compare(ChainLinkName) == 0;
+    if (found)
+        ReadChainLink(link, in);
+    in->Seek(pos, kSeekBegin);
+    return found;
+}
+
+static bool FindChainLink(const ComponentList &list, ChainLink &link)
+{
+    for (const auto &comp : list)
+    {
+        if (comp.Name.Compare(ChainLinkName) != 0)
+            continue;
+        MemoryStream in(comp.Data.data(), comp.Data.size());
+        ReadChainLink(link, &in);
+        return true;
+    }
+    return false;
+}
+
+void MergeDelta(ComponentList &base, const ComponentList &delta)
+{
+    for (const auto &comp : delta)
+    {
+        if (comp.Name.Compare(RoomStatesDeltaName) == 0)
+        {
+            // Room changes are applied on top of the full room states,
+            // in the order in which they were saved
+            auto it = std::find_if(base.begin(), base.end(),
+                [](const Component &c) { return c.Name.Compare(RoomStatesName) == 0; });
+            if (it != base.end())
+                ++it;
+            for (; it != base.end() && it->Name.Compare(RoomStatesDeltaName) == 0; ++it);
+            base.insert(it, comp);
+            continue;
+        }
+
+        auto it = std::find_if(base.begin(), base.end(),
+            [&comp](const Component &c) { return c.Name.Compare(comp.Name) == 0; });
+        if (it != base.end())
+            *it = comp;
+        else
+            base.push_back(comp);
+    }
+}
+
+HSaveError ResolveChain(const String &filename, ComponentList &list, ListLoader loader)
+{
+    ChainLink link;
+    if (!FindChainLink(list, link) || link.BaseSuffix.IsEmpty())
+        return HSaveError::None(); // not a delta
+
+    std::vector<ComponentList> chain;
+    chain.push_back(std::move(list));
+    while (!link.BaseSuffix.IsEmpty())
+    {
+        if (chain.size() > MaxChainLength)
+            return new SavegameError(kSvgErr_InconsistentFormat, "Savegame chain is too long.");
+        ComponentList base;
+        HSaveError err = loader(String::FromFormat("%s%s", filename.GetCStr(), link.BaseSuffix.GetCStr()), base);
+        if (!err)
+            return new SavegameError(kSvgErr_InconsistentData,
+                String::FromFormat("Failed to load the base save: %s.", link.BaseSuffix.GetCStr()), err);
+        ChainLink base_link;
+        if (!FindChainLink(base, base_link) || base_link.SaveId != link.BaseId)
+            return new SavegameError(kSvgErr_InconsistentData,
+                String::FromFormat("The base save does not match: %s.", link.BaseSuffix.GetCStr()));
+        chain.push_back(std::move(base));
+        link = base_link;
+    }
+
+    list = std::move(chain.back());
+    for (size_t i = chain.size() - 1; i-- > 0;)
+        MergeDelta(list, chain[i]);
+    return HSaveError::None();
+}
+
+static Component MakeChainLinkComponent(const ChainLink &link)
+{
+    Component comp;
+    comp.Name = ChainLinkName;
+    VectorStream out(comp.Data, kStream_Write);
+    WriteChainLink(link, &out);
+    return comp;
+}
+
+void Tracker::Reset()
+{
+    _last = SaveState();
+    _pending = SaveState();
+}
+
+bool Tracker::CanWriteDelta(const String &filename, size_t max_chain) const
+{
+    return _last.SaveId != 0u && Path::ComparePaths(_last.Filename, filename) == 0 &&
+        _last.ChainLength < std::min(max_chain, MaxChainLength);
+}
+
+void Tracker::HashAll(const ComponentList &comps, const RoomStateMap &rooms, SaveState &state)
+{
+    for (const auto &comp : comps)
+    {
+        if (comp.Name.Compare(RoomStatesName) == 0)
+            continue; // tracked per room
+        state.Components[comp.Name] =
+            HashData(comp.Data.data(), comp.Data.size()) ^ static_cast<uint32_t>(comp.Version);
+    }
+    for (const auto &room : rooms)
+        state.Rooms[room.first] = HashData(room.second.data(), room.second.size());
+}
+
+void Tracker::MakeFull(const String &filename, ComponentList &comps,
+    const RoomStateMap &rooms, int room_count)
+{
+    _pending = SaveState();
+    _pending.Filename = filename;
+    _pending.SaveId = MakeSaveId();
+    HashAll(comps, rooms, _pending);
+
+    for (auto &comp : comps)
+    {
+        if (comp.Name.Compare(RoomStatesName) != 0)
+            continue;
+        comp.Data.clear();
+        VectorStream out(comp.Data, kStream_Write);
+        WriteRoomStates(rooms, room_count, &out);
+    }
+    ChainLink link;
+    link.SaveId = _pending.SaveId;
+    comps.insert(comps.begin(), MakeChainLinkComponent(link));
+}
+
+void Tracker::MakeDelta(const String &base_suffix, ComponentList &comps, const RoomStateMap &rooms)
+{
+    _pending = SaveState();
+    _pending.Filename = _last.Filename;
+    _pending.SaveId = MakeSaveId();
+    _pending.ChainLength = _last.ChainLength + 1;
+    HashAll(comps, rooms, _pending);
+
+    ComponentList delta;
+    ChainLink link;
+    link.SaveId = _pending.SaveId;
+    link.BaseSuffix = base_suffix;
+    link.BaseId = _last.SaveId;
+    delta.push_back(MakeChainLinkComponent(link));
+    for (auto &comp : comps)
+    {
+        if (comp.Name.Compare(RoomStatesName) == 0)
+        {
+            // Write changed room states, and mark the removed ones
+            std::vector<uint8_t> data;
+            VectorStream out(data, kStream_Write);
+            out.WriteInt32(0); // placeholder for the count
+            int32_t count = 0;
+            for (const auto &room : rooms)
+            {
+                auto it = _last.Rooms.find(room.first);
+                if (it != _last.Rooms.end() && it->second == _pending.Rooms[room.first])
+                    continue;
+                out.WriteInt32(room.first);
+                out.WriteInt8(1);
+                WriteRoomState(room.second, &out);
+                count++;
+            }
+            for (const auto &room : _last.Rooms)
+            {
+                if (rooms.count(room.first) > 0)
+                    continue;
+                out.WriteInt32(room.first);
+                out.WriteInt8(0);
+                count++;
+            }
+            if (count == 0)
+                continue;
+            out.Seek(0, kSeekBegin);
+            out.WriteInt32(count);
+            Component room_delta;
+            room_delta.Name = RoomStatesDeltaName;
+            room_delta.Version = comp.Version;
+            room_delta.Data = std::move(data);
+            delta.push_back(std::move(room_delta));
+            continue;
+        }
+
+        auto it = _last.Components.find(comp.Name);
+        if (it != _last.Components.end() && it->second == _pending.Components[comp.Name])
+            continue;
+        delta.push_back(std::move(comp));
+    }
+    comps = std::move(delta);
+}
+
+void Tracker::Commit(bool written)
+{
+    if (written)
+        _last = std::move(_pending);
+    _pending = SaveState();
+}
+
+uint64_t HashData(const uint8_t *data, size_t len)
+{
+    // A multiplicative hash consuming 8 bytes at a time; it's only used
+    // to detect changes in the data, so there's no need for a strong one
+    const uint64_t mul = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = 0xcbf29ce484222325ULL ^ (len * mul);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t))
+    {
+        uint64_t w;
+        memcpy(&w, data + i, sizeof(w));
+        h = (h ^ w) * mul;
+        h ^= h >> 29;
+    }
+    for (; i < len; ++i)
+    {
+        h = (h ^ data[i]) * mul;
+        h ^= h >> 29;
+    }
+    return h;
+}
+
+uint64_t MakeSaveId()
+{
+    static std::mt19937_64 rng(std::random_device{}() ^
+        static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count()));
+    uint64_t id;
+    do { id = rng(); } while (id == 0u);
+    return id;
+}
+
+} // namespace SavegameDelta
+
+} // namespace Engine
+} // namespace AGS
@@ -0,0 +1,155 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Incremental savegames.
+//
+// A delta save contains only the components that changed since its base
+// save, and a reference to the base save file. The base may be a delta save
+// too, which makes a chain of saves ending with a full save. Restoring a delta
+// save loads the whole chain and merges it into a full list of components,
+// which is then read as usual.
+//
+// Changes are detected by comparing hashes of the serialized component data
+// with the ones remembered when writing the previous save. Room states are
+// tracked per room, because there are usually many of them, and only a few
+// change in between the saves.
+//
+//=============================================================================
+#ifndef __AGS_EE_GAME__SAVEGAMEDELTA_H
+#define __AGS_EE_GAME__SAVEGAMEDELTA_H
+
+#include <functional>
+#include <map>
+#include <vector>
+#include "game/savegame.h"
+#include "util/string.h"
+
+namespace AGS
+{
+namespace Engine
+{
+
+namespace SavegameDelta
+{
+    // Serialized savegame component
+    struct Component
+    {
+        String  Name;
+        int32_t Version = 0;
+        std::vector<uint8_t> Data;
+    };
+    typedef std::vector<Component> ComponentList;
+    // Serialized room states, indexed by the room number
+    typedef std::map<int, std::vector<uint8_t>> RoomStateMap;
+
+    // The component which tells the save's place in a delta chain
+    extern const String ChainLinkName;
+    // The regular room states component
+    extern const String RoomStatesName;
+    // The component with only changed and removed room states
+    extern const String RoomStatesDeltaName;
+    // Maximal supported length of a delta chain
+    const size_t MaxChainLength = 64;
+
+    // Save's place in a delta chain
+    struct ChainLink
+    {
+        // Unique id of this save
+        uint64_t SaveId = 0u;
+        // Suffix which makes the base save's filename out of the name
+        // of the restored save file; empty if this is a full save
+        String   BaseSuffix;
+        // Unique id of the base save
+        uint64_t BaseId = 0u;
+    };
+
+    // Serializes chain link component data
+    void WriteChainLink(const ChainLink &link, Stream *out);
+    // Unserializes chain link component data
+    void ReadChainLink(ChainLink &link, Stream *in);
+    // Serializes room states in the regular "Room States" component format
+    void WriteRoomStates(const RoomStateMap &rooms, int room_count, Stream *out);
+
+    // Reads the list of components from the stream
+    HSaveError ReadComponentList(Stream *in, SavegameVersion svg_version, ComponentList &list);
+    // Writes the list of components to the stream
+    void       WriteComponentList(const ComponentList &list, Stream *out);
+    // Tests if the component list in the stream begins with a chain link,
+    // and reads it; restores the stream position after reading
+    bool       PeekChainLink(Stream *in, SavegameVersion svg_version, ChainLink &link);
+    // Merges the delta's components into the base list
+    void       MergeDelta(ComponentList &base, const ComponentList &delta);
+
+    // Loads the list of components from the save file
+    typedef std::function<HSaveError(const String &filename, ComponentList &list)> ListLoader;
+    // Loads all the bases of the given delta save, and merges them into a full list of components;
+    // filename is the name of the restored save, which base file names are made from
+    HSaveError ResolveChain(const String &filename, ComponentList &list, ListLoader loader);
+
+    // Tracker keeps hashes of the last written save, and selects
+    // the components to write into the next one
+    class Tracker
+    {
+    public:
+        // Forgets the last save, next save will be a full one
+        void Reset();
+        // Tells if the next save into this file may be written as a delta
+        bool CanWriteDelta(const String &filename, size_t max_chain) const;
+        // Name of the file which the last save was written into
+        const String &GetFilename() const { return _last.Filename; }
+        // Id of the last save
+        uint64_t GetSaveId() const { return _last.SaveId; }
+        // Number of delta saves on top of the last full save
+        size_t GetChainLength() const { return _last.ChainLength; }
+
+        // Prepares the full save: adds the chain link and room states to
+        // the list of components.
+        void MakeFull(const String &filename, ComponentList &comps,
+            const RoomStateMap &rooms, int room_count);
+        // Prepares the delta save to the last save, which is expected to be
+        // found in the file with base_suffix appended to the save's name: removes
+        // unchanged components from the list, adds the chain link and the changed
+        // room states.
+        void MakeDelta(const String &base_suffix, ComponentList &comps, const RoomStateMap &rooms);
+        // Remembers the prepared save as the last one if it was written
+        // successfully, otherwise discards it
+        void Commit(bool written);
+
+    private:
+        struct SaveState
+        {
+            String   Filename;
+            uint64_t SaveId = 0u;
+            size_t   ChainLength = 0u;
+            std::map<String, uint64_t> Components;
+            std::map<int, uint64_t> Rooms;
+        };
+
+        // Calculates hashes of the components and room states
+        static void HashAll(const ComponentList &comps, const RoomStateMap &rooms, SaveState &state);
+
+        SaveState _last;
+        SaveState _pending;
+    };
+
+    // Calculates 64-bit hash of the data
+    uint64_t HashData(const uint8_t *data, size_t len);
+    // Generates new unique save id
+    uint64_t MakeSaveId();
+}
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_GAME__SAVEGAMEDELTA_H
@@ -21,6 +21,7 @@
 #include "ac/sys_events.h"
 #include "ac/timer.h"
 #include "debug/out.h"
+#include "debug/profiler.h"
 #include "gfx/ali3dexception.h"
 #include "gfx/gfx_def.h"
 #include "gfx/gfxfilter_ogl.h"
@@ -70,12 +71,22 @@ namespace OGL
 
 using namespace AGS::Common;
 
+// Sprite atlas limits: size of a page, max size of an image
+// which may be placed on a page, and max number of pages
+static const int ATLAS_PAGE_SIZE = 2048;
+static const int MAX_ATLAS_SPRITE_SIZE = 256;
+static const size_t MAX_ATLAS_PAGES = 8;
+
 OGLTexture::~OGLTexture()
 {
     if (_tiles)
     {
-        for (size_t i = 0; i < _numTiles; ++i)
-            glDeleteTextures(1, &(_tiles[i].texture));
+        // Atlas textures share the page's texture, which is deleted with the page
+        if (_atlasPage)
+            _atlasPage->Packer.Free(_atlasRect);
+        else
+            for (size_t i = 0; i < _numTiles; ++i)
+                glDeleteTextures(1, &(_tiles[i].texture));
         delete[] _tiles;
     }
     if (_vertex)
@@ -93,6 +104,12 @@ size_t OGLTexture::GetMemSize() const
     return sz;
 }
 
+OGLAtlasPage::~OGLAtlasPage()
+{
+    if (Texture)
+        glDeleteTextures(1, &Texture);
+}
+
 OGLBitmap::~OGLBitmap()
 {
     if (_fbo)
@@ -896,6 +913,7 @@ void OGLGraphicsDriver::UnInit()
   DeleteShaderProgram(_transparencyShader);
   DeleteShaderProgram(_tintShader);
   DeleteShaderProgram(_lightShader);
+  _atlasPages.clear();
 
   DeleteWindowAndGlContext();
   sys_window_destroy();
@@ -1172,6 +1190,7 @@ void OGLGraphicsDriver::_renderSprite(const OGLDrawListEntry *drawListEntry,
     }
 
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    _drawCallCount++;
 
     // Restore default blending mode
     SetBlendOpRGB(GL_FUNC_ADD, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -1196,6 +1215,7 @@ void OGLGraphicsDriver::_render(bool clearDrawListAfterwards)
   }
 #endif
   glm::mat4 projection;
+  _drawCallCount = 0u;
 
   if (_do_render_to_texture)
   {
@@ -1265,11 +1285,13 @@ void OGLGraphicsDriver::_render(bool clearDrawListAfterwards)
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    _drawCallCount++;
 
     glEnable(GL_BLEND);
     glUseProgram(0);
   }
 
+  _lastDrawCallCount = _drawCallCount;
   glFinish();
 
   SDL_GL_SwapWindow(_sdlWindow);
@@ -1429,11 +1451,14 @@ void OGLGraphicsDriver::RenderSpriteBatches(const glm::mat4 &projection)
 size_t OGLGraphicsDriver::RenderSpriteBatch(const OGLSpriteBatch &batch, size_t from,
     const glm::mat4 &projection, const Size &surface_size)
 {
-    for (; (from < _spriteList.size()) && (_spriteList[from].node == batch.ID); ++from)
+    while ((from < _spriteList.size()) && (_spriteList[from].node == batch.ID))
     {
         const auto &e = _spriteList[from];
         if (e.skip)
+        {
+            ++from;
             continue;
+        }
 
         switch (reinterpret_cast<intptr_t>(e.ddb))
         {
@@ -1445,15 +1470,117 @@ size_t OGLGraphicsDriver::RenderSpriteBatch(const OGLSpriteBatch &batch, size_t
                 auto stageEntry = OGLDrawListEntry((OGLBitmap*)ddb, batch.ID, sx, sy);
                 _renderSprite(&stageEntry, projection, batch.Matrix, batch.Color, surface_size);
             }
+            ++from;
             break;
         default:
-            _renderSprite(&e, projection, batch.Matrix, batch.Color, surface_size);
+            if (IsAtlasBatchable(e))
+            {
+                from = RenderAtlasSprites(batch, from, projection, surface_size);
+            }
+            else
+            {
+                _renderSprite(&e, projection, batch.Matrix, batch.Color, surface_size);
+                ++from;
+            }
             break;
         }
     }
     return from;
 }
 
+bool OGLGraphicsDriver::IsAtlasBatchable(const OGLDrawListEntry &entry) const
+{
+    const OGLBitmap *ddb = entry.ddb;
+    if (!ddb->_data || !ddb->_data->_atlasPage)
+        return false;
+    // Only sprites drawn with the default shader and blending
+    if ((ddb->_tintSaturation > 0) || (ddb->_lightLevel > 0) || (ddb->_renderHint != kTxHint_Normal))
+        return false;
+    // Smoothly scaled sprites use their own texture filtering
+    return !(_smoothScaling && ddb->_useResampler && (ddb->_stretchToHeight > 0) &&
+        ((ddb->_stretchToHeight != ddb->_height) || (ddb->_stretchToWidth != ddb->_width)));
+}
+
+size_t OGLGraphicsDriver::RenderAtlasSprites(const OGLSpriteBatch &batch, size_t from,
+    const glm::mat4 &projection, const Size &surface_size)
+{
+    const OGLBitmap *first = _spriteList[from].ddb;
+    const OGLAtlasPage *page = first->_data->_atlasPage.get();
+    const int alpha = (batch.Color.Alpha * first->_alpha) / 255;
+
+    // Make two triangles per sprite, positioned same way as _renderSprite
+    // does with the sprite's own transform, but calculated here
+    static const int strip_to_list[6] = { 0, 1, 2, 2, 1, 3 };
+    _atlasVertices.clear();
+    size_t end = from;
+    for (; (end < _spriteList.size()) && (_spriteList[end].node == batch.ID); ++end)
+    {
+        const auto &e = _spriteList[end];
+        if (e.skip)
+            continue;
+        if ((reinterpret_cast<intptr_t>(e.ddb) == DRAWENTRY_STAGECALLBACK) || !IsAtlasBatchable(e) ||
+            (e.ddb->_data->_atlasPage.get() != page) || (e.ddb->_alpha != first->_alpha))
+            break;
+
+        const OGLBitmap *ddb = e.ddb;
+        const float width = ddb->GetWidthToRender();
+        const float height = ddb->GetHeightToRender();
+        float x = (-(surface_size.Width / 2.0f)) + e.x;
+        const float y = (surface_size.Height / 2.0f) - e.y;
+        float scale_x = width;
+        if (ddb->_flipped)
+        {
+            scale_x = -width;
+            x += width;
+        }
+        const OGLCUSTOMVERTEX *vertex = ddb->_data->_vertex;
+        for (int i : strip_to_list)
+        {
+            OGLCUSTOMVERTEX v = vertex[i];
+            v.position.x = x + vertex[i].position.x * scale_x;
+            v.position.y = y + vertex[i].position.y * height;
+            _atlasVertices.push_back(v);
+        }
+    }
+
+    ShaderProgram program = _transparencyShader;
+    glUseProgram(program.Program);
+    glUniform1i(program.TextureId, 0);
+    glUniform1f(program.Alpha, alpha / 255.0f);
+
+    glm::mat4 transform = projection;
+    transform = glmex::translate(transform, surface_size.Width / 2.0f, surface_size.Height / 2.0f);
+    transform = transform * batch.Matrix;
+    glUniformMatrix4fv(program.MVPMatrix, 1, GL_FALSE, glm::value_ptr(transform));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, page->Texture);
+    if (_do_render_to_texture)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+    else
+    {
+        _filter->SetFilteringForStandardSprite();
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+    glEnableVertexAttribArray(0);
+    GLint a_Position = glGetAttribLocation(program.Program, "a_Position");
+    glVertexAttribPointer(a_Position, 2, GL_FLOAT, GL_FALSE, sizeof(OGLCUSTOMVERTEX), &(_atlasVertices[0].position));
+
+    glEnableVertexAttribArray(1);
+    GLint a_TexCoord = glGetAttribLocation(program.Program, "a_TexCoord");
+    glVertexAttribPointer(a_TexCoord, 2, GL_FLOAT, GL_FALSE, sizeof(OGLCUSTOMVERTEX), &(_atlasVertices[0].tu));
+
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(_atlasVertices.size()));
+    _drawCallCount++;
+    glUseProgram(0);
+    return end;
+}
+
 void OGLGraphicsDriver::InitSpriteBatch(size_t index, const SpriteBatchDesc &desc)
 {
     // Create transformation matrix for this batch
@@ -1619,63 +1746,59 @@ void OGLGraphicsDriver::UpdateTextureRegion(OGLTextureTile *tile, Bitmap *bitmap
   }
 
   const bool usingLinearFiltering = _filter->UseLinearFiltering();
-  uint8_t *origPtr = new uint8_t[sizeof(int) * tileWidth * tileHeight];
   const int pitch = tileWidth * sizeof(int);
+  const size_t buf_size = static_cast<size_t>(pitch) * tileHeight;
+  if (_stagingBuffer.size() < buf_size)
+    _stagingBuffer.resize(buf_size);
+  uint8_t *origPtr = _stagingBuffer.data();
   uint8_t *memPtr = origPtr + pitch * tiley + tilex * sizeof(int);
 
+  // Mimic the behaviour of GL_CLAMP_EDGE for the tile edges, by filling
+  // the extra texture pixels along with the conversion.
+  // NOTE: on some platforms GL_CLAMP_EDGE does not work with the version of OpenGL we're using.
+  int edge_flags = 0;
+  if (tile->width < tileWidth)
+    edge_flags |= kVMem_EdgeRight | ((tilex > 0) ? kVMem_EdgeLeft : 0);
+  if (tile->height < tileHeight)
+    edge_flags |= kVMem_EdgeBottom | ((tiley > 0) ? kVMem_EdgeTop : 0);
+
   TextureTile fixedTile;
   fixedTile.x = tile->x;
   fixedTile.y = tile->y;
   fixedTile.width = std::min(tile->width, tileWidth);
   fixedTile.height = std::min(tile->height, tileHeight);
   if (opaque)
-    BitmapToVideoMemOpaque(bitmap, has_alpha, &fixedTile, memPtr, pitch);
+    BitmapToVideoMemOpaque(bitmap, has_alpha, &fixedTile, memPtr, pitch, edge_flags);
   else
-    BitmapToVideoMem(bitmap, has_alpha, &fixedTile, memPtr, pitch, usingLinearFiltering);
-
-  // Mimic the behaviour of GL_CLAMP_EDGE for the tile edges
-  // NOTE: on some platforms GL_CLAMP_EDGE does not work with the version of OpenGL we're using.
-  if (tile->width < tileWidth)
-  {
-    if (tilex > 0)
-    {
-      for (int y = 0; y < tileHeight; y++)
-      {
-        unsigned int* edge_left_col = (unsigned int*)(origPtr + y * pitch + (tilex - 1) * sizeof(int));
-        unsigned int* bm_left_col = (unsigned int*)(origPtr + y * pitch + (tilex) * sizeof(int));
-        *edge_left_col = *bm_left_col & 0x00FFFFFF;
-      }
-    }
-    for (int y = 0; y < tileHeight; y++)
-    {
-      unsigned int* edge_right_col = (unsigned int*)(origPtr + y * pitch + (tilex + tile->width) * sizeof(int));
-      unsigned int* bm_right_col = edge_right_col - 1;
-      *edge_right_col = *bm_right_col & 0x00FFFFFF;
-    }
-  }
-  if (tile->height < tileHeight)
-  {
-    if (tiley > 0)
-    {
-      unsigned int* edge_top_row = (unsigned int*)(origPtr + pitch * (tiley - 1));
-      unsigned int* bm_top_row = (unsigned int*)(origPtr + pitch * (tiley));
-      for (int x = 0; x < tileWidth; x++)
-      {
-        edge_top_row[x] = bm_top_row[x] & 0x00FFFFFF;
-      }
-    }
-    unsigned int* edge_bottom_row = (unsigned int*)(origPtr + pitch * (tiley + tile->height));
-    unsigned int* bm_bottom_row = (unsigned int*)(origPtr + pitch * (tiley + tile->height - 1));
-    for (int x = 0; x < tileWidth; x++)
-    {
-      edge_bottom_row[x] = bm_bottom_row[x] & 0x00FFFFFF;
-    }
-  }
+    BitmapToVideoMem(bitmap, has_alpha, &fixedTile, memPtr, pitch, usingLinearFiltering, edge_flags);
 
   glBindTexture(GL_TEXTURE_2D, tile->texture);
   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tileWidth, tileHeight, GL_RGBA, GL_UNSIGNED_BYTE, origPtr);
+}
+
+void OGLGraphicsDriver::UpdateAtlasTexture(OGLTexture *txdata, Bitmap *bitmap, bool has_alpha, bool opaque)
+{
+  // The image is surrounded by a border of repeated edge pixels,
+  // which stops neighbouring images from leaking in when filtering
+  const Rect &rc = txdata->_atlasRect;
+  const int pitch = rc.GetWidth() * sizeof(int);
+  const size_t buf_size = static_cast<size_t>(pitch) * rc.GetHeight();
+  if (_stagingBuffer.size() < buf_size)
+    _stagingBuffer.resize(buf_size);
+  uint8_t *memPtr = _stagingBuffer.data() + pitch + sizeof(int);
+  const int edge_flags = kVMem_EdgeLeft | kVMem_EdgeTop | kVMem_EdgeRight | kVMem_EdgeBottom;
+
+  TextureTile tile;
+  tile.width = bitmap->GetWidth();
+  tile.height = bitmap->GetHeight();
+  if (opaque)
+    BitmapToVideoMemOpaque(bitmap, has_alpha, &tile, memPtr, pitch, edge_flags);
+  else
+    BitmapToVideoMem(bitmap, has_alpha, &tile, memPtr, pitch, _filter->UseLinearFiltering(), edge_flags);
 
-  delete []origPtr;
+  glBindTexture(GL_TEXTURE_2D, txdata->_atlasPage->Texture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, rc.Left, rc.Top, rc.GetWidth(), rc.GetHeight(),
+      GL_RGBA, GL_UNSIGNED_BYTE, _stagingBuffer.data());
 }
 
 void OGLGraphicsDriver::UpdateDDBFromBitmap(IDriverDependantBitmap* ddb, Bitmap *bitmap, bool has_alpha)
@@ -1688,6 +1811,8 @@ void OGLGraphicsDriver::UpdateDDBFromBitmap(IDriverDependantBitmap* ddb, Bitmap
 
 void OGLGraphicsDriver::UpdateTexture(Texture *txdata, Bitmap *bitmap, bool has_alpha, bool opaque)
 {
+  AGS_PROFILE_ZONE("Texture upload");
+  AGS_PROFILE_COUNT("Texture uploads", 1);
   const int color_depth = bitmap->GetColorDepth();
   if (bitmap->GetColorDepth() != txdata->Res.ColorDepth)
     throw Ali3DException("UpdateDDBFromBitmap: mismatched colour depths");
@@ -1698,9 +1823,16 @@ void OGLGraphicsDriver::UpdateTexture(Texture *txdata, Bitmap *bitmap, bool has_
       select_palette(palette);
 
   auto *ogldata = reinterpret_cast<OGLTexture*>(txdata);
-  for (size_t i = 0; i < ogldata->_numTiles; ++i)
+  if (ogldata->_atlasPage)
   {
-    UpdateTextureRegion(&ogldata->_tiles[i], bitmap, has_alpha, opaque);
+    UpdateAtlasTexture(ogldata, bitmap, has_alpha, opaque);
+  }
+  else
+  {
+    for (size_t i = 0; i < ogldata->_numTiles; ++i)
+    {
+      UpdateTextureRegion(&ogldata->_tiles[i], bitmap, has_alpha, opaque);
+    }
   }
 
   if (color_depth == 8)
@@ -1931,6 +2063,80 @@ Texture *OGLGraphicsDriver::CreateTexture(int width, int height, int color_depth
   return txdata;
 }
 
+Texture *OGLGraphicsDriver::CreateTexture(Bitmap *bmp, bool has_alpha, bool opaque)
+{
+  if (_useSpriteAtlas)
+  {
+    if (OGLTexture *txdata = CreateAtlasTexture(bmp->GetWidth(), bmp->GetHeight(), bmp->GetColorDepth()))
+    {
+      UpdateTexture(txdata, bmp, has_alpha, opaque);
+      return txdata;
+    }
+  }
+  return VideoMemoryGraphicsDriver::CreateTexture(bmp, has_alpha, opaque);
+}
+
+OGLTexture *OGLGraphicsDriver::CreateAtlasTexture(int width, int height, int color_depth)
+{
+  if (width > MAX_ATLAS_SPRITE_SIZE || height > MAX_ATLAS_SPRITE_SIZE)
+    return nullptr;
+
+  // Reserve 1 pixel border around the image
+  const int alloc_width = width + 2;
+  const int alloc_height = height + 2;
+  std::shared_ptr<OGLAtlasPage> page;
+  Rect rc;
+  for (const auto &p : _atlasPages)
+  {
+    if (p->Packer.Allocate(alloc_width, alloc_height, rc))
+    {
+      page = p;
+      break;
+    }
+  }
+  if (!page)
+  {
+    if (_atlasPages.size() >= MAX_ATLAS_PAGES)
+      return nullptr;
+    GLint max_size = ATLAS_PAGE_SIZE;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    const int page_size = std::min<int>(ATLAS_PAGE_SIZE, max_size);
+    unsigned int texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page_size, page_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    page = std::make_shared<OGLAtlasPage>(texture, page_size, page_size);
+    if (!page->Packer.Allocate(alloc_width, alloc_height, rc))
+      return nullptr;
+    _atlasPages.push_back(page);
+    Debug::Printf("OGL: created sprite atlas page %d x %d (%zu total)", page_size, page_size, _atlasPages.size());
+  }
+
+  auto *txdata = new OGLTexture(GraphicResolution(width, height, color_depth), false);
+  txdata->_atlasPage = page;
+  txdata->_atlasRect = rc;
+  txdata->_numTiles = 1;
+  txdata->_tiles = new OGLTextureTile[1];
+  txdata->_tiles[0].width = width;
+  txdata->_tiles[0].height = height;
+  txdata->_tiles[0].texture = page->Texture;
+  // Texture coordinates point to the image's region on the page
+  txdata->_vertex = new OGLCUSTOMVERTEX[4];
+  const float page_width = page->Packer.GetWidth();
+  const float page_height = page->Packer.GetHeight();
+  for (int i = 0; i < 4; ++i)
+  {
+    txdata->_vertex[i] = defaultVertices[i];
+    txdata->_vertex[i].tu = (rc.Left + 1 + (defaultVertices[i].tu > 0.f ? width : 0)) / page_width;
+    txdata->_vertex[i].tv = (rc.Top + 1 + (defaultVertices[i].tv > 0.f ? height : 0)) / page_height;
+  }
+  return txdata;
+}
+
 void OGLGraphicsDriver::do_fade(bool fadingOut, int speed, int targetColourRed, int targetColourGreen, int targetColourBlue)
 {
   // Construct scene in order: game screen, fade fx, post game overlay
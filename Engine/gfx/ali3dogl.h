@@ -27,6 +27,7 @@
 #include "gfx/ddb.h"
 #include "gfx/gfxdriverfactorybase.h"
 #include "gfx/gfxdriverbase.h"
+#include "gfx/texture_atlas.h"
 #include "util/string.h"
 #include "util/version.h"
 
@@ -62,12 +63,27 @@ struct OGLTextureTile : public TextureTile
     unsigned int texture = 0;
 };
 
+// Shared texture which holds a number of small textures
+struct OGLAtlasPage
+{
+    unsigned int Texture = 0;
+    TextureAtlasPacker Packer;
+
+    OGLAtlasPage(unsigned int texture, int width, int height)
+        : Texture(texture), Packer(width, height) {}
+    ~OGLAtlasPage();
+};
+
 // Full OpenGL texture data
 struct OGLTexture : Texture
 {
     OGLCUSTOMVERTEX *_vertex = nullptr;
     OGLTextureTile *_tiles = nullptr;
     size_t _numTiles = 0;
+    // Atlas page which holds this texture, if any, and the region allocated
+    // on that page, which includes 1 pixel border around the image
+    std::shared_ptr<OGLAtlasPage> _atlasPage;
+    Rect _atlasRect;
 
     OGLTexture(const GraphicResolution &res, bool rt)
         : Texture(res, rt) {}
@@ -251,6 +267,8 @@ public:
     
     // Create texture data with the given parameters
     Texture *CreateTexture(int width, int height, int color_depth, bool opaque, bool as_render_target = false) override;
+    // Create texture data from the given bitmap; may place it on an atlas page
+    Texture *CreateTexture(Bitmap *bmp, bool has_alpha, bool opaque = false) override;
     // Update texture data from the given bitmap
     void UpdateTexture(Texture *txdata, Bitmap *bitmap, bool has_alpha, bool opaque) override;
     // Retrieve shared texture data object from the given DDB
@@ -269,6 +287,8 @@ public:
     bool SupportsGammaControl() override;
     void SetGamma(int newGamma) override;
     void UseSmoothScaling(bool enabled) override { _smoothScaling = enabled; }
+    void UseSpriteAtlas(bool enabled) override { _useSpriteAtlas = enabled; }
+    size_t GetDrawCallCount() const override { return _lastDrawCallCount; }
     void SetScreenFade(int red, int green, int blue) override;
     void SetScreenTint(int red, int green, int blue) override;
 
@@ -339,6 +359,17 @@ private:
     std::vector<std::pair<size_t, size_t>> _backupBatchRange;
     OGLSpriteBatches _backupBatches;
     std::vector<OGLDrawListEntry> _backupSpriteList;
+    // Staging buffer for the texture uploads, reused between the calls
+    std::vector<uint8_t> _stagingBuffer;
+
+    // Sprite atlas: pages holding small sprite textures, and the vertex
+    // buffer for drawing sprites from the same page at once
+    bool _useSpriteAtlas = false;
+    std::vector<std::shared_ptr<OGLAtlasPage>> _atlasPages;
+    std::vector<OGLCUSTOMVERTEX> _atlasVertices;
+    // Draw calls made in the current, and in the last rendered frame
+    size_t _drawCallCount = 0u;
+    size_t _lastDrawCallCount = 0u;
 
     // Saved blend settings exclusive for alpha channel; for convenience,
     // because GL does not have functions for setting ONLY RGB or ONLY alpha ops.
@@ -372,10 +403,19 @@ private:
     void ReleaseDisplayMode();
     void AdjustSizeToNearestSupportedByCard(int *width, int *height);
     void UpdateTextureRegion(OGLTextureTile *tile, Bitmap *bitmap, bool has_alpha, bool opaque);
+    // Allocates texture on one of the atlas pages, returns null if it does not fit
+    OGLTexture *CreateAtlasTexture(int width, int height, int color_depth);
+    void UpdateAtlasTexture(OGLTexture *txdata, Bitmap *bitmap, bool has_alpha, bool opaque);
     void CreateVirtualScreen();
     void do_fade(bool fadingOut, int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
     void _renderSprite(const OGLDrawListEntry *entry, const glm::mat4 &projection, const glm::mat4 &matGlobal,
         const SpriteColorTransform &color, const Size &surface_size);
+    // Tells if the sprite may be drawn along with others from the same atlas page
+    bool IsAtlasBatchable(const OGLDrawListEntry &entry) const;
+    // Draws the consecutive sprites from the same atlas page, using same
+    // render settings, with one draw call; returns the next sprite index
+    size_t RenderAtlasSprites(const OGLSpriteBatch &batch, size_t from,
+        const glm::mat4 &projection, const Size &surface_size);
     void SetupViewport();
     // Converts rectangle in top->down coordinates into OpenGL's native bottom->up coordinates
     Rect ConvertTopDownRect(const Rect &top_down_rect, int surface_height);
@@ -16,6 +16,7 @@
 #include <stack>
 #include "ac/sys_events.h"
 #include "gfx/ali3dexception.h"
+#include "gfx/blender.h"
 #include "gfx/gfxfilter_sdl_renderer.h"
 #include "gfx/gfx_util.h"
 #include "platform/base/agsplatformdriver.h"
@@ -31,7 +32,6 @@ namespace ALSW
 
 using namespace Common;
 
-static uint32_t _trans_alpha_blender32(uint32_t x, uint32_t y, uint32_t n);
 RGB faded_out_palette[256];
 
 
@@ -109,6 +109,11 @@ void SDLRendererGraphicsDriver::SetGraphicsFilter(PSDLRenderFilter filter)
   // SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");  // make the scaled rendering look smoother.
 }
 
+void SDLRendererGraphicsDriver::SetRenderThreads(int count)
+{
+  _bandRenderer.SetThreadCount(count);
+}
+
 void SDLRendererGraphicsDriver::SetTintMethod(TintMethod /*method*/) 
 {
   // TODO: support new D3D-style tint method
@@ -557,9 +562,20 @@ void SDLRendererGraphicsDriver::RenderToBackBuffer()
 
 size_t SDLRendererGraphicsDriver::RenderSpriteBatch(const ALSpriteBatch &batch, size_t from, Bitmap *surface, int surf_offx, int surf_offy)
 {
+  bool use_bands = _bandRenderer.IsEnabledFor(surface);
+  if (use_bands)
+    _bandRenderer.Begin(surface);
   for (; (from < _spriteList.size()) && (_spriteList[from].node == batch.ID); ++from)
   {
     const auto &sprite = _spriteList[from];
+    if (use_bands)
+    {
+      if (AddSpriteToBands(sprite, surface, surf_offx, surf_offy))
+        continue;
+      // draw everything recorded so far, to keep the order of drawing
+      _bandRenderer.Render();
+    }
+
     if (sprite.ddb == nullptr)
     {
       if (_spriteEvtCallback)
@@ -568,6 +584,9 @@ size_t SDLRendererGraphicsDriver::RenderSpriteBatch(const ALSpriteBatch &batch,
         throw Ali3DException("Unhandled attempt to draw null sprite");
       // Stage surface could have been replaced by plugin
       surface = _stageVirtualScreen;
+      use_bands = _bandRenderer.IsEnabledFor(surface);
+      if (use_bands)
+        _bandRenderer.Begin(surface);
       continue;
     }
     else if (sprite.ddb == reinterpret_cast<ALSoftwareBitmap*>(DRAWENTRY_TINT))
@@ -607,9 +626,53 @@ size_t SDLRendererGraphicsDriver::RenderSpriteBatch(const ALSpriteBatch &batch,
           bitmap->_alpha);
     }
   }
+  if (use_bands)
+    _bandRenderer.Render();
   return from;
 }
 
+// Does same as RenderSpriteBatch, but only records the drawing operations
+bool SDLRendererGraphicsDriver::AddSpriteToBands(const ALDrawListEntry &sprite, Bitmap *surface, int surf_offx, int surf_offy)
+{
+  if (sprite.ddb == nullptr)
+    return false; // plugin callback, must run in order
+  if (sprite.ddb == reinterpret_cast<ALSoftwareBitmap*>(DRAWENTRY_TINT))
+  {
+    set_trans_blender(_tint_red, _tint_green, _tint_blue, 0);
+    return _bandRenderer.AddBlend(surface, 0, 0, true, 128);
+  }
+
+  ALSoftwareBitmap* bitmap = sprite.ddb;
+  const int drawAtX = sprite.x + surf_offx;
+  const int drawAtY = sprite.y + surf_offy;
+  if (bitmap->_alpha == 0)
+    return true;
+  if (bitmap->_opaque)
+  {
+    if ((bitmap->_bmp == surface) && (bitmap->_alpha == 255))
+      return true;
+    return _bandRenderer.AddBlit(bitmap->_bmp, drawAtX, drawAtY, false);
+  }
+  if (bitmap->_hasAlpha)
+  {
+    if (bitmap->_alpha == 255)
+      set_alpha_blender();
+    else
+      set_blender_mode(nullptr, nullptr, _trans_alpha_blender32, 0, 0, 0, bitmap->_alpha);
+    return _bandRenderer.AddBlend(bitmap->_bmp, drawAtX, drawAtY, false, 0);
+  }
+  // see GfxUtil::DrawSpriteWithTransparency; sprites of other color depths
+  // are converted there, and are drawn the regular way
+  if (bitmap->_bmp->GetColorDepth() != surface->GetColorDepth())
+    return false;
+  if (bitmap->_alpha < 255)
+  {
+    set_trans_blender(0, 0, 0, bitmap->_alpha);
+    return _bandRenderer.AddBlend(bitmap->_bmp, drawAtX, drawAtY, false, 0);
+  }
+  return _bandRenderer.AddBlit(bitmap->_bmp, drawAtX, drawAtY, true);
+}
+
 void SDLRendererGraphicsDriver::BlitToTexture()
 {
     void *pixels = nullptr;
@@ -946,28 +1009,6 @@ void SDLRendererGraphicsDriver::BoxOutEffect(bool blackingOut, int speed, int de
 }
 // end fading routines
 
-// add the alpha values together, used for compositing alpha images
-// TODO: why is this here, move to gfx/blender? check if there's already similar function there
-static uint32_t _trans_alpha_blender32(uint32_t x, uint32_t y, uint32_t n)
-{
-   uint32_t res, g;
-
-   n = (n * geta32(x)) / 256;
-
-   if (n)
-      n++;
-
-   res = ((x & 0xFF00FF) - (y & 0xFF00FF)) * n / 256 + y;
-   y &= 0xFF00;
-   x &= 0xFF00;
-   g = (x - y) * n / 256 + y;
-
-   res &= 0xFF00FF;
-   g &= 0xFF00;
-
-   return res | g;
-}
-
 bool SDLRendererGraphicsDriver::SetVsyncImpl(bool enabled, bool &vsync_res)
 {
     #if SDL_VERSION_ATLEAST(2, 0, 18)
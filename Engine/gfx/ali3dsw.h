@@ -26,6 +26,7 @@
 #include <memory>
 #include <SDL.h>
 #include "core/platform.h"
+#include "gfx/band_renderer.h"
 #include "gfx/bitmap.h"
 #include "gfx/ddb.h"
 #include "gfx/gfxdriverfactorybase.h"
@@ -217,6 +218,9 @@ public:
     typedef std::shared_ptr<SDLRendererGfxFilter> PSDLRenderFilter;
 
     void SetGraphicsFilter(PSDLRenderFilter filter);
+    // Sets the number of threads for drawing sprites, each drawing its own
+    // horizontal band of the surface; 0 or 1 draws everything on the calling thread
+    void SetRenderThreads(int count);
 
 protected:
     bool SetVsyncImpl(bool vsync, bool &vsync_res) override;
@@ -254,6 +258,8 @@ private:
     ALSpriteBatches _spriteBatches;
     // List of sprites to render
     std::vector<ALDrawListEntry> _spriteList;
+    // Optional multithreaded sprite drawing
+    BandRenderer _bandRenderer;
 
     void InitSpriteBatch(size_t index, const SpriteBatchDesc &desc) override;
     void ResetAllBatches() override;
@@ -265,6 +271,9 @@ private:
     void ReleaseDisplayMode();
     // Renders single sprite batch on the precreated surface
     size_t RenderSpriteBatch(const ALSpriteBatch &batch, size_t from, Common::Bitmap *surface, int surf_offx, int surf_offy);
+    // Records the sprite drawing for the band renderer,
+    // returns false if the sprite has to be drawn the regular way
+    bool AddSpriteToBands(const ALDrawListEntry &sprite, Common::Bitmap *surface, int surf_offx, int surf_offy);
 
     void highcolor_fade_in(Bitmap *vs, void(*draw_callback)(), int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
     void highcolor_fade_out(Bitmap *vs, void(*draw_callback)(), int speed, int targetColourRed, int targetColourGreen, int targetColourBlue);
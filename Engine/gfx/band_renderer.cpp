@@ -0,0 +1,262 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "gfx/band_renderer.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace AGS
+{
+namespace Engine
+{
+
+using namespace Common;
+
+// Bands are not made thinner than this, in pixel rows
+static const int MIN_BAND_HEIGHT = 32;
+// Less pixels are drawn faster without waking up the threads
+static const uint64_t MIN_PIXELS_FOR_THREADS = 64 * 1024;
+// Sanity limit for the number of threads
+static const int MAX_THREADS = 16;
+
+struct BandRenderer::ThreadState
+{
+    std::vector<std::thread> Threads; // thread N draws band N + 1
+    std::mutex Mutex;
+    std::condition_variable StartCV;
+    std::condition_variable DoneCV;
+    uint32_t Frame = 0u; // increments when there's a new job for the threads
+    size_t BandCount = 0u; // number of bands in the current job
+    size_t Pending = 0u; // number of threads still drawing
+    bool Exit = false;
+};
+
+BandRenderer::BandRenderer()
+    : _threads(new ThreadState())
+{
+}
+
+BandRenderer::~BandRenderer()
+{
+    StopThreads();
+}
+
+void BandRenderer::SetThreadCount(int count)
+{
+#if defined(AGS_DISABLE_THREADS)
+    count = 0;
+#endif
+    count = std::min(std::max(count, 0), MAX_THREADS);
+    if (count == _threadCount)
+        return;
+    StopThreads();
+    _threadCount = count;
+}
+
+bool BandRenderer::IsEnabledFor(Bitmap *surface) const
+{
+    return (_threadCount > 1) && surface && (surface->GetColorDepth() == 32);
+}
+
+void BandRenderer::Begin(Bitmap *surface)
+{
+    Reset();
+    _surface = surface;
+}
+
+void BandRenderer::Reset()
+{
+    _ops.clear();
+    _opPixels = 0u;
+}
+
+bool BandRenderer::CanDraw(Bitmap *src) const
+{
+    return _surface && (src->GetColorDepth() == 32) &&
+        !is_same_bitmap(src->GetAllegroBitmap(), _surface->GetAllegroBitmap());
+}
+
+void BandRenderer::AddOp(OpType type, Bitmap *src, int x, int y)
+{
+    DrawOp op;
+    op.Type = type;
+    op.Src = src;
+    op.DstRect = src ? RectWH(x, y, src->GetWidth(), src->GetHeight()) :
+        RectWH(0, 0, _surface->GetWidth(), _surface->GetHeight());
+    _ops.push_back(op);
+    _opPixels += (uint64_t)op.DstRect.GetWidth() * op.DstRect.GetHeight();
+}
+
+bool BandRenderer::AddBlit(Bitmap *src, int x, int y, bool masked)
+{
+    if (!CanDraw(src))
+        return false;
+    AddOp(masked ? kOp_MaskedBlit : kOp_Blit, src, x, y);
+    return true;
+}
+
+bool BandRenderer::AddBlend(Bitmap *src, int x, int y, bool lit, int light_amount)
+{
+    BlendSpriteParams params;
+    if (src == _surface)
+    {
+        // blending the surface onto itself is only supported without offset
+        if (!_surface || x != 0 || y != 0)
+            return false;
+        src = nullptr;
+    }
+    else if (!CanDraw(src))
+    {
+        return false;
+    }
+    if (!get_blend_sprite32_params(lit, light_amount, params))
+        return false;
+    AddOp(kOp_Blend, src, x, y);
+    _ops.back().Blend = params;
+    return true;
+}
+
+void BandRenderer::Render()
+{
+    if (_ops.empty())
+        return;
+
+    // Split the surface's clipping rect into bands, and only keep the ones
+    // which have anything drawn on them
+    const Rect clip = _surface->GetClip();
+    size_t max_bands = 1u;
+    if (_opPixels >= MIN_PIXELS_FOR_THREADS)
+        max_bands = std::max(1, std::min(_threadCount, clip.GetHeight() / MIN_BAND_HEIGHT));
+    _bandRects.clear();
+    for (size_t i = 0; i < max_bands; ++i)
+    {
+        const Rect band(clip.Left, clip.Top + clip.GetHeight() * i / max_bands,
+            clip.Right, clip.Top + clip.GetHeight() * (i + 1) / max_bands - 1);
+        for (const auto &op : _ops)
+        {
+            if (AreRectsIntersecting(band, op.DstRect))
+            {
+                _bandRects.push_back(band);
+                break;
+            }
+        }
+    }
+    if (_bandRects.empty())
+    {
+        Reset();
+        return;
+    }
+
+    // Subbitmaps are made on this thread, as allegro registers them in the parent
+    _bands.resize(std::max(_bands.size(), _bandRects.size()));
+    for (size_t i = 0; i < _bandRects.size(); ++i)
+    {
+        if (!_bands[i])
+            _bands[i].reset(new Bitmap());
+        _bands[i]->CreateSubBitmap(_surface, _bandRects[i]);
+    }
+
+    const size_t band_count = _bandRects.size();
+    if (band_count == 1)
+    {
+        RenderBand(0);
+        Reset();
+        return;
+    }
+
+#if !defined(AGS_DISABLE_THREADS)
+    {
+        std::lock_guard<std::mutex> lk(_threads->Mutex);
+        for (size_t i = _threads->Threads.size(); i < band_count - 1; ++i)
+            _threads->Threads.emplace_back(&BandRenderer::BandThread, this, i + 1, _threads->Frame);
+        _threads->BandCount = band_count;
+        _threads->Pending = band_count - 1;
+        _threads->Frame++;
+    }
+    _threads->StartCV.notify_all();
+    RenderBand(0);
+    {
+        std::unique_lock<std::mutex> lk(_threads->Mutex);
+        _threads->DoneCV.wait(lk, [this]() { return _threads->Pending == 0u; });
+    }
+#endif
+    Reset();
+}
+
+void BandRenderer::RenderBand(size_t band_index)
+{
+    Bitmap *band = _bands[band_index].get();
+    const Rect &band_rc = _bandRects[band_index];
+    for (const auto &op : _ops)
+    {
+        if (!AreRectsIntersecting(band_rc, op.DstRect))
+            continue;
+        const int x = op.DstRect.Left - band_rc.Left;
+        const int y = op.DstRect.Top - band_rc.Top;
+        switch (op.Type)
+        {
+        case kOp_Blit:
+            band->Blit(op.Src, 0, 0, x, y, op.Src->GetWidth(), op.Src->GetHeight());
+            break;
+        case kOp_MaskedBlit:
+            band->Blit(op.Src, x, y, kBitmap_Transparency);
+            break;
+        case kOp_Blend:
+            if (op.Src)
+                blend_sprite32(band->GetAllegroBitmap(), op.Src->GetAllegroBitmap(), x, y, op.Blend);
+            else // surface onto itself, each band is drawn onto itself too
+                blend_sprite32(band->GetAllegroBitmap(), band->GetAllegroBitmap(), 0, 0, op.Blend);
+            break;
+        }
+    }
+}
+
+void BandRenderer::StopThreads()
+{
+    if (_threads->Threads.empty())
+        return;
+    {
+        std::lock_guard<std::mutex> lk(_threads->Mutex);
+        _threads->Exit = true;
+    }
+    _threads->StartCV.notify_all();
+    for (auto &t : _threads->Threads)
+        t.join();
+    _threads->Threads.clear();
+    _threads->Exit = false;
+}
+
+void BandRenderer::BandThread(size_t band_index, uint32_t last_frame)
+{
+    std::unique_lock<std::mutex> lk(_threads->Mutex);
+    while (true)
+    {
+        _threads->StartCV.wait(lk, [this, last_frame]()
+            { return _threads->Exit || _threads->Frame != last_frame; });
+        if (_threads->Exit)
+            break;
+        last_frame = _threads->Frame;
+        if (band_index >= _threads->BandCount)
+            continue; // not needed this time
+        lk.unlock();
+        RenderBand(band_index);
+        lk.lock();
+        if (--_threads->Pending == 0u)
+            _threads->DoneCV.notify_one();
+    }
+}
+
+} // namespace Engine
+} // namespace AGS
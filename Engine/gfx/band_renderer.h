@@ -0,0 +1,109 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// BandRenderer draws a list of sprites onto a 32-bit surface, splitting the
+// surface into horizontal bands, each drawn by its own thread. Every band
+// runs through the whole list in order, clipped to its own rows, so the
+// result is exactly same as if the sprites were drawn one by one.
+//
+// The drawing operations are recorded first, with their blending parameters
+// captured from the current allegro blender; this is because the blender
+// state is global, and cannot be changed by the band threads.
+//
+//=============================================================================
+#ifndef __AGS_EE_GFX__BANDRENDERER_H
+#define __AGS_EE_GFX__BANDRENDERER_H
+
+#include <memory>
+#include <vector>
+#include "gfx/bitmap.h"
+#include "gfx/blender.h"
+#include "util/geometry.h"
+
+namespace AGS
+{
+namespace Engine
+{
+
+using Common::Bitmap;
+
+class BandRenderer
+{
+public:
+    BandRenderer();
+    ~BandRenderer();
+
+    // Sets the max number of bands drawn at once, including the calling
+    // thread; 0 or 1 disables the band rendering
+    void SetThreadCount(int count);
+    int  GetThreadCount() const { return _threadCount; }
+    // Tells if the surface may be drawn on using bands
+    bool IsEnabledFor(Bitmap *surface) const;
+
+    // Starts recording operations for the surface
+    void Begin(Bitmap *surface);
+    // Records a plain or masked copy of the sprite;
+    // returns false if this cannot be done by the band renderer
+    bool AddBlit(Bitmap *src, int x, int y, bool masked);
+    // Records a blend of the sprite using the current allegro blender,
+    // either in translucent or lit mode (see Bitmap::TransBlendBlt and
+    // LitBlendBlt); src may be the surface itself, for drawing at 0,0.
+    // Returns false if this cannot be done by the band renderer.
+    bool AddBlend(Bitmap *src, int x, int y, bool lit, int light_amount);
+    // Draws the recorded operations and clears the list
+    void Render();
+    // Clears the recorded operations without drawing them
+    void Reset();
+
+private:
+    enum OpType
+    {
+        kOp_Blit,
+        kOp_MaskedBlit,
+        kOp_Blend
+    };
+
+    struct DrawOp
+    {
+        OpType Type = kOp_Blit;
+        Bitmap *Src = nullptr; // null for drawing the surface onto itself
+        Rect DstRect; // in surface coordinates
+        BlendSpriteParams Blend;
+    };
+
+    bool CanDraw(Bitmap *src) const;
+    void AddOp(OpType type, Bitmap *src, int x, int y);
+    // Draws all the operations, clipped by the band's subbitmap
+    void RenderBand(size_t band_index);
+
+    int _threadCount = 0;
+    Bitmap *_surface = nullptr;
+    std::vector<DrawOp> _ops;
+    // Number of pixels in all the recorded operations
+    uint64_t _opPixels = 0u;
+    // Bands which are drawn this time, and the surface's subbitmaps for them
+    std::vector<Rect> _bandRects;
+    std::vector<std::unique_ptr<Bitmap>> _bands;
+
+    // Band threads, waiting for the next frame to draw
+    struct ThreadState;
+    std::unique_ptr<ThreadState> _threads;
+    void StopThreads();
+    void BandThread(size_t band_index, uint32_t last_frame);
+};
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_GFX__BANDRENDERER_H
@@ -12,8 +12,25 @@
 //
 //=============================================================================
 #include "gfx/blender.h"
+#include <algorithm>
 #include <allegro.h>
+#include <allegro/internal/aintern.h>
 #include "core/types.h"
+#include "gfx/allegrobitmap.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AGS_BLENDER_SSE2 1
+#if !defined(__EMSCRIPTEN__)
+#define AGS_BLENDER_AVX2 1
+#endif
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AGS_BLENDER_NEON 1
+#include <arm_neon.h>
+#endif
 
 extern "C" {
     // Fallback routine for when we don't have anything better to do.
@@ -21,10 +38,14 @@ extern "C" {
     // Standard Allegro 4 trans blenders for 16 and 15-bit color modes
     uint32_t _blender_trans15(uint32_t x, uint32_t y, uint32_t n);
     uint32_t _blender_trans16(uint32_t x, uint32_t y, uint32_t n);
+    // Standard Allegro 4 trans blender for 24 and 32-bit color modes
+    uint32_t _blender_trans24(uint32_t x, uint32_t y, uint32_t n);
     // Standard Allegro 4 alpha blenders for 16 and 15-bit color modes
     uint32_t _blender_alpha15(uint32_t x, uint32_t y, uint32_t n);
     uint32_t _blender_alpha16(uint32_t x, uint32_t y, uint32_t n);
     uint32_t _blender_alpha24(uint32_t x, uint32_t y, uint32_t n);
+    // Standard Allegro 4 alpha blender for 32-bit destination
+    uint32_t _blender_alpha32(uint32_t x, uint32_t y, uint32_t n);
 }
 
 
@@ -161,6 +182,27 @@ void set_my_trans_blender(int r, int g, int b, int a)
     set_blender_mode(_blender_trans15, _blender_trans16, _myblender_alpha_trans24, r, g, b, a);
 }
 
+// add the alpha values together, used for compositing alpha images
+uint32_t _trans_alpha_blender32(uint32_t x, uint32_t y, uint32_t n)
+{
+   uint32_t res, g;
+
+   n = (n * geta32(x)) / 256;
+
+   if (n)
+      n++;
+
+   res = ((x & 0xFF00FF) - (y & 0xFF00FF)) * n / 256 + y;
+   y &= 0xFF00;
+   x &= 0xFF00;
+   g = (x - y) * n / 256 + y;
+
+   res &= 0xFF00FF;
+   g &= 0xFF00;
+
+   return res | g;
+}
+
 // plain copy source to destination
 // assign new alpha value as a summ of alphas.
 uint32_t _additive_alpha_copysrc_blender(uint32_t x, uint32_t y, uint32_t /*n*/)
@@ -291,3 +333,455 @@ void set_argb2any_blender()
         _blender_alpha15, skiptranspixels_blender_alpha16, _blender_alpha24,
         0, 0, 0, 0xff); // TODO: do we need to support proper 15- and 24-bit here?
 }
+
+
+
+//-----------------------------------------------------------------------------
+// Row blenders
+//
+// Allegro calls the blender function for every pixel. Row blenders do the
+// same work for a whole row of pixels, which lets to keep the parameters
+// in registers, and to process several pixels at once with SIMD
+// instructions. Each row blender must give exactly same results as the
+// per-pixel blender it replaces.
+//-----------------------------------------------------------------------------
+
+struct BlendRowParams
+{
+    uint32_t Color = 0; // blender color, used by lit blending
+    uint32_t Alpha = 0; // blender alpha, or light amount
+    const uint32_t *LUT = nullptr; // lookup table, for the blenders using one
+};
+
+// Blends a number of pixels, returns the number of processed pixels
+typedef int (*PfnBlendRow)(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &params);
+
+enum BlendRowKind
+{
+    kBlendRow_Trans24,          // _blender_trans24
+    kBlendRow_AlphaTrans24,     // _myblender_alpha_trans24
+    kBlendRow_Alpha32,          // _blender_alpha32
+    kBlendRow_TransAlpha32,     // _trans_alpha_blender32
+    kBlendRow_Argb2Argb,        // _argb2argb_blender
+    kBlendRow_Argb2Rgb,         // _argb2rgb_blender
+    kBlendRow_Rgb2Argb,         // _rgb2argb_blender
+    kBlendRow_OpaqueAlpha,      // _opaque_alpha_blender
+    kBlendRow_AdditiveAlpha,    // _additive_alpha_copysrc_blender
+    kBlendRow_LitTrans24,       // _blender_trans24 in draw_lit_sprite
+    kBlendRow_LitAlphaTrans24,  // _myblender_alpha_trans24 in draw_lit_sprite
+    kBlendRow_LitColor32,       // _myblender_color32(_light) in draw_lit_sprite
+    kNumBlendRowKinds
+};
+
+// Precalculated 0x10000 / alpha for alpha in [1; 256], see argb2argb_blend_core
+struct AlphaRecipTable
+{
+    uint32_t Values[257];
+    AlphaRecipTable()
+    {
+        Values[0] = 0;
+        for (uint32_t i = 1; i < 257; ++i)
+            Values[i] = 0x10000 / i;
+    }
+    operator const uint32_t *() const { return Values; }
+};
+static const AlphaRecipTable AlphaRecip;
+
+// Generic row blenders, call the per-pixel blender directly
+template <BLENDER_FUNC Blender>
+static int TransRowGeneric(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (src[i] != MASK_COLOR_32)
+            dst[i] = Blender(src[i], dst[i], p.Alpha);
+    }
+    return count;
+}
+
+template <BLENDER_FUNC Blender>
+static int LitRowGeneric(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (src[i] != MASK_COLOR_32)
+            dst[i] = Blender(p.Color, src[i], p.Alpha);
+    }
+    return count;
+}
+
+// Color blenders take hue and saturation from the blender color, and only
+// luminance from the image, which is defined by the max of its RGB components;
+// so the result may be looked up in the table of 256 precalculated colors.
+static int LitRowColorLUT(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const uint32_t c = src[i];
+        if (c == MASK_COLOR_32)
+            continue;
+        const uint32_t v = std::max(std::max(c & 0xFF, (c >> 8) & 0xFF), (c >> 16) & 0xFF);
+        dst[i] = p.LUT[v] | (c & 0xFF000000);
+    }
+    return count;
+}
+
+static const PfnBlendRow GenericRowFuncs[kNumBlendRowKinds] =
+{
+    TransRowGeneric<_blender_trans24>,
+    TransRowGeneric<_myblender_alpha_trans24>,
+    TransRowGeneric<_blender_alpha32>,
+    TransRowGeneric<_trans_alpha_blender32>,
+    TransRowGeneric<_argb2argb_blender>,
+    TransRowGeneric<_argb2rgb_blender>,
+    TransRowGeneric<_rgb2argb_blender>,
+    TransRowGeneric<_opaque_alpha_blender>,
+    TransRowGeneric<_additive_alpha_copysrc_blender>,
+    LitRowGeneric<_blender_trans24>,
+    LitRowGeneric<_myblender_alpha_trans24>,
+    LitRowColorLUT,
+};
+
+#if defined(AGS_BLENDER_SSE2)
+namespace SSE2
+{
+struct BlendOps
+{
+    typedef __m128i V;
+    static const int N = 4;
+    static inline V Load(const uint32_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static inline void Store(uint32_t *p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static inline V Set1(uint32_t v) { return _mm_set1_epi32(static_cast<int>(v)); }
+    static inline V Zero() { return _mm_setzero_si128(); }
+    static inline V And(V a, V b) { return _mm_and_si128(a, b); }
+    static inline V Or(V a, V b) { return _mm_or_si128(a, b); }
+    static inline V Add(V a, V b) { return _mm_add_epi32(a, b); }
+    static inline V Sub(V a, V b) { return _mm_sub_epi32(a, b); }
+    // SSE2 has no 32-bit multiplication with the low result, combine it from two 64-bit ones
+    static inline V Mul(V a, V b)
+    {
+        const V even = _mm_mul_epu32(a, b);
+        const V odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+    static inline V Shr8(V v) { return _mm_srli_epi32(v, 8); }
+    static inline V Shr24(V v) { return _mm_srli_epi32(v, 24); }
+    static inline V Shl24(V v) { return _mm_slli_epi32(v, 24); }
+    static inline V CmpEq(V a, V b) { return _mm_cmpeq_epi32(a, b); }
+    static inline V Select(V mask, V a, V b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+    // Min for the values which fit in 15 bits
+    static inline V MinSmall(V a, V b) { return _mm_min_epi16(a, b); }
+    static inline V Lookup(const uint32_t *table, V index)
+    {
+        uint32_t i[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(i), index);
+        return _mm_setr_epi32(static_cast<int>(table[i[0]]), static_cast<int>(table[i[1]]),
+                              static_cast<int>(table[i[2]]), static_cast<int>(table[i[3]]));
+    }
+};
+
+#include "gfx/blender_rows.h"
+} // namespace SSE2
+#endif // AGS_BLENDER_SSE2
+
+#if defined(AGS_BLENDER_AVX2)
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+namespace AVX2
+{
+struct BlendOps
+{
+    typedef __m256i V;
+    static const int N = 8;
+    static inline V Load(const uint32_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static inline void Store(uint32_t *p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static inline V Set1(uint32_t v) { return _mm256_set1_epi32(static_cast<int>(v)); }
+    static inline V Zero() { return _mm256_setzero_si256(); }
+    static inline V And(V a, V b) { return _mm256_and_si256(a, b); }
+    static inline V Or(V a, V b) { return _mm256_or_si256(a, b); }
+    static inline V Add(V a, V b) { return _mm256_add_epi32(a, b); }
+    static inline V Sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+    static inline V Mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+    static inline V Shr8(V v) { return _mm256_srli_epi32(v, 8); }
+    static inline V Shr24(V v) { return _mm256_srli_epi32(v, 24); }
+    static inline V Shl24(V v) { return _mm256_slli_epi32(v, 24); }
+    static inline V CmpEq(V a, V b) { return _mm256_cmpeq_epi32(a, b); }
+    static inline V Select(V mask, V a, V b) { return _mm256_blendv_epi8(b, a, mask); }
+    static inline V MinSmall(V a, V b) { return _mm256_min_epu32(a, b); }
+    static inline V Lookup(const uint32_t *table, V index)
+    {
+        return _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), index, 4);
+    }
+};
+
+#include "gfx/blender_rows.h"
+} // namespace AVX2
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif // AGS_BLENDER_AVX2
+
+#if defined(AGS_BLENDER_NEON)
+namespace NEON
+{
+struct BlendOps
+{
+    typedef uint32x4_t V;
+    static const int N = 4;
+    static inline V Load(const uint32_t *p) { return vld1q_u32(p); }
+    static inline void Store(uint32_t *p, V v) { vst1q_u32(p, v); }
+    static inline V Set1(uint32_t v) { return vdupq_n_u32(v); }
+    static inline V Zero() { return vdupq_n_u32(0); }
+    static inline V And(V a, V b) { return vandq_u32(a, b); }
+    static inline V Or(V a, V b) { return vorrq_u32(a, b); }
+    static inline V Add(V a, V b) { return vaddq_u32(a, b); }
+    static inline V Sub(V a, V b) { return vsubq_u32(a, b); }
+    static inline V Mul(V a, V b) { return vmulq_u32(a, b); }
+    static inline V Shr8(V v) { return vshrq_n_u32(v, 8); }
+    static inline V Shr24(V v) { return vshrq_n_u32(v, 24); }
+    static inline V Shl24(V v) { return vshlq_n_u32(v, 24); }
+    static inline V CmpEq(V a, V b) { return vceqq_u32(a, b); }
+    static inline V Select(V mask, V a, V b) { return vbslq_u32(mask, a, b); }
+    static inline V MinSmall(V a, V b) { return vminq_u32(a, b); }
+    static inline V Lookup(const uint32_t *table, V index)
+    {
+        uint32_t i[4];
+        vst1q_u32(i, index);
+        const uint32_t v[4] = { table[i[0]], table[i[1]], table[i[2]], table[i[3]] };
+        return vld1q_u32(v);
+    }
+};
+
+#include "gfx/blender_rows.h"
+} // namespace NEON
+#endif // AGS_BLENDER_NEON
+
+// Per-pixel blenders which have row versions
+struct BlendRowBinding
+{
+    BLENDER_FUNC Blender;
+    bool Lit;
+    BlendRowKind Kind;
+};
+
+static const BlendRowBinding BlendRowBindings[] =
+{
+    { _blender_trans24, false, kBlendRow_Trans24 },
+    { _myblender_alpha_trans24, false, kBlendRow_AlphaTrans24 },
+    { _blender_alpha32, false, kBlendRow_Alpha32 },
+    { _trans_alpha_blender32, false, kBlendRow_TransAlpha32 },
+    { _argb2argb_blender, false, kBlendRow_Argb2Argb },
+    { _argb2rgb_blender, false, kBlendRow_Argb2Rgb },
+    { _rgb2argb_blender, false, kBlendRow_Rgb2Argb },
+    { _opaque_alpha_blender, false, kBlendRow_OpaqueAlpha },
+    { _additive_alpha_copysrc_blender, false, kBlendRow_AdditiveAlpha },
+    { _blender_trans24, true, kBlendRow_LitTrans24 },
+    { _myblender_alpha_trans24, true, kBlendRow_LitAlphaTrans24 },
+    { _myblender_color32, true, kBlendRow_LitColor32 },
+    { _myblender_color32_light, true, kBlendRow_LitColor32 },
+};
+
+// Row blenders of the selected instruction set, or null if using generic ones
+static const PfnBlendRow *SimdRowFuncs = nullptr;
+static BlenderRowImpl RowImpl = kBlenderRow_Generic;
+
+static bool cpu_has_avx2()
+{
+#if defined(AGS_BLENDER_AVX2)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool has_avx = (info[2] & (1 << 28)) != 0;
+    const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+    // OS must save the AVX registers on context switch
+    if (!has_avx || !has_osxsave || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+#else
+    return false;
+#endif
+}
+
+bool blender_row_impl_supported(BlenderRowImpl impl)
+{
+    switch (impl)
+    {
+    case kBlenderRow_Generic: return true;
+#if defined(AGS_BLENDER_SSE2)
+    case kBlenderRow_SSE2: return true;
+#endif
+#if defined(AGS_BLENDER_AVX2)
+    case kBlenderRow_AVX2: return cpu_has_avx2();
+#endif
+#if defined(AGS_BLENDER_NEON)
+    case kBlenderRow_NEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+bool set_blender_row_impl(BlenderRowImpl impl)
+{
+    if (!blender_row_impl_supported(impl))
+        return false;
+    switch (impl)
+    {
+#if defined(AGS_BLENDER_SSE2)
+    case kBlenderRow_SSE2: SimdRowFuncs = SSE2::RowFuncs; break;
+#endif
+#if defined(AGS_BLENDER_AVX2)
+    case kBlenderRow_AVX2: SimdRowFuncs = AVX2::RowFuncs; break;
+#endif
+#if defined(AGS_BLENDER_NEON)
+    case kBlenderRow_NEON: SimdRowFuncs = NEON::RowFuncs; break;
+#endif
+    default: SimdRowFuncs = nullptr; break;
+    }
+    RowImpl = impl;
+    return true;
+}
+
+BlenderRowImpl get_blender_row_impl()
+{
+    return RowImpl;
+}
+
+const char *get_blender_row_impl_name(BlenderRowImpl impl)
+{
+    switch (impl)
+    {
+    case kBlenderRow_SSE2: return "SSE2";
+    case kBlenderRow_AVX2: return "AVX2";
+    case kBlenderRow_NEON: return "NEON";
+    default: return "Generic";
+    }
+}
+
+static const BlendRowBinding *find_blend_row_binding(BLENDER_FUNC blender, bool lit)
+{
+    for (const auto &b : BlendRowBindings)
+    {
+        if (b.Blender == blender && b.Lit == lit)
+            return &b;
+    }
+    return nullptr;
+}
+
+// Tests if the row blenders may draw src on dst
+static bool can_blend_rows(BITMAP *dst, BITMAP *src, int dst_x, int dst_y)
+{
+    if (bitmap_color_depth(dst) != 32 || bitmap_color_depth(src) != 32)
+        return false;
+    // per-pixel blending allows to blend a bitmap onto itself with an offset
+    return !is_same_bitmap(dst, src) || (dst == src && dst_x == 0 && dst_y == 0);
+}
+
+// Blends src onto dst, clipping the same way as allegro's draw_trans_sprite
+// and draw_lit_sprite do; optional lut_min_pixels tells the least number of
+// pixels to draw for which the color blenders' lookup table is worth calculating.
+static bool blend_rows(BITMAP *dst, BITMAP *src, int dst_x, int dst_y,
+    const BlendRowBinding &binding, BlendRowParams params, int lut_min_pixels = 0)
+{
+    int src_x = 0, src_y = 0, w = src->w, h = src->h;
+    if (dst->clip)
+    {
+        src_x = std::max(0, dst->cl - dst_x);
+        w = std::min(src->w, dst->cr - dst_x) - src_x;
+        src_y = std::max(0, dst->ct - dst_y);
+        h = std::min(src->h, dst->cb - dst_y) - src_y;
+        if (w <= 0 || h <= 0)
+            return true;
+        dst_x += src_x;
+        dst_y += src_y;
+    }
+
+    uint32_t lut[256];
+    if (binding.Kind == kBlendRow_LitColor32)
+    {
+        if (w * h < lut_min_pixels)
+            return false;
+        for (uint32_t v = 0; v < 256; ++v)
+            lut[v] = binding.Blender(params.Color, v, params.Alpha) & 0x00FFFFFF;
+        params.LUT = lut;
+    }
+
+    const PfnBlendRow generic_row = GenericRowFuncs[binding.Kind];
+    const PfnBlendRow simd_row = SimdRowFuncs ? SimdRowFuncs[binding.Kind] : nullptr;
+    for (int y = 0; y < h; ++y)
+    {
+        uint32_t *dst_row = reinterpret_cast<uint32_t*>(dst->line[dst_y + y]) + dst_x;
+        const uint32_t *src_row = reinterpret_cast<const uint32_t*>(src->line[src_y + y]) + src_x;
+        const int done = simd_row ? simd_row(dst_row, src_row, w, params) : 0;
+        if (done < w)
+            generic_row(dst_row + done, src_row + done, w - done, params);
+    }
+    return true;
+}
+
+bool blend_sprite32(BITMAP *dst, BITMAP *src, int dst_x, int dst_y, bool lit, int light_amount)
+{
+    if (!can_blend_rows(dst, src, dst_x, dst_y))
+        return false;
+    const BlendRowBinding *binding = find_blend_row_binding(_blender_func32, lit);
+    if (!binding)
+        return false;
+
+    BlendRowParams params;
+    params.Color = _blender_col_32;
+    params.Alpha = lit ? light_amount : _blender_alpha;
+    // for the small sprites allegro's per-pixel blending is faster
+    // than calculating the lookup table
+    return blend_rows(dst, src, dst_x, dst_y, *binding, params, 1024);
+}
+
+bool get_blend_sprite32_params(bool lit, int light_amount, BlendSpriteParams &params)
+{
+    if (!find_blend_row_binding(_blender_func32, lit))
+        return false;
+    params.Blender = _blender_func32;
+    params.Color = _blender_col_32;
+    params.Alpha = lit ? light_amount : _blender_alpha;
+    params.Lit = lit;
+    return true;
+}
+
+bool blend_sprite32(BITMAP *dst, BITMAP *src, int dst_x, int dst_y, const BlendSpriteParams &params)
+{
+    if (!can_blend_rows(dst, src, dst_x, dst_y))
+        return false;
+    const BlendRowBinding *binding = find_blend_row_binding(params.Blender, params.Lit);
+    if (!binding)
+        return false;
+
+    BlendRowParams row_params;
+    row_params.Color = params.Color;
+    row_params.Alpha = params.Alpha;
+    return blend_rows(dst, src, dst_x, dst_y, *binding, row_params);
+}
+
+void init_blenders()
+{
+    const BlenderRowImpl try_impls[] = { kBlenderRow_AVX2, kBlenderRow_SSE2, kBlenderRow_NEON };
+    set_blender_row_impl(kBlenderRow_Generic);
+    for (auto impl : try_impls)
+    {
+        if (set_blender_row_impl(impl))
+            break;
+    }
+    AGS::Common::Bitmap::SetBlendBltHandler(blend_sprite32);
+}
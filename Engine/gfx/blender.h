@@ -20,6 +20,8 @@
 
 #include "core/types.h"
 
+struct BITMAP;
+
 //
 // Allegro's standard alpha blenders result in:
 // - src and dst RGB are combined proportionally to src alpha
@@ -40,6 +42,7 @@ uint32_t _myblender_color16_light(uint32_t x, uint32_t y, uint32_t n);
 uint32_t _myblender_color32_light(uint32_t x, uint32_t y, uint32_t n);
 // Customizable alpha blender that uses the supplied alpha value as src alpha,
 // and preserves destination's alpha channel (if there was one);
+uint32_t _myblender_alpha_trans24(uint32_t x, uint32_t y, uint32_t n);
 void set_my_trans_blender(int r, int g, int b, int a);
 // Argb2argb alpha blender combines RGBs proportionally to src alpha, but also
 // applies dst alpha factor to the dst RGB used in the merge;
@@ -54,13 +57,57 @@ uint32_t _argb2rgb_blender(uint32_t src_col, uint32_t dst_col, uint32_t src_alph
 uint32_t _rgb2argb_blender(uint32_t src_col, uint32_t dst_col, uint32_t src_alpha);
 // Sets the alpha channel to opaque. Used when drawing a non-alpha sprite onto an alpha-sprite.
 uint32_t _opaque_alpha_blender(uint32_t src_col, uint32_t dst_col, uint32_t src_alpha);
+// Trans blender which applies the custom alpha multiplied by the src alpha.
+uint32_t _trans_alpha_blender32(uint32_t src_col, uint32_t dst_col, uint32_t src_alpha);
 
 // Additive alpha blender plain copies src over, applying a summ of src and
 // dst alpha values.
+uint32_t _additive_alpha_copysrc_blender(uint32_t src_col, uint32_t dst_col, uint32_t src_alpha);
 void set_additive_alpha_blender();
 // Opaque alpha blender plain copies src over, applying opaque alpha value.
 void set_opaque_alpha_blender();
 // Sets argb2argb for 32-bit mode, and provides appropriate funcs for blending 32-bit onto 15/16/24-bit destination
 void set_argb2any_blender();
 
+// Row blenders implementations, using different instruction sets
+enum BlenderRowImpl
+{
+    kBlenderRow_Generic,
+    kBlenderRow_SSE2,
+    kBlenderRow_AVX2,
+    kBlenderRow_NEON
+};
+
+// Selects the best row blenders supported by the CPU, and makes Bitmap's
+// TransBlendBlt and LitBlendBlt use them for the 32-bit bitmaps.
+void init_blenders();
+// Tells whether the row blenders implementation is available in this build and on this CPU
+bool blender_row_impl_supported(BlenderRowImpl impl);
+// Selects the row blenders implementation, returns false if it's not supported
+bool set_blender_row_impl(BlenderRowImpl impl);
+BlenderRowImpl get_blender_row_impl();
+const char *get_blender_row_impl_name(BlenderRowImpl impl);
+// Draws 32-bit sprite using the row version of the current 32-bit allegro blender,
+// either in translucent or lit mode (see draw_trans_sprite and draw_lit_sprite).
+// Returns false if there's no row version of the blender, and nothing was drawn.
+bool blend_sprite32(BITMAP *dst, BITMAP *src, int dst_x, int dst_y, bool lit, int light_amount);
+
+// Blending parameters for drawing 32-bit sprites without relying on allegro's
+// global blender state; this lets to draw on separate bitmaps from several
+// threads at once.
+struct BlendSpriteParams
+{
+    uint32_t (*Blender)(uint32_t x, uint32_t y, uint32_t n) = nullptr;
+    uint32_t Color = 0; // blender color
+    uint32_t Alpha = 0; // blender alpha, or light amount in lit mode
+    bool Lit = false;
+};
+// Captures the current 32-bit allegro blender into params; returns false if
+// there's no row version of that blender.
+bool get_blend_sprite32_params(bool lit, int light_amount, BlendSpriteParams &params);
+// Draws 32-bit sprite using the row blender with the given parameters,
+// clipped by the dst bitmap's clipping rectangle.
+// Returns false if the bitmaps cannot be blended, and nothing was drawn.
+bool blend_sprite32(BITMAP *dst, BITMAP *src, int dst_x, int dst_y, const BlendSpriteParams &params);
+
 #endif // __AC_BLENDER_H
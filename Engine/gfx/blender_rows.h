@@ -0,0 +1,274 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Row blending kernels, written in terms of a vector operations set.
+//
+// NOTE: this file is included by blender.cpp once per instruction set,
+// inside a namespace which defines BlendOps struct; it must not be
+// included anywhere else, and so has no include guards.
+//
+// Every kernel processes as many whole vectors of pixels as fit in a row,
+// and returns the number of pixels processed; the rest is blended by
+// the caller. Kernels replicate the 32-bit unsigned arithmetic of the
+// respective per-pixel blenders exactly, lane by lane.
+//
+//=============================================================================
+
+typedef BlendOps::V V;
+
+static inline V Const(uint32_t v) { return BlendOps::Set1(v); }
+
+// n + 1 if n is not zero
+static inline V IncNonZero(V n)
+{
+    return BlendOps::Add(BlendOps::Add(n, Const(1)), BlendOps::CmpEq(n, BlendOps::Zero()));
+}
+
+// Blends x into y by the n/256 factor, same as Allegro's _blender_trans24
+static inline V TransCore(V x, V y, V n)
+{
+    const V rb_mask = Const(0xFF00FF), g_mask = Const(0xFF00);
+    const V res = BlendOps::Add(BlendOps::Shr8(BlendOps::Mul(
+        BlendOps::Sub(BlendOps::And(x, rb_mask), BlendOps::And(y, rb_mask)), n)), y);
+    const V y_g = BlendOps::And(y, g_mask);
+    const V g = BlendOps::Add(BlendOps::Shr8(BlendOps::Mul(
+        BlendOps::Sub(BlendOps::And(x, g_mask), y_g), n)), y_g);
+    return BlendOps::Or(BlendOps::And(res, rb_mask), BlendOps::And(g, g_mask));
+}
+
+// Same as argb2argb_blend_core; expects src_alpha already incremented
+static inline V Argb2ArgbCore(V src_col, V dst_col, V src_alpha)
+{
+    const V rb_mask = Const(0xFF00FF), g_mask = Const(0xFF00);
+    V dst_alpha = IncNonZero(BlendOps::Shr24(dst_col));
+    V dst_g  = BlendOps::Shr8(BlendOps::Mul(BlendOps::And(dst_col, g_mask), dst_alpha));
+    V dst_rb = BlendOps::Shr8(BlendOps::Mul(BlendOps::And(dst_col, rb_mask), dst_alpha));
+    dst_g = BlendOps::And(BlendOps::Add(BlendOps::Shr8(BlendOps::Mul(
+        BlendOps::Sub(BlendOps::And(src_col, g_mask), BlendOps::And(dst_g, g_mask)), src_alpha)), dst_g), g_mask);
+    dst_rb = BlendOps::And(BlendOps::Add(BlendOps::Shr8(BlendOps::Mul(
+        BlendOps::Sub(BlendOps::And(src_col, rb_mask), BlendOps::And(dst_rb, rb_mask)), src_alpha)), dst_rb), rb_mask);
+    const V c256 = Const(256);
+    dst_alpha = BlendOps::Sub(c256, BlendOps::Shr8(BlendOps::Mul(
+        BlendOps::Sub(c256, src_alpha), BlendOps::Sub(c256, dst_alpha))));
+    const V factor = BlendOps::Lookup(AlphaRecip, dst_alpha);
+    dst_g  = BlendOps::And(BlendOps::Shr8(BlendOps::Mul(dst_g, factor)), g_mask);
+    dst_rb = BlendOps::And(BlendOps::Shr8(BlendOps::Mul(dst_rb, factor)), rb_mask);
+    return BlendOps::Or(BlendOps::Or(dst_rb, dst_g),
+        BlendOps::Shl24(BlendOps::Sub(dst_alpha, Const(1))));
+}
+
+// Source alpha scaled by the optional custom alpha, as in _argb2argb_blender
+static inline V ScaledSrcAlpha(V src_col, uint32_t alpha)
+{
+    const V src_alpha = BlendOps::Shr24(src_col);
+    if (alpha == 0)
+        return src_alpha;
+    return BlendOps::Shr8(BlendOps::Mul(src_alpha, Const((alpha & 0xFF) + 1)));
+}
+
+// Runs blend(src, dst) for each pixel, skipping the mask color pixels
+template <typename TBlend>
+static inline int TransRows(uint32_t *dst, const uint32_t *src, int count, const TBlend &blend)
+{
+    const V mask_color = Const(MASK_COLOR_32);
+    int i = 0;
+    for (; i + BlendOps::N <= count; i += BlendOps::N)
+    {
+        const V s = BlendOps::Load(src + i);
+        const V d = BlendOps::Load(dst + i);
+        BlendOps::Store(dst + i, BlendOps::Select(BlendOps::CmpEq(s, mask_color), d, blend(s, d)));
+    }
+    return i;
+}
+
+// Writes blend(src) for each pixel, skipping the mask color pixels
+template <typename TBlend>
+static inline int LitRows(uint32_t *dst, const uint32_t *src, int count, const TBlend &blend)
+{
+    const V mask_color = Const(MASK_COLOR_32);
+    int i = 0;
+    for (; i + BlendOps::N <= count; i += BlendOps::N)
+    {
+        const V s = BlendOps::Load(src + i);
+        const V d = BlendOps::Load(dst + i);
+        BlendOps::Store(dst + i, BlendOps::Select(BlendOps::CmpEq(s, mask_color), d, blend(s)));
+    }
+    return i;
+}
+
+struct Trans24
+{
+    V N;
+    Trans24(uint32_t alpha) : N(Const(alpha ? alpha + 1 : 0)) {}
+    V operator()(V s, V d) const { return TransCore(s, d, N); }
+};
+
+struct AlphaTrans24
+{
+    V N;
+    AlphaTrans24(uint32_t alpha) : N(Const(alpha ? alpha + 1 : 0)) {}
+    V operator()(V s, V d) const
+    {
+        return BlendOps::Or(TransCore(s, d, N), BlendOps::And(d, Const(0xFF000000)));
+    }
+};
+
+struct Alpha32
+{
+    V operator()(V s, V d) const { return TransCore(s, d, IncNonZero(BlendOps::Shr24(s))); }
+};
+
+struct TransAlpha32
+{
+    V Alpha;
+    TransAlpha32(uint32_t alpha) : Alpha(Const(alpha)) {}
+    V operator()(V s, V d) const
+    {
+        return TransCore(s, d, IncNonZero(BlendOps::Shr8(BlendOps::Mul(Alpha, BlendOps::Shr24(s)))));
+    }
+};
+
+struct Argb2Argb
+{
+    uint32_t Alpha;
+    Argb2Argb(uint32_t alpha) : Alpha(alpha) {}
+    V operator()(V s, V d) const
+    {
+        const V src_alpha = ScaledSrcAlpha(s, Alpha);
+        return BlendOps::Select(BlendOps::CmpEq(src_alpha, BlendOps::Zero()), d,
+            Argb2ArgbCore(s, d, BlendOps::Add(src_alpha, Const(1))));
+    }
+};
+
+struct Argb2Rgb
+{
+    uint32_t Alpha;
+    Argb2Rgb(uint32_t alpha) : Alpha(alpha) {}
+    V operator()(V s, V d) const { return TransCore(s, d, IncNonZero(ScaledSrcAlpha(s, Alpha))); }
+};
+
+struct Rgb2Argb
+{
+    V SrcAlpha;
+    Rgb2Argb(uint32_t alpha) : SrcAlpha(Const(alpha + 1)) {}
+    V operator()(V s, V d) const
+    {
+        return Argb2ArgbCore(BlendOps::Or(s, Const(0xFF000000)), d, SrcAlpha);
+    }
+};
+
+struct OpaqueAlpha
+{
+    V operator()(V s, V /*d*/) const { return BlendOps::Or(s, Const(0xFF000000)); }
+};
+
+struct AdditiveAlpha
+{
+    V operator()(V s, V d) const
+    {
+        const V alpha = BlendOps::MinSmall(
+            BlendOps::Add(BlendOps::Shr24(s), BlendOps::Shr24(d)), Const(0xFF));
+        return BlendOps::Or(BlendOps::Shl24(alpha), BlendOps::And(s, Const(0x00FFFFFF)));
+    }
+};
+
+struct LitTrans24
+{
+    V Color, N;
+    LitTrans24(uint32_t color, uint32_t alpha) : Color(Const(color)), N(Const(alpha ? alpha + 1 : 0)) {}
+    V operator()(V s) const { return TransCore(Color, s, N); }
+};
+
+struct LitAlphaTrans24
+{
+    V Color, N;
+    LitAlphaTrans24(uint32_t color, uint32_t alpha) : Color(Const(color)), N(Const(alpha ? alpha + 1 : 0)) {}
+    V operator()(V s) const
+    {
+        return BlendOps::Or(TransCore(Color, s, N), BlendOps::And(s, Const(0xFF000000)));
+    }
+};
+
+static int RowTrans24(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    return TransRows(dst, src, count, Trans24(p.Alpha));
+}
+
+static int RowAlphaTrans24(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    return TransRows(dst, src, count, AlphaTrans24(p.Alpha));
+}
+
+static int RowAlpha32(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &/*p*/)
+{
+    return TransRows(dst, src, count, Alpha32());
+}
+
+static int RowTransAlpha32(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    return TransRows(dst, src, count, TransAlpha32(p.Alpha));
+}
+
+static int RowArgb2Argb(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    return TransRows(dst, src, count, Argb2Argb(p.Alpha));
+}
+
+static int RowArgb2Rgb(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    return TransRows(dst, src, count, Argb2Rgb(p.Alpha));
+}
+
+static int RowRgb2Argb(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    if (p.Alpha == 0 || p.Alpha == 0xFF)
+        return TransRows(dst, src, count, OpaqueAlpha());
+    return TransRows(dst, src, count, Rgb2Argb(p.Alpha));
+}
+
+static int RowOpaqueAlpha(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &/*p*/)
+{
+    return TransRows(dst, src, count, OpaqueAlpha());
+}
+
+static int RowAdditiveAlpha(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &/*p*/)
+{
+    return TransRows(dst, src, count, AdditiveAlpha());
+}
+
+static int RowLitTrans24(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    return LitRows(dst, src, count, LitTrans24(p.Color, p.Alpha));
+}
+
+static int RowLitAlphaTrans24(uint32_t *dst, const uint32_t *src, int count, const BlendRowParams &p)
+{
+    return LitRows(dst, src, count, LitAlphaTrans24(p.Color, p.Alpha));
+}
+
+static const PfnBlendRow RowFuncs[kNumBlendRowKinds] =
+{
+    RowTrans24,
+    RowAlphaTrans24,
+    RowAlpha32,
+    RowTransAlpha32,
+    RowArgb2Argb,
+    RowArgb2Rgb,
+    RowRgb2Argb,
+    RowOpaqueAlpha,
+    RowAdditiveAlpha,
+    RowLitTrans24,
+    RowLitAlphaTrans24,
+    nullptr, // kBlendRow_LitColor32, uses lookup table
+};
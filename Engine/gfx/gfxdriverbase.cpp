@@ -353,290 +353,36 @@ void VideoMemoryGraphicsDriver::DestroyFxPool()
     _fxIndex = 0;
 }
 
-
-#define algetr32(c) getr32(c)
-#define algetg32(c) getg32(c)
-#define algetb32(c) getb32(c)
-#define algeta32(c) geta32(c)
-
-#define algetr16(c) getr16(c)
-#define algetg16(c) getg16(c)
-#define algetb16(c) getb16(c)
-
-#define algetr8(c)  getr8(c)
-#define algetg8(c)  getg8(c)
-#define algetb8(c)  getb8(c)
-
-
-__inline void get_pixel_if_not_transparent8(unsigned char *pixel, unsigned char *red, unsigned char *green, unsigned char *blue, unsigned char *divisor)
-{
-  if (pixel[0] != MASK_COLOR_8)
-  {
-    *red += algetr8(pixel[0]);
-    *green += algetg8(pixel[0]);
-    *blue += algetb8(pixel[0]);
-    divisor[0]++;
-  }
-}
-
-__inline void get_pixel_if_not_transparent16(unsigned short *pixel, unsigned short *red, unsigned short *green, unsigned short *blue, unsigned short *divisor)
-{
-  if (pixel[0] != MASK_COLOR_16)
-  {
-    *red += algetr16(pixel[0]);
-    *green += algetg16(pixel[0]);
-    *blue += algetb16(pixel[0]);
-    divisor[0]++;
-  }
-}
-
-__inline void get_pixel_if_not_transparent32(unsigned int *pixel, unsigned int *red, unsigned int *green, unsigned int *blue, unsigned int *divisor)
-{
-  if (pixel[0] != MASK_COLOR_32)
-  {
-    *red += algetr32(pixel[0]);
-    *green += algetg32(pixel[0]);
-    *blue += algetb32(pixel[0]);
-    divisor[0]++;
-  }
-}
-
-
-#define VMEMCOLOR_RGBA(r,g,b,a) \
-    ( (((a) & 0xFF) << _vmem_a_shift_32) | (((r) & 0xFF) << _vmem_r_shift_32) | (((g) & 0xFF) << _vmem_g_shift_32) | (((b) & 0xFF) << _vmem_b_shift_32) )
-
-
 void VideoMemoryGraphicsDriver::BitmapToVideoMem(const Bitmap *bitmap, const bool has_alpha, const TextureTile *tile,
-    uint8_t *dst_ptr, const int dst_pitch, const bool usingLinearFiltering)
+    uint8_t *dst_ptr, const int dst_pitch, const bool usingLinearFiltering, const int edge_flags)
 {
-    const int src_depth = bitmap->GetColorDepth();
-    bool lastPixelWasTransparent = false;
-
-    switch (src_depth)
-    {
-        case 8: {
-            for (int y = 0; y < tile->height; y++) {
-                lastPixelWasTransparent = false;
-                const uint8_t *scanline_before = (y > 0) ? bitmap->GetScanLine(y + tile->y - 1) : nullptr;
-                const uint8_t *scanline_at = bitmap->GetScanLine(y + tile->y);
-                const uint8_t *scanline_after = (y < tile->height - 1) ? bitmap->GetScanLine(y + tile->y + 1) : nullptr;
-                unsigned int *memPtrLong = (unsigned int *) dst_ptr;
-
-                for (int x = 0; x < tile->width; x++) {
-                    unsigned char *srcData = (unsigned char *) &scanline_at[(x + tile->x) * sizeof(char)];
-                    if (*srcData == MASK_COLOR_8) {
-                        if (!usingLinearFiltering)
-                            memPtrLong[x] = 0;
-                            // set to transparent, but use the colour from the neighbouring
-                            // pixel to stop the linear filter doing black outlines
-                        else {
-                            unsigned char red = 0, green = 0, blue = 0, divisor = 0;
-                            if (x > 0)
-                                get_pixel_if_not_transparent8(&srcData[-1], &red, &green, &blue, &divisor);
-                            if (x < tile->width - 1)
-                                get_pixel_if_not_transparent8(&srcData[1], &red, &green, &blue, &divisor);
-                            if (y > 0)
-                                get_pixel_if_not_transparent8(
-                                        (unsigned char *) &scanline_before[(x + tile->x) * sizeof(char)],
-                                        &red, &green, &blue, &divisor);
-                            if (y < tile->height - 1)
-                                get_pixel_if_not_transparent8(
-                                        (unsigned char *) &scanline_after[(x + tile->x) * sizeof(char)],
-                                        &red, &green, &blue, &divisor);
-                            if (divisor > 0)
-                                memPtrLong[x] = VMEMCOLOR_RGBA(red / divisor, green / divisor, blue / divisor, 0);
-                            else
-                                memPtrLong[x] = 0;
-                        }
-                        lastPixelWasTransparent = true;
-                    } else {
-                        memPtrLong[x] = VMEMCOLOR_RGBA(algetr8(*srcData), algetg8(*srcData), algetb8(*srcData), 0xFF);
-                        if (lastPixelWasTransparent) {
-                            // update the colour of the previous tranparent pixel, to
-                            // stop black outlines when linear filtering
-                            memPtrLong[x - 1] = memPtrLong[x] & 0x00FFFFFF;
-                            lastPixelWasTransparent = false;
-                        }
-                    }
-                }
-                dst_ptr += dst_pitch;
-            }
-        }
-        break;
-        case 16: {
-            for (int y = 0; y < tile->height; y++) {
-                lastPixelWasTransparent = false;
-                const uint8_t *scanline_before = (y > 0) ? bitmap->GetScanLine(y + tile->y - 1) : nullptr;
-                const uint8_t *scanline_at = bitmap->GetScanLine(y + tile->y);
-                const uint8_t *scanline_after = (y < tile->height - 1) ? bitmap->GetScanLine(y + tile->y + 1) : nullptr;
-                unsigned int *memPtrLong = (unsigned int *) dst_ptr;
-
-                for (int x = 0; x < tile->width; x++) {
-                    unsigned short *srcData = (unsigned short *) &scanline_at[(x + tile->x) * sizeof(short)];
-                    if (*srcData == MASK_COLOR_16) {
-                        if (!usingLinearFiltering)
-                            memPtrLong[x] = 0;
-                            // set to transparent, but use the colour from the neighbouring
-                            // pixel to stop the linear filter doing black outlines
-                        else {
-                            unsigned short red = 0, green = 0, blue = 0, divisor = 0;
-                            if (x > 0)
-                                get_pixel_if_not_transparent16(&srcData[-1], &red, &green, &blue, &divisor);
-                            if (x < tile->width - 1)
-                                get_pixel_if_not_transparent16(&srcData[1], &red, &green, &blue, &divisor);
-                            if (y > 0)
-                                get_pixel_if_not_transparent16(
-                                        (unsigned short *) &scanline_before[(x + tile->x) * sizeof(short)], &red,
-                                        &green, &blue, &divisor);
-                            if (y < tile->height - 1)
-                                get_pixel_if_not_transparent16(
-                                        (unsigned short *) &scanline_after[(x + tile->x) * sizeof(short)], &red, &green,
-                                        &blue, &divisor);
-                            if (divisor > 0)
-                                memPtrLong[x] = VMEMCOLOR_RGBA(red / divisor, green / divisor, blue / divisor, 0);
-                            else
-                                memPtrLong[x] = 0;
-                        }
-                        lastPixelWasTransparent = true;
-                    } else {
-                        memPtrLong[x] = VMEMCOLOR_RGBA(algetr16(*srcData), algetg16(*srcData), algetb16(*srcData),
-                                                       0xFF);
-                        if (lastPixelWasTransparent) {
-                            // update the colour of the previous tranparent pixel, to
-                            // stop black outlines when linear filtering
-                            memPtrLong[x - 1] = memPtrLong[x] & 0x00FFFFFF;
-                            lastPixelWasTransparent = false;
-                        }
-                    }
-                }
-                dst_ptr += dst_pitch;
-            }
-        }
-        break;
-        case 32: {
-            for (int y = 0; y < tile->height; y++) {
-                lastPixelWasTransparent = false;
-                const uint8_t *scanline_before = (y > 0) ? bitmap->GetScanLine(y + tile->y - 1) : nullptr;
-                const uint8_t *scanline_at = bitmap->GetScanLine(y + tile->y);
-                const uint8_t *scanline_after = (y < tile->height - 1) ? bitmap->GetScanLine(y + tile->y + 1) : nullptr;
-                unsigned int *memPtrLong = (unsigned int *) dst_ptr;
-
-                for (int x = 0; x < tile->width; x++) {
-                    unsigned int *srcData = (unsigned int *) &scanline_at[(x + tile->x) * sizeof(int)];
-                    if (*srcData == MASK_COLOR_32) {
-                        if (!usingLinearFiltering)
-                            memPtrLong[x] = 0;
-                            // set to transparent, but use the colour from the neighbouring
-                            // pixel to stop the linear filter doing black outlines
-                        else {
-                            unsigned int red = 0, green = 0, blue = 0, divisor = 0;
-                            if (x > 0)
-                                get_pixel_if_not_transparent32(&srcData[-1], &red, &green, &blue, &divisor);
-                            if (x < tile->width - 1)
-                                get_pixel_if_not_transparent32(&srcData[1], &red, &green, &blue, &divisor);
-                            if (y > 0)
-                                get_pixel_if_not_transparent32(
-                                        (unsigned int *) &scanline_before[(x + tile->x) * sizeof(int)], &red, &green,
-                                        &blue, &divisor);
-                            if (y < tile->height - 1)
-                                get_pixel_if_not_transparent32(
-                                        (unsigned int *) &scanline_after[(x + tile->x) * sizeof(int)], &red, &green,
-                                        &blue, &divisor);
-                            if (divisor > 0)
-                                memPtrLong[x] = VMEMCOLOR_RGBA(red / divisor, green / divisor, blue / divisor, 0);
-                            else
-                                memPtrLong[x] = 0;
-                        }
-                        lastPixelWasTransparent = true;
-                    } else if (has_alpha) {
-                        memPtrLong[x] = VMEMCOLOR_RGBA(algetr32(*srcData), algetg32(*srcData), algetb32(*srcData),
-                                                       algeta32(*srcData));
-                    } else {
-                        memPtrLong[x] = VMEMCOLOR_RGBA(algetr32(*srcData), algetg32(*srcData), algetb32(*srcData),
-                                                       0xFF);
-                        if (lastPixelWasTransparent) {
-                            // update the colour of the previous tranparent pixel, to
-                            // stop black outlines when linear filtering
-                            memPtrLong[x - 1] = memPtrLong[x] & 0x00FFFFFF;
-                            lastPixelWasTransparent = false;
-                        }
-                    }
-                }
-                dst_ptr += dst_pitch;
-            }
-        }
-        break;
-        default:
-            break;
-    }
+    int flags = edge_flags;
+    if (has_alpha)
+        flags |= kVMem_HasAlpha;
+    if (usingLinearFiltering)
+        flags |= kVMem_KeepMaskColor;
+    Engine::BitmapToVideoMem(bitmap, tile->x, tile->y, tile->width, tile->height,
+        GetVMemPixelFormat(), flags, dst_ptr, dst_pitch);
 }
 
 void VideoMemoryGraphicsDriver::BitmapToVideoMemOpaque(const Bitmap *bitmap, const bool has_alpha, const TextureTile *tile,
-    uint8_t *dst_ptr, const int dst_pitch)
+    uint8_t *dst_ptr, const int dst_pitch, const int edge_flags)
 {
-    const int src_depth = bitmap->GetColorDepth();
+    int flags = edge_flags | kVMem_Opaque;
+    if (has_alpha)
+        flags |= kVMem_HasAlpha;
+    Engine::BitmapToVideoMem(bitmap, tile->x, tile->y, tile->width, tile->height,
+        GetVMemPixelFormat(), flags, dst_ptr, dst_pitch);
+}
 
-    switch (src_depth)
-    {
-        case 8: {
-            for (int y = 0; y < tile->height; y++) {
-                const uint8_t *scanline_at = bitmap->GetScanLine(y + tile->y);
-                unsigned int *memPtrLong = (unsigned int *) dst_ptr;
-
-                for (int x = 0; x < tile->width; x++) {
-                    unsigned char *srcData = (unsigned char *) &scanline_at[(x + tile->x) * sizeof(char)];
-                    memPtrLong[x] = VMEMCOLOR_RGBA(algetr8(*srcData), algetg8(*srcData), algetb8(*srcData), 0xFF);
-                }
-
-                dst_ptr += dst_pitch;
-            }
-        }
-        break;
-        case 16: {
-            for (int y = 0; y < tile->height; y++) {
-                const uint8_t *scanline_at = bitmap->GetScanLine(y + tile->y);
-                unsigned int *memPtrLong = (unsigned int *) dst_ptr;
-
-                for (int x = 0; x < tile->width; x++) {
-                    unsigned short *srcData = (unsigned short *) &scanline_at[(x + tile->x) * sizeof(short)];
-                    memPtrLong[x] = VMEMCOLOR_RGBA(algetr16(*srcData), algetg16(*srcData), algetb16(*srcData), 0xFF);
-                }
-
-                dst_ptr += dst_pitch;
-            }
-        }
-        break;
-        case 32: {
-            if (has_alpha) {
-                for (int y = 0; y < tile->height; y++) {
-                    const uint8_t* scanline_at = bitmap->GetScanLine(y + tile->y);
-                    unsigned int* memPtrLong = (unsigned int*)dst_ptr;
-
-                    for (int x = 0; x < tile->width; x++) {
-                        unsigned int* srcData = (unsigned int*)&scanline_at[(x + tile->x) * sizeof(int)];
-                        memPtrLong[x] = VMEMCOLOR_RGBA(algetr32(*srcData), algetg32(*srcData), algetb32(*srcData),
-                            algeta32(*srcData));
-                    }
-                    dst_ptr += dst_pitch;
-                }
-            } else {
-                for (int y = 0; y < tile->height; y++) {
-                    const uint8_t* scanline_at = bitmap->GetScanLine(y + tile->y);
-                    unsigned int* memPtrLong = (unsigned int*)dst_ptr;
-
-                    for (int x = 0; x < tile->width; x++) {
-                        unsigned int* srcData = (unsigned int*)&scanline_at[(x + tile->x) * sizeof(int)];
-                        memPtrLong[x] = VMEMCOLOR_RGBA(algetr32(*srcData), algetg32(*srcData), algetb32(*srcData),
-                            0xFF);
-                    }
-                    dst_ptr += dst_pitch;
-                }
-            }
-        }
-        break;
-        default:
-            break;
-    }
+VMemPixelFormat VideoMemoryGraphicsDriver::GetVMemPixelFormat() const
+{
+    VMemPixelFormat format;
+    format.RShift = _vmem_r_shift_32;
+    format.GShift = _vmem_g_shift_32;
+    format.BShift = _vmem_b_shift_32;
+    format.AShift = _vmem_a_shift_32;
+    return format;
 }
 
 } // namespace Engine
@@ -24,6 +24,7 @@
 #include "gfx/ddb.h"
 #include "gfx/gfx_def.h"
 #include "gfx/graphicsdriver.h"
+#include "gfx/vmem_convert.h"
 #include "util/scaling.h"
 #include "util/resourcecache.h"
 
@@ -115,6 +116,9 @@ public:
 
     bool        SetVsync(bool enabled) override;
     bool        GetVsync() const override;
+    void        UseSpriteAtlas(bool /*enabled*/) override { /* not supported by default */ }
+    size_t      GetDrawCallCount() const override { return 0u; }
+    uint32_t    GetRenderTargetResetCount() const override { return _renderTargetResetCount; }
 
     void        BeginSpriteBatch(const Rect &viewport, const SpriteTransform &transform,
                     Common::GraphicFlip flip = Common::kFlip_None, PBitmap surface = nullptr) override;
@@ -175,6 +179,9 @@ protected:
     // Capability flags
     bool                _capsVsync = false; // is vsync available
 
+    // Incremented each time the render targets are recreated and lose their contents
+    uint32_t            _renderTargetResetCount = 0u;
+
     // Callbacks
     GFXDRV_CLIENTCALLBACK _pollingCallback;
     GFXDRV_CLIENTCALLBACK _drawScreenCallback;
@@ -316,12 +323,16 @@ protected:
     // Disposes all items in the fx pool
     void DestroyFxPool();
 
-    // Prepares bitmap to be applied to the texture, copies pixels to the provided buffer
+    // Prepares bitmap to be applied to the texture, copies pixels to the provided buffer;
+    // edge_flags tell which borders around the tile to fill (see VMemConvertFlags)
     void BitmapToVideoMem(const Bitmap *bitmap, const bool has_alpha, const TextureTile *tile,
-                            uint8_t *dst_ptr, const int dst_pitch, const bool usingLinearFiltering);
+                            uint8_t *dst_ptr, const int dst_pitch, const bool usingLinearFiltering,
+                            const int edge_flags = 0);
     // Same but optimized for opaque source bitmaps which ignore transparent "mask color"
     void BitmapToVideoMemOpaque(const Bitmap *bitmap, const bool has_alpha, const TextureTile *tile,
-        uint8_t *dst_ptr, const int dst_pitch);
+        uint8_t *dst_ptr, const int dst_pitch, const int edge_flags = 0);
+    // Gets the color component shifts in video bitmap format
+    VMemPixelFormat GetVMemPixelFormat() const;
 
     // Stage matrixes are used to let plugins with hardware acceleration know model matrix;
     // these matrixes are filled compatible with each given renderer
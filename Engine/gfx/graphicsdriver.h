@@ -225,6 +225,16 @@ public:
   // Runs box-out animation in a blocking manner.
   virtual void BoxOutEffect(bool blackingOut, int speed, int delay) = 0;
   virtual void UseSmoothScaling(bool enabled) = 0;
+  // Enables packing of the small sprite textures into the shared atlas pages,
+  // which lets renderer draw consecutive sprites from the same page at once.
+  virtual void UseSpriteAtlas(bool enabled) = 0;
+  // Returns the number of draw calls made in the last rendered frame,
+  // or 0 if the renderer does not count them.
+  virtual size_t GetDrawCallCount() const = 0;
+  // Returns the number of times the render targets had their contents lost
+  // and were recreated (e.g. after the device reset). Callers which cache
+  // their drawing on render targets should redraw when this value changes.
+  virtual uint32_t GetRenderTargetResetCount() const = 0;
   virtual bool SupportsGammaControl() = 0;
   virtual void SetGamma(int newGamma) = 0;
   // Returns the virtual screen. Will return NULL if renderer does not support memory backbuffer.
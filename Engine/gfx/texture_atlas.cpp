@@ -0,0 +1,147 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "gfx/texture_atlas.h"
+#include <algorithm>
+
+namespace AGS
+{
+namespace Engine
+{
+
+// Shelf heights are rounded up to this step, so that the regions
+// of slightly different heights could share the same shelf
+static const int SHELF_HEIGHT_STEP = 8;
+
+TextureAtlasPacker::TextureAtlasPacker(int width, int height)
+    : _width(width)
+    , _height(height)
+{
+}
+
+bool TextureAtlasPacker::AllocateOnShelf(Shelf &shelf, int width, int &x)
+{
+    for (auto it = shelf.Free.begin(); it != shelf.Free.end(); ++it)
+    {
+        if (it->Width < width)
+            continue;
+        x = it->X;
+        it->X += width;
+        it->Width -= width;
+        if (it->Width == 0)
+            shelf.Free.erase(it);
+        return true;
+    }
+    return false;
+}
+
+bool TextureAtlasPacker::Allocate(int width, int height, Rect &rc)
+{
+    if (width <= 0 || height <= 0 || width > _width || height > _height)
+        return false;
+    const int shelf_height = std::min(
+        (height + SHELF_HEIGHT_STEP - 1) / SHELF_HEIGHT_STEP * SHELF_HEIGHT_STEP, _height);
+
+    int x = 0;
+    // First try the shelves made for this height
+    for (auto &shelf : _shelves)
+    {
+        if (shelf.Height == shelf_height && AllocateOnShelf(shelf, width, x))
+        {
+            rc = RectWH(x, shelf.Y, width, height);
+            _count++;
+            return true;
+        }
+    }
+    // Then start a new shelf, if there's space left
+    if (_top + shelf_height <= _height)
+    {
+        Shelf shelf;
+        shelf.Y = _top;
+        shelf.Height = shelf_height;
+        shelf.Free.push_back(Span());
+        shelf.Free.back().Width = _width;
+        AllocateOnShelf(shelf, width, x);
+        _shelves.push_back(shelf);
+        _top += shelf_height;
+        rc = RectWH(x, shelf.Y, width, height);
+        _count++;
+        return true;
+    }
+    // Finally try the lowest of the taller shelves
+    Shelf *best = nullptr;
+    for (auto &shelf : _shelves)
+    {
+        if (shelf.Height > shelf_height && (!best || shelf.Height < best->Height) &&
+            std::any_of(shelf.Free.begin(), shelf.Free.end(), [width](const Span &s) { return s.Width >= width; }))
+            best = &shelf;
+    }
+    if (!best)
+        return false;
+    AllocateOnShelf(*best, width, x);
+    rc = RectWH(x, best->Y, width, height);
+    _count++;
+    return true;
+}
+
+void TextureAtlasPacker::Free(const Rect &rc)
+{
+    auto shelf_it = std::find_if(_shelves.begin(), _shelves.end(),
+        [&rc](const Shelf &s) { return s.Y == rc.Top; });
+    if (shelf_it == _shelves.end())
+        return;
+    auto &free = shelf_it->Free;
+    Span span;
+    span.X = rc.Left;
+    span.Width = rc.GetWidth();
+    auto it = std::lower_bound(free.begin(), free.end(), span,
+        [](const Span &a, const Span &b) { return a.X < b.X; });
+    it = free.insert(it, span);
+    // Merge with the neighbour spans
+    auto next = it + 1;
+    if (next != free.end() && it->X + it->Width == next->X)
+    {
+        it->Width += next->Width;
+        free.erase(next);
+    }
+    if (it != free.begin())
+    {
+        auto prev = it - 1;
+        if (prev->X + prev->Width == it->X)
+        {
+            prev->Width += it->Width;
+            free.erase(it);
+        }
+    }
+    _count--;
+
+    // Give the empty shelves at the top back to the unused space
+    while (!_shelves.empty())
+    {
+        const auto &last = _shelves.back();
+        if (last.Free.size() != 1 || last.Free[0].Width != _width)
+            break;
+        _top = last.Y;
+        _shelves.pop_back();
+    }
+}
+
+void TextureAtlasPacker::Clear()
+{
+    _shelves.clear();
+    _top = 0;
+    _count = 0u;
+}
+
+} // namespace Engine
+} // namespace AGS
@@ -0,0 +1,78 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// TextureAtlasPacker allocates rectangular regions on a fixed-size texture
+// atlas page. Regions are placed on horizontal shelves, each shelf holding
+// regions of a similar height; space released by the freed regions is
+// reused by the following allocations on the same shelf.
+//
+//=============================================================================
+#ifndef __AGS_EE_GFX__TEXTUREATLAS_H
+#define __AGS_EE_GFX__TEXTUREATLAS_H
+
+#include <vector>
+#include "util/geometry.h"
+
+namespace AGS
+{
+namespace Engine
+{
+
+class TextureAtlasPacker
+{
+public:
+    TextureAtlasPacker(int width, int height);
+
+    int GetWidth() const { return _width; }
+    int GetHeight() const { return _height; }
+    // Gets the number of allocated regions
+    size_t GetCount() const { return _count; }
+
+    // Allocates a region of the given size, returns false if there's no room
+    bool Allocate(int width, int height, Rect &rc);
+    // Releases the region previously returned by Allocate
+    void Free(const Rect &rc);
+    // Releases all regions
+    void Clear();
+
+private:
+    // A horizontal range of free pixels on a shelf
+    struct Span
+    {
+        int X = 0;
+        int Width = 0;
+    };
+
+    struct Shelf
+    {
+        int Y = 0;
+        int Height = 0;
+        std::vector<Span> Free; // sorted by X
+    };
+
+    static bool AllocateOnShelf(Shelf &shelf, int width, int &x);
+
+    int _width = 0;
+    int _height = 0;
+    // Shelves, sorted by Y
+    std::vector<Shelf> _shelves;
+    // Top of the yet unused space on the page
+    int _top = 0;
+    size_t _count = 0u;
+};
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_GFX__TEXTUREATLAS_H
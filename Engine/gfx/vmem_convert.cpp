@@ -0,0 +1,481 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include "gfx/vmem_convert.h"
+#include <allegro.h>
+#include "gfx/bitmap.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AGS_VMEM_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AGS_VMEM_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace AGS
+{
+namespace Engine
+{
+
+using namespace Common;
+
+struct ConvertParams
+{
+    // Source component shifts
+    uint32_t SrcR = 0, SrcG = 0, SrcB = 0, SrcA = 0;
+    // Video memory component shifts
+    uint32_t DstR = 0, DstG = 0, DstB = 0, DstA = 0;
+    bool HasAlpha = false;
+    bool Opaque = false;
+    // Converted palette, for 8-bit bitmaps
+    uint32_t Palette[256];
+};
+
+// Converts a number of pixels, returns the number of processed pixels;
+// sets has_mask if any of them had mask color
+typedef int (*PfnConvertRow)(uint32_t *dst, const uint8_t *src, int count, const ConvertParams &p, bool &has_mask);
+
+static inline uint32_t VMemColor(const ConvertParams &p, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return ((r & 0xFF) << p.DstR) | ((g & 0xFF) << p.DstG) | ((b & 0xFF) << p.DstB) | ((a & 0xFF) << p.DstA);
+}
+
+//-----------------------------------------------------------------------------
+// Generic row converters
+//-----------------------------------------------------------------------------
+
+static int ConvertRow8(uint32_t *dst, const uint8_t *src, int count, const ConvertParams &p, bool &has_mask)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (!p.Opaque && src[i] == MASK_COLOR_8)
+        {
+            dst[i] = 0;
+            has_mask = true;
+        }
+        else
+        {
+            dst[i] = p.Palette[src[i]];
+        }
+    }
+    return count;
+}
+
+static int ConvertRow16(uint32_t *dst, const uint8_t *src_bytes, int count, const ConvertParams &p, bool &has_mask)
+{
+    const uint16_t *src = reinterpret_cast<const uint16_t*>(src_bytes);
+    for (int i = 0; i < count; ++i)
+    {
+        const uint32_t c = src[i];
+        if (!p.Opaque && c == MASK_COLOR_16)
+        {
+            dst[i] = 0;
+            has_mask = true;
+        }
+        else
+        {
+            dst[i] = VMemColor(p, _rgb_scale_5[(c >> p.SrcR) & 0x1F], _rgb_scale_6[(c >> p.SrcG) & 0x3F],
+                _rgb_scale_5[(c >> p.SrcB) & 0x1F], 0xFF);
+        }
+    }
+    return count;
+}
+
+static int ConvertRow32(uint32_t *dst, const uint8_t *src_bytes, int count, const ConvertParams &p, bool &has_mask)
+{
+    const uint32_t *src = reinterpret_cast<const uint32_t*>(src_bytes);
+    for (int i = 0; i < count; ++i)
+    {
+        const uint32_t c = src[i];
+        if (!p.Opaque && c == MASK_COLOR_32)
+        {
+            dst[i] = 0;
+            has_mask = true;
+        }
+        else
+        {
+            dst[i] = VMemColor(p, c >> p.SrcR, c >> p.SrcG, c >> p.SrcB, p.HasAlpha ? (c >> p.SrcA) : 0xFF);
+        }
+    }
+    return count;
+}
+
+//-----------------------------------------------------------------------------
+// SIMD row converters
+//
+// Written in terms of a small set of vector operations on 32-bit lanes.
+// The 5- and 6-bit components are scaled up by repeating their high bits,
+// which gives same values as allegro's _rgb_scale_5 and _rgb_scale_6 tables.
+//-----------------------------------------------------------------------------
+
+template <typename Ops>
+struct SimdConvert
+{
+    typedef typename Ops::V V;
+
+    static inline V Component(V c, uint32_t src_shift, uint32_t mask, uint32_t dst_shift)
+    {
+        return Ops::Shl(Ops::And(Ops::Shr(c, src_shift), Ops::Set1(mask)), dst_shift);
+    }
+
+    static inline V Scale5(V v) { return Ops::Or(Ops::Shl(v, 3), Ops::Shr(v, 2)); }
+    static inline V Scale6(V v) { return Ops::Or(Ops::Shl(v, 2), Ops::Shr(v, 4)); }
+
+    static inline V Pixel16(V c, const ConvertParams &p, V alpha)
+    {
+        const V r = Scale5(Ops::And(Ops::Shr(c, p.SrcR), Ops::Set1(0x1F)));
+        const V g = Scale6(Ops::And(Ops::Shr(c, p.SrcG), Ops::Set1(0x3F)));
+        const V b = Scale5(Ops::And(Ops::Shr(c, p.SrcB), Ops::Set1(0x1F)));
+        return Ops::Or(Ops::Or(Ops::Shl(r, p.DstR), Ops::Shl(g, p.DstG)), Ops::Or(Ops::Shl(b, p.DstB), alpha));
+    }
+
+    static int Row16(uint32_t *dst, const uint8_t *src_bytes, int count, const ConvertParams &p, bool &has_mask)
+    {
+        const uint16_t *src = reinterpret_cast<const uint16_t*>(src_bytes);
+        const V alpha = Ops::Set1(0xFFu << p.DstA);
+        const V mask_color = Ops::Set1(MASK_COLOR_16);
+        V any_mask = Ops::Zero();
+        int i = 0;
+        for (; i + 2 * Ops::N <= count; i += 2 * Ops::N)
+        {
+            V lo, hi;
+            Ops::Load16(src + i, lo, hi);
+            V out_lo = Pixel16(lo, p, alpha);
+            V out_hi = Pixel16(hi, p, alpha);
+            if (!p.Opaque)
+            {
+                const V m_lo = Ops::CmpEq(lo, mask_color);
+                const V m_hi = Ops::CmpEq(hi, mask_color);
+                out_lo = Ops::AndNot(m_lo, out_lo);
+                out_hi = Ops::AndNot(m_hi, out_hi);
+                any_mask = Ops::Or(any_mask, Ops::Or(m_lo, m_hi));
+            }
+            Ops::Store(dst + i, out_lo);
+            Ops::Store(dst + i + Ops::N, out_hi);
+        }
+        has_mask |= Ops::Any(any_mask);
+        return i;
+    }
+
+    static int Row32(uint32_t *dst, const uint8_t *src_bytes, int count, const ConvertParams &p, bool &has_mask)
+    {
+        const uint32_t *src = reinterpret_cast<const uint32_t*>(src_bytes);
+        const V opaque_alpha = Ops::Set1(0xFFu << p.DstA);
+        const V mask_color = Ops::Set1(MASK_COLOR_32);
+        V any_mask = Ops::Zero();
+        int i = 0;
+        for (; i + Ops::N <= count; i += Ops::N)
+        {
+            const V c = Ops::Load(src + i);
+            V out = Ops::Or(Ops::Or(Component(c, p.SrcR, 0xFF, p.DstR), Component(c, p.SrcG, 0xFF, p.DstG)),
+                Component(c, p.SrcB, 0xFF, p.DstB));
+            out = Ops::Or(out, p.HasAlpha ? Component(c, p.SrcA, 0xFF, p.DstA) : opaque_alpha);
+            if (!p.Opaque)
+            {
+                const V m = Ops::CmpEq(c, mask_color);
+                out = Ops::AndNot(m, out);
+                any_mask = Ops::Or(any_mask, m);
+            }
+            Ops::Store(dst + i, out);
+        }
+        has_mask |= Ops::Any(any_mask);
+        return i;
+    }
+};
+
+#if defined(AGS_VMEM_SSE2)
+struct SSE2Ops
+{
+    typedef __m128i V;
+    static const int N = 4;
+    static inline V Load(const uint32_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static inline void Store(uint32_t *p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    static inline void Load16(const uint16_t *p, V &lo, V &hi)
+    {
+        const V v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        lo = _mm_unpacklo_epi16(v, _mm_setzero_si128());
+        hi = _mm_unpackhi_epi16(v, _mm_setzero_si128());
+    }
+    static inline V Set1(uint32_t v) { return _mm_set1_epi32(static_cast<int>(v)); }
+    static inline V Zero() { return _mm_setzero_si128(); }
+    static inline V And(V a, V b) { return _mm_and_si128(a, b); }
+    static inline V Or(V a, V b) { return _mm_or_si128(a, b); }
+    // b & ~mask
+    static inline V AndNot(V mask, V b) { return _mm_andnot_si128(mask, b); }
+    static inline V Shr(V v, uint32_t n) { return _mm_srl_epi32(v, _mm_cvtsi32_si128(static_cast<int>(n))); }
+    static inline V Shl(V v, uint32_t n) { return _mm_sll_epi32(v, _mm_cvtsi32_si128(static_cast<int>(n))); }
+    static inline V CmpEq(V a, V b) { return _mm_cmpeq_epi32(a, b); }
+    static inline bool Any(V v) { return _mm_movemask_epi8(v) != 0; }
+};
+
+static const PfnConvertRow SSE2Row16 = SimdConvert<SSE2Ops>::Row16;
+static const PfnConvertRow SSE2Row32 = SimdConvert<SSE2Ops>::Row32;
+#endif // AGS_VMEM_SSE2
+
+#if defined(AGS_VMEM_NEON)
+struct NEONOps
+{
+    typedef uint32x4_t V;
+    static const int N = 4;
+    static inline V Load(const uint32_t *p) { return vld1q_u32(p); }
+    static inline void Store(uint32_t *p, V v) { vst1q_u32(p, v); }
+    static inline void Load16(const uint16_t *p, V &lo, V &hi)
+    {
+        const uint16x8_t v = vld1q_u16(p);
+        lo = vmovl_u16(vget_low_u16(v));
+        hi = vmovl_u16(vget_high_u16(v));
+    }
+    static inline V Set1(uint32_t v) { return vdupq_n_u32(v); }
+    static inline V Zero() { return vdupq_n_u32(0); }
+    static inline V And(V a, V b) { return vandq_u32(a, b); }
+    static inline V Or(V a, V b) { return vorrq_u32(a, b); }
+    // b & ~mask
+    static inline V AndNot(V mask, V b) { return vbicq_u32(b, mask); }
+    static inline V Shr(V v, uint32_t n) { return vshlq_u32(v, vdupq_n_s32(-static_cast<int32_t>(n))); }
+    static inline V Shl(V v, uint32_t n) { return vshlq_u32(v, vdupq_n_s32(static_cast<int32_t>(n))); }
+    static inline V CmpEq(V a, V b) { return vceqq_u32(a, b); }
+    static inline bool Any(V v)
+    {
+        const uint32x2_t t = vorr_u32(vget_low_u32(v), vget_high_u32(v));
+        return (vget_lane_u32(t, 0) | vget_lane_u32(t, 1)) != 0;
+    }
+};
+
+static const PfnConvertRow NEONRow16 = SimdConvert<NEONOps>::Row16;
+static const PfnConvertRow NEONRow32 = SimdConvert<NEONOps>::Row32;
+#endif // AGS_VMEM_NEON
+
+// Row converters of the selected instruction set, or null if using generic ones
+#if defined(AGS_VMEM_SSE2)
+static PfnConvertRow SimdRow16 = SSE2Row16;
+static PfnConvertRow SimdRow32 = SSE2Row32;
+#elif defined(AGS_VMEM_NEON)
+static PfnConvertRow SimdRow16 = NEONRow16;
+static PfnConvertRow SimdRow32 = NEONRow32;
+#else
+static PfnConvertRow SimdRow16 = nullptr;
+static PfnConvertRow SimdRow32 = nullptr;
+#endif
+
+bool vmem_convert_impl_supported(VMemConvertImpl impl)
+{
+    switch (impl)
+    {
+    case kVMemConvert_Generic: return true;
+#if defined(AGS_VMEM_SSE2)
+    case kVMemConvert_SSE2: return true;
+#endif
+#if defined(AGS_VMEM_NEON)
+    case kVMemConvert_NEON: return true;
+#endif
+    default: return false;
+    }
+}
+
+bool set_vmem_convert_impl(VMemConvertImpl impl)
+{
+    if (!vmem_convert_impl_supported(impl))
+        return false;
+    switch (impl)
+    {
+#if defined(AGS_VMEM_SSE2)
+    case kVMemConvert_SSE2: SimdRow16 = SSE2Row16; SimdRow32 = SSE2Row32; break;
+#endif
+#if defined(AGS_VMEM_NEON)
+    case kVMemConvert_NEON: SimdRow16 = NEONRow16; SimdRow32 = NEONRow32; break;
+#endif
+    default: SimdRow16 = nullptr; SimdRow32 = nullptr; break;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Transparent pixels fix-up
+//-----------------------------------------------------------------------------
+
+// Pixel types, and the types which the neighbours' components are summed in
+struct Pixel8
+{
+    typedef uint8_t T; typedef unsigned char Sum;
+    static const uint32_t MaskColor = MASK_COLOR_8;
+    static int R(int c) { return getr8(c); }
+    static int G(int c) { return getg8(c); }
+    static int B(int c) { return getb8(c); }
+};
+
+struct Pixel16
+{
+    typedef uint16_t T; typedef unsigned short Sum;
+    static const uint32_t MaskColor = MASK_COLOR_16;
+    static int R(int c) { return getr16(c); }
+    static int G(int c) { return getg16(c); }
+    static int B(int c) { return getb16(c); }
+};
+
+struct Pixel32
+{
+    typedef uint32_t T; typedef unsigned int Sum;
+    static const uint32_t MaskColor = MASK_COLOR_32;
+    static int R(int c) { return getr32(c); }
+    static int G(int c) { return getg32(c); }
+    static int B(int c) { return getb32(c); }
+};
+
+template <typename Px>
+static inline void AddIfNotTransparent(typename Px::T c,
+    typename Px::Sum &r, typename Px::Sum &g, typename Px::Sum &b, typename Px::Sum &divisor)
+{
+    if (c != Px::MaskColor)
+    {
+        r += Px::R(c);
+        g += Px::G(c);
+        b += Px::B(c);
+        divisor++;
+    }
+}
+
+// Updates the transparent pixels of the converted row: with the linear
+// filtering they get the average color of their opaque neighbours, and
+// the transparent pixel followed by an opaque one gets that one's color;
+// in both cases alpha is kept zero.
+template <typename Px>
+static void FixMaskedRow(const Bitmap *bitmap, int src_x, int src_y, int width, int height, int y,
+    const ConvertParams &p, bool keep_color, bool copy_next, uint32_t *dst)
+{
+    typedef typename Px::T T;
+    typedef typename Px::Sum Sum;
+    const T *row = reinterpret_cast<const T*>(bitmap->GetScanLine(src_y + y)) + src_x;
+    const T *row_before = (y > 0) ? reinterpret_cast<const T*>(bitmap->GetScanLine(src_y + y - 1)) + src_x : nullptr;
+    const T *row_after = (y < height - 1) ? reinterpret_cast<const T*>(bitmap->GetScanLine(src_y + y + 1)) + src_x : nullptr;
+    for (int x = 0; x < width; ++x)
+    {
+        if (row[x] != Px::MaskColor)
+            continue;
+        if (copy_next && (x < width - 1) && (row[x + 1] != Px::MaskColor))
+        {
+            dst[x] = dst[x + 1] & 0x00FFFFFF;
+            continue;
+        }
+        if (!keep_color)
+            continue;
+        Sum r = 0, g = 0, b = 0, divisor = 0;
+        if (x > 0)
+            AddIfNotTransparent<Px>(row[x - 1], r, g, b, divisor);
+        if (x < width - 1)
+            AddIfNotTransparent<Px>(row[x + 1], r, g, b, divisor);
+        if (row_before)
+            AddIfNotTransparent<Px>(row_before[x], r, g, b, divisor);
+        if (row_after)
+            AddIfNotTransparent<Px>(row_after[x], r, g, b, divisor);
+        if (divisor > 0)
+            dst[x] = VMemColor(p, r / divisor, g / divisor, b / divisor, 0);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Bitmap conversion
+//-----------------------------------------------------------------------------
+
+void BitmapToVideoMem(const Bitmap *bitmap, int src_x, int src_y, int width, int height,
+    const VMemPixelFormat &format, int flags, uint8_t *dst_ptr, int dst_pitch)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    const int depth = bitmap->GetColorDepth();
+    ConvertParams p;
+    p.DstR = format.RShift;
+    p.DstG = format.GShift;
+    p.DstB = format.BShift;
+    p.DstA = format.AShift;
+    p.Opaque = (flags & kVMem_Opaque) != 0;
+    PfnConvertRow generic_row, simd_row;
+    switch (depth)
+    {
+    case 8:
+        for (int c = 0; c < 256; ++c)
+            p.Palette[c] = VMemColor(p, getr8(c), getg8(c), getb8(c), 0xFF);
+        generic_row = ConvertRow8;
+        simd_row = nullptr;
+        break;
+    case 16:
+        p.SrcR = _rgb_r_shift_16;
+        p.SrcG = _rgb_g_shift_16;
+        p.SrcB = _rgb_b_shift_16;
+        generic_row = ConvertRow16;
+        simd_row = SimdRow16;
+        break;
+    case 32:
+        p.SrcR = _rgb_r_shift_32;
+        p.SrcG = _rgb_g_shift_32;
+        p.SrcB = _rgb_b_shift_32;
+        p.SrcA = _rgb_a_shift_32;
+        p.HasAlpha = (flags & kVMem_HasAlpha) != 0;
+        generic_row = ConvertRow32;
+        simd_row = SimdRow32;
+        break;
+    default:
+        return; // unsupported
+    }
+
+    const int bpp = depth / 8;
+    const bool keep_color = (flags & kVMem_KeepMaskColor) != 0;
+    // transparent pixels take the color of the next opaque pixel,
+    // unless the pixels have their own alpha
+    const bool copy_next = !p.HasAlpha;
+    const bool edge_left = (flags & kVMem_EdgeLeft) != 0;
+    const bool edge_right = (flags & kVMem_EdgeRight) != 0;
+    for (int y = 0; y < height; ++y)
+    {
+        const uint8_t *src = bitmap->GetScanLine(src_y + y) + src_x * bpp;
+        uint32_t *dst = reinterpret_cast<uint32_t*>(dst_ptr + y * dst_pitch);
+        bool has_mask = false;
+        const int done = simd_row ? simd_row(dst, src, width, p, has_mask) : 0;
+        if (done < width)
+            generic_row(dst + done, src + done * bpp, width - done, p, has_mask);
+        if (has_mask)
+        {
+            switch (depth)
+            {
+            case 8: FixMaskedRow<Pixel8>(bitmap, src_x, src_y, width, height, y, p, keep_color, copy_next, dst); break;
+            case 16: FixMaskedRow<Pixel16>(bitmap, src_x, src_y, width, height, y, p, keep_color, copy_next, dst); break;
+            default: FixMaskedRow<Pixel32>(bitmap, src_x, src_y, width, height, y, p, keep_color, copy_next, dst); break;
+            }
+        }
+        if (edge_left)
+            dst[-1] = dst[0] & 0x00FFFFFF;
+        if (edge_right)
+            dst[width] = dst[width - 1] & 0x00FFFFFF;
+    }
+
+    // Edge rows repeat the outer rows, including their edge pixels
+    const int row_from = edge_left ? -1 : 0;
+    const int row_to = edge_right ? width + 1 : width;
+    if (flags & kVMem_EdgeTop)
+    {
+        const uint32_t *src = reinterpret_cast<const uint32_t*>(dst_ptr);
+        uint32_t *dst = reinterpret_cast<uint32_t*>(dst_ptr - dst_pitch);
+        for (int x = row_from; x < row_to; ++x)
+            dst[x] = src[x] & 0x00FFFFFF;
+    }
+    if (flags & kVMem_EdgeBottom)
+    {
+        const uint32_t *src = reinterpret_cast<const uint32_t*>(dst_ptr + (height - 1) * dst_pitch);
+        uint32_t *dst = reinterpret_cast<uint32_t*>(dst_ptr + height * dst_pitch);
+        for (int x = row_from; x < row_to; ++x)
+            dst[x] = src[x] & 0x00FFFFFF;
+    }
+}
+
+} // namespace Engine
+} // namespace AGS
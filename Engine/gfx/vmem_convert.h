@@ -0,0 +1,84 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+//
+// Conversion of the 8, 16 and 32-bit bitmaps into the 32-bit RGBA pixels
+// in the video memory format, used when uploading textures.
+//
+// Whole rows of pixels are converted at once, using SIMD instructions where
+// available; results are exactly same as of the per-pixel conversion with
+// allegro's getr/getg/getb functions.
+//
+//=============================================================================
+#ifndef __AGS_EE_GFX__VMEMCONVERT_H
+#define __AGS_EE_GFX__VMEMCONVERT_H
+
+#include "core/types.h"
+
+namespace AGS
+{
+namespace Common { class Bitmap; }
+namespace Engine
+{
+
+// Bit shifts of the color components in the 32-bit video memory pixel
+struct VMemPixelFormat
+{
+    int RShift = 16;
+    int GShift = 8;
+    int BShift = 0;
+    int AShift = 24;
+};
+
+enum VMemConvertFlags
+{
+    // Use the source's alpha channel (32-bit only), otherwise pixels are opaque
+    kVMem_HasAlpha      = 0x0001,
+    // Ignore the mask color, and convert all pixels as opaque
+    kVMem_Opaque        = 0x0002,
+    // Fill the fully transparent pixels with the color of their neighbours,
+    // so that the linear filtering does not make dark outlines
+    kVMem_KeepMaskColor = 0x0004,
+    // Fill the destination's border pixels around the converted area by
+    // repeating the area's outer pixels with zero alpha; this mimics
+    // GL_CLAMP_TO_EDGE for the texture tiles which are smaller than textures
+    kVMem_EdgeLeft      = 0x0010,
+    kVMem_EdgeTop       = 0x0020,
+    kVMem_EdgeRight     = 0x0040,
+    kVMem_EdgeBottom    = 0x0080
+};
+
+// Converts the width x height region of the bitmap, starting at src_x,src_y,
+// and writes the pixels to dst_ptr, which points to the area's top-left pixel.
+// 8-bit bitmaps are converted using the currently selected palette.
+void BitmapToVideoMem(const Common::Bitmap *bitmap, int src_x, int src_y, int width, int height,
+    const VMemPixelFormat &format, int flags, uint8_t *dst_ptr, int dst_pitch);
+
+// Row converters implementations, using different instruction sets
+enum VMemConvertImpl
+{
+    kVMemConvert_Generic,
+    kVMemConvert_SSE2,
+    kVMemConvert_NEON
+};
+
+// Tells whether the converters implementation is available in this build
+bool vmem_convert_impl_supported(VMemConvertImpl impl);
+// Selects the converters implementation, returns false if it's not supported;
+// the best supported one is used by default
+bool set_vmem_convert_impl(VMemConvertImpl impl);
+
+} // namespace Engine
+} // namespace AGS
+
+#endif // __AGS_EE_GFX__VMEMCONVERT_H
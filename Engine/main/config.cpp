@@ -333,6 +333,8 @@ void apply_config(const ConfigTree &cfg)
         usetup.RenderAtScreenRes = CfgReadBoolInt(cfg, "graphics", "render_at_screenres");
         usetup.Supersampling = CfgReadInt(cfg, "graphics", "supersampling", 1);
         usetup.software_render_driver = CfgReadString(cfg, "graphics", "software_driver");
+        usetup.SoftwareRenderThreads = CfgReadInt(cfg, "graphics", "software_render_threads", 0);
+        usetup.SpriteAtlas = CfgReadBoolInt(cfg, "graphics", "sprite_atlas", false);
 
         usetup.rotation = (ScreenRotation)CfgReadInt(cfg, "graphics", "rotation", usetup.rotation);
         String rotation_str = CfgReadString(cfg, "graphics", "rotation", "unlocked");
@@ -344,15 +346,33 @@ void apply_config(const ConfigTree &cfg)
 
         // Custom paths
         usetup.load_latest_save = CfgReadBoolInt(cfg, "misc", "load_latest_save", usetup.load_latest_save);
+        usetup.IncrementalSaves = CfgReadBoolInt(cfg, "misc", "incremental_saves", usetup.IncrementalSaves);
+        usetup.IncrementalSaveChain = CfgReadInt(cfg, "misc", "incremental_save_chain", usetup.IncrementalSaveChain);
+        if (usetup.IncrementalSaveChain < 0)
+            usetup.IncrementalSaveChain = 0;
+        usetup.SaveCompression = StrUtil::ParseEnum<SavegameCompression>(
+            CfgReadString(cfg, "misc", "save_compression", "none"),
+            CstrArr<kNumSvgCompressions>{ "none", "zlib", "lzw" }, usetup.SaveCompression);
+        usetup.BackgroundSaves = CfgReadBoolInt(cfg, "misc", "background_saves", usetup.BackgroundSaves);
         usetup.user_data_dir = CfgReadString(cfg, "misc", "user_data_dir");
         usetup.shared_data_dir = CfgReadString(cfg, "misc", "shared_data_dir");
         usetup.show_fps = CfgReadBoolInt(cfg, "misc", "show_fps");
+        usetup.ShowProfiler = CfgReadBoolInt(cfg, "misc", "show_profiler", usetup.ShowProfiler);
+        usetup.ProfilerTraceFrames = CfgReadInt(cfg, "misc", "profiler_trace_frames", usetup.ProfilerTraceFrames);
+        if (usetup.ProfilerTraceFrames < 0)
+            usetup.ProfilerTraceFrames = 0;
 
         // Translation / localization
         usetup.translation = CfgReadString(cfg, "language", "translation");
 
         // Resource caches and options
         usetup.clear_cache_on_room_change = CfgReadBoolInt(cfg, "misc", "clear_cache_on_room_change", usetup.clear_cache_on_room_change);
+        usetup.GCTimeBudget = CfgReadInt(cfg, "misc", "gc_time_budget", usetup.GCTimeBudget);
+        if (usetup.GCTimeBudget < 0)
+            usetup.GCTimeBudget = 0;
+        usetup.PreloadRooms = CfgReadInt(cfg, "misc", "preload_rooms", usetup.PreloadRooms);
+        if (usetup.PreloadRooms < 0)
+            usetup.PreloadRooms = 0;
         usetup.SpriteCacheSize = CfgReadInt(cfg, "graphics", "sprite_cache_size", usetup.SpriteCacheSize);
         usetup.TextureCacheSize = CfgReadInt(cfg, "graphics", "texture_cache_size", usetup.TextureCacheSize);
         usetup.SoundCacheSize = CfgReadInt(cfg, "sound", "cache_size", usetup.SoundCacheSize);
@@ -48,15 +48,18 @@
 #include "ac/spritecache.h"
 #include "ac/translation.h"
 #include "ac/viewframe.h"
+#include "ac/dynobj/managedobjectpool.h"
 #include "ac/dynobj/scriptobject.h"
 #include "ac/dynobj/scriptsystem.h"
 #include "core/assetmanager.h"
 #include "debug/debug_log.h"
 #include "debug/debugger.h"
 #include "debug/out.h"
+#include "debug/profiler.h"
 #include "device/mousew32.h"
 #include "font/agsfontrenderer.h"
 #include "font/fonts.h"
+#include "gfx/blender.h"
 #include "gfx/graphicsdriver.h"
 #include "gfx/gfxdriverfactory.h"
 #include "gfx/ddb.h"
@@ -125,6 +128,8 @@ bool engine_init_backend()
         platform->DisplayAlert("Internal error: unable to initialize stripped Allegro 4 library.");
         return false;
     }
+    init_blenders();
+    Debug::Printf(kDbgMsg_Info, "Blenders: using %s row blending", get_blender_row_impl_name(get_blender_row_impl()));
 
     platform->PostBackendInit();
     return true;
@@ -403,6 +408,19 @@ void engine_init_debug()
 {
     if (usetup.show_fps)
         display_fps = kFPS_Forced;
+#if AGS_PROFILER
+    if (usetup.ShowProfiler)
+    {
+        Profiler::SetEnabled(true);
+        display_profiler = true;
+    }
+    if (usetup.ProfilerTraceFrames > 0)
+    {
+        FSLocation fs = platform->GetAppOutputDirectory();
+        CreateFSDirs(fs);
+        Profiler::StartTrace(usetup.ProfilerTraceFrames, Path::ConcatPaths(fs.FullDir, "ags_trace.json"));
+    }
+#endif
     if ((debug_flags & (~DBG_DEBUGMODE)) >0) {
         platform->DisplayAlert("Engine debugging enabled.\n"
             "\nNOTE: You have selected to enable one or more engine debugging options.\n"
@@ -613,6 +631,9 @@ void engine_init_game_settings()
         play.separate_music_lib = false;
     }
 
+    // Limit the time which garbage collection may take at once
+    pool.SetGarbageCollectionBudget(std::chrono::microseconds(usetup.GCTimeBudget));
+
     // Setup a text encoding mode depending on the game data hint
     if (game.options[OPT_GAMETEXTENCODING] == 65001) // utf-8 codepage number
         set_uformat(U_UTF8);
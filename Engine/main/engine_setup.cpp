@@ -26,6 +26,7 @@
 #include "device/mousew32.h"
 #include "font/fonts.h"
 #include "gfx/ali3dexception.h"
+#include "gfx/ali3dsw.h"
 #include "gfx/graphicsdriver.h"
 #include "gui/guimain.h"
 #include "gui/guiinv.h"
@@ -65,6 +66,14 @@ void engine_post_gfxmode_driver_setup()
     gfxDriver->SetCallbackForPolling(update_polled_stuff);
     gfxDriver->SetCallbackToDrawScreen(draw_game_screen_callback, construct_engine_overlay);
     gfxDriver->SetCallbackOnSpriteEvt(GfxDriverSpriteEvtCallback);
+    gfxDriver->UseSpriteAtlas(usetup.SpriteAtlas);
+    auto *sw_driver = dynamic_cast<AGS::Engine::ALSW::SDLRendererGraphicsDriver*>(gfxDriver);
+    if (sw_driver)
+    {
+        sw_driver->SetRenderThreads(usetup.SoftwareRenderThreads);
+        if (usetup.SoftwareRenderThreads > 1)
+            Debug::Printf("Software renderer: drawing sprites using %d threads", usetup.SoftwareRenderThreads);
+    }
 }
 
 // Reset gfx driver callbacks
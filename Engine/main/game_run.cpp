@@ -51,6 +51,7 @@
 #include "ac/walkbehind.h"
 #include "debug/debugger.h"
 #include "debug/debug_log.h"
+#include "debug/profiler.h"
 #include "device/mousew32.h"
 #include "gui/animatingguibutton.h"
 #include "gui/guiinv.h"
@@ -778,6 +779,7 @@ static void update_cursor_over_location(int mwasatx, int mwasaty)
 
 static void game_loop_update_events()
 {
+    update_background_save();
     new_room_was = in_new_room;
     if (in_new_room>0)
         setevent(EV_FADEIN,0,0,0);
@@ -851,6 +853,10 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
 
     int res;
 
+#if AGS_PROFILER
+    Profiler::NextFrame();
+#endif
+
     sys_evt_process_pending();
 
     numEventsAtStartOfFunction = events.size();
@@ -917,15 +923,24 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
     update_cursor_over_location(mwasatx, mwasaty);
     update_cursor_view();
 
-    update_audio_system_on_game_loop();
+    {
+        AGS_PROFILE_ZONE("Audio update");
+        update_audio_system_on_game_loop();
+    }
 
     // Only render if we are not skipping a cutscene
     if (!play.fast_forward)
+    {
+        AGS_PROFILE_ZONE("Render");
         render_graphics(extraBitmap, extraX, extraY);
+    }
 
     our_eip=6;
 
-    game_loop_update_events();
+    {
+        AGS_PROFILE_ZONE("Events");
+        game_loop_update_events();
+    }
 
     our_eip=7;
 
@@ -945,14 +960,22 @@ void UpdateGameOnce(bool checkControls, IDriverDependantBitmap *extraBitmap, int
 
     update_polled_stuff();
 
+    AGS_PROFILE_ZONE("Wait");
     WaitForNextFrame();
 }
 
 void UpdateGameAudioOnly()
 {
-    update_audio_system_on_game_loop();
+#if AGS_PROFILER
+    Profiler::NextFrame();
+#endif
+    {
+        AGS_PROFILE_ZONE("Audio update");
+        update_audio_system_on_game_loop();
+    }
     game_loop_update_loop_counter();
     game_loop_update_fps();
+    AGS_PROFILE_ZONE("Wait");
     WaitForNextFrame();
 }
 
@@ -166,6 +166,9 @@ void main_print_help() {
            "  --nospr                      Don't draw room objects and characters\n"
            "  --noupdate                   Don't run game update\n"
            "  --novideo                    Don't play game videos\n"
+           "  --profiler                   Display frame profiler's stats\n"
+           "  --profiler-trace <FRAMES>    Record profiler trace for the number of frames\n"
+           "                               and write it to ags_trace.json\n"
            "  --rotation <MODE>            Screen rotation preferences. MODEs are:\n"
            "                                 unlocked (0), portrait (1), landscape (2)\n"
            "  --sdl-log=LEVEL              Setup SDL backend logging level\n"
@@ -320,6 +323,10 @@ static int main_process_cmdline(ConfigTree &cfg, int argc, char *argv[])
             cfg["override"]["multitasking"] = "1";
         else if (ags_stricmp(arg, "--fps") == 0)
             cfg["misc"]["show_fps"] = "1";
+        else if (ags_stricmp(arg, "--profiler") == 0)
+            cfg["misc"]["show_profiler"] = "1";
+        else if ((ags_stricmp(arg, "--profiler-trace") == 0) && (argc > ee + 1))
+            cfg["misc"]["profiler_trace_frames"] = argv[++ee];
         else if (ags_stricmp(arg, "--test") == 0) debug_flags |= DBG_DEBUGMODE;
         else if (ags_stricmp(arg, "--noiface") == 0) debug_flags |= DBG_NOIFACE;
         else if (ags_stricmp(arg, "--nosprdisp") == 0) debug_flags |= DBG_NODRAWSPRITES;
@@ -33,6 +33,7 @@
 #include "debug/debugger.h"
 #include "debug/out.h"
 #include "font/fonts.h"
+#include "game/savegame.h"
 #include "main/config.h"
 #include "main/engine.h"
 #include "main/main.h"
@@ -205,6 +206,9 @@ void quit(const char *quitmsg)
 
     our_eip = 9900;
 
+    // make sure that the save written in background is complete
+    WaitBackgroundSave();
+
     quit_stop_cd();
 
     our_eip = 9020;
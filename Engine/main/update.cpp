@@ -39,6 +39,7 @@
 #include "ac/timer.h"
 #include "main/game_run.h"
 #include "ac/movelist.h"
+#include "debug/profiler.h"
 
 using namespace AGS::Common;
 using namespace AGS::Engine;
@@ -183,6 +184,7 @@ void update_script_timers()
 
 void update_cycling_views()
 {
+  AGS_PROFILE_ZONE("Objects update");
 	// update graphics for object if cycling view
   for (uint32_t i = 0; i < croom->numobj; ++i)
   {
@@ -211,6 +213,7 @@ void update_player_view()
 
 void update_character_move_and_anim(std::vector<int> &followingAsSheep)
 {
+  AGS_PROFILE_ZONE("Characters update");
 	// move & animate characters
   for (int aa=0;aa<game.numcharacters;aa++) {
     if (game.chars[aa].on != 1) continue;
@@ -468,7 +471,8 @@ void update_sierra_speech()
 // update_stuff: moves and animates objects, executes repeat scripts, and
 // the like.
 void update_stuff() {
-  
+  AGS_PROFILE_ZONE("Game update");
+
   our_eip = 20;
 
   update_script_timers();
@@ -486,6 +490,8 @@ void update_stuff() {
   update_character_move_and_anim(followingAsSheep);
 
   update_following_exactly_characters(followingAsSheep);
+  // followers may have moved to another room
+  invalidate_room_characters();
 
   our_eip = 23;
 
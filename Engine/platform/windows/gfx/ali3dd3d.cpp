@@ -24,6 +24,7 @@
 #include "ac/sys_events.h"
 #include "ac/timer.h"
 #include "debug/out.h"
+#include "debug/profiler.h"
 #include "gfx/ali3dexception.h"
 #include "gfx/gfx_def.h"
 #include "gfx/gfxfilter_d3d.h"
@@ -804,6 +805,8 @@ void D3DGraphicsDriver::RecreateRenderTargets()
             batch.RenderSurface = ((D3DBitmap*)batch.RenderTarget)->_renderSurface;
         }
     }
+    // New textures are empty, let the users know they have to redraw them
+    _renderTargetResetCount++;
 }
 
 bool D3DGraphicsDriver::SetNativeResolution(const GraphicResolution &native_res)
@@ -1617,6 +1620,8 @@ void D3DGraphicsDriver::UpdateDDBFromBitmap(IDriverDependantBitmap *ddb, Bitmap
 
 void D3DGraphicsDriver::UpdateTexture(Texture *txdata, Bitmap *bitmap, bool has_alpha, bool opaque)
 {
+  AGS_PROFILE_ZONE("Texture upload");
+  AGS_PROFILE_COUNT("Texture uploads", 1);
   const int color_depth = bitmap->GetColorDepth();
   if (bitmap->GetColorDepth() != txdata->Res.ColorDepth)
     throw Ali3DException("UpdateDDBFromBitmap: mismatched colour depths");
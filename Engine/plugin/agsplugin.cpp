@@ -35,6 +35,7 @@
 #include "ac/string.h"
 #include "ac/sys_events.h"
 #include "ac/view.h"
+#include "ac/walkablearea.h"
 #include "ac/dynobj/dynobj_manager.h"
 #include "ac/dynobj/scriptstring.h"
 #include "ac/dynobj/scriptsystem.h"
@@ -464,7 +465,11 @@ BITMAP *IAGSEngine::GetSpriteGraphic (int32 num) {
 }
 BITMAP *IAGSEngine::GetRoomMask (int32 index) {
     if (index == MASK_WALKABLE)
+    {
+        // plugin may draw onto the mask
+        invalidate_walkable_areas_temp();
         return (BITMAP*)thisroom.WalkAreaMask->GetAllegroBitmap();
+    }
     else if (index == MASK_WALKBEHIND)
         return (BITMAP*)thisroom.WalkBehindMask->GetAllegroBitmap();
     else if (index == MASK_HOTSPOT)
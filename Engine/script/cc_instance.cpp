@@ -11,6 +11,7 @@
 // http://www.opensource.org/licenses/artistic-license-2.0.php
 //
 //=============================================================================
+#include <algorithm>
 #include <cstdio>
 #include <deque>
 #include <string.h>
@@ -23,6 +24,7 @@
 #include "script/cc_instance.h"
 #include "debug/debug_log.h"
 #include "debug/out.h"
+#include "debug/profiler.h"
 #include "script/cc_common.h"
 #include "script/script.h"
 #include "script/script_runtime.h"
@@ -376,6 +378,7 @@ void ccInstance::AbortAndDestroy()
 
 int ccInstance::CallScriptFunction(const char *funcname, int32_t numargs, const RuntimeScriptValue *params)
 {
+    AGS_PROFILE_ZONE_DETAIL("Script", funcname);
     cc_clear_error();
     currentline = 0;
 
@@ -577,6 +580,105 @@ inline bool FixupArgument(RuntimeScriptValue &arg, int fixup, uintptr_t code,
 }
 
 
+// Decodes the operation at the given code position;
+// returns false if there's no valid operation
+inline bool DecodeOperation(const intptr_t *code, int32_t codesize, int32_t pc, ScriptOperation &op)
+{
+    const int32_t instr = static_cast<int32_t>(code[pc]);
+    op.Instruction.Code = instr & INSTANCE_ID_REMOVEMASK; // pure instruction code
+    op.Instruction.InstanceId = (instr >> INSTANCE_ID_SHIFT) & INSTANCE_ID_MASK;
+    if (op.Instruction.Code < 0 || op.Instruction.Code >= CC_NUM_SCCMDS)
+        return false;
+    op.ExecCode = op.Instruction.Code;
+    op.ArgCount = sccmd_info[op.Instruction.Code].ArgCount;
+    if (pc + op.ArgCount >= codesize)
+        return false;
+    for (int i = 0; i < op.ArgCount; ++i)
+        op.Args[i] = static_cast<int32_t>(code[pc + 1 + i]);
+    op.FixedArg = ScriptOperation::RuntimeFixup;
+    return true;
+}
+
+// Decodes the operation at the given code position at runtime;
+// this is only done if the position was not decoded at load time,
+// which means that the code is broken, or execution jumped in between
+inline bool ReadOperation(const intptr_t *code, int32_t codesize, int32_t pc, ScriptOperation &op)
+{
+    if (DecodeOperation(code, codesize, pc, op))
+        return true;
+    if (op.Instruction.Code < 0 || op.Instruction.Code >= CC_NUM_SCCMDS)
+        cc_error("invalid instruction %d found in code stream", op.Instruction.Code);
+    else
+        cc_error("unexpected end of code data (%d; %d)", pc + op.ArgCount, codesize);
+    return false;
+}
+
+// Gets the operation's 2nd argument with a fixup applied;
+// uses the value resolved at load time, if there's one
+inline void GetFixedArgument2(RuntimeScriptValue &arg, const ScriptOperation &op,
+    const ccInstance *inst, int32_t pc, RuntimeScriptValue *stack)
+{
+    if (op.FixedArg >= 0)
+    {
+        arg = inst->decoded_code->FixedArgs[op.FixedArg];
+        return;
+    }
+    arg.SetInt32(op.Arg2i());
+    if (op.FixedArg == ScriptOperation::RuntimeFixup)
+        FixupArgument(arg, inst->code_fixups[pc + 2], inst->code[pc + 2], stack, inst->strings);
+}
+
+// Threaded dispatch: each operation ends with a jump directly to the next
+// operation's handler, instead of returning to the common switch. This uses
+// "labels as values" extension, and is only enabled where it's supported.
+#ifndef CC_THREADED_DISPATCH
+#if defined(__GNUC__)
+#define CC_THREADED_DISPATCH 1
+#else
+#define CC_THREADED_DISPATCH 0
+#endif
+#endif
+
+#if (DEBUG_CC_EXEC)
+#define DUMP_OPERATION \
+    if (dump_opcodes) \
+        DumpInstruction(*codeOp)
+#else
+#define DUMP_OPERATION
+#endif
+
+// Reads pre-decoded operation at the current pc
+#define READ_OPERATION \
+    CC_ERROR_IF_RETCODE(pc < 0 || pc >= codeInst->codesize, \
+        "unexpected end of code data (%d; %d)", pc, codeInst->codesize); \
+    codeOp = &codeOps[pc]; \
+    if (codeOp->Instruction.Code < 0) \
+    { \
+        if (!ReadOperation(codeInst->code, codeInst->codesize, pc, undecodedOp)) \
+            return -1; \
+        codeOp = &undecodedOp; \
+    } \
+    DUMP_OPERATION
+
+// OP_CASE and OP_DEFAULT begin the operation handler,
+// OP_NEXT ends it, proceeding to the next operation
+#if CC_THREADED_DISPATCH
+#define OP_CASE(op) case op: op_##op
+#define OP_DEFAULT default: op_default
+#define OP_NEXT \
+    { \
+        pc += codeOp->ArgCount + 1; \
+        if ((flags & INSTF_ABORTED) != 0) \
+            return 0; \
+        READ_OPERATION; \
+        goto *dispatch_table[codeOp->ExecCode]; \
+    }
+#else
+#define OP_CASE(op) case op
+#define OP_DEFAULT default
+#define OP_NEXT break
+#endif
+
 #define MAXNEST 50  // number of recursive function calls allowed
 int ccInstance::Run(int32_t curpc)
 {
@@ -597,10 +699,45 @@ int ccInstance::Run(int32_t curpc)
     thisbase[0] = 0;
     funcstart[0] = pc;
     ccInstance *codeInst = runningInst;
-    ScriptOperation codeOp;
+    if (!codeInst->decoded_code)
+        codeInst->DecodeCode();
+    const ScriptOperation *codeOps = codeInst->decoded_code->Ops.data();
+    const ScriptOperation *codeOp = nullptr;
+    ScriptOperation undecodedOp; // for the code positions not decoded at load time
     FunctionCallStack func_callstack;
 #if DEBUG_CC_EXEC
     const bool dump_opcodes = ccGetOption(SCOPT_DEBUGRUN) != 0;
+#endif
+#if CC_THREADED_DISPATCH
+    static const void *const dispatch_table[CC_NUM_EXEC_CMDS] = {
+        &&op_default, &&op_SCMD_ADD, &&op_SCMD_SUB, &&op_SCMD_REGTOREG, &&op_SCMD_WRITELIT,
+        &&op_SCMD_RET, &&op_SCMD_LITTOREG, &&op_SCMD_MEMREAD, &&op_SCMD_MEMWRITE,
+        &&op_SCMD_MULREG, &&op_SCMD_DIVREG, &&op_SCMD_ADDREG, &&op_SCMD_SUBREG,
+        &&op_SCMD_BITAND, &&op_SCMD_BITOR, &&op_SCMD_ISEQUAL, &&op_SCMD_NOTEQUAL,
+        &&op_SCMD_GREATER, &&op_SCMD_LESSTHAN, &&op_SCMD_GTE, &&op_SCMD_LTE, &&op_SCMD_AND,
+        &&op_SCMD_OR, &&op_SCMD_CALL, &&op_SCMD_MEMREADB, &&op_SCMD_MEMREADW,
+        &&op_SCMD_MEMWRITEB, &&op_SCMD_MEMWRITEW, &&op_SCMD_JZ, &&op_SCMD_PUSHREG,
+        &&op_SCMD_POPREG, &&op_SCMD_JMP, &&op_SCMD_MUL, &&op_SCMD_CALLEXT, &&op_SCMD_PUSHREAL,
+        &&op_SCMD_SUBREALSTACK, &&op_SCMD_LINENUM, &&op_SCMD_CALLAS, &&op_SCMD_THISBASE,
+        &&op_SCMD_NUMFUNCARGS, &&op_SCMD_MODREG, &&op_SCMD_XORREG, &&op_SCMD_NOTREG,
+        &&op_SCMD_SHIFTLEFT, &&op_SCMD_SHIFTRIGHT, &&op_SCMD_CALLOBJ, &&op_SCMD_CHECKBOUNDS,
+        &&op_SCMD_MEMWRITEPTR, &&op_SCMD_MEMREADPTR, &&op_SCMD_MEMZEROPTR, &&op_SCMD_MEMINITPTR,
+        &&op_SCMD_LOADSPOFFS, &&op_SCMD_CHECKNULL, &&op_SCMD_FADD, &&op_SCMD_FSUB,
+        &&op_SCMD_FMULREG, &&op_SCMD_FDIVREG, &&op_SCMD_FADDREG, &&op_SCMD_FSUBREG,
+        &&op_SCMD_FGREATER, &&op_SCMD_FLESSTHAN, &&op_SCMD_FGTE, &&op_SCMD_FLTE,
+        &&op_SCMD_ZEROMEMORY, &&op_SCMD_CREATESTRING, &&op_SCMD_STRINGSEQUAL,
+        &&op_SCMD_STRINGSNOTEQ, &&op_SCMD_CHECKNULLREG, &&op_SCMD_LOOPCHECKOFF,
+        &&op_SCMD_MEMZEROPTRND, &&op_SCMD_JNZ, &&op_SCMD_DYNAMICBOUNDS, &&op_SCMD_NEWARRAY,
+        &&op_SCMD_NEWUSEROBJECT,
+        // typed operations
+        &&op_SCMD_LITTOREG_I, &&op_SCMD_MULREG_I, &&op_SCMD_DIVREG_I, &&op_SCMD_MODREG_I,
+        &&op_SCMD_BITAND_I, &&op_SCMD_BITOR_I, &&op_SCMD_XORREG_I, &&op_SCMD_SHIFTLEFT_I,
+        &&op_SCMD_SHIFTRIGHT_I, &&op_SCMD_ISEQUAL_I, &&op_SCMD_NOTEQUAL_I, &&op_SCMD_GREATER_I,
+        &&op_SCMD_LESSTHAN_I, &&op_SCMD_GTE_I, &&op_SCMD_LTE_I, &&op_SCMD_AND_I, &&op_SCMD_OR_I,
+        &&op_SCMD_NOTREG_I, &&op_SCMD_FADD_F, &&op_SCMD_FSUB_F, &&op_SCMD_FMULREG_F,
+        &&op_SCMD_FDIVREG_F, &&op_SCMD_FADDREG_F, &&op_SCMD_FSUBREG_F, &&op_SCMD_REGTOREG_N,
+        &&op_SCMD_JZ_I, &&op_SCMD_JNZ_I, &&op_SCMD_PUSHREG_N, &&op_SCMD_POPREG_N
+    };
 #endif
     int loopIterationCheckDisabled = 0;
     unsigned loopIterations = 0u; // any loop iterations (needed for timeout test)
@@ -621,59 +758,25 @@ int ccInstance::Run(int32_t curpc)
         //
         /* Read operation */
         //=====================================================================
-        codeOp.Instruction.Code = codeInst->code[pc];
-        codeOp.Instruction.InstanceId = (codeOp.Instruction.Code >> INSTANCE_ID_SHIFT) & INSTANCE_ID_MASK;
-        codeOp.Instruction.Code &= INSTANCE_ID_REMOVEMASK; // now this is pure instruction code
-
-        CC_ERROR_IF_RETCODE((codeOp.Instruction.Code < 0 || codeOp.Instruction.Code >= CC_NUM_SCCMDS),
-            "invalid instruction %d found in code stream", codeOp.Instruction.Code);
-
-        codeOp.ArgCount = sccmd_info[codeOp.Instruction.Code].ArgCount;
-
-        CC_ERROR_IF_RETCODE(pc + codeOp.ArgCount >= codeInst->codesize,
-            "unexpected end of code data (%d; %d)", pc + codeOp.ArgCount, codeInst->codesize);
-
-
-        // Read arguments; use switch as it proved to be faster than the loop
-        switch (codeOp.ArgCount)
-        {
-        case 3:
-            codeOp.Args[2].SetInt32((int32_t)codeInst->code[pc + 3]);
-            /* fall-through */
-        case 2:
-            codeOp.Args[1].SetInt32((int32_t)codeInst->code[pc + 2]);
-            /* fall-through */
-        case 1:
-            codeOp.Args[0].SetInt32((int32_t)codeInst->code[pc + 1]);
-            break;
-        default:
-            break;
-        }
+        READ_OPERATION;
         //---------------------------------------------------------------------
         /* End read operation */
         //=====================================================================
 
-#if (DEBUG_CC_EXEC)
-        if (dump_opcodes)
-        {
-            DumpInstruction(codeOp);
-        }
-#endif
-
         /* Perform operation */
         //=====================================================================
-        switch (codeOp.Instruction.Code)
+        switch (codeOp->ExecCode)
         {
-        case SCMD_LINENUM:
-            line_number = codeOp.Arg1i();
+        OP_CASE(SCMD_LINENUM):
+            line_number = codeOp->Arg1i();
             currentline = line_number;
             if (new_line_hook)
                 new_line_hook(this, currentline);
-            break;
-        case SCMD_ADD:
+            OP_NEXT;
+        OP_CASE(SCMD_ADD):
         {
-            const auto arg_reg = codeOp.Arg1i();
-            const auto arg_lit = codeOp.Arg2i();
+            const auto arg_reg = codeOp->Arg1i();
+            const auto arg_lit = codeOp->Arg2i();
             auto &reg1 = registers[arg_reg];
             // If the the register is SREG_SP, we are allocating new variable on the stack
             if (arg_reg == SREG_SP)
@@ -700,12 +803,12 @@ int ccInstance::Run(int32_t curpc)
             {
                 reg1.IValue += arg_lit;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_SUB:
+        OP_CASE(SCMD_SUB):
         {
-            const auto arg_reg = codeOp.Arg1i();
-            const auto arg_lit = codeOp.Arg2i();
+            const auto arg_reg = codeOp->Arg1i();
+            const auto arg_lit = codeOp->Arg2i();
             auto &reg1 = registers[arg_reg];
             if (reg1.Type == kScValStackPtr)
             {
@@ -730,16 +833,16 @@ int ccInstance::Run(int32_t curpc)
             {
                 reg1.IValue -= arg_lit;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_REGTOREG:
+        OP_CASE(SCMD_REGTOREG):
         {
-            const auto &reg1 = registers[codeOp.Arg1i()];
-            auto       &reg2 = registers[codeOp.Arg2i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
+            auto       &reg2 = registers[codeOp->Arg2i()];
             reg2 = reg1;
-            break;
+            OP_NEXT;
         }
-        case SCMD_WRITELIT:
+        OP_CASE(SCMD_WRITELIT):
         {
             // Take the data address from reg[MAR] and copy there arg1 bytes from arg2 address
             //
@@ -747,10 +850,10 @@ int ccInstance::Run(int32_t curpc)
             // long, or rather int32 due x32 build), written value may normally
             // be only up to 4 bytes large;
             // I guess that's an obsolete way to do WRITE, WRITEW and WRITEB
-            const auto arg_size = codeOp.Arg1i();
-            FixupArgument(codeOp.Args[1], codeInst->code_fixups[pc + 2], codeInst->code[pc + 2], this->stack, codeInst->strings);
+            const auto arg_size = codeOp->Arg1i();
+            RuntimeScriptValue arg_value;
+            GetFixedArgument2(arg_value, *codeOp, codeInst, pc, this->stack);
             ASSERT_CC_ERROR();
-            const auto &arg_value = codeOp.Arg2();
             switch (arg_size)
             {
             case sizeof(char) :
@@ -767,9 +870,9 @@ int ccInstance::Run(int32_t curpc)
                 cc_error("unexpected data size for WRITELIT op: %d", arg_size);
                 break;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_RET:
+        OP_CASE(SCMD_RET):
         {
             if (loopIterationCheckDisabled > 0)
                 loopIterationCheckDisabled--;
@@ -786,168 +889,168 @@ int ccInstance::Run(int32_t curpc)
             POP_CALL_STACK;
             continue; // continue so that the PC doesn't get overwritten
         }
-        case SCMD_LITTOREG:
+        OP_CASE(SCMD_LITTOREG):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
-            FixupArgument(codeOp.Args[1], codeInst->code_fixups[pc + 2], codeInst->code[pc + 2], this->stack, codeInst->strings);
+            auto &reg1 = registers[codeOp->Arg1i()];
+            RuntimeScriptValue arg_value;
+            GetFixedArgument2(arg_value, *codeOp, codeInst, pc, this->stack);
             ASSERT_CC_ERROR();
-            const auto &arg_value = codeOp.Arg2();
             reg1 = arg_value;
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMREAD:
+        OP_CASE(SCMD_MEMREAD):
         {
             // Take the data address from reg[MAR] and copy int32_t to reg[arg1]
-            auto &reg1 = registers[codeOp.Arg1i()];
+            auto &reg1 = registers[codeOp->Arg1i()];
             reg1 = registers[SREG_MAR].ReadValue();
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMWRITE:
+        OP_CASE(SCMD_MEMWRITE):
         {
             // Take the data address from reg[MAR] and copy there int32_t from reg[arg1]
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             registers[SREG_MAR].WriteValue(reg1);
-            break;
+            OP_NEXT;
         }
-        case SCMD_LOADSPOFFS:
+        OP_CASE(SCMD_LOADSPOFFS):
         {
-            const auto arg_off = codeOp.Arg1i();
+            const auto arg_off = codeOp->Arg1i();
             registers[SREG_MAR] = GetStackPtrOffsetRw(arg_off);
             ASSERT_CC_ERROR();
-            break;
+            OP_NEXT;
         }
-        case SCMD_MULREG:
+        OP_CASE(SCMD_MULREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32(reg1.IValue * reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_DIVREG:
+        OP_CASE(SCMD_DIVREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             if (reg2.IValue == 0)
             {
                 cc_error("!Integer divide by zero");
                 return -1;
             }
             reg1.SetInt32(reg1.IValue / reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_ADDREG:
+        OP_CASE(SCMD_ADDREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             // This may be pointer arithmetics, in which case IValue stores offset from base pointer
             reg1.IValue += reg2.IValue;
-            break;
+            OP_NEXT;
         }
-        case SCMD_SUBREG:
+        OP_CASE(SCMD_SUBREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             // This may be pointer arithmetics, in which case IValue stores offset from base pointer
             reg1.IValue -= reg2.IValue;
-            break;
+            OP_NEXT;
         }
-        case SCMD_BITAND:
+        OP_CASE(SCMD_BITAND):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32(reg1.IValue & reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_BITOR:
+        OP_CASE(SCMD_BITOR):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32(reg1.IValue | reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_ISEQUAL:
+        OP_CASE(SCMD_ISEQUAL):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1 == reg2);
-            break;
+            OP_NEXT;
         }
-        case SCMD_NOTEQUAL:
+        OP_CASE(SCMD_NOTEQUAL):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1 != reg2);
-            break;
+            OP_NEXT;
         }
-        case SCMD_GREATER:
+        OP_CASE(SCMD_GREATER):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1.IValue > reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_LESSTHAN:
+        OP_CASE(SCMD_LESSTHAN):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1.IValue < reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_GTE:
+        OP_CASE(SCMD_GTE):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1.IValue >= reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_LTE:
+        OP_CASE(SCMD_LTE):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1.IValue <= reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_AND:
+        OP_CASE(SCMD_AND):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1.IValue && reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_OR:
+        OP_CASE(SCMD_OR):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32AsBool(reg1.IValue || reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_XORREG:
+        OP_CASE(SCMD_XORREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32(reg1.IValue ^ reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_MODREG:
+        OP_CASE(SCMD_MODREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             if (reg2.IValue == 0)
             {
                 cc_error("!Integer divide by zero");
                 return -1;
             }
             reg1.SetInt32(reg1.IValue % reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_NOTREG:
+        OP_CASE(SCMD_NOTREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1 = !(reg1);
-            break;
+            OP_NEXT;
         }
-        case SCMD_CALL:
+        OP_CASE(SCMD_CALL):
         {
             // Call another function within same script, just save PC
             // and continue from there
@@ -960,9 +1063,9 @@ int ccInstance::Run(int32_t curpc)
             PUSH_CALL_STACK;
 
             ASSERT_STACK_SPACE_VALS(1);
-            PushValueToStack(RuntimeScriptValue().SetInt32(pc + codeOp.ArgCount + 1));
+            PushValueToStack(RuntimeScriptValue().SetInt32(pc + codeOp->ArgCount + 1));
 
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             if (thisbase[curnest] == 0)
                 pc = reg1.IValue;
             else {
@@ -980,66 +1083,66 @@ int ccInstance::Run(int32_t curpc)
             funcstart[curnest] = pc;
             continue; // continue so that the PC doesn't get overwritten
         }
-        case SCMD_MEMREADB:
+        OP_CASE(SCMD_MEMREADB):
         {
             // Take the data address from reg[MAR] and copy byte to reg[arg1]
-            auto &reg1 = registers[codeOp.Arg1i()];
+            auto &reg1 = registers[codeOp->Arg1i()];
             reg1.SetUInt8(registers[SREG_MAR].ReadByte());
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMREADW:
+        OP_CASE(SCMD_MEMREADW):
         {
             // Take the data address from reg[MAR] and copy int16_t to reg[arg1]
-            auto &reg1 = registers[codeOp.Arg1i()];
+            auto &reg1 = registers[codeOp->Arg1i()];
             reg1.SetInt16(registers[SREG_MAR].ReadInt16());
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMWRITEB:
+        OP_CASE(SCMD_MEMWRITEB):
         {
             // Take the data address from reg[MAR] and copy there byte from reg[arg1]
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             registers[SREG_MAR].WriteByte(reg1.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMWRITEW:
+        OP_CASE(SCMD_MEMWRITEW):
         {
             // Take the data address from reg[MAR] and copy there int16_t from reg[arg1]
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             registers[SREG_MAR].WriteInt16(reg1.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_JZ:
+        OP_CASE(SCMD_JZ):
         {
-            const auto arg_lit = codeOp.Arg1i();
+            const auto arg_lit = codeOp->Arg1i();
             if (registers[SREG_AX].IsNull())
                 pc += arg_lit;
-            break;
+            OP_NEXT;
         }
-        case SCMD_JNZ:
+        OP_CASE(SCMD_JNZ):
         {
-            const auto arg_lit = codeOp.Arg1i();
+            const auto arg_lit = codeOp->Arg1i();
             if (!registers[SREG_AX].IsNull())
                 pc += arg_lit;
-            break;
+            OP_NEXT;
         }
-        case SCMD_PUSHREG:
+        OP_CASE(SCMD_PUSHREG):
         {
             // Push reg[arg1] value to the stack
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             ASSERT_STACK_SPACE_VALS(1);
             PushValueToStack(reg1);
-            break;
+            OP_NEXT;
         }
-        case SCMD_POPREG:
+        OP_CASE(SCMD_POPREG):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
+            auto &reg1 = registers[codeOp->Arg1i()];
             ASSERT_STACK_SIZE(1);
             reg1 = PopValueFromStack();
-            break;
+            OP_NEXT;
         }
-        case SCMD_JMP:
+        OP_CASE(SCMD_JMP):
         {
-            const auto arg_lit = codeOp.Arg1i();
+            const auto arg_lit = codeOp->Arg1i();
             pc += arg_lit;
 
             // Make sure it's not stuck in a While loop
@@ -1068,30 +1171,30 @@ int ccInstance::Run(int32_t curpc)
                     _lastAliveTs = AGS_FastClock::now();
                 }
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_MUL:
+        OP_CASE(SCMD_MUL):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
-            const auto arg_lit = codeOp.Arg2i();
+            auto &reg1 = registers[codeOp->Arg1i()];
+            const auto arg_lit = codeOp->Arg2i();
             reg1.IValue *= arg_lit;
-            break;
+            OP_NEXT;
         }
-        case SCMD_CHECKBOUNDS:
+        OP_CASE(SCMD_CHECKBOUNDS):
         {
-            const auto &reg1 = registers[codeOp.Arg1i()];
-            const auto arg_lit = codeOp.Arg2i();
+            const auto &reg1 = registers[codeOp->Arg1i()];
+            const auto arg_lit = codeOp->Arg2i();
             if ((reg1.IValue < 0) ||
                 (reg1.IValue >= arg_lit))
             {
                 cc_error("!Array index out of bounds (index: %d, bounds: 0..%d)", reg1.IValue, arg_lit - 1);
                 return -1;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_DYNAMICBOUNDS:
+        OP_CASE(SCMD_DYNAMICBOUNDS):
         {
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             // TODO: test reg[MAR] type here;
             // That might be dynamic object, but also a non-managed dynamic array, "allocated"
             // on global or local memspace (buffer)
@@ -1112,11 +1215,11 @@ int ccInstance::Run(int32_t curpc)
                 }
                 return -1;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMREADPTR:
+        OP_CASE(SCMD_MEMREADPTR):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
+            auto &reg1 = registers[codeOp->Arg1i()];
             int32_t handle = registers[SREG_MAR].ReadInt32();
             // FIXME: make pool return a ready RuntimeScriptValue with these set?
             // or another struct, which may be assigned to RSV
@@ -1125,11 +1228,11 @@ int ccInstance::Run(int32_t curpc)
             ScriptValueType obj_type = ccGetObjectAddressAndManagerFromHandle(handle, object, manager);
             reg1.SetScriptObject(obj_type, object, manager);
             ASSERT_CC_ERROR();
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMWRITEPTR:
+        OP_CASE(SCMD_MEMWRITEPTR):
         {
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             int32_t handle = registers[SREG_MAR].ReadInt32();
             void *address;
 
@@ -1166,12 +1269,12 @@ int ccInstance::Run(int32_t curpc)
             }
             // Assign always, avoid leaving undefined value
             registers[SREG_MAR].WriteInt32(newHandle);
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMINITPTR:
+        OP_CASE(SCMD_MEMINITPTR):
         {
             void *address;
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
 
             switch (reg1.Type)
             {
@@ -1202,16 +1305,16 @@ int ccInstance::Run(int32_t curpc)
 
             ccAddObjectReference(newHandle);
             registers[SREG_MAR].WriteInt32(newHandle);
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMZEROPTR:
+        OP_CASE(SCMD_MEMZEROPTR):
         {
             int32_t handle = registers[SREG_MAR].ReadInt32();
             ccReleaseObjectReference(handle);
             registers[SREG_MAR].WriteInt32(0);
-            break;
+            OP_NEXT;
         }
-        case SCMD_MEMZEROPTRND:
+        OP_CASE(SCMD_MEMZEROPTRND):
         {
             int32_t handle = registers[SREG_MAR].ReadInt32();
 
@@ -1224,37 +1327,37 @@ int ccInstance::Run(int32_t curpc)
             ccReleaseObjectReference(handle);
             pool.disableDisposeForObject = nullptr;
             registers[SREG_MAR].WriteInt32(0);
-            break;
+            OP_NEXT;
         }
-        case SCMD_CHECKNULL:
+        OP_CASE(SCMD_CHECKNULL):
             if (registers[SREG_MAR].IsNull())
             {
                 cc_error("!Null pointer referenced");
                 return -1;
             }
-            break;
-        case SCMD_CHECKNULLREG:
+            OP_NEXT;
+        OP_CASE(SCMD_CHECKNULLREG):
         {
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             if (reg1.IsNull())
             {
                 cc_error("!Null string referenced");
                 return -1;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_NUMFUNCARGS:
+        OP_CASE(SCMD_NUMFUNCARGS):
         {
-            const auto arg_lit = codeOp.Arg1i();
+            const auto arg_lit = codeOp->Arg1i();
             num_args_to_func = arg_lit;
-            break;
+            OP_NEXT;
         }
-        case SCMD_CALLAS:
+        OP_CASE(SCMD_CALLAS):
         {
             PUSH_CALL_STACK;
 
             // Call to a function in another script
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
 
             // If there are nested CALLAS calls, the stack might
             // contain 2 calls worth of parameters, so only
@@ -1279,7 +1382,7 @@ int ccInstance::Run(int32_t curpc)
             ccInstance *wasRunning = runningInst;
 
             // extract the instance ID
-            int32_t instId = codeOp.Instruction.InstanceId;
+            int32_t instId = codeOp->Instruction.InstanceId;
             // determine the offset into the code of the instance we want
             runningInst = loadedInstances[instId];
             intptr_t callAddr = reg1.PtrU8 - reinterpret_cast<uint8_t*>(&runningInst->code[0]);
@@ -1304,12 +1407,12 @@ int ccInstance::Run(int32_t curpc)
             was_just_callas = func_callstack.Count;
             num_args_to_func = -1;
             POP_CALL_STACK;
-            break;
+            OP_NEXT;
         }
-        case SCMD_CALLEXT:
+        OP_CASE(SCMD_CALLEXT):
         {
             // Call to a real 'C' code function
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
 
             was_just_callas = -1;
             if (num_args_to_func < 0)
@@ -1385,17 +1488,17 @@ int ccInstance::Run(int32_t curpc)
             registers[SREG_AX] = return_value;
             next_call_needs_object = 0;
             num_args_to_func = -1;
-            break;
+            OP_NEXT;
         }
-        case SCMD_PUSHREAL:
+        OP_CASE(SCMD_PUSHREAL):
         {
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             PushToFuncCallStack(func_callstack, reg1);
-            break;
+            OP_NEXT;
         }
-        case SCMD_SUBREALSTACK:
+        OP_CASE(SCMD_SUBREALSTACK):
         {
-            const auto arg_lit = codeOp.Arg1i();
+            const auto arg_lit = codeOp->Arg1i();
             PopFromFuncCallStack(func_callstack, arg_lit);
             if (was_just_callas >= 0)
             {
@@ -1403,12 +1506,12 @@ int ccInstance::Run(int32_t curpc)
                 PopValuesFromStack(arg_lit);
                 was_just_callas = -1;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_CALLOBJ:
+        OP_CASE(SCMD_CALLOBJ):
         {
             // set the OP register
-            const auto &reg1 = registers[codeOp.Arg1i()];
+            const auto &reg1 = registers[codeOp->Arg1i()];
             if (reg1.IsNull())
             {
                 cc_error("!Null pointer referenced");
@@ -1439,33 +1542,33 @@ int ccInstance::Run(int32_t curpc)
                 return -1;
             }
             next_call_needs_object = 1;
-            break;
+            OP_NEXT;
         }
-        case SCMD_SHIFTLEFT:
+        OP_CASE(SCMD_SHIFTLEFT):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32(reg1.IValue << reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_SHIFTRIGHT:
+        OP_CASE(SCMD_SHIFTRIGHT):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetInt32(reg1.IValue >> reg2.IValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_THISBASE:
+        OP_CASE(SCMD_THISBASE):
         {
-            const auto arg_lit = codeOp.Arg1i();
+            const auto arg_lit = codeOp->Arg1i();
             thisbase[curnest] = arg_lit;
-            break;
+            OP_NEXT;
         }
-        case SCMD_NEWARRAY:
+        OP_CASE(SCMD_NEWARRAY):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
-            const auto arg_elsize = codeOp.Arg2i();
-            const auto arg_managed = codeOp.Arg3().GetAsBool();
+            auto &reg1 = registers[codeOp->Arg1i()];
+            const auto arg_elsize = codeOp->Arg2i();
+            const auto arg_managed = codeOp->Arg3i() != 0;
             int numElements = reg1.IValue;
             if (numElements < 1)
             {
@@ -1474,12 +1577,12 @@ int ccInstance::Run(int32_t curpc)
             }
             DynObjectRef ref = CCDynamicArray::Create(numElements, arg_elsize, arg_managed);
             reg1.SetScriptObject(ref.Obj, &globalDynamicArray);
-            break;
+            OP_NEXT;
         }
-        case SCMD_NEWUSEROBJECT:
+        OP_CASE(SCMD_NEWUSEROBJECT):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
-            const auto arg_size = codeOp.Arg2i();
+            auto &reg1 = registers[codeOp->Arg1i()];
+            const auto arg_size = codeOp->Arg2i();
             if (arg_size < 0)
             {
                 cc_error("Invalid size for user object; requested: %d (or %d), range: 0..%d", arg_size, arg_size, INT_MAX);
@@ -1487,86 +1590,86 @@ int ccInstance::Run(int32_t curpc)
             }
             DynObjectRef ref = ScriptUserObject::Create(arg_size);
             reg1.SetScriptObject(ref.Obj, ref.Mgr);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FADD:
+        OP_CASE(SCMD_FADD):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
-            const auto arg_lit = codeOp.Arg2i();
+            auto &reg1 = registers[codeOp->Arg1i()];
+            const auto arg_lit = codeOp->Arg2i();
             reg1.SetFloat(reg1.FValue + arg_lit); // arg2 was used as int here originally
-            break;
+            OP_NEXT;
         }
-        case SCMD_FSUB:
+        OP_CASE(SCMD_FSUB):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
-            const auto arg_lit = codeOp.Arg2i();
+            auto &reg1 = registers[codeOp->Arg1i()];
+            const auto arg_lit = codeOp->Arg2i();
             reg1.SetFloat(reg1.FValue - arg_lit); // arg2 was used as int here originally
-            break;
+            OP_NEXT;
         }
-        case SCMD_FMULREG:
+        OP_CASE(SCMD_FMULREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetFloat(reg1.FValue * reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FDIVREG:
+        OP_CASE(SCMD_FDIVREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             if (reg2.FValue == 0.0)
             {
                 cc_error("!Floating point divide by zero");
                 return -1;
             }
             reg1.SetFloat(reg1.FValue / reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FADDREG:
+        OP_CASE(SCMD_FADDREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetFloat(reg1.FValue + reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FSUBREG:
+        OP_CASE(SCMD_FSUBREG):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetFloat(reg1.FValue - reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FGREATER:
+        OP_CASE(SCMD_FGREATER):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetFloatAsBool(reg1.FValue > reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FLESSTHAN:
+        OP_CASE(SCMD_FLESSTHAN):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetFloatAsBool(reg1.FValue < reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FGTE:
+        OP_CASE(SCMD_FGTE):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetFloatAsBool(reg1.FValue >= reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_FLTE:
+        OP_CASE(SCMD_FLTE):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             reg1.SetFloatAsBool(reg1.FValue <= reg2.FValue);
-            break;
+            OP_NEXT;
         }
-        case SCMD_ZEROMEMORY:
+        OP_CASE(SCMD_ZEROMEMORY):
         {
-            const auto arg_size = codeOp.Arg1i();
+            const auto arg_size = codeOp->Arg1i();
             // Check if we are zeroing at stack tail
             if (registers[SREG_MAR] == registers[SREG_SP])
             {
@@ -1583,11 +1686,11 @@ int ccInstance::Run(int32_t curpc)
                     registers[SREG_MAR].Type);
                 return -1;
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_CREATESTRING:
+        OP_CASE(SCMD_CREATESTRING):
         {
-            auto &reg1 = registers[codeOp.Arg1i()];
+            auto &reg1 = registers[codeOp->Arg1i()];
             // FIXME: provide a dummy impl to avoid this?
             // why arrays can be created using global mgr and strings not?
             if (stringClassImpl == nullptr)
@@ -1602,12 +1705,12 @@ int ccInstance::Run(int32_t curpc)
                     stringClassImpl->CreateString(ptr).Obj,
                     &myScriptStringImpl);
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_STRINGSEQUAL:
+        OP_CASE(SCMD_STRINGSEQUAL):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             if ((reg1.IsNull()) || (reg2.IsNull()))
             {
                 cc_error("!Null pointer referenced");
@@ -1619,12 +1722,12 @@ int ccInstance::Run(int32_t curpc)
                 const char *ptr2 = reinterpret_cast<const char*>(reg2.GetDirectPtr());
                 reg1.SetInt32AsBool(strcmp(ptr1, ptr2) == 0);
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_STRINGSNOTEQ:
+        OP_CASE(SCMD_STRINGSNOTEQ):
         {
-            auto       &reg1 = registers[codeOp.Arg1i()];
-            const auto &reg2 = registers[codeOp.Arg2i()];
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
             if ((reg1.IsNull()) || (reg2.IsNull()))
             {
                 cc_error("!Null pointer referenced");
@@ -1636,20 +1739,188 @@ int ccInstance::Run(int32_t curpc)
                 const char *ptr2 = reinterpret_cast<const char*>(reg2.GetDirectPtr());
                 reg1.SetInt32AsBool(strcmp(ptr1, ptr2) != 0);
             }
-            break;
+            OP_NEXT;
         }
-        case SCMD_LOOPCHECKOFF:
+        OP_CASE(SCMD_LOOPCHECKOFF):
             if (loopIterationCheckDisabled == 0)
                 loopIterationCheckDisabled++;
-            break;
-        default:
-            cc_error("instruction %d is not implemented", codeOp.Instruction.Code);
+            OP_NEXT;
+        // Typed operations: the decoder has made sure that the registers
+        // already have the resulting type, so only their values are updated
+        OP_CASE(SCMD_LITTOREG_I):
+            registers[codeOp->Arg1i()].SetInt32(codeOp->Arg2i());
+            OP_NEXT;
+        OP_CASE(SCMD_MULREG_I):
+            registers[codeOp->Arg1i()].IValue *= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        OP_CASE(SCMD_DIVREG_I):
+        {
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
+            if (reg2.IValue == 0)
+            {
+                cc_error("!Integer divide by zero");
+                return -1;
+            }
+            reg1.IValue /= reg2.IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_MODREG_I):
+        {
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
+            if (reg2.IValue == 0)
+            {
+                cc_error("!Integer divide by zero");
+                return -1;
+            }
+            reg1.IValue %= reg2.IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_BITAND_I):
+            registers[codeOp->Arg1i()].IValue &= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        OP_CASE(SCMD_BITOR_I):
+            registers[codeOp->Arg1i()].IValue |= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        OP_CASE(SCMD_XORREG_I):
+            registers[codeOp->Arg1i()].IValue ^= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        OP_CASE(SCMD_SHIFTLEFT_I):
+            registers[codeOp->Arg1i()].IValue <<= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        OP_CASE(SCMD_SHIFTRIGHT_I):
+            registers[codeOp->Arg1i()].IValue >>= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        OP_CASE(SCMD_ISEQUAL_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue == registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_NOTEQUAL_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue != registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_GREATER_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue > registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_LESSTHAN_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue < registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_GTE_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue >= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_LTE_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue <= registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_AND_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue && registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_OR_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue || registers[codeOp->Arg2i()].IValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_NOTREG_I):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            reg1.IValue = reg1.IValue == 0;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_FADD_F):
+            registers[codeOp->Arg1i()].FValue += codeOp->Arg2i(); // arg2 was used as int here originally
+            OP_NEXT;
+        OP_CASE(SCMD_FSUB_F):
+            registers[codeOp->Arg1i()].FValue -= codeOp->Arg2i(); // arg2 was used as int here originally
+            OP_NEXT;
+        OP_CASE(SCMD_FMULREG_F):
+            registers[codeOp->Arg1i()].FValue *= registers[codeOp->Arg2i()].FValue;
+            OP_NEXT;
+        OP_CASE(SCMD_FDIVREG_F):
+        {
+            auto       &reg1 = registers[codeOp->Arg1i()];
+            const auto &reg2 = registers[codeOp->Arg2i()];
+            if (reg2.FValue == 0.0)
+            {
+                cc_error("!Floating point divide by zero");
+                return -1;
+            }
+            reg1.FValue /= reg2.FValue;
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_FADDREG_F):
+            registers[codeOp->Arg1i()].FValue += registers[codeOp->Arg2i()].FValue;
+            OP_NEXT;
+        OP_CASE(SCMD_FSUBREG_F):
+            registers[codeOp->Arg1i()].FValue -= registers[codeOp->Arg2i()].FValue;
+            OP_NEXT;
+        OP_CASE(SCMD_REGTOREG_N):
+            registers[codeOp->Arg2i()].IValue = registers[codeOp->Arg1i()].IValue;
+            OP_NEXT;
+        OP_CASE(SCMD_JZ_I):
+            if (registers[SREG_AX].IValue == 0)
+                pc += codeOp->Arg1i();
+            OP_NEXT;
+        OP_CASE(SCMD_JNZ_I):
+            if (registers[SREG_AX].IValue != 0)
+                pc += codeOp->Arg1i();
+            OP_NEXT;
+        OP_CASE(SCMD_PUSHREG_N):
+        {
+            const auto &reg1 = registers[codeOp->Arg1i()];
+            ASSERT_STACK_SPACE_VALS(1);
+            RuntimeScriptValue *entry = registers[SREG_SP].RValue;
+            // Stack tail is normally an invalid entry, which is simply
+            // overwritten; anything else goes through the full procedure
+            if (entry->IsValid())
+            {
+                PushValueToStack(reg1);
+            }
+            else
+            {
+                *entry = reg1;
+                stackdata_ptr += sizeof(int32_t);
+                registers[SREG_SP].RValue++;
+            }
+            OP_NEXT;
+        }
+        OP_CASE(SCMD_POPREG_N):
+        {
+            auto &reg1 = registers[codeOp->Arg1i()];
+            ASSERT_STACK_SIZE(1);
+            RuntimeScriptValue *entry = --registers[SREG_SP].RValue;
+            reg1 = *entry;
+            stackdata_ptr -= sizeof(int32_t);
+            entry->Invalidate();
+            OP_NEXT;
+        }
+        OP_DEFAULT:
+            cc_error("instruction %d is not implemented", codeOp->Instruction.Code);
             return -1;
         }
         /* End perform operation */
         //=====================================================================
 
-        pc += codeOp.ArgCount + 1;
+        pc += codeOp->ArgCount + 1;
     }
     return 0;
 }
@@ -1701,7 +1972,7 @@ void ccInstance::DumpInstruction(const ScriptOperation &op) const
 
     if (op.Instruction.Code == SCMD_LINENUM)
     {
-        line_num = op.Args[0].IValue;
+        line_num = op.Args[0];
         return;
     }
 
@@ -1720,11 +1991,12 @@ void ccInstance::DumpInstruction(const ScriptOperation &op) const
         }
         if (cmd_info.ArgIsReg[i])
         {
-            writer.WriteFormat(" %s", regnames[op.Args[i].IValue]);
+            writer.WriteFormat(" %s", regnames[op.Args[i]]);
         }
         else
         {
-            RuntimeScriptValue arg = op.Args[i];
+            RuntimeScriptValue arg;
+            arg.SetInt32(op.Args[i]);
             if (arg.Type == kScValStackPtr || arg.Type == kScValGlobalVar)
             {
                 arg = *arg.RValue;
@@ -1862,6 +2134,7 @@ bool ccInstance::_Create(PScript scri, ccInstance * joined)
     {
         resolved_imports = joined->resolved_imports;
         code_fixups = joined->code_fixups;
+        decoded_code = joined->decoded_code;
     }
     else
     {
@@ -1966,6 +2239,7 @@ void ccInstance::Free()
     }
     resolved_imports = nullptr;
     code_fixups = nullptr;
+    decoded_code.reset();
 }
 
 bool ccInstance::ResolveScriptImports(const ccScript *scri)
@@ -2202,9 +2476,254 @@ bool ccInstance::ResolveImportFixups(const ccScript *scri)
         if (import->InstancePtr != nullptr && (code[fixup + 1] & INSTANCE_ID_REMOVEMASK) == SCMD_CALLEXT)
             code[fixup + 1] = SCMD_CALLAS | (import->InstancePtr->loadedInstanceId << INSTANCE_ID_SHIFT);
     }
+    // The code is final now, so decode it
+    DecodeCode();
     return true;
 }
 
+// Register value type, as far as the decoder can tell
+enum DecodedRegType
+{
+    kDecReg_Unknown,
+    kDecReg_Int,    // integer set by SetInt32
+    kDecReg_Float   // float set by SetFloat
+};
+
+// Selects the typed variant of the operation with an integer result,
+// if the register already has the integer type
+inline int32_t TypedIntOp(DecodedRegType reg1, int32_t typed_code, int32_t code)
+{
+    return (reg1 == kDecReg_Int) ? typed_code : code;
+}
+
+// Selects the typed variant of the operation with a float result,
+// if the register already has the float type
+inline int32_t TypedFloatOp(DecodedRegType reg1, int32_t typed_code, int32_t code)
+{
+    return (reg1 == kDecReg_Float) ? typed_code : code;
+}
+
+// Replaces operations with their typed variants, where the types of the
+// registers involved are known. Types are tracked along each straight run
+// of code, starting with all unknown at the positions where the execution
+// may come from elsewhere: function entries, jump targets and return
+// addresses. Types of the values pushed to the stack are tracked too, for
+// as long as nothing else modifies the stack.
+static void AssignTypedOperations(std::vector<ScriptOperation> &ops, std::vector<bool> &entries)
+{
+    const int32_t codesize = static_cast<int32_t>(ops.size());
+    for (int32_t pc = 0; pc < codesize; ++pc)
+    {
+        const ScriptOperation &op = ops[pc];
+        if (op.Instruction.Code == SCMD_JZ || op.Instruction.Code == SCMD_JNZ ||
+            op.Instruction.Code == SCMD_JMP)
+        {
+            const int32_t target = pc + op.ArgCount + 1 + op.Arg1i();
+            if (target >= 0 && target < codesize)
+                entries[target] = true;
+        }
+    }
+
+    DecodedRegType regs[CC_NUM_REGISTERS];
+    std::vector<DecodedRegType> stack;
+    bool reset = true;
+    for (int32_t pc = 0; pc < codesize;)
+    {
+        ScriptOperation &op = ops[pc];
+        if (op.Instruction.Code < 0)
+        {
+            reset = true;
+            pc++;
+            continue;
+        }
+        if (reset || entries[pc])
+        {
+            std::fill(regs, regs + CC_NUM_REGISTERS, kDecReg_Unknown);
+            stack.clear();
+            reset = false;
+        }
+        const ScriptCommandInfo &info = sccmd_info[op.Instruction.Code];
+        bool valid_regs = true;
+        for (int i = 0; i < op.ArgCount; ++i)
+            valid_regs &= !info.ArgIsReg[i] || (op.Args[i] >= 0 && op.Args[i] < CC_NUM_REGISTERS);
+        if (!valid_regs)
+        {
+            reset = true;
+            pc += op.ArgCount + 1;
+            continue;
+        }
+
+        const int r1 = info.ArgIsReg[0] ? op.Args[0] : 0;
+        const int r2 = info.ArgIsReg[1] ? op.Args[1] : 0;
+        switch (op.Instruction.Code)
+        {
+        case SCMD_LITTOREG:
+            if (op.FixedArg == ScriptOperation::NoFixup)
+            {
+                op.ExecCode = SCMD_LITTOREG_I;
+                regs[r1] = kDecReg_Int;
+            }
+            else
+            {
+                regs[r1] = kDecReg_Unknown;
+            }
+            break;
+        case SCMD_MULREG: op.ExecCode = TypedIntOp(regs[r1], SCMD_MULREG_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_DIVREG: op.ExecCode = TypedIntOp(regs[r1], SCMD_DIVREG_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_MODREG: op.ExecCode = TypedIntOp(regs[r1], SCMD_MODREG_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_BITAND: op.ExecCode = TypedIntOp(regs[r1], SCMD_BITAND_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_BITOR: op.ExecCode = TypedIntOp(regs[r1], SCMD_BITOR_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_XORREG: op.ExecCode = TypedIntOp(regs[r1], SCMD_XORREG_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_SHIFTLEFT: op.ExecCode = TypedIntOp(regs[r1], SCMD_SHIFTLEFT_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_SHIFTRIGHT: op.ExecCode = TypedIntOp(regs[r1], SCMD_SHIFTRIGHT_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_GREATER: op.ExecCode = TypedIntOp(regs[r1], SCMD_GREATER_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_LESSTHAN: op.ExecCode = TypedIntOp(regs[r1], SCMD_LESSTHAN_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_GTE: op.ExecCode = TypedIntOp(regs[r1], SCMD_GTE_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_LTE: op.ExecCode = TypedIntOp(regs[r1], SCMD_LTE_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_AND: op.ExecCode = TypedIntOp(regs[r1], SCMD_AND_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_OR: op.ExecCode = TypedIntOp(regs[r1], SCMD_OR_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_NOTREG: op.ExecCode = TypedIntOp(regs[r1], SCMD_NOTREG_I, op.ExecCode); regs[r1] = kDecReg_Int; break;
+        case SCMD_ISEQUAL:
+        case SCMD_NOTEQUAL:
+            // these compare raw values, which is exact if neither is a pointer
+            if (regs[r1] == kDecReg_Int && regs[r2] != kDecReg_Unknown)
+                op.ExecCode = (op.Instruction.Code == SCMD_ISEQUAL) ? SCMD_ISEQUAL_I : SCMD_NOTEQUAL_I;
+            regs[r1] = kDecReg_Int;
+            break;
+        case SCMD_STRINGSEQUAL:
+        case SCMD_STRINGSNOTEQ:
+            regs[r1] = kDecReg_Int;
+            break;
+        case SCMD_FADD: op.ExecCode = TypedFloatOp(regs[r1], SCMD_FADD_F, op.ExecCode); regs[r1] = kDecReg_Float; break;
+        case SCMD_FSUB: op.ExecCode = TypedFloatOp(regs[r1], SCMD_FSUB_F, op.ExecCode); regs[r1] = kDecReg_Float; break;
+        case SCMD_FMULREG: op.ExecCode = TypedFloatOp(regs[r1], SCMD_FMULREG_F, op.ExecCode); regs[r1] = kDecReg_Float; break;
+        case SCMD_FDIVREG: op.ExecCode = TypedFloatOp(regs[r1], SCMD_FDIVREG_F, op.ExecCode); regs[r1] = kDecReg_Float; break;
+        case SCMD_FADDREG: op.ExecCode = TypedFloatOp(regs[r1], SCMD_FADDREG_F, op.ExecCode); regs[r1] = kDecReg_Float; break;
+        case SCMD_FSUBREG: op.ExecCode = TypedFloatOp(regs[r1], SCMD_FSUBREG_F, op.ExecCode); regs[r1] = kDecReg_Float; break;
+        case SCMD_FGREATER: case SCMD_FLESSTHAN: case SCMD_FGTE: case SCMD_FLTE:
+            regs[r1] = kDecReg_Float;
+            break;
+        case SCMD_ADD: case SCMD_SUB: case SCMD_MUL: case SCMD_ADDREG: case SCMD_SUBREG:
+            // these change the value, but not the type, except for the stack pointer
+            if (r1 == SREG_SP)
+                stack.clear();
+            break;
+        case SCMD_REGTOREG:
+            if (regs[r1] != kDecReg_Unknown && regs[r2] == regs[r1])
+                op.ExecCode = SCMD_REGTOREG_N;
+            regs[r2] = regs[r1];
+            break;
+        case SCMD_JZ:
+        case SCMD_JNZ:
+            if (regs[SREG_AX] == kDecReg_Int)
+                op.ExecCode = (op.Instruction.Code == SCMD_JZ) ? SCMD_JZ_I : SCMD_JNZ_I;
+            break;
+        case SCMD_PUSHREG:
+            if (regs[r1] != kDecReg_Unknown && r1 != SREG_SP)
+                op.ExecCode = SCMD_PUSHREG_N;
+            stack.push_back(regs[r1]);
+            break;
+        case SCMD_POPREG:
+        {
+            DecodedRegType type = kDecReg_Unknown;
+            if (!stack.empty())
+            {
+                type = stack.back();
+                stack.pop_back();
+            }
+            if (type != kDecReg_Unknown && r1 != SREG_SP)
+                op.ExecCode = SCMD_POPREG_N;
+            regs[r1] = type;
+            break;
+        }
+        case SCMD_MEMREAD: case SCMD_MEMREADB: case SCMD_MEMREADW: case SCMD_MEMREADPTR:
+        case SCMD_NEWARRAY: case SCMD_NEWUSEROBJECT: case SCMD_CREATESTRING:
+            regs[r1] = kDecReg_Unknown;
+            break;
+        case SCMD_LOADSPOFFS:
+            regs[SREG_MAR] = kDecReg_Unknown;
+            break;
+        case SCMD_CALLOBJ:
+            regs[SREG_OP] = kDecReg_Unknown;
+            break;
+        case SCMD_MEMWRITE: case SCMD_MEMWRITEB: case SCMD_MEMWRITEW: case SCMD_WRITELIT:
+        case SCMD_MEMWRITEPTR: case SCMD_MEMINITPTR: case SCMD_MEMZEROPTR: case SCMD_MEMZEROPTRND:
+        case SCMD_ZEROMEMORY: case SCMD_SUBREALSTACK:
+            // these may write over the pushed values
+            stack.clear();
+            break;
+        case SCMD_LINENUM: case SCMD_CHECKBOUNDS: case SCMD_DYNAMICBOUNDS: case SCMD_CHECKNULL:
+        case SCMD_CHECKNULLREG: case SCMD_THISBASE: case SCMD_NUMFUNCARGS: case SCMD_LOOPCHECKOFF:
+        case SCMD_PUSHREAL:
+            break;
+        default:
+            // calls, returns and jumps: next operation is not reached
+            // from this one, or not with the same registers
+            reset = true;
+            break;
+        }
+        regs[SREG_SP] = kDecReg_Unknown;
+        pc += op.ArgCount + 1;
+    }
+}
+
+void ccInstance::DecodeCode()
+{
+    decoded_code.reset(new ScriptDecodedCode());
+    std::vector<ScriptOperation> &ops = decoded_code->Ops;
+    ops.resize(codesize);
+    // Positions where the execution may start: function entries
+    std::vector<bool> entries(codesize);
+    if (codesize > 0)
+        entries[0] = true;
+    for (int i = 0; i < instanceof->numexports; ++i)
+    {
+        const int32_t etype = (instanceof->export_addr[i] >> 24) & 0x000ff;
+        const int32_t eaddr = instanceof->export_addr[i] & 0x00ffffff;
+        if (etype == EXPORT_FUNCTION && eaddr < codesize)
+            entries[eaddr] = true;
+    }
+    // Decode operations sequentially; any position which does not have
+    // a valid operation is left undecoded, and is handled when executed
+    for (int32_t at = 0; at < codesize;)
+    {
+        ScriptOperation &op = ops[at];
+        if (!DecodeOperation(code, codesize, at, op))
+        {
+            op = ScriptOperation();
+            at++;
+            continue;
+        }
+
+        if (op.Instruction.Code == SCMD_WRITELIT || op.Instruction.Code == SCMD_LITTOREG)
+        {
+            // Apply fixups which do not depend on the runtime state
+            RuntimeScriptValue arg;
+            arg.SetInt32(op.Arg2i());
+            switch (code_fixups[at + 2])
+            {
+            case FIXUP_NOFIXUP:
+                op.FixedArg = ScriptOperation::NoFixup;
+                break;
+            case FIXUP_GLOBALDATA:
+            case FIXUP_FUNCTION:
+            case FIXUP_STRING:
+                FixupArgument(arg, code_fixups[at + 2], code[at + 2], stack, strings);
+                op.FixedArg = static_cast<int32_t>(decoded_code->FixedArgs.size());
+                decoded_code->FixedArgs.push_back(arg);
+                if (code_fixups[at + 2] == FIXUP_FUNCTION && arg.IValue >= 0 && arg.IValue < codesize)
+                    entries[arg.IValue] = true;
+                break;
+            default: // imports and stack offsets are resolved at runtime
+                op.FixedArg = ScriptOperation::RuntimeFixup;
+                break;
+            }
+        }
+        at += op.ArgCount + 1;
+    }
+    AssignTypedOperations(ops, entries);
+}
+
 void ccInstance::PushValueToStack(const RuntimeScriptValue &rval)
 {
     // Write value to the stack tail and advance stack ptr
@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "ac/timer.h"
 #include "script/cc_script.h"  // ccScript
@@ -64,21 +65,79 @@ struct ScriptInstruction
     int32_t	InstanceId = 0;
 };
 
+// Operations with the register types known in advance. The decoder puts
+// these in place of the regular instructions where it can tell that the
+// registers hold plain integers or floats; they only access the 32-bit
+// values, skipping the type checks and copying of RuntimeScriptValues.
+enum ScriptTypedOpcode
+{
+    SCMD_LITTOREG_I = CC_NUM_SCCMDS, // reg1 = arg2, a plain integer literal
+    SCMD_MULREG_I,      // int reg1 *= reg2
+    SCMD_DIVREG_I,      // int reg1 /= reg2
+    SCMD_MODREG_I,      // int reg1 %= reg2
+    SCMD_BITAND_I,      // int reg1 &= reg2
+    SCMD_BITOR_I,       // int reg1 |= reg2
+    SCMD_XORREG_I,      // int reg1 ^= reg2
+    SCMD_SHIFTLEFT_I,   // int reg1 <<= reg2
+    SCMD_SHIFTRIGHT_I,  // int reg1 >>= reg2
+    SCMD_ISEQUAL_I,     // int reg1 = (int reg1 == int reg2)
+    SCMD_NOTEQUAL_I,    // int reg1 = (int reg1 != int reg2)
+    SCMD_GREATER_I,     // int reg1 = (reg1 > reg2)
+    SCMD_LESSTHAN_I,    // int reg1 = (reg1 < reg2)
+    SCMD_GTE_I,         // int reg1 = (reg1 >= reg2)
+    SCMD_LTE_I,         // int reg1 = (reg1 <= reg2)
+    SCMD_AND_I,         // int reg1 = (reg1 && reg2)
+    SCMD_OR_I,          // int reg1 = (reg1 || reg2)
+    SCMD_NOTREG_I,      // int reg1 = !reg1
+    SCMD_FADD_F,        // float reg1 += arg2
+    SCMD_FSUB_F,        // float reg1 -= arg2
+    SCMD_FMULREG_F,     // float reg1 *= reg2
+    SCMD_FDIVREG_F,     // float reg1 /= reg2
+    SCMD_FADDREG_F,     // float reg1 += reg2
+    SCMD_FSUBREG_F,     // float reg1 -= reg2
+    SCMD_REGTOREG_N,    // reg2 = reg1, both of the same numeric type
+    SCMD_JZ_I,          // jump if int ax == 0
+    SCMD_JNZ_I,         // jump if int ax != 0
+    SCMD_PUSHREG_N,     // push numeric reg1 to the stack
+    SCMD_POPREG_N,      // pop numeric value from the stack to reg1
+    CC_NUM_EXEC_CMDS
+};
+
+// Pre-decoded script operation. Operations are decoded once when the script
+// is loaded, and stored per code position, so that the program counter
+// and jump offsets remain same as in the original bytecode.
 struct ScriptOperation
 {
-	ScriptInstruction   Instruction;
-	RuntimeScriptValue	Args[MAX_SCMD_ARGS];
-	int				    ArgCount = 0;
+    // Tells that the 2nd argument is a plain literal
+    static const int32_t NoFixup = -1;
+    // Tells that the 2nd argument must be fixed up at runtime
+    static const int32_t RuntimeFixup = -2;
+
+    // Instruction code is -1 for positions which were not decoded
+    ScriptInstruction   Instruction = ScriptInstruction(-1, 0);
+    // Code of the handler which executes this operation: either the
+    // instruction's code, or one of the ScriptTypedOpcode
+    int32_t             ExecCode = -1;
+    int32_t             Args[MAX_SCMD_ARGS] = {};
+    int32_t             ArgCount = 0;
+    // Index of the 2nd argument's value resolved at load time,
+    // or one of the NoFixup, RuntimeFixup
+    int32_t             FixedArg = NoFixup;
 
     // Helper functions for clarity of intent:
-    // returns argN, 1-based
-    inline const RuntimeScriptValue &Arg1() const { return Args[0]; }
-    inline const RuntimeScriptValue &Arg2() const { return Args[1]; }
-    inline const RuntimeScriptValue &Arg3() const { return Args[2]; }
-    // returns argN as a integer literal
-    inline int Arg1i() const { return Args[0].IValue; }
-    inline int Arg2i() const { return Args[1].IValue; }
-    inline int Arg3i() const { return Args[2].IValue; }
+    // returns argN as a integer literal, 1-based
+    inline int Arg1i() const { return Args[0]; }
+    inline int Arg2i() const { return Args[1]; }
+    inline int Arg3i() const { return Args[2]; }
+};
+
+// Script's bytecode decoded into operations
+struct ScriptDecodedCode
+{
+    // Operations, one per code position
+    std::vector<ScriptOperation>    Ops;
+    // Argument values with the fixups applied at load time
+    std::vector<RuntimeScriptValue> FixedArgs;
 };
 
 struct ScriptVariable
@@ -158,6 +217,8 @@ public:
     int  numimports;
 
     char *code_fixups;
+    // pre-decoded operations, shared with the forked instances
+    std::shared_ptr<ScriptDecodedCode> decoded_code;
 
     // returns the currently executing instance, or NULL if none
     static ccInstance *GetCurrentInstance(void);
@@ -207,6 +268,9 @@ private:
     bool    AddGlobalVar(const ScriptVariable &glvar);
     ScriptVariable *FindGlobalVar(int32_t var_addr);
     bool    CreateRuntimeCodeFixups(const ccScript *scri);
+    // Decodes the bytecode into operations, resolving the fixups which
+    // do not depend on the script's runtime state
+    void    DecodeCode();
 
     // Begin executing script starting from the given bytecode index
     int     Run(int32_t curpc);
@@ -897,6 +897,7 @@ int run_interaction_commandlist(const ObjectEvent &obj_evt, InteractionCommandLi
           if (!is_valid_character(IPARAM1))
               quit("!Move NPC to different room: invalid character specified");
           game.chars[IPARAM1].room = IPARAM2;
+          invalidate_room_characters();
           break;
       case 27: // Set character view
           SetCharacterView (IPARAM1, IPARAM2);
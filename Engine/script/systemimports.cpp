@@ -11,6 +11,7 @@
 // http://www.opensource.org/licenses/artistic-license-2.0.php
 //
 //=============================================================================
+#include <algorithm>
 #include <stdlib.h>
 #include <string.h>
 #include "script/systemimports.h"
@@ -18,6 +19,66 @@
 SystemImports simp;
 SystemImports simp_for_plugin;
 
+// Gets the key for the reverse lookup, matching RuntimeScriptValue::operator==
+static inline intptr_t GetValueKey(const RuntimeScriptValue &value)
+{
+    return (intptr_t)value.Ptr + (intptr_t)value.IValue;
+}
+
+void SystemImports::AddToIndex(uint32_t index)
+{
+    const String &name = imports[index].Name;
+    lookup[name] = index;
+    // Mangled names are registered under each prefix that ends before '$'
+    for (size_t c = name.FindChar('$'); c != String::NoIndex; c = name.FindChar('$', c + 1))
+        prefix_lookup[name.Left(c)].push_back(index);
+    AddValueToIndex(index);
+}
+
+void SystemImports::RemoveFromIndex(uint32_t index)
+{
+    const String &name = imports[index].Name;
+    lookup.erase(name);
+    for (size_t c = name.FindChar('$'); c != String::NoIndex; c = name.FindChar('$', c + 1))
+    {
+        auto it = prefix_lookup.find(name.Left(c));
+        if (it == prefix_lookup.end())
+            continue;
+        auto &list = it->second;
+        list.erase(std::remove(list.begin(), list.end(), index), list.end());
+        if (list.empty())
+            prefix_lookup.erase(it);
+    }
+    RemoveValueFromIndex(index);
+}
+
+void SystemImports::AddValueToIndex(uint32_t index)
+{
+    value_lookup.insert(std::make_pair(GetValueKey(imports[index].Value), index));
+}
+
+void SystemImports::RemoveValueFromIndex(uint32_t index)
+{
+    auto range = value_lookup.equal_range(GetValueKey(imports[index].Value));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == index)
+        {
+            value_lookup.erase(it);
+            return;
+        }
+    }
+}
+
+void SystemImports::RemoveAt(uint32_t index)
+{
+    RemoveFromIndex(index);
+    imports[index].Name = nullptr;
+    imports[index].Value.Invalidate();
+    imports[index].InstancePtr = nullptr;
+    free_slots.push(index);
+}
+
 uint32_t SystemImports::add(const String &name, const RuntimeScriptValue &value, ccInstance *anotherscr)
 {
     uint32_t ixof = get_index_of(name);
@@ -27,28 +88,28 @@ uint32_t SystemImports::add(const String &name, const RuntimeScriptValue &value,
         // Only allow override if not a script-exported function
         if (anotherscr == nullptr)
         {
+            RemoveValueFromIndex(ixof);
             imports[ixof].Value = value;
             imports[ixof].InstancePtr = anotherscr;
+            AddValueToIndex(ixof);
         }
         return ixof;
     }
 
-    ixof = imports.size();
-    for (size_t i = 0; i < imports.size(); ++i)
+    if (!free_slots.empty())
     {
-        if (imports[i].Name == nullptr)
-        {
-            ixof = i;
-            break;
-        }
+        ixof = free_slots.top();
+        free_slots.pop();
     }
-
-    btree[name] = ixof;
-    if (ixof == imports.size())
+    else
+    {
+        ixof = imports.size();
         imports.push_back(ScriptImport());
+    }
     imports[ixof].Name          = name;
     imports[ixof].Value         = value;
     imports[ixof].InstancePtr   = anotherscr;
+    AddToIndex(ixof);
     return ixof;
 }
 
@@ -57,10 +118,7 @@ void SystemImports::remove(const String &name)
     uint32_t idx = get_index_of(name);
     if (idx == UINT32_MAX)
         return;
-    btree.erase(imports[idx].Name);
-    imports[idx].Name = nullptr;
-    imports[idx].Value.Invalidate();
-    imports[idx].InstancePtr = nullptr;
+    RemoveAt(idx);
 }
 
 const ScriptImport *SystemImports::getByName(const String &name)
@@ -82,16 +140,24 @@ const ScriptImport *SystemImports::getByIndex(uint32_t index)
 
 uint32_t SystemImports::get_index_of(const String &name)
 {
-    IndexMap::const_iterator it = btree.find(name);
-    if (it != btree.end())
+    IndexMap::const_iterator it = lookup.find(name);
+    if (it != lookup.end())
         return it->second;
 
     // CHECKME: what are "mangled names" and where do they come from?
-    String mangled_name = String::FromFormat("%s$", name.GetCStr());
-    // if it's a function with a mangled name, allow it
-    it = btree.lower_bound(mangled_name);
-    if (it != btree.end() && it->first.CompareLeft(mangled_name) == 0)
-        return it->second;
+    // if it's a function with a mangled name ("name$N"), allow it;
+    // if there are several, choose the lexicographically first one
+    PrefixMap::const_iterator pit = prefix_lookup.find(name);
+    if (pit != prefix_lookup.end())
+    {
+        uint32_t found = pit->second.front();
+        for (uint32_t idx : pit->second)
+        {
+            if (imports[idx].Name.Compare(imports[found].Name) < 0)
+                found = idx;
+        }
+        return found;
+    }
 
     if (name.GetLength() > 3)
     {
@@ -108,14 +174,14 @@ uint32_t SystemImports::get_index_of(const String &name)
 
 String SystemImports::findName(const RuntimeScriptValue &value)
 {
-    for (const auto &import : imports)
-    {
-        if (import.Value == value)
-        {
-            return import.Name;
-        }
-    }
-    return String();
+    // if several imports have the same value, return the first one
+    auto range = value_lookup.equal_range(GetValueKey(value));
+    uint32_t found = UINT32_MAX;
+    for (auto it = range.first; it != range.second; ++it)
+        found = std::min(found, it->second);
+    if (found == UINT32_MAX)
+        return String();
+    return imports[found].Name;
 }
 
 void SystemImports::RemoveScriptExports(ccInstance *inst)
@@ -125,23 +191,21 @@ void SystemImports::RemoveScriptExports(ccInstance *inst)
         return;
     }
 
-    for (auto &import : imports)
+    for (uint32_t i = 0; i < imports.size(); ++i)
     {
-        if (import.Name == nullptr)
+        if (imports[i].Name == nullptr)
             continue;
 
-        if (import.InstancePtr == inst)
-        {
-            btree.erase(import.Name);
-            import.Name = nullptr;
-            import.Value.Invalidate();
-            import.InstancePtr = nullptr;
-        }
+        if (imports[i].InstancePtr == inst)
+            RemoveAt(i);
     }
 }
 
 void SystemImports::clear()
 {
-    btree.clear();
+    lookup.clear();
+    prefix_lookup.clear();
+    value_lookup.clear();
+    free_slots = decltype(free_slots)();
     imports.clear();
 }
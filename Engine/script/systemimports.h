@@ -15,8 +15,12 @@
 #ifndef __CC_SYSTEMIMPORTS_H
 #define __CC_SYSTEMIMPORTS_H
 
-#include <map>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
 #include "script/cc_instance.h"    // ccInstance
+#include "util/string_types.h"
 
 struct IScriptObject;
 
@@ -37,12 +41,27 @@ struct ScriptImport
 struct SystemImports
 {
 private:
-    // Note we can't use a hash-map here, because we sometimes need to search
-    // by partial keys.
-    typedef std::map<String, uint32_t> IndexMap;
+    typedef std::unordered_map<String, uint32_t> IndexMap;
+    // Lists imports which names begin with a certain prefix
+    typedef std::unordered_map<String, std::vector<uint32_t>> PrefixMap;
+    // Lists imports by their value, see RuntimeScriptValue::operator==
+    typedef std::unordered_multimap<intptr_t, uint32_t> ValueMap;
 
     std::vector<ScriptImport> imports;
-    IndexMap btree;
+    // Exact name lookup
+    IndexMap lookup;
+    // Lookup of the mangled names ("name$N") by the part preceding '$'
+    PrefixMap prefix_lookup;
+    // Reverse lookup of names by value
+    ValueMap value_lookup;
+    // Free import slots, lowest index is reused first
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> free_slots;
+
+    void AddToIndex(uint32_t index);
+    void RemoveFromIndex(uint32_t index);
+    void AddValueToIndex(uint32_t index);
+    void RemoveValueFromIndex(uint32_t index);
+    void RemoveAt(uint32_t index);
 
 public:
     uint32_t add(const String &name, const RuntimeScriptValue &value, ccInstance *inst);
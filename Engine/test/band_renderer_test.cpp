@@ -0,0 +1,195 @@
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "gfx/band_renderer.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+
+extern "C" {
+    uint32_t _blender_trans24(uint32_t x, uint32_t y, uint32_t n);
+}
+
+// Sprite drawn the way the software renderer does
+struct TestSprite
+{
+    std::unique_ptr<Bitmap> Image;
+    int X, Y;
+    enum { kOpaque, kMasked, kAlpha, kTransAlpha, kTrans, kTint } Type;
+    int Alpha;
+};
+
+static void FillRandom(Bitmap *bmp, std::mt19937 &rng)
+{
+    for (int y = 0; y < bmp->GetHeight(); ++y)
+    {
+        uint32_t *line = reinterpret_cast<uint32_t*>(bmp->GetScanLineForWriting(y));
+        for (int x = 0; x < bmp->GetWidth(); ++x)
+            line[x] = (rng() % 8 == 0) ? MASK_COLOR_32 : rng();
+    }
+}
+
+static bool SameBitmaps(Bitmap *a, Bitmap *b)
+{
+    for (int y = 0; y < a->GetHeight(); ++y)
+    {
+        if (memcmp(a->GetScanLine(y), b->GetScanLine(y), a->GetLineLength()) != 0)
+            return false;
+    }
+    return true;
+}
+
+static std::vector<TestSprite> MakeScene(int width, int height, int count, int max_size, std::mt19937 &rng)
+{
+    std::vector<TestSprite> scene;
+    for (int i = 0; i < count; ++i)
+    {
+        TestSprite spr;
+        spr.Type = static_cast<decltype(spr.Type)>(rng() % 5);
+        spr.Alpha = 1 + rng() % 255;
+        spr.Image.reset(BitmapHelper::CreateBitmap(1 + rng() % max_size, 1 + rng() % max_size, 32));
+        FillRandom(spr.Image.get(), rng);
+        spr.X = static_cast<int>(rng() % (width + max_size)) - max_size / 2;
+        spr.Y = static_cast<int>(rng() % (height + max_size)) - max_size / 2;
+        scene.push_back(std::move(spr));
+    }
+    TestSprite tint;
+    tint.Type = TestSprite::kTint;
+    tint.X = tint.Y = 0;
+    tint.Alpha = 0;
+    scene.insert(scene.begin() + count / 2, std::move(tint));
+    return scene;
+}
+
+static void SetSpriteBlender(const TestSprite &spr)
+{
+    switch (spr.Type)
+    {
+    case TestSprite::kAlpha: set_alpha_blender(); break;
+    case TestSprite::kTransAlpha: set_blender_mode(nullptr, nullptr, _trans_alpha_blender32, 0, 0, 0, spr.Alpha); break;
+    case TestSprite::kTrans: set_trans_blender(0, 0, 0, spr.Alpha); break;
+    case TestSprite::kTint: set_trans_blender(200, 40, 90, 0); break;
+    default: break;
+    }
+}
+
+static void DrawReference(Bitmap *surface, const std::vector<TestSprite> &scene)
+{
+    for (const auto &spr : scene)
+    {
+        SetSpriteBlender(spr);
+        switch (spr.Type)
+        {
+        case TestSprite::kOpaque: surface->Blit(spr.Image.get(), 0, 0, spr.X, spr.Y,
+            spr.Image->GetWidth(), spr.Image->GetHeight()); break;
+        case TestSprite::kMasked: surface->Blit(spr.Image.get(), spr.X, spr.Y, kBitmap_Transparency); break;
+        case TestSprite::kTint: surface->LitBlendBlt(surface, 0, 0, 128); break;
+        default: surface->TransBlendBlt(spr.Image.get(), spr.X, spr.Y); break;
+        }
+    }
+}
+
+static void DrawBands(BandRenderer &renderer, Bitmap *surface, const std::vector<TestSprite> &scene)
+{
+    renderer.Begin(surface);
+    for (const auto &spr : scene)
+    {
+        SetSpriteBlender(spr);
+        bool added = false;
+        switch (spr.Type)
+        {
+        case TestSprite::kOpaque: added = renderer.AddBlit(spr.Image.get(), spr.X, spr.Y, false); break;
+        case TestSprite::kMasked: added = renderer.AddBlit(spr.Image.get(), spr.X, spr.Y, true); break;
+        case TestSprite::kTint: added = renderer.AddBlend(surface, 0, 0, true, 128); break;
+        default: added = renderer.AddBlend(spr.Image.get(), spr.X, spr.Y, false, 0); break;
+        }
+        ASSERT_TRUE(added);
+    }
+    renderer.Render();
+}
+
+// Compares band rendering with the sprites drawn one by one, with various
+// number of threads, and with a clipping rect set on the surface
+TEST(BandRenderer, MatchesSerialDrawing) {
+    const int width = 320, height = 200;
+    std::mt19937 rng(4321);
+    std::unique_ptr<Bitmap> init(BitmapHelper::CreateBitmap(width, height, 32));
+    std::unique_ptr<Bitmap> ref(BitmapHelper::CreateBitmap(width, height, 32));
+    std::unique_ptr<Bitmap> bands(BitmapHelper::CreateBitmap(width, height, 32));
+    FillRandom(init.get(), rng);
+    // big sprites, so that there's enough pixels to use the threads
+    const auto scene = MakeScene(width, height, 40, 120, rng);
+    const Rect clips[] = { RectWH(0, 0, width, height), Rect(13, 7, 300, 190) };
+    const int thread_counts[] = { 1, 2, 3, 4, 7 };
+    Bitmap::SetBlendBltHandler(nullptr);
+    BandRenderer renderer;
+    for (const auto &clip : clips)
+    {
+        ref->Blit(init.get());
+        ref->SetClip(clip);
+        DrawReference(ref.get(), scene);
+        for (int threads : thread_counts)
+        {
+            renderer.SetThreadCount(threads);
+            bands->Blit(init.get());
+            bands->SetClip(clip);
+            DrawBands(renderer, bands.get(), scene);
+            ASSERT_TRUE(SameBitmaps(ref.get(), bands.get())) << threads << " threads, clip "
+                << clip.Left << "," << clip.Top << "," << clip.Right << "," << clip.Bottom;
+        }
+    }
+}
+
+TEST(BandRenderer, Unsupported) {
+    std::unique_ptr<Bitmap> surface(BitmapHelper::CreateBitmap(64, 64, 32));
+    std::unique_ptr<Bitmap> sprite16(BitmapHelper::CreateBitmap(8, 8, 16));
+    std::unique_ptr<Bitmap> sprite32(BitmapHelper::CreateBitmap(8, 8, 32));
+    std::unique_ptr<Bitmap> sub(BitmapHelper::CreateSubBitmap(surface.get(), RectWH(0, 0, 8, 8)));
+    BandRenderer renderer;
+    renderer.SetThreadCount(4);
+    ASSERT_TRUE(renderer.IsEnabledFor(surface.get()));
+    ASSERT_FALSE(renderer.IsEnabledFor(sprite16.get()));
+    renderer.Begin(surface.get());
+    ASSERT_FALSE(renderer.AddBlit(sprite16.get(), 0, 0, false));
+    ASSERT_FALSE(renderer.AddBlit(sub.get(), 0, 0, false));
+    ASSERT_FALSE(renderer.AddBlend(surface.get(), 1, 0, true, 128));
+    set_blender_mode(nullptr, nullptr, _myblender_color16, 0, 0, 0, 0);
+    ASSERT_FALSE(renderer.AddBlend(sprite32.get(), 0, 0, false, 0));
+    renderer.Reset();
+    renderer.SetThreadCount(0);
+    ASSERT_FALSE(renderer.IsEnabledFor(surface.get()));
+}
+
+// Measures drawing of a busy 1080p scene, like a room with a number
+// of large characters and a translucent GUI
+TEST(BandRenderer, DISABLED_Benchmark) {
+    const int width = 1920, height = 1080, frames = 5;
+    std::mt19937 rng(1);
+    std::unique_ptr<Bitmap> surface(BitmapHelper::CreateBitmap(width, height, 32));
+    FillRandom(surface.get(), rng);
+    const auto scene = MakeScene(width, height, 60, 400, rng);
+    init_blenders();
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < frames; ++i)
+        DrawReference(surface.get(), scene);
+    printf("BandRenderer: %dx%d, %d sprites; serial %.2f ms", width, height,
+        static_cast<int>(scene.size()), msec(Clock::now() - t0).count() / frames);
+    BandRenderer renderer;
+    for (int threads : { 2, 4, 8 })
+    {
+        renderer.SetThreadCount(threads);
+        t0 = Clock::now();
+        for (int i = 0; i < frames; ++i)
+            DrawBands(renderer, surface.get(), scene);
+        printf(", %d threads %.2f ms", threads, msec(Clock::now() - t0).count() / frames);
+    }
+    printf("\n");
+    Bitmap::SetBlendBltHandler(nullptr);
+}
@@ -0,0 +1,185 @@
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include "gtest/gtest.h"
+#include "gfx/allegrobitmap.h"
+#include "gfx/blender.h"
+
+using namespace AGS::Common;
+
+extern "C" {
+    uint32_t _blender_trans24(uint32_t x, uint32_t y, uint32_t n);
+    uint32_t _blender_alpha32(uint32_t x, uint32_t y, uint32_t n);
+}
+
+static const BlenderRowImpl AllRowImpls[] =
+    { kBlenderRow_Generic, kBlenderRow_SSE2, kBlenderRow_AVX2, kBlenderRow_NEON };
+
+// Fills bitmap with random pixels, including the edge alpha values and mask color
+static void FillRandom(Bitmap *bmp, std::mt19937 &rng)
+{
+    static const uint32_t alphas[] = { 0x00, 0x01, 0x7F, 0x80, 0xFE, 0xFF };
+    for (int y = 0; y < bmp->GetHeight(); ++y)
+    {
+        uint32_t *line = reinterpret_cast<uint32_t*>(bmp->GetScanLineForWriting(y));
+        for (int x = 0; x < bmp->GetWidth(); ++x)
+        {
+            uint32_t c = rng();
+            switch (rng() % 8)
+            {
+            case 0: c = MASK_COLOR_32; break;
+            case 1: c = (c & 0x00FFFFFF) | (alphas[rng() % 6] << 24); break;
+            default: break;
+            }
+            line[x] = c;
+        }
+    }
+}
+
+static bool SameBitmaps(Bitmap *a, Bitmap *b)
+{
+    for (int y = 0; y < a->GetHeight(); ++y)
+    {
+        if (memcmp(a->GetScanLine(y), b->GetScanLine(y), a->GetLineLength()) != 0)
+            return false;
+    }
+    return true;
+}
+
+struct BlenderTestCase
+{
+    const char *Name;
+    BLENDER_FUNC Blender;
+    bool Lit;
+    int Alpha;
+};
+
+static const BlenderTestCase BlenderCases[] = {
+    { "trans24", _blender_trans24, false, 0 },
+    { "trans24", _blender_trans24, false, 100 },
+    { "trans24", _blender_trans24, false, 255 },
+    { "alpha_trans24", _myblender_alpha_trans24, false, 180 },
+    { "alpha32", _blender_alpha32, false, 0 },
+    { "trans_alpha32", _trans_alpha_blender32, false, 77 },
+    { "trans_alpha32", _trans_alpha_blender32, false, 255 },
+    { "argb2argb", _argb2argb_blender, false, 0 },
+    { "argb2argb", _argb2argb_blender, false, 1 },
+    { "argb2argb", _argb2argb_blender, false, 128 },
+    { "argb2argb", _argb2argb_blender, false, 255 },
+    { "argb2rgb", _argb2rgb_blender, false, 0 },
+    { "argb2rgb", _argb2rgb_blender, false, 200 },
+    { "rgb2argb", _rgb2argb_blender, false, 0 },
+    { "rgb2argb", _rgb2argb_blender, false, 64 },
+    { "rgb2argb", _rgb2argb_blender, false, 255 },
+    { "opaque_alpha", _opaque_alpha_blender, false, 0 },
+    { "additive_alpha", _additive_alpha_copysrc_blender, false, 0 },
+    { "lit trans24", _blender_trans24, true, 0 },
+    { "lit trans24", _blender_trans24, true, 128 },
+    { "lit alpha_trans24", _myblender_alpha_trans24, true, 90 },
+    { "lit color32", _myblender_color32, true, 0 },
+    { "lit color32_light", _myblender_color32_light, true, 0 },
+    { "lit color32_light", _myblender_color32_light, true, 200 },
+};
+
+// Blends using allegro's per-pixel blending
+static void BlendReference(Bitmap *dst, Bitmap *src, int x, int y, bool lit, int alpha)
+{
+    Bitmap::SetBlendBltHandler(nullptr);
+    if (lit)
+        dst->LitBlendBlt(src, x, y, alpha);
+    else
+        dst->TransBlendBlt(src, x, y);
+}
+
+// Blends using the row blenders
+static void BlendRows(Bitmap *dst, Bitmap *src, int x, int y, bool lit, int alpha)
+{
+    Bitmap::SetBlendBltHandler(blend_sprite32);
+    if (lit)
+        dst->LitBlendBlt(src, x, y, alpha);
+    else
+        dst->TransBlendBlt(src, x, y);
+    Bitmap::SetBlendBltHandler(nullptr);
+}
+
+// Compares the row blenders of every supported instruction set with the
+// per-pixel blenders; includes clipped sprites and the odd widths which
+// leave a tail of pixels for the generic blenders
+TEST(Blender, RowsMatchPerPixel) {
+    std::mt19937 rng(12345);
+    const int positions[][2] = { { 0, 0 }, { 5, 3 }, { -7, -2 }, { 50, 30 }, { -1, 40 } };
+    std::unique_ptr<Bitmap> src(BitmapHelper::CreateBitmap(61, 37, 32));
+    std::unique_ptr<Bitmap> dst_init(BitmapHelper::CreateBitmap(83, 53, 32));
+    std::unique_ptr<Bitmap> dst_ref(BitmapHelper::CreateBitmap(83, 53, 32));
+    std::unique_ptr<Bitmap> dst_rows(BitmapHelper::CreateBitmap(83, 53, 32));
+    FillRandom(src.get(), rng);
+    FillRandom(dst_init.get(), rng);
+    int tested_impls = 0;
+    for (auto impl : AllRowImpls)
+    {
+        if (!set_blender_row_impl(impl))
+            continue;
+        tested_impls++;
+        for (const auto &tc : BlenderCases)
+        {
+            for (const auto &pos : positions)
+            {
+                set_blender_mode(nullptr, nullptr, tc.Blender, 40, 150, 220, tc.Lit ? 0 : tc.Alpha);
+                dst_ref->Blit(dst_init.get());
+                dst_rows->Blit(dst_init.get());
+                BlendReference(dst_ref.get(), src.get(), pos[0], pos[1], tc.Lit, tc.Alpha);
+                BlendRows(dst_rows.get(), src.get(), pos[0], pos[1], tc.Lit, tc.Alpha);
+                ASSERT_TRUE(SameBitmaps(dst_ref.get(), dst_rows.get()))
+                    << get_blender_row_impl_name(impl) << ": " << tc.Name << ", alpha " << tc.Alpha
+                    << ", at " << pos[0] << "," << pos[1];
+            }
+        }
+    }
+    init_blenders();
+    Bitmap::SetBlendBltHandler(nullptr);
+    // the generic implementation is always supported
+    ASSERT_GT(tested_impls, 0);
+}
+
+// Measures blending of a full-screen alpha sprite, as done by the software
+// renderer for a GUI covering the whole screen
+TEST(Blender, DISABLED_Benchmark) {
+    const int width = 1920, height = 1080, frames = 10;
+    std::mt19937 rng(1);
+    std::unique_ptr<Bitmap> src(BitmapHelper::CreateBitmap(width, height, 32));
+    std::unique_ptr<Bitmap> dst(BitmapHelper::CreateBitmap(width, height, 32));
+    FillRandom(src.get(), rng);
+    FillRandom(dst.get(), rng);
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+
+    set_argb2any_blender();
+    auto t0 = Clock::now();
+    for (int i = 0; i < frames; ++i)
+        BlendReference(dst.get(), src.get(), 0, 0, false, 0);
+    const double per_pixel = msec(Clock::now() - t0).count() / frames;
+    printf("Blender: %dx%d argb2argb, per-pixel %.2f ms", width, height, per_pixel);
+    for (auto impl : AllRowImpls)
+    {
+        if (!set_blender_row_impl(impl))
+            continue;
+        t0 = Clock::now();
+        for (int i = 0; i < frames; ++i)
+            BlendRows(dst.get(), src.get(), 0, 0, false, 0);
+        printf(", %s %.2f ms", get_blender_row_impl_name(impl), msec(Clock::now() - t0).count() / frames);
+    }
+    printf("\n");
+
+    set_blender_mode(nullptr, nullptr, _myblender_color32, 40, 150, 220, 0);
+    t0 = Clock::now();
+    BlendReference(dst.get(), src.get(), 0, 0, true, 0);
+    const double lit_per_pixel = msec(Clock::now() - t0).count();
+    t0 = Clock::now();
+    BlendRows(dst.get(), src.get(), 0, 0, true, 0);
+    printf("Blender: %dx%d color tint, per-pixel %.2f ms, rows %.2f ms\n",
+        width, height, lit_per_pixel, msec(Clock::now() - t0).count());
+    init_blenders();
+    Bitmap::SetBlendBltHandler(nullptr);
+}
@@ -0,0 +1,372 @@
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "script/cc_common.h"
+#include "script/cc_instance.h"
+#include "script/script_runtime.h"
+
+// Helps to assemble script's bytecode by hand
+struct ScriptAssembler
+{
+    std::vector<int32_t> Code;
+    std::vector<int32_t> Fixups;
+    std::vector<char> FixupTypes;
+
+    int32_t Pos() const { return static_cast<int32_t>(Code.size()); }
+
+    void Op(int32_t cmd) { Code.push_back(cmd); }
+    void Op(int32_t cmd, int32_t arg1) { Code.push_back(cmd); Code.push_back(arg1); }
+    void Op(int32_t cmd, int32_t arg1, int32_t arg2)
+    {
+        Code.push_back(cmd); Code.push_back(arg1); Code.push_back(arg2);
+    }
+    // Puts literal with a fixup to the register
+    void LitWithFixup(int32_t reg, int32_t value, char fixup)
+    {
+        Op(SCMD_LITTOREG, reg, value);
+        Fixups.push_back(Pos() - 1);
+        FixupTypes.push_back(fixup);
+    }
+    // Puts jump instruction, returns position of the offset argument
+    int32_t Jump(int32_t cmd, int32_t target = 0)
+    {
+        Op(cmd, target - (Pos() + 2));
+        return Pos() - 1;
+    }
+    void SetJumpTarget(int32_t arg_pos, int32_t target)
+    {
+        Code[arg_pos] = target - (arg_pos + 1);
+    }
+};
+
+static char *CopyStr(const char *str)
+{
+    char *copy = (char*)malloc(strlen(str) + 1);
+    strcpy(copy, str);
+    return copy;
+}
+
+static PScript CreateScript(const ScriptAssembler &as, int32_t globaldatasize, const char *export_name);
+
+// Makes a script with a single exported function:
+//
+//   import int BenchExt(int);
+//   int data[100];
+//   int sum;
+//   export int bench(int n)
+//   {
+//       for (int i = 0; i < n; i++)
+//       {
+//           data[i % 100] += i * 3 + 1;
+//           if (i % 10 == 0)
+//               sum += BenchExt(i);
+//       }
+//       return sum;
+//   }
+static PScript CreateBenchScript()
+{
+    const int32_t data_addr = 0, sum_addr = 400;
+    ScriptAssembler as;
+    // int i = 0
+    as.Op(SCMD_LITTOREG, SREG_AX, 0);
+    as.Op(SCMD_PUSHREG, SREG_AX);
+    // i < n
+    const int32_t loop_start = as.Pos();
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LOADSPOFFS, 12);
+    as.Op(SCMD_MEMREAD, SREG_BX);
+    as.Op(SCMD_LESSTHAN, SREG_AX, SREG_BX);
+    const int32_t jump_end = as.Jump(SCMD_JZ);
+    // data[i % 100] += i * 3 + 1
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_REGTOREG, SREG_AX, SREG_CX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 100);
+    as.Op(SCMD_MODREG, SREG_AX, SREG_BX);
+    as.Op(SCMD_MUL, SREG_AX, sizeof(int32_t));
+    as.LitWithFixup(SREG_MAR, data_addr, FIXUP_GLOBALDATA);
+    as.Op(SCMD_ADDREG, SREG_MAR, SREG_AX);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_MUL, SREG_CX, 3);
+    as.Op(SCMD_ADD, SREG_CX, 1);
+    as.Op(SCMD_ADDREG, SREG_AX, SREG_CX);
+    as.Op(SCMD_MEMWRITE, SREG_AX);
+    // if (i % 10 == 0)
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 10);
+    as.Op(SCMD_MODREG, SREG_AX, SREG_BX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 0);
+    as.Op(SCMD_ISEQUAL, SREG_AX, SREG_BX);
+    const int32_t jump_next = as.Jump(SCMD_JZ);
+    // sum += BenchExt(i)
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_PUSHREAL, SREG_AX);
+    as.Op(SCMD_NUMFUNCARGS, 1);
+    as.LitWithFixup(SREG_AX, 0, FIXUP_IMPORT);
+    as.Op(SCMD_CALLEXT, SREG_AX);
+    as.Op(SCMD_SUBREALSTACK, 1);
+    as.Op(SCMD_REGTOREG, SREG_AX, SREG_BX);
+    as.LitWithFixup(SREG_MAR, sum_addr, FIXUP_GLOBALDATA);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_ADDREG, SREG_AX, SREG_BX);
+    as.Op(SCMD_MEMWRITE, SREG_AX);
+    // i++
+    as.SetJumpTarget(jump_next, as.Pos());
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_ADD, SREG_AX, 1);
+    as.Op(SCMD_MEMWRITE, SREG_AX);
+    as.Jump(SCMD_JMP, loop_start);
+    // return sum
+    as.SetJumpTarget(jump_end, as.Pos());
+    as.Op(SCMD_POPREG, SREG_BX);
+    as.LitWithFixup(SREG_MAR, sum_addr, FIXUP_GLOBALDATA);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_RET);
+
+    PScript scri = CreateScript(as, sum_addr + sizeof(int32_t), "bench$1");
+    scri->numimports = 1;
+    scri->imports = (char**)malloc(sizeof(char*));
+    scri->imports[0] = CopyStr("BenchExt");
+    return scri;
+}
+
+// Makes a script of the assembled code, with a single exported function at its start
+static PScript CreateScript(const ScriptAssembler &as, int32_t globaldatasize, const char *export_name)
+{
+    PScript scri(new ccScript());
+    scri->globaldatasize = globaldatasize;
+    scri->globaldata = (char*)calloc(scri->globaldatasize, 1);
+    scri->codesize = as.Pos();
+    scri->code = (int32_t*)malloc(as.Code.size() * sizeof(int32_t));
+    memcpy(scri->code, as.Code.data(), as.Code.size() * sizeof(int32_t));
+    scri->numfixups = static_cast<int>(as.Fixups.size());
+    scri->fixups = (int32_t*)malloc(as.Fixups.size() * sizeof(int32_t));
+    memcpy(scri->fixups, as.Fixups.data(), as.Fixups.size() * sizeof(int32_t));
+    scri->fixuptypes = (char*)malloc(as.FixupTypes.size());
+    memcpy(scri->fixuptypes, as.FixupTypes.data(), as.FixupTypes.size());
+    scri->numexports = 1;
+    scri->exports = (char**)malloc(sizeof(char*));
+    scri->exports[0] = CopyStr(export_name);
+    scri->export_addr = (int32_t*)malloc(sizeof(int32_t));
+    scri->export_addr[0] = (EXPORT_FUNCTION << 24) | 0;
+    return scri;
+}
+
+static RuntimeScriptValue Sc_BenchExt(const RuntimeScriptValue *params, int32_t param_count)
+{
+    return RuntimeScriptValue().SetInt32(params[0].IValue / 10 + 1);
+}
+
+// Runs the script function, compares the results with the same
+// algorithm in C++, and measures the average time per loop iteration
+static void RunBenchScript(int iterations, double &ns_per_iteration)
+{
+    ccAddExternalStaticFunction("BenchExt", Sc_BenchExt);
+    PScript scri = CreateBenchScript();
+    std::unique_ptr<ccInstance> inst(ccInstance::CreateFromScript(scri));
+    ASSERT_TRUE(inst != nullptr);
+    ASSERT_TRUE(inst->ResolveScriptImports(scri.get()));
+    ASSERT_TRUE(inst->ResolveImportFixups(scri.get()));
+
+    int32_t data[100] = {};
+    int32_t sum = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        data[i % 100] += i * 3 + 1;
+        if (i % 10 == 0)
+            sum += i / 10 + 1;
+    }
+
+    RuntimeScriptValue params[1];
+    params[0].SetInt32(iterations);
+    typedef std::chrono::high_resolution_clock Clock;
+    auto t0 = Clock::now();
+    ASSERT_EQ(inst->CallScriptFunction("bench", 1, params), 0);
+    auto t1 = Clock::now();
+    ASSERT_EQ(inst->returnValue, sum);
+    ASSERT_EQ(memcmp(inst->globaldata, data, sizeof(data)), 0);
+
+    std::chrono::duration<double, std::nano> dur = t1 - t0;
+    ns_per_iteration = dur.count() / iterations;
+    inst.reset();
+    ccRemoveExternalSymbol("BenchExt");
+}
+
+TEST(ScriptVM, Loop) {
+    double ns_per_iteration;
+    RunBenchScript(1000, ns_per_iteration);
+}
+
+TEST(ScriptVM, DISABLED_Benchmark) {
+    const int iterations = 1000000;
+    double ns_per_iteration;
+    RunBenchScript(iterations, ns_per_iteration);
+    printf("ScriptVM: %d loop iterations, %.2f ns/iteration\n",
+        iterations, ns_per_iteration);
+}
+
+// Jumps into the middle of an operation's arguments; the code at that
+// position was not decoded at load time, and is read when executed:
+//
+//   0: jmp 4
+//   2: littoreg bx, (6: littoreg)
+//   4:           littoreg ax, 42
+//   7: ret
+TEST(ScriptVM, JumpToUndecoded) {
+    ScriptAssembler as;
+    const int32_t jump = as.Jump(SCMD_JMP);
+    as.Op(SCMD_LITTOREG, SREG_BX, SCMD_LITTOREG);
+    as.SetJumpTarget(jump, as.Pos() - 1);
+    as.Code.push_back(SREG_AX);
+    as.Code.push_back(42);
+    as.Op(SCMD_RET);
+    PScript scri = CreateScript(as, 0, "jump$0");
+    std::unique_ptr<ccInstance> inst(ccInstance::CreateFromScript(scri));
+    ASSERT_TRUE(inst != nullptr);
+    ASSERT_EQ(inst->CallScriptFunction("jump", 0, nullptr), 0);
+    ASSERT_EQ(inst->returnValue, 42);
+}
+
+// Makes a script with integer math, in the way the compiler generates it:
+//
+//   export int mix(int n)
+//   {
+//       int acc = 0;
+//       for (int i = 0; i < n; i++)
+//       {
+//           acc = (acc * 31 + (i ^ 7) * (i & 15)) % 65521;
+//           if (acc > 30000 && i != 5)
+//               acc = acc - 1000;
+//       }
+//       return acc;
+//   }
+static PScript CreateMathScript()
+{
+    ScriptAssembler as;
+    // int acc = 0, i = 0
+    as.Op(SCMD_LITTOREG, SREG_AX, 0);
+    as.Op(SCMD_PUSHREG, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_AX, 0);
+    as.Op(SCMD_PUSHREG, SREG_AX);
+    // i < n
+    const int32_t loop_start = as.Pos();
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LOADSPOFFS, 16);
+    as.Op(SCMD_MEMREAD, SREG_BX);
+    as.Op(SCMD_LESSTHAN, SREG_AX, SREG_BX);
+    const int32_t jump_end = as.Jump(SCMD_JZ);
+    // acc = (acc * 31 + (i ^ 7) * (i & 15)) % 65521
+    as.Op(SCMD_LOADSPOFFS, 8);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 31);
+    as.Op(SCMD_MULREG, SREG_AX, SREG_BX);
+    as.Op(SCMD_PUSHREG, SREG_AX);
+    as.Op(SCMD_LOADSPOFFS, 8);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 7);
+    as.Op(SCMD_XORREG, SREG_AX, SREG_BX);
+    as.Op(SCMD_PUSHREG, SREG_AX);
+    as.Op(SCMD_LOADSPOFFS, 12);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 15);
+    as.Op(SCMD_BITAND, SREG_AX, SREG_BX);
+    as.Op(SCMD_POPREG, SREG_BX);
+    as.Op(SCMD_MULREG, SREG_BX, SREG_AX);
+    as.Op(SCMD_REGTOREG, SREG_BX, SREG_AX);
+    as.Op(SCMD_POPREG, SREG_BX);
+    as.Op(SCMD_ADDREG, SREG_BX, SREG_AX);
+    as.Op(SCMD_REGTOREG, SREG_BX, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 65521);
+    as.Op(SCMD_MODREG, SREG_AX, SREG_BX);
+    as.Op(SCMD_LOADSPOFFS, 8);
+    as.Op(SCMD_MEMWRITE, SREG_AX);
+    // if (acc > 30000 && i != 5)
+    as.Op(SCMD_LOADSPOFFS, 8);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 30000);
+    as.Op(SCMD_GREATER, SREG_AX, SREG_BX);
+    const int32_t jump_skip1 = as.Jump(SCMD_JZ);
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 5);
+    as.Op(SCMD_NOTEQUAL, SREG_AX, SREG_BX);
+    const int32_t jump_skip2 = as.Jump(SCMD_JZ);
+    // acc = acc - 1000
+    as.Op(SCMD_LOADSPOFFS, 8);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_LITTOREG, SREG_BX, 1000);
+    as.Op(SCMD_SUBREG, SREG_AX, SREG_BX);
+    as.Op(SCMD_MEMWRITE, SREG_AX);
+    // i++
+    as.SetJumpTarget(jump_skip1, as.Pos());
+    as.SetJumpTarget(jump_skip2, as.Pos());
+    as.Op(SCMD_LOADSPOFFS, 4);
+    as.Op(SCMD_MEMREAD, SREG_AX);
+    as.Op(SCMD_ADD, SREG_AX, 1);
+    as.Op(SCMD_MEMWRITE, SREG_AX);
+    as.Jump(SCMD_JMP, loop_start);
+    // return acc
+    as.SetJumpTarget(jump_end, as.Pos());
+    as.Op(SCMD_POPREG, SREG_BX);
+    as.Op(SCMD_POPREG, SREG_AX);
+    as.Op(SCMD_RET);
+    return CreateScript(as, sizeof(int32_t), "mix$1");
+}
+
+// Runs the script with the typed operations, and with them replaced by the
+// regular ones, compares the results with the same algorithm in C++, and
+// measures the average time per loop iteration
+TEST(ScriptVM, TypedOperations) {
+    const int iterations = 1000000;
+    PScript scri = CreateMathScript();
+    std::unique_ptr<ccInstance> inst(ccInstance::CreateFromScript(scri));
+    ASSERT_TRUE(inst != nullptr);
+    ASSERT_TRUE(inst->ResolveScriptImports(scri.get()));
+    ASSERT_TRUE(inst->ResolveImportFixups(scri.get()));
+
+    int acc = 0;
+    for (int i = 0; i < iterations; i++)
+    {
+        acc = (acc * 31 + (i ^ 7) * (i & 15)) % 65521;
+        if (acc > 30000 && i != 5)
+            acc = acc - 1000;
+    }
+
+    std::vector<ScriptOperation> &ops = inst->decoded_code->Ops;
+    int op_count = 0, typed_count = 0;
+    for (const auto &op : ops)
+    {
+        op_count += (op.Instruction.Code >= 0) ? 1 : 0;
+        typed_count += (op.ExecCode >= CC_NUM_SCCMDS) ? 1 : 0;
+    }
+    ASSERT_GT(typed_count, 0);
+
+    RuntimeScriptValue params[1];
+    params[0].SetInt32(iterations);
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::nano> nsec;
+    auto t0 = Clock::now();
+    ASSERT_EQ(inst->CallScriptFunction("mix", 1, params), 0);
+    const double typed_time = nsec(Clock::now() - t0).count();
+    ASSERT_EQ(inst->returnValue, acc);
+
+    for (auto &op : ops)
+        op.ExecCode = op.Instruction.Code;
+    t0 = Clock::now();
+    ASSERT_EQ(inst->CallScriptFunction("mix", 1, params), 0);
+    const double regular_time = nsec(Clock::now() - t0).count();
+    ASSERT_EQ(inst->returnValue, acc);
+
+    printf("ScriptVM: %d loop iterations, %d of %d operations typed; typed %.2f ns/iteration, regular %.2f ns/iteration\n",
+        iterations, typed_count, op_count,
+        typed_time / iterations, regular_time / iterations);
+}
@@ -0,0 +1,253 @@
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ac/character.h"
+#include "ac/draw.h"
+#include "ac/gamesetupstruct.h"
+#include "ac/global_object.h"
+#include "ac/object.h"
+#include "ac/roomobject.h"
+#include "ac/roomstatus.h"
+#include "ac/spritecache.h"
+#include "ac/view.h"
+#include "gfx/bitmap.h"
+
+using namespace AGS::Common;
+
+extern GameSetupStruct game;
+extern std::vector<ViewStruct> views;
+extern std::vector<CharacterExtras> charextra;
+extern SpriteCache spriteset;
+extern RoomObject *objs;
+extern RoomStatus *croom;
+extern int displayed_room;
+extern int char_lowest_yp, obj_lowest_yp;
+
+static const int TestRoom = 5;
+static const int NumChars = 6;
+static const int NumObjs = 4;
+// Sprites: one fully opaque, and one with the transparent left half
+static const int SolidSprite = 1;
+static const int HalfSprite = 2;
+static const int SpriteSize = 10;
+// View frames: the solid sprite, the half-transparent one, and the latter mirrored
+static const int SolidFrame = 0;
+static const int HalfFrame = 1;
+static const int FlippedFrame = 2;
+
+static Bitmap *MakeSprite(bool half_transparent)
+{
+    Bitmap *bmp = BitmapHelper::CreateBitmap(SpriteSize, SpriteSize, 32);
+    bmp->Clear(0x00FF00);
+    if (half_transparent)
+        bmp->FillRect(Rect(0, 0, SpriteSize / 2 - 1, SpriteSize - 1), bmp->GetMaskColor());
+    return bmp;
+}
+
+class HitTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        game.options[OPT_PIXPERFECT] = 1;
+        spriteset.SetSprite(SolidSprite, std::unique_ptr<Bitmap>(MakeSprite(false)));
+        spriteset.SetSprite(HalfSprite, std::unique_ptr<Bitmap>(MakeSprite(true)));
+        views.resize(1);
+        views[0].Initialize(1);
+        views[0].loops[0].Initialize(3);
+        views[0].loops[0].frames[SolidFrame].pic = SolidSprite;
+        views[0].loops[0].frames[HalfFrame].pic = HalfSprite;
+        views[0].loops[0].frames[FlippedFrame].pic = HalfSprite;
+        views[0].loops[0].frames[FlippedFrame].flags = VFLG_FLIPSPRITE;
+
+        // all the characters stand at the same place, at (50,100),
+        // covering the room rectangle (45,90)-(55,100)
+        game.numcharacters = NumChars;
+        game.chars.resize(NumChars);
+        charextra.resize(NumChars);
+        for (int i = 0; i < NumChars; ++i)
+        {
+            CharacterInfo &chin = game.chars[i];
+            chin = CharacterInfo();
+            chin.room = TestRoom;
+            chin.on = 1;
+            chin.x = 50;
+            chin.y = 100;
+        }
+        displayed_room = TestRoom;
+        invalidate_room_characters();
+
+        // all the objects are at (45,100), covering the same rectangle
+        roomobjs.resize(NumObjs);
+        for (auto &obj : roomobjs)
+        {
+            obj.on = 1;
+            obj.x = 45;
+            obj.y = 100;
+            obj.num = SolidSprite;
+            obj.view = RoomObject::NoView;
+        }
+        room.reset(new RoomStatus());
+        room->numobj = NumObjs;
+        croom = room.get();
+        objs = roomobjs.data();
+        // no cached images, the hit tests should use the sprites
+        init_game_drawdata();
+    }
+
+    void TearDown() override {
+        dispose_game_drawdata();
+        objs = nullptr;
+        croom = nullptr;
+        room.reset();
+        roomobjs.clear();
+        displayed_room = -10;
+        invalidate_room_characters();
+        charextra.clear();
+        game.chars.clear();
+        game.numcharacters = 0;
+        views.clear();
+        spriteset.DisposeSprite(HalfSprite);
+        spriteset.DisposeSprite(SolidSprite);
+        game.options[OPT_PIXPERFECT] = 0;
+    }
+
+    std::unique_ptr<RoomStatus> room;
+    std::vector<RoomObject> roomobjs;
+};
+
+TEST(HitCandidates, Sort) {
+    std::vector<SpriteHitCandidate> candidates;
+    const int baselines[] = { 10, 30, 20, 30, -1, 0, 20 };
+    for (int i = 0; i < 7; ++i)
+    {
+        SpriteHitCandidate c = {};
+        c.Id = i;
+        c.Baseline = baselines[i];
+        candidates.push_back(c);
+    }
+    sort_hit_candidates(candidates);
+    // higher baseline first, and the later of the ones with equal baseline
+    const int expect_ids[] = { 3, 1, 6, 2, 0, 5, 4 };
+    ASSERT_EQ(candidates.size(), 7u);
+    for (int i = 0; i < 7; ++i)
+        ASSERT_EQ(candidates[i].Id, expect_ids[i]) << "at " << i;
+}
+
+TEST_F(HitTest, Character) {
+    char_lowest_yp = 77;
+    // the later one wins when the baselines are equal
+    ASSERT_EQ(is_pos_on_character(52, 95), NumChars - 1);
+    ASSERT_EQ(char_lowest_yp, 100);
+    // then the one with the highest baseline
+    game.chars[2].baseline = 120;
+    ASSERT_EQ(is_pos_on_character(52, 95), 2);
+    ASSERT_EQ(char_lowest_yp, 120);
+    // ...unless the position is on its transparent pixel
+    game.chars[2].frame = HalfFrame;
+    ASSERT_EQ(is_pos_on_character(48, 95), NumChars - 1);
+    ASSERT_EQ(is_pos_on_character(52, 95), 2);
+    game.chars[2].frame = FlippedFrame;
+    ASSERT_EQ(is_pos_on_character(48, 95), 2);
+    ASSERT_EQ(is_pos_on_character(52, 95), NumChars - 1);
+    game.chars[2].frame = SolidFrame;
+    // ...or the position is outside of its bounding box,
+    // including one which size differs from the sprite's
+    game.chars[2].x = 70;
+    ASSERT_EQ(is_pos_on_character(52, 95), NumChars - 1);
+    game.chars[2].x = 50;
+    charextra[2].width = 4;
+    charextra[2].height = 4;
+    ASSERT_EQ(is_pos_on_character(51, 97), 2);
+    ASSERT_EQ(is_pos_on_character(53, 95), NumChars - 1);
+    charextra[2].width = 0;
+    charextra[2].height = 0;
+    ASSERT_EQ(is_pos_on_character(52, 95), 2);
+
+    // characters which are not in the room, or disabled, are skipped
+    game.chars[NumChars - 1].on = 0;
+    game.chars[NumChars - 2].room = TestRoom + 1;
+    game.chars[NumChars - 3].flags |= CHF_NOINTERACT;
+    game.chars[2].baseline = 0;
+    invalidate_room_characters();
+    ASSERT_EQ(is_pos_on_character(52, 95), 2);
+
+    // nothing hit
+    char_lowest_yp = 77;
+    ASSERT_EQ(is_pos_on_character(10, 10), -1);
+    ASSERT_EQ(char_lowest_yp, 0);
+    ASSERT_EQ(is_pos_on_character(56, 95), -1);
+    ASSERT_EQ(char_lowest_yp, 0);
+}
+
+TEST_F(HitTest, CharacterNegativeBaseline) {
+    // character which is drawn at (45,5)-(55,15), but has the baseline at -5
+    game.chars[0].y = -5;
+    game.chars[0].z = -20;
+    ASSERT_EQ(is_pos_on_character(50, 10), -1);
+    ASSERT_EQ(char_lowest_yp, 0);
+    // zero baseline is fine
+    game.chars[0].y = 0;
+    game.chars[0].z = -15;
+    ASSERT_EQ(is_pos_on_character(50, 10), 0);
+    ASSERT_EQ(char_lowest_yp, 0);
+    game.chars[0].y = -5;
+    game.chars[0].z = -20;
+    game.chars[0].baseline = 1;
+    ASSERT_EQ(is_pos_on_character(50, 10), 0);
+    ASSERT_EQ(char_lowest_yp, 1);
+}
+
+TEST_F(HitTest, Object) {
+    obj_lowest_yp = 77;
+    // the later one wins when the baselines are equal
+    ASSERT_EQ(GetObjectIDAtRoom(52, 95), NumObjs - 1);
+    ASSERT_EQ(obj_lowest_yp, 100);
+    // then the one with the highest baseline
+    roomobjs[1].baseline = 120;
+    ASSERT_EQ(GetObjectIDAtRoom(52, 95), 1);
+    ASSERT_EQ(obj_lowest_yp, 120);
+    // ...unless the position is on its transparent pixel
+    roomobjs[1].num = HalfSprite;
+    ASSERT_EQ(GetObjectIDAtRoom(47, 95), NumObjs - 1);
+    ASSERT_EQ(GetObjectIDAtRoom(52, 95), 1);
+    roomobjs[1].num = SolidSprite;
+    // ...or the position is outside of its bounding box
+    roomobjs[1].x = 70;
+    ASSERT_EQ(GetObjectIDAtRoom(52, 95), NumObjs - 1);
+    roomobjs[1].x = 45;
+    roomobjs[1].last_width = 4;
+    roomobjs[1].last_height = 4;
+    ASSERT_EQ(GetObjectIDAtRoom(47, 97), 1);
+    ASSERT_EQ(GetObjectIDAtRoom(47, 95), NumObjs - 1);
+    roomobjs[1].last_width = 0;
+    roomobjs[1].last_height = 0;
+
+    // objects which are disabled are skipped
+    roomobjs[NumObjs - 1].on = 0;
+    roomobjs[NumObjs - 2].flags |= OBJF_NOINTERACT;
+    roomobjs[1].baseline = 0;
+    ASSERT_EQ(GetObjectIDAtRoom(52, 95), 1);
+
+    // nothing hit
+    obj_lowest_yp = 77;
+    ASSERT_EQ(GetObjectIDAtRoom(10, 10), -1);
+    ASSERT_EQ(obj_lowest_yp, -1);
+    ASSERT_EQ(GetObjectIDAtRoom(56, 95), -1);
+    ASSERT_EQ(obj_lowest_yp, -1);
+}
+
+TEST_F(HitTest, ObjectNegativeBaseline) {
+    // object at (45,-11)-(55,-1) has the baseline at -1, and is selected
+    roomobjs[0].y = -1;
+    ASSERT_EQ(GetObjectIDAtRoom(50, -5), 0);
+    ASSERT_EQ(obj_lowest_yp, -1);
+    // object with even lower baseline is not
+    roomobjs[0].y = -2;
+    obj_lowest_yp = 77;
+    ASSERT_EQ(GetObjectIDAtRoom(50, -5), -1);
+    ASSERT_EQ(obj_lowest_yp, -1);
+    // while the others are still found
+    roomobjs[1].y = 5;
+    roomobjs[1].baseline = -5; // same as unset
+    ASSERT_EQ(GetObjectIDAtRoom(50, -3), 1);
+    ASSERT_EQ(obj_lowest_yp, 5);
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ac/dynobj/cc_agsdynamicobject.h"
+#include "ac/dynobj/managedobjectpool.h"
+
+// Test objects are plain integers, the manager counts disposals;
+// it may be told to refuse disposing particular object
+struct TestObjectManager : CCBasicObject
+{
+    int DisposedCount = 0;
+    void *RefuseDispose = nullptr;
+
+    int Dispose(void *address, bool force) override
+    {
+        if (address == RefuseDispose && !force)
+            return 0;
+        delete static_cast<int*>(address);
+        DisposedCount++;
+        return 1;
+    }
+    const char *GetType() override { return "TestObject"; }
+};
+
+static int32_t AddTestObject(ManagedObjectPool &objpool, TestObjectManager &mgr)
+{
+    return objpool.AddObject(new int(), &mgr, kScValScriptObject);
+}
+
+TEST(ManagedObjectPool, GarbageCollection) {
+    ManagedObjectPool objpool;
+    TestObjectManager mgr;
+    std::vector<int32_t> referenced, unreferenced;
+    for (int i = 0; i < 2000; ++i)
+    {
+        const int32_t handle = AddTestObject(objpool, mgr);
+        if (i % 2 == 0)
+        {
+            objpool.AddRef(handle);
+            referenced.push_back(handle);
+        }
+        else
+        {
+            unreferenced.push_back(handle);
+        }
+    }
+    // referenced and released again, should be disposed right away
+    const int32_t released = referenced.back();
+    referenced.pop_back();
+    ASSERT_EQ(objpool.SubRef(released), 0);
+    ASSERT_EQ(objpool.HandleToAddress(released), nullptr);
+    ASSERT_EQ(mgr.DisposedCount, 1);
+
+    objpool.RunGarbageCollectionIfAppropriate();
+    ASSERT_EQ(mgr.DisposedCount, 1 + (int)unreferenced.size());
+    for (auto handle : referenced)
+        ASSERT_NE(objpool.HandleToAddress(handle), nullptr);
+    for (auto handle : unreferenced)
+        ASSERT_EQ(objpool.HandleToAddress(handle), nullptr);
+    objpool.reset();
+    ASSERT_EQ(mgr.DisposedCount, 2000);
+}
+
+TEST(ManagedObjectPool, DelayedDisposal) {
+    ManagedObjectPool objpool;
+    TestObjectManager mgr;
+    // object protected from disposal when released
+    const int32_t protect_handle = AddTestObject(objpool, mgr);
+    objpool.AddRef(protect_handle);
+    objpool.disableDisposeForObject = objpool.HandleToAddress(protect_handle);
+    objpool.SubRef(protect_handle);
+    objpool.disableDisposeForObject = nullptr;
+    ASSERT_NE(objpool.HandleToAddress(protect_handle), nullptr);
+    // object which refuses disposal at first
+    const int32_t refuse_handle = AddTestObject(objpool, mgr);
+    objpool.AddRef(refuse_handle);
+    mgr.RefuseDispose = objpool.HandleToAddress(refuse_handle);
+    objpool.SubRef(refuse_handle);
+    ASSERT_NE(objpool.HandleToAddress(refuse_handle), nullptr);
+    // object which stays referenced
+    const int32_t keep_handle = AddTestObject(objpool, mgr);
+    objpool.AddRef(keep_handle);
+
+    // fill the objpool to trigger collection
+    for (int i = 0; i < 1100; ++i)
+        objpool.AddRef(AddTestObject(objpool, mgr));
+    objpool.RunGarbageCollectionIfAppropriate();
+    ASSERT_EQ(objpool.HandleToAddress(protect_handle), nullptr);
+    ASSERT_NE(objpool.HandleToAddress(refuse_handle), nullptr);
+    ASSERT_NE(objpool.HandleToAddress(keep_handle), nullptr);
+
+    mgr.RefuseDispose = nullptr;
+    for (int i = 0; i < 1100; ++i)
+        objpool.AddRef(AddTestObject(objpool, mgr));
+    objpool.RunGarbageCollectionIfAppropriate();
+    ASSERT_EQ(objpool.HandleToAddress(refuse_handle), nullptr);
+    ASSERT_NE(objpool.HandleToAddress(keep_handle), nullptr);
+    objpool.reset();
+}
+
+TEST(ManagedObjectPool, HandleReuse) {
+    ManagedObjectPool objpool;
+    TestObjectManager mgr;
+    std::vector<int32_t> handles;
+    for (int i = 0; i < 10; ++i)
+    {
+        handles.push_back(AddTestObject(objpool, mgr));
+        objpool.AddRef(handles.back());
+    }
+    // most recently released handle is reused first
+    objpool.SubRef(handles[3]);
+    objpool.SubRef(handles[7]);
+    ASSERT_EQ(AddTestObject(objpool, mgr), handles[7]);
+    ASSERT_EQ(AddTestObject(objpool, mgr), handles[3]);
+    // and the released handle is not mistaken for the new object
+    objpool.SubRef(handles[5]);
+    const int32_t new_handle = AddTestObject(objpool, mgr);
+    ASSERT_EQ(new_handle, handles[5]);
+    objpool.AddRef(new_handle);
+    for (int i = 0; i < 1100; ++i)
+        AddTestObject(objpool, mgr);
+    objpool.RunGarbageCollectionIfAppropriate();
+    ASSERT_NE(objpool.HandleToAddress(new_handle), nullptr);
+    objpool.reset();
+}
+
+TEST(ManagedObjectPool, TimeBudget) {
+    ManagedObjectPool objpool;
+    TestObjectManager mgr;
+    const int count = 200000;
+    for (int i = 0; i < count; ++i)
+        AddTestObject(objpool, mgr);
+    objpool.SetGarbageCollectionBudget(std::chrono::microseconds(100));
+    int steps = 0;
+    for (; mgr.DisposedCount < count && steps < count; ++steps)
+        objpool.RunGarbageCollectionIfAppropriate();
+    ASSERT_EQ(mgr.DisposedCount, count);
+    // the collection was split, but every step got through at least
+    // one batch of candidates between the clock checks (64)
+    ASSERT_GT(steps, 1);
+    ASSERT_LE(steps, count / 64 + 1);
+    objpool.reset();
+}
+
+// Simulates scripts which keep a large number of live objects, and create
+// lots of short-lived objects every frame, like temporary strings
+TEST(ManagedObjectPool, DISABLED_ChurnBenchmark) {
+    const int live_count = 100000;
+    const int frames = 500;
+    const int temp_per_frame = 3000;
+    ManagedObjectPool objpool;
+    TestObjectManager mgr;
+    for (int i = 0; i < live_count; ++i)
+        objpool.AddRef(AddTestObject(objpool, mgr));
+
+    typedef std::chrono::high_resolution_clock Clock;
+    std::chrono::duration<double, std::micro> total_gc {}, max_gc {};
+    auto t0 = Clock::now();
+    for (int f = 0; f < frames; ++f)
+    {
+        for (int i = 0; i < temp_per_frame; ++i)
+        {
+            const int32_t handle = AddTestObject(objpool, mgr);
+            // some are assigned to a variable and released later,
+            // others are never referenced
+            if (i % 3 == 0)
+            {
+                objpool.AddRef(handle);
+                objpool.SubRef(handle);
+            }
+        }
+        auto gc_start = Clock::now();
+        objpool.RunGarbageCollectionIfAppropriate();
+        std::chrono::duration<double, std::micro> gc_time = Clock::now() - gc_start;
+        total_gc += gc_time;
+        max_gc = std::max(max_gc, gc_time);
+    }
+    auto t1 = Clock::now();
+    std::chrono::duration<double, std::micro> dur = t1 - t0;
+    ASSERT_EQ(mgr.DisposedCount, frames * temp_per_frame);
+    printf("ManagedObjectPool: %d live objects, %d temp objects per frame; %.2f us/frame, gc %.2f us/frame, max gc %.2f us\n",
+        live_count, temp_per_frame, dur.count() / frames, total_gc.count() / frames, max_gc.count());
+    objpool.reset();
+}
@@ -0,0 +1,167 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "gtest/gtest.h"
+#include "game/room_preloader.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+
+// Fake room reader: fails on room 13, marks the data with
+// the room number, and keeps room 99 loading until released
+struct FakeRoomReader
+{
+    std::atomic<int> LoadCount{ 0 };
+    std::atomic<bool> Started99{ false };
+    std::atomic<bool> Release99{ false };
+
+    bool Load(PreloadedRoom &room)
+    {
+        LoadCount++;
+        if (room.Room == 99)
+        {
+            Started99 = true;
+            while (!Release99)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        room.Data.Width = room.Room * 10;
+        room.ScriptData.assign(4, static_cast<uint8_t>(room.Room));
+        return room.Room != 13;
+    }
+};
+
+static void InitPreloader(RoomPreloader &preloader, FakeRoomReader &reader, size_t capacity)
+{
+    preloader.SetLoader([&reader](PreloadedRoom &room) { return reader.Load(room); });
+    preloader.SetCapacity(capacity);
+}
+
+TEST(RoomPreloader, PreloadAndTake) {
+    FakeRoomReader reader;
+    RoomPreloader preloader;
+    InitPreloader(preloader, reader, 2);
+    preloader.Preload(1, "room1.crm");
+    preloader.Preload(2, "room2.crm");
+    ASSERT_TRUE(preloader.IsPreloaded(1));
+    ASSERT_TRUE(preloader.IsPreloaded(2));
+    ASSERT_FALSE(preloader.IsPreloaded(3));
+    // Let the worker finish both rooms, then take them out
+    while (reader.LoadCount < 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto room2 = preloader.Take(2, "room2.crm");
+    auto room1 = preloader.Take(1, "room1.crm");
+    ASSERT_NE(room1, nullptr);
+    ASSERT_NE(room2, nullptr);
+    ASSERT_EQ(room1->Data.Width, 10);
+    ASSERT_EQ(room2->Data.Width, 20);
+    ASSERT_EQ(room2->ScriptData, std::vector<uint8_t>(4, 2));
+    ASSERT_FALSE(preloader.IsPreloaded(1));
+    // Taken only once
+    ASSERT_EQ(preloader.Take(1, "room1.crm"), nullptr);
+    // Repeated requests are ignored
+    preloader.Preload(3, "room3.crm");
+    preloader.Preload(3, "room3.crm");
+    while (reader.LoadCount < 3)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_NE(preloader.Take(3, "room3.crm"), nullptr);
+    ASSERT_EQ(reader.LoadCount, 3);
+    // Rooms which were not started loading are removed from the queue
+    preloader.Preload(99, "room99.crm");
+    preloader.Preload(4, "room4.crm");
+    while (!reader.Started99)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_EQ(preloader.Take(4, "room4.crm"), nullptr);
+    ASSERT_FALSE(preloader.IsPreloaded(4));
+    reader.Release99 = true;
+}
+
+TEST(RoomPreloader, TakeWaitsForLoading) {
+    FakeRoomReader reader;
+    RoomPreloader preloader;
+    InitPreloader(preloader, reader, 1);
+    preloader.Preload(99, "room99.crm");
+    while (!reader.Started99)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::thread release([&reader]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        reader.Release99 = true;
+    });
+    auto room = preloader.Take(99, "room99.crm");
+    release.join();
+    ASSERT_NE(room, nullptr);
+    ASSERT_EQ(room->Data.Width, 990);
+}
+
+TEST(RoomPreloader, TakeMismatchOrFailed) {
+    FakeRoomReader reader;
+    RoomPreloader preloader;
+    InitPreloader(preloader, reader, 2);
+    preloader.Preload(0, "room0.crm");
+    preloader.Preload(13, "room13.crm");
+    while (reader.LoadCount < 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Room file name is different from the one it was preloaded from
+    ASSERT_EQ(preloader.Take(0, "intro.crm"), nullptr);
+    ASSERT_FALSE(preloader.IsPreloaded(0));
+    // Failed to load
+    ASSERT_FALSE(preloader.IsPreloaded(13));
+    ASSERT_EQ(preloader.Take(13, "room13.crm"), nullptr);
+    // Never requested
+    ASSERT_EQ(preloader.Take(5, "room5.crm"), nullptr);
+}
+
+TEST(RoomPreloader, CapacityDropsOldest) {
+    FakeRoomReader reader;
+    RoomPreloader preloader;
+    InitPreloader(preloader, reader, 2);
+    preloader.Preload(1, "room1.crm");
+    preloader.Preload(2, "room2.crm");
+    while (reader.LoadCount < 2)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    preloader.Preload(3, "room3.crm");
+    ASSERT_FALSE(preloader.IsPreloaded(1));
+    ASSERT_TRUE(preloader.IsPreloaded(2));
+    ASSERT_TRUE(preloader.IsPreloaded(3));
+    while (reader.LoadCount < 3)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    // Lowering capacity discards the rooms too
+    preloader.SetCapacity(1);
+    ASSERT_FALSE(preloader.IsPreloaded(2));
+    ASSERT_NE(preloader.Take(3, "room3.crm"), nullptr);
+    // Reset forgets everything
+    preloader.Preload(4, "room4.crm");
+    preloader.Reset();
+    ASSERT_FALSE(preloader.IsPreloaded(4));
+    ASSERT_EQ(preloader.Take(4, "room4.crm"), nullptr);
+}
+
+TEST(RoomPreloader, Disabled) {
+    FakeRoomReader reader;
+    RoomPreloader preloader;
+    InitPreloader(preloader, reader, 0);
+    preloader.Preload(1, "room1.crm");
+    ASSERT_FALSE(preloader.IsPreloaded(1));
+    ASSERT_EQ(preloader.Take(1, "room1.crm"), nullptr);
+    ASSERT_EQ(reader.LoadCount, 0);
+}
+
+TEST(RoomPreloader, PredictNext) {
+    RoomPreloader preloader;
+    // Nothing known but the room player came from
+    ASSERT_EQ(preloader.PredictNext(1, 2, 3), std::vector<int>({ 2 }));
+    ASSERT_EQ(preloader.PredictNext(1, -1, 3), std::vector<int>());
+    preloader.NoteRoomChange(1, 5);
+    preloader.NoteRoomChange(1, 3);
+    preloader.NoteRoomChange(1, 3);
+    preloader.NoteRoomChange(1, 4);
+    preloader.NoteRoomChange(2, 6);
+    preloader.NoteRoomChange(1, 1); // not a change
+    preloader.NoteRoomChange(-1, 1); // restored game
+    // Most frequent first, lower number first if equal, then the previous room
+    ASSERT_EQ(preloader.PredictNext(1, 2, 5), std::vector<int>({ 3, 4, 5, 2 }));
+    ASSERT_EQ(preloader.PredictNext(1, 4, 5), std::vector<int>({ 3, 4, 5 }));
+    ASSERT_EQ(preloader.PredictNext(1, 2, 2), std::vector<int>({ 3, 4 }));
+    ASSERT_EQ(preloader.PredictNext(2, 1, 5), std::vector<int>({ 6, 1 }));
+    preloader.ResetHistory();
+    ASSERT_EQ(preloader.PredictNext(1, 2, 5), std::vector<int>({ 2 }));
+}
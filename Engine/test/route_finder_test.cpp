@@ -0,0 +1,164 @@
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "ac/movelist.h"
+#include "ac/route_finder.h"
+#include "ac/route_finder_impl.h"
+#include "ac/roomstatus.h"
+#include "ac/walkablearea.h"
+#include "game/roomstruct.h"
+#include "gfx/bitmap.h"
+
+using namespace AGS::Common;
+namespace RF = AGS::Engine::RouteFinder;
+
+extern std::vector<MoveList> mls;
+extern RoomStruct thisroom;
+extern RoomStatus *croom;
+extern Bitmap *walkable_areas_temp;
+
+// A path query: source and destination in mask coordinates
+struct PathQuery
+{
+    short FromX, FromY, ToX, ToY;
+};
+
+// Path queries across the test mask: crossing the whole room through
+// the walls' gaps, short moves, and moves along a single wall
+static const PathQuery TestQueries[] = {
+    {  10,  20, 300, 180 }, { 300, 180,  10,  20 }, {  40, 150, 250,  30 },
+    { 250,  30,  40, 150 }, {  15, 100, 305, 100 }, { 120,  60, 200, 160 },
+    { 200, 160, 120,  60 }, {  70,  10,  70, 190 }, { 150, 100, 290,  15 },
+    {  30, 185, 180,  15 }, { 100, 100, 110, 100 }, { 310, 190,   5,   5 },
+    {  60,  40, 220, 140 }, { 220, 140,  60,  40 }, { 160,  10, 160, 190 },
+    { 280,  90,  20,  90 },
+};
+
+// Makes a room mask with a number of vertical walls, each having a gap
+// in a different place, so that the paths have to zig-zag
+static Bitmap *CreateTestMask(int width, int height)
+{
+    Bitmap *mask = BitmapHelper::CreateBitmap(width, height, 8);
+    mask->Clear(1);
+    for (int i = 1; i < 8; ++i)
+    {
+        const int wall_x = width * i / 8 + 3;
+        const int gap_y = (i % 2) ? height / 10 : height * 8 / 10;
+        for (int y = 0; y < height; ++y)
+        {
+            if (y < gap_y || y >= gap_y + height / 10)
+                mask->PutPixel(wall_x, y, 0);
+        }
+    }
+    return mask;
+}
+
+static int FindRoute(const PathQuery &q, Bitmap *mask)
+{
+    return RF::find_route(q.FromX, q.FromY, q.ToX, q.ToY, mask, 1, 1);
+}
+
+TEST(RouteFinder, MaskChanges) {
+    mls.resize(2);
+    RF::init_pathfinder();
+    RF::set_route_move_speed(1, 1);
+    std::unique_ptr<Bitmap> mask(CreateTestMask(320, 200));
+    RF::set_wallscreen(mask.get());
+    // straight line through the gap of the first wall
+    ASSERT_TRUE(RF::can_see_from(20, 25, 60, 25));
+    // close the gap directly in the mask, pathfinder should see the change
+    for (int y = 0; y < 200; ++y)
+        mask->PutPixel(43, y, 0);
+    ASSERT_FALSE(RF::can_see_from(20, 25, 60, 25));
+    // replace the mask with a new one, pathfinder should see it too
+    mask.reset(BitmapHelper::CreateBitmap(100, 100, 8));
+    mask->Clear(1);
+    RF::set_wallscreen(mask.get());
+    ASSERT_TRUE(RF::can_see_from(20, 25, 60, 25));
+    ASSERT_TRUE(RF::can_see_from(10, 90, 90, 10));
+    RF::shutdown_pathfinder();
+}
+
+static bool SameMasks(const Bitmap *a, const Bitmap *b, int first_row = 0, int last_row = -1)
+{
+    if (last_row < 0)
+        last_row = a->GetHeight() - 1;
+    for (int y = first_row; y <= last_row; ++y)
+        if (memcmp(a->GetScanLine(y), b->GetScanLine(y), a->GetWidth()) != 0)
+            return false;
+    return true;
+}
+
+// Tests that the pathfinder's temp mask only restores the rows which
+// were cut out by the blocking characters and objects
+TEST(RouteFinder, TempMaskRestore) {
+    RoomStatus room_status;
+    RoomStatus *old_croom = croom;
+    croom = &room_status;
+    thisroom.MaskResolution = 1;
+    thisroom.WalkAreaMask.reset(CreateTestMask(64, 48));
+    Bitmap *mask = thisroom.WalkAreaMask.get();
+    std::unique_ptr<Bitmap> temp(BitmapHelper::CreateBitmap(64, 48, 8));
+    walkable_areas_temp = temp.get();
+    invalidate_walkable_areas_temp();
+
+    // first use copies the whole mask
+    ASSERT_EQ(prepare_walkable_areas(-1), temp.get());
+    ASSERT_TRUE(SameMasks(temp.get(), mask));
+    // cut out a blocking area, and have it restored next time
+    remove_walkable_areas_from_temp(10, 20, 5, 15);
+    ASSERT_FALSE(SameMasks(temp.get(), mask, 5, 15));
+    ASSERT_EQ(temp->GetPixel(15, 10), 0);
+    prepare_walkable_areas(-1);
+    ASSERT_TRUE(SameMasks(temp.get(), mask));
+    // rows which were not cut out are not copied again
+    mask->PutPixel(30, 40, 5);
+    mask->PutPixel(30, 10, 5);
+    remove_walkable_areas_from_temp(0, 1, 8, 12);
+    prepare_walkable_areas(-1);
+    ASSERT_TRUE(SameMasks(temp.get(), mask, 8, 12));
+    ASSERT_NE(temp->GetPixel(30, 40), 5);
+    // invalidation copies the whole mask again
+    invalidate_walkable_areas_temp();
+    prepare_walkable_areas(-1);
+    ASSERT_TRUE(SameMasks(temp.get(), mask));
+
+    walkable_areas_temp = nullptr;
+    thisroom.WalkAreaMask.reset();
+    croom = old_croom;
+}
+
+// Runs the test path queries, measuring the average time per query;
+// disabled by default, run with --gtest_also_run_disabled_tests
+TEST(RouteFinder, DISABLED_QueriesBenchmark) {
+    const int replay_count = 50;
+    const size_t query_count = sizeof(TestQueries) / sizeof(TestQueries[0]);
+    mls.resize(2);
+    RF::init_pathfinder();
+    RF::set_route_move_speed(2, 2);
+    std::unique_ptr<Bitmap> mask(CreateTestMask(320, 200));
+
+    for (const auto &q : TestQueries)
+    {
+        ASSERT_EQ(FindRoute(q, mask.get()), 1);
+        const MoveList &ml = mls[1];
+        ASSERT_GE(ml.numstage, 2);
+        ASSERT_EQ(ml.pos[ml.numstage - 1], (q.ToX << 16) | q.ToY);
+    }
+
+    typedef std::chrono::high_resolution_clock Clock;
+    auto t0 = Clock::now();
+    for (int i = 0; i < replay_count; ++i)
+    {
+        for (const auto &q : TestQueries)
+            FindRoute(q, mask.get());
+    }
+    auto t1 = Clock::now();
+    std::chrono::duration<double, std::micro> dur = t1 - t0;
+    printf("RouteFinder: %zu queries x %d replays, %.2f us/query\n",
+        query_count, replay_count, dur.count() / (query_count * replay_count));
+    RF::shutdown_pathfinder();
+}
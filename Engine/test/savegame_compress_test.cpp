@@ -0,0 +1,146 @@
+#include <memory>
+#include <random>
+#include <string.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "game/savegame_compress.h"
+#include "util/memorystream.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+
+// Game data which is only written before the list of components
+static const char *SaveHeader = "Save header";
+static const size_t TagLength = 12; // "<Compressed>"
+static const size_t DataSizeOffset = TagLength + sizeof(int32_t);
+static const size_t PackedSizeOffset = DataSizeOffset + sizeof(int64_t);
+
+// Makes the data resembling serialized components: text, numbers and noise
+static std::vector<uint8_t> MakeData(size_t size)
+{
+    std::mt19937 rng(17);
+    std::vector<uint8_t> data;
+    const char *text = "Components\0Character\0Room States\0";
+    while (data.size() < size)
+    {
+        data.insert(data.end(), text, text + 32);
+        for (int i = 0; i < 16; ++i)
+            data.push_back(static_cast<uint8_t>(i < 4 ? rng() : i));
+    }
+    data.resize(size);
+    return data;
+}
+
+// Writes the save with the header and the game data
+static std::vector<uint8_t> WriteSave(const std::vector<uint8_t> &data, SavegameCompression compression)
+{
+    std::vector<uint8_t> file;
+    VectorStream out(file, kStream_Write);
+    out.Write(SaveHeader, strlen(SaveHeader));
+    EXPECT_TRUE(WriteSaveData(data, compression, &out));
+    return file;
+}
+
+// Opens the save's game data, and reads all of it
+static HSaveError ReadSave(const std::vector<uint8_t> &file, std::vector<uint8_t> &data)
+{
+    VectorStream in(file);
+    in.Seek(strlen(SaveHeader), kSeekBegin);
+    std::vector<uint8_t> buf;
+    std::unique_ptr<Stream> buf_in;
+    Stream *data_in = nullptr;
+    HSaveError err = OpenSaveData(&in, buf, buf_in, data_in);
+    if (!err)
+        return err;
+    data.resize(static_cast<size_t>(data_in->GetLength() - data_in->GetPosition()));
+    data_in->Read(data.data(), data.size());
+    return HSaveError::None();
+}
+
+static void PutInt64(std::vector<uint8_t> &file, size_t at, int64_t value)
+{
+    for (size_t i = 0; i < sizeof(int64_t); ++i)
+        file[at + i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8));
+}
+
+TEST(SavegameCompress, Roundtrip) {
+    const std::vector<uint8_t> data = MakeData(100000);
+    for (auto compression : { kSvgCompress_Zlib, kSvgCompress_LZW })
+    {
+        std::vector<uint8_t> file = WriteSave(data, compression);
+        ASSERT_EQ(memcmp(&file[strlen(SaveHeader)], "<Compressed>", TagLength), 0);
+        ASSERT_LT(file.size(), data.size() / 2);
+        std::vector<uint8_t> read_data;
+        ASSERT_TRUE(ReadSave(file, read_data)) << compression;
+        ASSERT_EQ(read_data, data) << compression;
+    }
+
+    // empty data
+    for (auto compression : { kSvgCompress_Zlib, kSvgCompress_LZW })
+    {
+        std::vector<uint8_t> read_data(1);
+        ASSERT_TRUE(ReadSave(WriteSave(std::vector<uint8_t>(), compression), read_data));
+        ASSERT_TRUE(read_data.empty());
+    }
+}
+
+TEST(SavegameCompress, Uncompressed) {
+    // Uncompressed data, same as in the saves written before compression
+    // was supported, is read right from the file
+    const std::vector<uint8_t> data = MakeData(1000);
+    std::vector<uint8_t> file = WriteSave(data, kSvgCompress_None);
+    ASSERT_EQ(file.size(), strlen(SaveHeader) + data.size());
+    std::vector<uint8_t> read_data;
+    ASSERT_TRUE(ReadSave(file, read_data));
+    ASSERT_EQ(read_data, data);
+
+    // data shorter than the tag
+    file.resize(strlen(SaveHeader) + 5);
+    ASSERT_TRUE(ReadSave(file, read_data));
+    ASSERT_EQ(read_data, std::vector<uint8_t>(data.begin(), data.begin() + 5));
+}
+
+TEST(SavegameCompress, CorruptHeader) {
+    const std::vector<uint8_t> data = MakeData(10000);
+    for (auto compression : { kSvgCompress_Zlib, kSvgCompress_LZW })
+    {
+        const std::vector<uint8_t> file = WriteSave(data, compression);
+        const size_t at = strlen(SaveHeader);
+        const int64_t packed_size = static_cast<int64_t>(file.size() - at - PackedSizeOffset - sizeof(int64_t));
+        std::vector<uint8_t> read_data;
+
+        std::vector<uint8_t> broken = file;
+        PutInt64(broken, at + DataSizeOffset, -1);
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        // unpacked size exceeds the upper limit
+        broken = file;
+        PutInt64(broken, at + DataSizeOffset, INT64_C(0x7FFFFFFFFFFF));
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        // unpacked size is more than the compression could make of the packed data
+        broken = file;
+        PutInt64(broken, at + DataSizeOffset, packed_size * 1033);
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        // packed size is larger than the rest of the file
+        broken = file;
+        PutInt64(broken, at + PackedSizeOffset, packed_size + 1);
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        broken = file;
+        PutInt64(broken, at + PackedSizeOffset, -1);
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        // unknown compression type
+        broken = file;
+        broken[at + TagLength] = 0x7F;
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        // unpacked size is larger than the packed data has
+        broken = file;
+        PutInt64(broken, at + DataSizeOffset, static_cast<int64_t>(data.size()) + 100);
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        // the file is cut
+        broken = file;
+        broken.resize(broken.size() - 10);
+        ASSERT_FALSE(ReadSave(broken, read_data));
+        // the file is still good
+        ASSERT_TRUE(ReadSave(file, read_data));
+        ASSERT_EQ(read_data, data);
+    }
+}
@@ -0,0 +1,327 @@
+#include <chrono>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "game/savegame_delta.h"
+#include "util/memorystream.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+using namespace AGS::Engine::SavegameDelta;
+
+// Files written by the test saves, by name
+typedef std::map<String, std::vector<uint8_t>> FileMap;
+
+static const int RoomCount = 300;
+
+// Makes a game state of a few components, and a number of room states
+static void MakeState(ComponentList &comps, RoomStateMap &rooms, std::mt19937 &rng,
+    size_t comp_size, size_t big_size, int room_count, size_t room_size)
+{
+    const char *names[] = { "Game State", "Characters", "Dynamic Sprites", "Script Modules",
+        "Room States", "Loaded Room State", "Managed Pool", "Plugin Data" };
+    comps.clear();
+    for (const char *name : names)
+    {
+        Component comp;
+        comp.Name = name;
+        comp.Version = 1;
+        if (comp.Name != RoomStatesName && comp.Name != "Plugin Data")
+            comp.Data.resize(comp.Name == "Dynamic Sprites" ? big_size : comp_size);
+        for (auto &b : comp.Data)
+            b = static_cast<uint8_t>(rng());
+        comps.push_back(comp);
+    }
+    rooms.clear();
+    for (int i = 0; i < room_count; ++i)
+    {
+        rooms[i * 2].resize(room_size);
+        for (auto &b : rooms[i * 2])
+            b = static_cast<uint8_t>(rng());
+    }
+}
+
+static void Modify(std::vector<uint8_t> &data, std::mt19937 &rng)
+{
+    if (!data.empty())
+        data[rng() % data.size()]++;
+}
+
+static Component *FindComponent(ComponentList &comps, const String &name)
+{
+    for (auto &comp : comps)
+        if (comp.Name == name)
+            return &comp;
+    return nullptr;
+}
+
+// Saves the state into the file, same way as the engine does
+static void Save(Tracker &tracker, FileMap &files, const String &filename,
+    const ComponentList &comps, const RoomStateMap &rooms, size_t max_chain = 8)
+{
+    ComponentList list = comps;
+    if (tracker.CanWriteDelta(filename, max_chain))
+    {
+        String suffix = String::FromFormat(".d%zu", tracker.GetChainLength());
+        files[String::FromFormat("%s%s", filename.GetCStr(), suffix.GetCStr())] = std::move(files[filename]);
+        tracker.MakeDelta(suffix, list, rooms);
+    }
+    else
+    {
+        tracker.MakeFull(filename, list, rooms, RoomCount);
+    }
+    std::vector<uint8_t> &data = files[filename];
+    data.clear();
+    VectorStream out(data, kStream_Write);
+    WriteComponentList(list, &out);
+    tracker.Commit(true);
+}
+
+static HSaveError LoadList(const FileMap &files, const String &filename, ComponentList &list)
+{
+    auto it = files.find(filename);
+    if (it == files.end())
+        return new SavegameError(kSvgErr_FileOpenFailed);
+    MemoryStream in(it->second.data(), it->second.size());
+    return ReadComponentList(&in, kSvgVersion_Current, list);
+}
+
+static HSaveError Load(const FileMap &files, const String &filename, ComponentList &list)
+{
+    HSaveError err = LoadList(files, filename, list);
+    if (!err)
+        return err;
+    return ResolveChain(filename, list,
+        [&files](const String &base_file, ComponentList &base_list)
+        { return LoadList(files, base_file, base_list); });
+}
+
+// Reads the room states the way the engine would, applying room deltas in order
+static RoomStateMap ApplyRooms(const ComponentList &list, size_t room_size)
+{
+    RoomStateMap rooms;
+    const String open_tag = "<RoomState>", close_tag = "</RoomState>";
+    auto read_state = [&](Stream *in, int id)
+    {
+        String tag = String::FromStreamCount(in, open_tag.GetLength());
+        EXPECT_EQ(tag, open_tag);
+        rooms[id].resize(room_size);
+        in->Read(rooms[id].data(), room_size);
+        tag = String::FromStreamCount(in, close_tag.GetLength());
+        EXPECT_EQ(tag, close_tag);
+    };
+    for (const auto &comp : list)
+    {
+        MemoryStream in(comp.Data.data(), comp.Data.size());
+        if (comp.Name == RoomStatesName)
+        {
+            int count = in.ReadInt32();
+            EXPECT_EQ(count, RoomCount);
+            for (int i = 0; i < count; ++i)
+            {
+                int id = in.ReadInt32();
+                if (id == -1)
+                    continue;
+                EXPECT_EQ(id, i);
+                read_state(&in, id);
+            }
+        }
+        else if (comp.Name == RoomStatesDeltaName)
+        {
+            int count = in.ReadInt32();
+            for (int i = 0; i < count; ++i)
+            {
+                int id = in.ReadInt32();
+                rooms.erase(id);
+                if (in.ReadInt8() != 0)
+                    read_state(&in, id);
+            }
+        }
+        else
+        {
+            continue;
+        }
+        EXPECT_TRUE(in.EOS());
+    }
+    return rooms;
+}
+
+// Compares the restored components to the ones which were saved
+static void ExpectSameState(const ComponentList &restored, const ComponentList &comps,
+    const RoomStateMap &rooms, size_t room_size)
+{
+    ComponentList list;
+    for (const auto &comp : restored)
+        if (comp.Name != ChainLinkName && comp.Name != RoomStatesName && comp.Name != RoomStatesDeltaName)
+            list.push_back(comp);
+    ComponentList expect;
+    for (const auto &comp : comps)
+        if (comp.Name != RoomStatesName)
+            expect.push_back(comp);
+    ASSERT_EQ(list.size(), expect.size());
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        ASSERT_EQ(list[i].Name, expect[i].Name);
+        ASSERT_EQ(list[i].Version, expect[i].Version);
+        ASSERT_TRUE(list[i].Data == expect[i].Data) << list[i].Name.GetCStr();
+    }
+    ASSERT_TRUE(ApplyRooms(restored, room_size) == rooms);
+}
+
+TEST(SavegameDelta, ChainRoundtrip) {
+    const size_t room_size = 64;
+    const String filename = "agssave.001";
+    std::mt19937 rng(42);
+    ComponentList comps;
+    RoomStateMap rooms;
+    MakeState(comps, rooms, rng, 256, 4096, 20, room_size);
+    Tracker tracker;
+    FileMap files;
+
+    // The first save is a full one
+    Save(tracker, files, filename, comps, rooms);
+    ASSERT_EQ(tracker.GetChainLength(), 0u);
+    ComponentList restored;
+    ASSERT_TRUE(Load(files, filename, restored));
+    ExpectSameState(restored, comps, rooms, room_size);
+    ASSERT_EQ(restored.front().Name, ChainLinkName);
+
+    for (int step = 1; step <= 5; ++step)
+    {
+        Modify(FindComponent(comps, "Game State")->Data, rng);
+        if (step % 2 == 0)
+            FindComponent(comps, "Managed Pool")->Data.resize(300 + step);
+        Modify(rooms[step * 2], rng);
+        if (step == 3)
+            rooms.erase(4); // room was reset
+        if (step == 4)
+            rooms[1].assign(room_size, 7); // first visit
+        Save(tracker, files, filename, comps, rooms);
+        ASSERT_EQ(tracker.GetChainLength(), static_cast<size_t>(step));
+        // Only changed components are written into the delta
+        ComponentList delta;
+        ASSERT_TRUE(LoadList(files, filename, delta));
+        ASSERT_TRUE(FindComponent(delta, "Game State"));
+        ASSERT_FALSE(FindComponent(delta, "Dynamic Sprites"));
+        ASSERT_FALSE(FindComponent(delta, RoomStatesName));
+        ASSERT_TRUE(FindComponent(delta, RoomStatesDeltaName));
+        ASSERT_EQ(FindComponent(delta, "Managed Pool") != nullptr, step % 2 == 0);
+
+        ASSERT_TRUE(Load(files, filename, restored));
+        ExpectSameState(restored, comps, rooms, room_size);
+    }
+
+    // Nothing changed: only the chain link is saved
+    Save(tracker, files, filename, comps, rooms);
+    ComponentList delta;
+    ASSERT_TRUE(LoadList(files, filename, delta));
+    ASSERT_EQ(delta.size(), 1u);
+    ASSERT_TRUE(Load(files, filename, restored));
+    ExpectSameState(restored, comps, rooms, room_size);
+
+    // Saving into another file, or over the chain limit, makes a full save
+    ASSERT_FALSE(tracker.CanWriteDelta("agssave.002", 8));
+    ASSERT_TRUE(tracker.CanWriteDelta(filename, 8));
+    Save(tracker, files, filename, comps, rooms, tracker.GetChainLength());
+    ASSERT_EQ(tracker.GetChainLength(), 0u);
+    ASSERT_TRUE(LoadList(files, filename, delta));
+    ASSERT_TRUE(FindComponent(delta, "Dynamic Sprites"));
+}
+
+TEST(SavegameDelta, BrokenChain) {
+    const String filename = "agssave.002";
+    std::mt19937 rng(7);
+    ComponentList comps;
+    RoomStateMap rooms;
+    MakeState(comps, rooms, rng, 100, 100, 4, 16);
+    Tracker tracker;
+    FileMap files;
+    Save(tracker, files, filename, comps, rooms);
+    Modify(FindComponent(comps, "Characters")->Data, rng);
+    Save(tracker, files, filename, comps, rooms);
+
+    ChainLink link;
+    MemoryStream in(files[filename].data(), files[filename].size());
+    ASSERT_TRUE(PeekChainLink(&in, kSvgVersion_Current, link));
+    ASSERT_EQ(in.GetPosition(), 0);
+    ASSERT_EQ(link.SaveId, tracker.GetSaveId());
+    ASSERT_EQ(link.BaseSuffix, ".d0");
+
+    // Base save was replaced by another one
+    ComponentList restored;
+    FileMap other = files;
+    Tracker other_tracker;
+    Save(other_tracker, other, "agssave.002.d0", comps, rooms);
+    ASSERT_FALSE(Load(other, filename, restored));
+    // Base save is missing
+    other = files;
+    other.erase("agssave.002.d0");
+    ASSERT_FALSE(Load(other, filename, restored));
+    // Not a delta save
+    ComponentList list;
+    ASSERT_TRUE(LoadList(files, "agssave.002.d0", list));
+    MemoryStream base_in(files["agssave.002.d0"].data(), files["agssave.002.d0"].size());
+    ASSERT_TRUE(PeekChainLink(&base_in, kSvgVersion_Current, link));
+    ASSERT_TRUE(link.BaseSuffix.IsEmpty());
+}
+
+// Compares time and size of the full saves vs delta saves, for the game state
+// where large components stay the same, and only a few rooms are changed
+TEST(SavegameDelta, DISABLED_Benchmark) {
+    const int saves = 20;
+    const size_t room_size = 4096;
+    std::mt19937 rng(1);
+    ComponentList comps;
+    RoomStateMap rooms;
+    MakeState(comps, rooms, rng, 64 * 1024, 8 * 1024 * 1024, 120, room_size);
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+
+    auto play = [&](int step)
+    {
+        Modify(FindComponent(comps, "Game State")->Data, rng);
+        Modify(FindComponent(comps, "Characters")->Data, rng);
+        Modify(FindComponent(comps, "Managed Pool")->Data, rng);
+        Modify(rooms[(step % 120) * 2], rng);
+    };
+
+    // Full saves: the whole list of components is written each time
+    std::vector<uint8_t> data;
+    size_t full_size = 0;
+    double full_time = 0.0;
+    for (int i = 0; i < saves; ++i)
+    {
+        play(i);
+        auto t0 = Clock::now();
+        ComponentList list = comps;
+        Tracker tracker;
+        tracker.MakeFull("agssave.001", list, rooms, RoomCount);
+        data.clear();
+        VectorStream out(data, kStream_Write);
+        WriteComponentList(list, &out);
+        full_time += msec(Clock::now() - t0).count();
+        full_size += data.size();
+    }
+
+    // Incremental saves, with a full save every 8 deltas
+    Tracker tracker;
+    FileMap files;
+    size_t delta_size = 0;
+    double delta_time = 0.0;
+    for (int i = 0; i < saves; ++i)
+    {
+        play(i);
+        auto t0 = Clock::now();
+        Save(tracker, files, "agssave.001", comps, rooms);
+        delta_time += msec(Clock::now() - t0).count();
+        delta_size += files["agssave.001"].size();
+    }
+    ComponentList restored;
+    ASSERT_TRUE(Load(files, "agssave.001", restored));
+    ExpectSameState(restored, comps, rooms, room_size);
+
+    printf("SavegameDelta: %d saves; full %.2f ms, %zu KB per save; incremental %.2f ms, %zu KB per save\n",
+        saves, full_time / saves, full_size / saves / 1024, delta_time / saves, delta_size / saves / 1024);
+}
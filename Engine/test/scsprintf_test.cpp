@@ -5,12 +5,6 @@
 
 using namespace AGS::Common;
 
-GameDataVersion loaded_game_file_version;
-void cc_error(const char *, ...)
-{
-    // do nothing
-}
-
 const char *ScriptVSprintf__(char *buffer, size_t buf_length, const char *format, ...)
 {
     va_list args;
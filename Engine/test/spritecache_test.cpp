@@ -0,0 +1,127 @@
+//=============================================================================
+//
+// Adventure Game Studio (AGS)
+//
+// Copyright (C) 1999-2011 Chris Jones and 2011-20xx others
+// The full list of copyright holders can be found in the Copyright.txt
+// file, which is part of this source code distribution.
+//
+// The AGS source code is provided under the Artistic License 2.0.
+// A copy of this license can be found in the file License.txt and at
+// http://www.opensource.org/licenses/artistic-license-2.0.php
+//
+//=============================================================================
+#include <string.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "core/platform.h"
+#include "ac/gamestructdefines.h"
+#include "ac/spritecache.h"
+#include "core/assetmanager.h"
+#include "gfx/bitmap.h"
+#include "util/file.h"
+
+using namespace AGS::Common;
+
+#if (AGS_PLATFORM_TEST_FILE_IO)
+
+static const char *DummySprFile = "dummy.spr";
+
+class SpriteFileTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        File::DeleteFile(DummySprFile);
+        // sprite file is opened through the asset manager
+        AssetMgr.reset(new AssetManager());
+        AssetMgr->AddLibrary(".");
+    }
+
+    void TearDown() override {
+        AssetMgr.reset();
+        File::DeleteFile(DummySprFile);
+    }
+};
+
+// Creates a test image with a distinct pixel pattern
+static Bitmap *CreateTestSprite(int seed, int width, int height)
+{
+    Bitmap *bmp = BitmapHelper::CreateBitmap(width, height, 32);
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            bmp->PutPixel(x, y, (seed * 7919 + x * 31 + (y / 4) * 17) & 0xFFFFFF);
+    return bmp;
+}
+
+static bool IsSameImage(Bitmap *bmp1, Bitmap *bmp2)
+{
+    if (!bmp1 || !bmp2 || bmp1->GetSize() != bmp2->GetSize() ||
+        bmp1->GetColorDepth() != bmp2->GetColorDepth())
+        return false;
+    for (int y = 0; y < bmp1->GetHeight(); ++y)
+        if (memcmp(bmp1->GetScanLine(y), bmp2->GetScanLine(y), bmp1->GetLineLength()) != 0)
+            return false;
+    return true;
+}
+
+TEST_F(SpriteFileTest, Prefetch) {
+    const int sprite_count = 16;
+    std::vector<std::unique_ptr<Bitmap>> images;
+    std::vector<std::pair<bool, Bitmap*>> sprites;
+    for (int i = 0; i < sprite_count; ++i)
+    {
+        images.emplace_back(CreateTestSprite(i, 40 + i, 30 + i * 2));
+        sprites.push_back(std::make_pair(true, images.back().get()));
+    }
+    SpriteFileIndex index;
+    ASSERT_EQ(SaveSpriteFile(DummySprFile, sprites, nullptr, 0, kSprCompress_RLE, index), 0);
+
+    std::vector<SpriteInfo> infos;
+    SpriteCache::Callbacks callbacks;
+    SpriteCache cache(infos, callbacks);
+    HError err = cache.InitFile(DummySprFile, "");
+    ASSERT_TRUE(err);
+    ASSERT_EQ(cache.GetSpriteSlotCount(), (size_t)sprite_count);
+
+    // prefetched sprites must be same as ones loaded directly,
+    // regardless of whether they were ready by the time of request
+    for (int i = 1; i < sprite_count; ++i)
+        cache.Prefetch(i);
+    for (int i = sprite_count - 1; i > 0; --i)
+        ASSERT_TRUE(IsSameImage(cache[i], images[i].get()));
+    // repeated prefetch of the loaded sprites does nothing
+    for (int i = 1; i < sprite_count; ++i)
+        cache.Prefetch(i);
+    ASSERT_TRUE(IsSameImage(cache[1], images[1].get()));
+
+    // sprites decoded in background are picked up by the next request
+    cache.DisposeAllCached();
+    for (int i = 1; i < sprite_count; ++i)
+        cache.Prefetch(i);
+    // wait until the background thread has decoded all of them
+    const auto wait_until = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((cache.GetPrefetchedCount() < (size_t)(sprite_count - 1)) &&
+           (std::chrono::steady_clock::now() < wait_until))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    ASSERT_EQ(cache.GetPrefetchedCount(), (size_t)(sprite_count - 1));
+    ASSERT_TRUE(IsSameImage(cache[0], images[0].get()));
+    // all the ready sprites were put into the cache at once
+    size_t total_size = 0;
+    for (const auto &im : images)
+        total_size += im->GetWidth() * im->GetHeight() * im->GetBPP();
+    ASSERT_EQ(cache.GetCacheSize(), total_size);
+    for (int i = 1; i < sprite_count; ++i)
+        ASSERT_TRUE(IsSameImage(cache[i], images[i].get()));
+
+    // pending sprites are discarded when the cache is reset
+    cache.DisposeAllCached();
+    for (int i = 1; i < sprite_count; ++i)
+        cache.Prefetch(i);
+    cache.Reset();
+    ASSERT_EQ(cache.GetCacheSize(), 0u);
+    ASSERT_EQ(cache[1], nullptr);
+}
+
+#endif // AGS_PLATFORM_TEST_FILE_IO
@@ -0,0 +1,143 @@
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "script/systemimports.h"
+
+static RuntimeScriptValue MakeValue(int32_t val)
+{
+    return RuntimeScriptValue().SetInt32(val);
+}
+
+TEST(SystemImports, FindByName) {
+    SystemImports imp;
+    ccInstance *inst = reinterpret_cast<ccInstance*>(&imp);
+    const uint32_t a = imp.add("Func", MakeValue(1), nullptr);
+    const uint32_t b = imp.add("ScriptFunc$2", MakeValue(2), inst);
+    const uint32_t c = imp.add("ScriptFunc$1", MakeValue(3), inst);
+    const uint32_t d = imp.add("Obj::Method^1", MakeValue(4), nullptr);
+    ASSERT_EQ(imp.get_index_of("Func"), a);
+    ASSERT_EQ(imp.get_index_of("ScriptFunc$2"), b);
+    // mangled name is found by the name without the '$' suffix,
+    // lexicographically first variant is chosen
+    ASSERT_EQ(imp.get_index_of("ScriptFunc"), c);
+    // number of parameters may be stripped from the end
+    ASSERT_EQ(imp.get_index_of("Func^3"), a);
+    ASSERT_EQ(imp.get_index_of("ScriptFunc^12"), c);
+    ASSERT_EQ(imp.get_index_of("Obj::Method^1"), d);
+    ASSERT_EQ(imp.get_index_of("Obj::Method"), UINT32_MAX);
+    ASSERT_EQ(imp.get_index_of("Script"), UINT32_MAX);
+    ASSERT_EQ(imp.get_index_of("Func$"), UINT32_MAX);
+    ASSERT_EQ(imp.getByName("Unknown"), nullptr);
+    ASSERT_EQ(imp.getByName("Func")->Value.IValue, 1);
+
+    // script exports may not be overridden, but others may
+    ASSERT_EQ(imp.add("ScriptFunc$1", MakeValue(10), nullptr), c);
+    ASSERT_EQ(imp.getByIndex(c)->Value.IValue, 10);
+    ASSERT_EQ(imp.add("ScriptFunc$1", MakeValue(20), inst), c);
+    ASSERT_EQ(imp.getByIndex(c)->Value.IValue, 10);
+    imp.clear();
+    ASSERT_EQ(imp.get_index_of("Func"), UINT32_MAX);
+}
+
+TEST(SystemImports, FindName) {
+    SystemImports imp;
+    imp.add("First", MakeValue(1), nullptr);
+    imp.add("Second", MakeValue(2), nullptr);
+    imp.add("SecondAlias", MakeValue(2), nullptr);
+    ASSERT_STREQ(imp.findName(MakeValue(1)).GetCStr(), "First");
+    ASSERT_STREQ(imp.findName(MakeValue(2)).GetCStr(), "Second");
+    ASSERT_TRUE(imp.findName(MakeValue(3)).IsEmpty());
+    // override updates the value lookup
+    imp.add("First", MakeValue(3), nullptr);
+    ASSERT_TRUE(imp.findName(MakeValue(1)).IsEmpty());
+    ASSERT_STREQ(imp.findName(MakeValue(3)).GetCStr(), "First");
+    imp.remove("Second");
+    ASSERT_STREQ(imp.findName(MakeValue(2)).GetCStr(), "SecondAlias");
+}
+
+TEST(SystemImports, RemoveAndReuse) {
+    SystemImports imp;
+    ccInstance *inst1 = reinterpret_cast<ccInstance*>(&imp);
+    ccInstance *inst2 = inst1 + 1;
+    std::vector<uint32_t> idx;
+    for (int i = 0; i < 10; ++i)
+        idx.push_back(imp.add(String::FromFormat("Export%d$1", i), MakeValue(i), (i % 2) ? inst1 : inst2));
+    imp.RemoveScriptExports(inst1);
+    for (int i = 0; i < 10; ++i)
+    {
+        const uint32_t found = imp.get_index_of(String::FromFormat("Export%d", i));
+        if (i % 2)
+        {
+            ASSERT_EQ(found, UINT32_MAX);
+            ASSERT_TRUE(imp.findName(MakeValue(i)).IsEmpty());
+        }
+        else
+        {
+            ASSERT_EQ(found, idx[i]);
+        }
+    }
+    // lowest free slot is reused first
+    imp.remove("Export4");
+    ASSERT_EQ(imp.add("New1", MakeValue(100), nullptr), idx[1]);
+    ASSERT_EQ(imp.add("New3", MakeValue(100), nullptr), idx[3]);
+    ASSERT_EQ(imp.add("New4", MakeValue(100), nullptr), idx[4]);
+    ASSERT_EQ(imp.get_index_of("Export4"), UINT32_MAX);
+}
+
+// Registers a large number of engine and script exports and resolves
+// them by the names that scripts would use, like during the game startup
+// and savegame restore
+TEST(SystemImports, DISABLED_Benchmark) {
+    const int api_count = 5000;
+    const int export_count = 5000;
+    SystemImports imp;
+    ccInstance *inst = reinterpret_cast<ccInstance*>(&imp);
+    std::vector<String> api_names, export_names, import_names;
+    for (int i = 0; i < api_count; ++i)
+    {
+        api_names.push_back(String::FromFormat("Struct%d::Function%d^%d", i / 20, i, i % 4));
+        import_names.push_back(api_names.back());
+    }
+    for (int i = 0; i < export_count; ++i)
+    {
+        export_names.push_back(String::FromFormat("script_function_%d$%d", i, i % 3));
+        import_names.push_back(String::FromFormat("script_function_%d^%d", i, i % 3));
+    }
+
+    typedef std::chrono::high_resolution_clock Clock;
+    auto t0 = Clock::now();
+    for (int i = 0; i < api_count; ++i)
+        imp.add(api_names[i], MakeValue(i), nullptr);
+    for (int i = 0; i < export_count; ++i)
+        imp.add(export_names[i], MakeValue(api_count + i), inst);
+    auto t1 = Clock::now();
+    size_t found = 0;
+    for (const auto &name : import_names)
+    {
+        if (imp.get_index_of(name) != UINT32_MAX)
+            found++;
+    }
+    auto t2 = Clock::now();
+    size_t names_found = 0;
+    for (int i = 0; i < api_count + export_count; ++i)
+    {
+        if (!imp.findName(MakeValue(i)).IsEmpty())
+            names_found++;
+    }
+    auto t3 = Clock::now();
+    imp.RemoveScriptExports(inst);
+    for (int i = 0; i < export_count; ++i)
+        imp.add(export_names[i], MakeValue(api_count + i), inst);
+    auto t4 = Clock::now();
+
+    ASSERT_EQ(found, import_names.size());
+    ASSERT_EQ(names_found, import_names.size());
+    typedef std::chrono::duration<double, std::micro> usec;
+    printf("SystemImports (%d symbols): add %.3f us/op; lookup %.3f us/op; find name %.3f us/op; re-export %.0f us\n",
+        api_count + export_count,
+        usec(t1 - t0).count() / (api_count + export_count),
+        usec(t2 - t1).count() / import_names.size(),
+        usec(t3 - t2).count() / (api_count + export_count),
+        usec(t4 - t3).count());
+}
@@ -0,0 +1,96 @@
+#include <random>
+#include <vector>
+#include "gtest/gtest.h"
+#include "gfx/texture_atlas.h"
+
+using namespace AGS::Engine;
+
+static bool IsInside(const Rect &rc, int width, int height)
+{
+    return rc.Left >= 0 && rc.Top >= 0 && rc.Right < width && rc.Bottom < height;
+}
+
+static bool HasOverlaps(const std::vector<Rect> &rects)
+{
+    for (size_t i = 0; i < rects.size(); ++i)
+        for (size_t j = i + 1; j < rects.size(); ++j)
+            if (AreRectsIntersecting(rects[i], rects[j]))
+                return true;
+    return false;
+}
+
+TEST(TextureAtlas, Allocate) {
+    TextureAtlasPacker packer(256, 256);
+    Rect rc;
+    ASSERT_FALSE(packer.Allocate(0, 10, rc));
+    ASSERT_FALSE(packer.Allocate(257, 10, rc));
+    ASSERT_FALSE(packer.Allocate(10, 257, rc));
+    ASSERT_TRUE(packer.Allocate(256, 256, rc));
+    ASSERT_EQ(rc.Left, 0);
+    ASSERT_EQ(rc.Top, 0);
+    ASSERT_EQ(rc.GetWidth(), 256);
+    ASSERT_EQ(rc.GetHeight(), 256);
+    ASSERT_FALSE(packer.Allocate(1, 1, rc));
+    packer.Free(RectWH(0, 0, 256, 256));
+    ASSERT_EQ(packer.GetCount(), 0u);
+
+    // Similar heights share a shelf
+    std::vector<Rect> rects;
+    for (int h : { 10, 12, 16, 9 })
+    {
+        ASSERT_TRUE(packer.Allocate(32, h, rc));
+        rects.push_back(rc);
+    }
+    for (const auto &r : rects)
+        ASSERT_EQ(r.Top, 0);
+    ASSERT_FALSE(HasOverlaps(rects));
+    ASSERT_EQ(packer.GetCount(), 4u);
+}
+
+TEST(TextureAtlas, FreeAndReuse) {
+    const int page = 512;
+    TextureAtlasPacker packer(page, page);
+    std::mt19937 rng(99);
+    std::vector<Rect> rects;
+    Rect rc;
+    // Fill the page with random regions until it's full
+    for (int fails = 0; fails < 50;)
+    {
+        if (packer.Allocate(1 + rng() % 64, 1 + rng() % 64, rc))
+        {
+            ASSERT_TRUE(IsInside(rc, page, page));
+            rects.push_back(rc);
+        }
+        else
+        {
+            fails++;
+        }
+    }
+    ASSERT_FALSE(HasOverlaps(rects));
+    ASSERT_EQ(packer.GetCount(), rects.size());
+
+    // Free random half, and fill again
+    std::shuffle(rects.begin(), rects.end(), rng);
+    for (size_t i = rects.size() / 2; i < rects.size(); ++i)
+        packer.Free(rects[i]);
+    rects.resize(rects.size() / 2);
+    ASSERT_EQ(packer.GetCount(), rects.size());
+    size_t reused = 0;
+    for (int i = 0; i < 200; ++i)
+    {
+        if (packer.Allocate(1 + rng() % 64, 1 + rng() % 64, rc))
+        {
+            ASSERT_TRUE(IsInside(rc, page, page));
+            rects.push_back(rc);
+            reused++;
+        }
+    }
+    ASSERT_GT(reused, 0u);
+    ASSERT_FALSE(HasOverlaps(rects));
+
+    // Freeing everything gives whole page back
+    for (const auto &r : rects)
+        packer.Free(r);
+    ASSERT_EQ(packer.GetCount(), 0u);
+    ASSERT_TRUE(packer.Allocate(page, page, rc));
+}
@@ -0,0 +1,209 @@
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "gfx/bitmap.h"
+#include "gfx/vmem_convert.h"
+
+using namespace AGS::Common;
+using namespace AGS::Engine;
+
+static const VMemConvertImpl AllImpls[] = { kVMemConvert_Generic, kVMemConvert_SSE2, kVMemConvert_NEON };
+static const char *ImplNames[] = { "generic", "SSE2", "NEON" };
+
+static void RestoreDefaultImpl()
+{
+    if (!set_vmem_convert_impl(kVMemConvert_SSE2))
+        set_vmem_convert_impl(kVMemConvert_NEON);
+}
+
+static void FillRandom(Bitmap *bmp, std::mt19937 &rng)
+{
+    const uint32_t mask = bmp->GetMaskColor();
+    for (int y = 0; y < bmp->GetHeight(); ++y)
+    {
+        for (int x = 0; x < bmp->GetWidth(); ++x)
+        {
+            // make small transparent areas, and single transparent pixels
+            const bool masked = ((x / 5 + y / 3) % 7 == 0) || (rng() % 11 == 0);
+            const uint32_t color = (bmp->GetColorDepth() == 32) ? rng() : rng() % (1u << bmp->GetColorDepth());
+            bmp->PutPixel(x, y, masked ? mask : color);
+        }
+    }
+}
+
+static uint32_t PackColor(const VMemPixelFormat &f, int r, int g, int b, int a)
+{
+    return ((r & 0xFF) << f.RShift) | ((g & 0xFF) << f.GShift) | ((b & 0xFF) << f.BShift) | ((a & 0xFF) << f.AShift);
+}
+
+static uint32_t ConvertPixel(const VMemPixelFormat &f, int depth, int c, bool has_alpha)
+{
+    switch (depth)
+    {
+    case 8: return PackColor(f, getr8(c), getg8(c), getb8(c), 0xFF);
+    case 16: return PackColor(f, getr16(c), getg16(c), getb16(c), 0xFF);
+    default: return PackColor(f, getr32(c), getg32(c), getb32(c), has_alpha ? geta32(c) : 0xFF);
+    }
+}
+
+// Straightforward per-pixel conversion, following the rules which
+// the texture uploads used before the row converters were introduced
+static void ConvertReference(const Bitmap *bmp, int sx, int sy, int w, int h,
+    const VMemPixelFormat &f, int flags, uint32_t *dst, int pitch)
+{
+    const int depth = bmp->GetColorDepth();
+    const bool has_alpha = (flags & kVMem_HasAlpha) && (depth == 32);
+    const bool opaque = (flags & kVMem_Opaque) != 0;
+    const int mask = bmp->GetMaskColor();
+    for (int y = 0; y < h; ++y)
+    {
+        uint32_t *row = dst + y * pitch;
+        bool last_transparent = false;
+        for (int x = 0; x < w; ++x)
+        {
+            const int c = bmp->GetPixel(sx + x, sy + y);
+            if (opaque || c != mask)
+            {
+                row[x] = ConvertPixel(f, depth, c, has_alpha);
+                if (last_transparent && !has_alpha)
+                    row[x - 1] = row[x] & 0x00FFFFFF;
+                last_transparent = false;
+                continue;
+            }
+            last_transparent = true;
+            row[x] = 0;
+            if (!(flags & kVMem_KeepMaskColor))
+                continue;
+            int r = 0, g = 0, b = 0, n = 0;
+            const int nx[] = { x - 1, x + 1, x, x };
+            const int ny[] = { y, y, y - 1, y + 1 };
+            for (int i = 0; i < 4; ++i)
+            {
+                if (nx[i] < 0 || nx[i] >= w || ny[i] < 0 || ny[i] >= h)
+                    continue;
+                const int nc = bmp->GetPixel(sx + nx[i], sy + ny[i]);
+                if (nc == mask)
+                    continue;
+                switch (depth)
+                {
+                case 8: r += getr8(nc); g += getg8(nc); b += getb8(nc); break;
+                case 16: r += getr16(nc); g += getg16(nc); b += getb16(nc); break;
+                default: r += getr32(nc); g += getg32(nc); b += getb32(nc); break;
+                }
+                n++;
+            }
+            if (depth == 8)
+            { // 8-bit sums were always accumulated in bytes
+                r &= 0xFF; g &= 0xFF; b &= 0xFF;
+            }
+            if (n > 0)
+                row[x] = PackColor(f, r / n, g / n, b / n, 0);
+        }
+        if (flags & kVMem_EdgeLeft)
+            row[-1] = row[0] & 0x00FFFFFF;
+        if (flags & kVMem_EdgeRight)
+            row[w] = row[w - 1] & 0x00FFFFFF;
+    }
+    const int from = (flags & kVMem_EdgeLeft) ? -1 : 0;
+    const int to = (flags & kVMem_EdgeRight) ? w + 1 : w;
+    for (int x = from; x < to; ++x)
+    {
+        if (flags & kVMem_EdgeTop)
+            dst[x - pitch] = dst[x] & 0x00FFFFFF;
+        if (flags & kVMem_EdgeBottom)
+            dst[x + h * pitch] = dst[x + (h - 1) * pitch] & 0x00FFFFFF;
+    }
+}
+
+static void SetTestPalette(std::mt19937 &rng)
+{
+    PALETTE pal;
+    for (int i = 0; i < 256; ++i)
+    {
+        pal[i].r = rng() % 64;
+        pal[i].g = rng() % 64;
+        pal[i].b = rng() % 64;
+    }
+    select_palette(pal);
+}
+
+// Converts bitmap regions of various sizes and offsets, with all the flag
+// combinations, and compares the result with the per-pixel conversion
+TEST(VMemConvert, MatchesPerPixelConversion) {
+    std::mt19937 rng(777);
+    SetTestPalette(rng);
+    const int depths[] = { 8, 16, 32 };
+    const VMemPixelFormat formats[] = { VMemPixelFormat(), VMemPixelFormat{ 0, 8, 16, 24 } };
+    const Rect regions[] = { RectWH(0, 0, 37, 23), RectWH(3, 5, 1, 1), RectWH(1, 2, 16, 9), RectWH(5, 0, 13, 23) };
+    const int flag_sets[] = { 0, kVMem_Opaque, kVMem_HasAlpha, kVMem_KeepMaskColor,
+        kVMem_HasAlpha | kVMem_KeepMaskColor, kVMem_Opaque | kVMem_HasAlpha };
+    const int edge_sets[] = { 0, kVMem_EdgeRight | kVMem_EdgeBottom,
+        kVMem_EdgeLeft | kVMem_EdgeTop | kVMem_EdgeRight | kVMem_EdgeBottom };
+    for (int depth : depths)
+    {
+        std::unique_ptr<Bitmap> bmp(BitmapHelper::CreateBitmap(40, 24, depth));
+        FillRandom(bmp.get(), rng);
+        for (int i = 0; i < 3; ++i)
+        {
+            if (!set_vmem_convert_impl(AllImpls[i]))
+                continue;
+            for (const auto &format : formats)
+            for (const auto &rc : regions)
+            for (int flags : flag_sets)
+            for (int edges : edge_sets)
+            {
+                // leave 1 px border around, and fill it with a junk value
+                const int pitch = rc.GetWidth() + 2;
+                std::vector<uint32_t> ref(pitch * (rc.GetHeight() + 2), 0xDEADBEEF);
+                std::vector<uint32_t> test(ref);
+                const int offset = pitch + 1;
+                ConvertReference(bmp.get(), rc.Left, rc.Top, rc.GetWidth(), rc.GetHeight(), format,
+                    flags | edges, &ref[offset], pitch);
+                BitmapToVideoMem(bmp.get(), rc.Left, rc.Top, rc.GetWidth(), rc.GetHeight(), format,
+                    flags | edges, reinterpret_cast<uint8_t*>(&test[offset]), pitch * sizeof(uint32_t));
+                ASSERT_EQ(ref, test) << ImplNames[i] << ", " << depth << "-bit, flags " << (flags | edges)
+                    << ", region " << rc.Left << "," << rc.Top << " " << rc.GetWidth() << "x" << rc.GetHeight();
+            }
+        }
+    }
+    RestoreDefaultImpl();
+}
+
+// Measures conversion of a 1024x1024 texture tile, for each available
+// implementation and color depth
+TEST(VMemConvert, DISABLED_TextureUploadBenchmark) {
+    const int size = 1024, repeats = 10;
+    std::mt19937 rng(1);
+    SetTestPalette(rng);
+    std::vector<uint8_t> staging((size + 2) * (size + 2) * sizeof(uint32_t));
+    const int pitch = (size + 2) * sizeof(uint32_t);
+    const int edges = kVMem_EdgeLeft | kVMem_EdgeTop | kVMem_EdgeRight | kVMem_EdgeBottom;
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+    for (int depth : { 8, 16, 32 })
+    {
+        std::unique_ptr<Bitmap> bmp(BitmapHelper::CreateBitmap(size, size, depth));
+        FillRandom(bmp.get(), rng);
+        printf("VMemConvert: %dx%d %d-bit", size, size, depth);
+        for (int i = 0; i < 3; ++i)
+        {
+            if (!set_vmem_convert_impl(AllImpls[i]))
+                continue;
+            for (int flags : { kVMem_Opaque, kVMem_KeepMaskColor })
+            {
+                auto t0 = Clock::now();
+                for (int r = 0; r < repeats; ++r)
+                    BitmapToVideoMem(bmp.get(), 0, 0, size, size, VMemPixelFormat(), flags | edges,
+                        staging.data() + pitch + sizeof(uint32_t), pitch);
+                const double ms = msec(Clock::now() - t0).count() / repeats;
+                printf("; %s %s %.2f ms (%.0f MPx/s)", ImplNames[i], (flags & kVMem_Opaque) ? "opaque" : "masked",
+                    ms, size * size / ms / 1000.0);
+            }
+        }
+        printf("\n");
+    }
+    RestoreDefaultImpl();
+}
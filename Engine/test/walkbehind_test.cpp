@@ -0,0 +1,174 @@
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include "gtest/gtest.h"
+#include "ac/roomstatus.h"
+#include "ac/walkbehind.h"
+#include "game/roomstruct.h"
+#include "gfx/bitmap.h"
+
+using namespace AGS::Common;
+
+extern RoomStruct thisroom;
+extern RoomStatus *croom;
+
+// Makes a walk-behind mask with a number of rectangular and
+// irregularly shaped areas, overlapping each other
+static Bitmap *MakeWalkBehindMask(int width, int height, std::mt19937 &rng)
+{
+    Bitmap *mask = BitmapHelper::CreateBitmap(width, height, 8);
+    for (int y = 0; y < height; ++y)
+        memset(mask->GetScanLineForWriting(y), 0, width);
+    for (int i = 0; i < 40; ++i)
+    {
+        const int wb = 1 + rng() % (MAX_WALK_BEHINDS - 1);
+        const int x = rng() % width, y = rng() % height;
+        const int w = 1 + rng() % (width / 4), h = 1 + rng() % (height / 4);
+        const bool solid = (i % 2 == 0);
+        for (int yy = y; yy < std::min(height, y + h); ++yy)
+            for (int xx = x; xx < std::min(width, x + w); ++xx)
+                if (solid || (rng() % 3 != 0))
+                    mask->GetScanLineForWriting(yy)[xx] = wb;
+    }
+    return mask;
+}
+
+static Bitmap *CopyBitmap(const Bitmap *src)
+{
+    Bitmap *dst = BitmapHelper::CreateBitmap(src->GetWidth(), src->GetHeight(), src->GetColorDepth());
+    for (int y = 0; y < src->GetHeight(); ++y)
+        memcpy(dst->GetScanLineForWriting(y), src->GetScanLine(y), src->GetLineLength());
+    return dst;
+}
+
+static Bitmap *MakeSprite(int width, int height, int coldepth, std::mt19937 &rng)
+{
+    Bitmap *sprite = BitmapHelper::CreateBitmap(width, height, coldepth);
+    for (int y = 0; y < height; ++y)
+    {
+        uint8_t *line = sprite->GetScanLineForWriting(y);
+        for (int i = 0; i < sprite->GetLineLength(); ++i)
+            line[i] = static_cast<uint8_t>(rng());
+    }
+    return sprite;
+}
+
+// Cuts out walk-behinds from the sprite testing each pixel against the mask
+static bool CropoutPerPixel(Bitmap *sprite, int sprx, int spry, int basel)
+{
+    const Bitmap *mask = thisroom.WalkBehindMask.get();
+    bool changed = false;
+    for (int y = 0; y < sprite->GetHeight(); ++y)
+    {
+        for (int x = 0; x < sprite->GetWidth(); ++x)
+        {
+            const int mx = x + sprx, my = y + spry;
+            if (mx < 0 || my < 0 || mx >= mask->GetWidth() || my >= mask->GetHeight())
+                continue;
+            const int wb = mask->GetScanLine(my)[mx];
+            if (wb < 1 || croom->walkbehind_base[wb] <= basel)
+                continue;
+            uint8_t *line = sprite->GetScanLineForWriting(y);
+            switch (sprite->GetColorDepth())
+            {
+            case 8: line[x] = sprite->GetMaskColor(); break;
+            case 16: reinterpret_cast<uint16_t*>(line)[x] = sprite->GetMaskColor(); break;
+            case 32: reinterpret_cast<uint32_t*>(line)[x] = sprite->GetMaskColor(); break;
+            }
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static bool SameBitmaps(Bitmap *a, Bitmap *b)
+{
+    for (int y = 0; y < a->GetHeight(); ++y)
+    {
+        if (memcmp(a->GetScanLine(y), b->GetScanLine(y), a->GetLineLength()) != 0)
+            return false;
+    }
+    return true;
+}
+
+class WalkBehindTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        _oldRoom = croom;
+        croom = &_room;
+        for (int wb = 0; wb < MAX_WALK_BEHINDS; ++wb)
+            _room.walkbehind_base[wb] = static_cast<short>(wb * 50);
+    }
+
+    void TearDown() override
+    {
+        croom = _oldRoom;
+        thisroom.WalkBehindMask.reset();
+        noWalkBehindsAtAll = true;
+    }
+
+    RoomStatus _room;
+    RoomStatus *_oldRoom = nullptr;
+};
+
+TEST_F(WalkBehindTest, Cropout) {
+    std::mt19937 rng(1);
+    thisroom.WalkBehindMask.reset(MakeWalkBehindMask(320, 200, rng));
+    walkbehinds_recalc();
+    ASSERT_FALSE(noWalkBehindsAtAll);
+
+    for (int coldepth : { 8, 16, 32 })
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            // include the sprites partially or fully outside of the mask
+            const int w = 1 + rng() % 80, h = 1 + rng() % 80;
+            const int x = -100 + static_cast<int>(rng() % 520);
+            const int y = -100 + static_cast<int>(rng() % 400);
+            const int basel = rng() % (MAX_WALK_BEHINDS * 50);
+            std::unique_ptr<Bitmap> sprite(MakeSprite(w, h, coldepth, rng));
+            std::unique_ptr<Bitmap> expect(CopyBitmap(sprite.get()));
+            const bool expect_changed = CropoutPerPixel(expect.get(), x, y, basel);
+            ASSERT_EQ(expect_changed, walkbehinds_cropout(sprite.get(), x, y, basel));
+            ASSERT_TRUE(SameBitmaps(expect.get(), sprite.get()));
+        }
+    }
+}
+
+TEST_F(WalkBehindTest, NoAreas) {
+    thisroom.WalkBehindMask.reset(BitmapHelper::CreateBitmap(64, 64, 8));
+    for (int y = 0; y < 64; ++y)
+        memset(thisroom.WalkBehindMask->GetScanLineForWriting(y), 0, 64);
+    walkbehinds_recalc();
+    ASSERT_TRUE(noWalkBehindsAtAll);
+    std::mt19937 rng(1);
+    std::unique_ptr<Bitmap> sprite(MakeSprite(16, 16, 32, rng));
+    ASSERT_FALSE(walkbehinds_cropout(sprite.get(), 0, 0, 0));
+}
+
+// Measures the time of cutting out the characters behind the scenery
+// in a large scrolling room
+TEST_F(WalkBehindTest, DISABLED_Benchmark) {
+    std::mt19937 rng(2);
+    thisroom.WalkBehindMask.reset(MakeWalkBehindMask(2560, 1440, rng));
+    typedef std::chrono::high_resolution_clock Clock;
+    typedef std::chrono::duration<double, std::milli> msec;
+    auto t0 = Clock::now();
+    walkbehinds_recalc();
+    const double recalc_time = msec(Clock::now() - t0).count();
+
+    std::unique_ptr<Bitmap> sprite(MakeSprite(200, 300, 32, rng));
+    const int count = 1000;
+    t0 = Clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        walkbehinds_cropout(sprite.get(), rng() % 2360, rng() % 1140, i % (MAX_WALK_BEHINDS * 50));
+    }
+    const double cropout_time = msec(Clock::now() - t0).count();
+    printf("WalkBehind: recalc %.3f ms, cropout 200x300 %.4f ms per sprite\n",
+        recalc_time, cropout_time / count);
+}
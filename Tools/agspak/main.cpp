@@ -6,6 +6,7 @@
 //-----------------------------------------------------------------------//
 #include <algorithm>
 #include <stdio.h>
+#include <thread>
 #include "data/mfl_utils.h"
 #include "util/file.h"
 #include "util/multifilelib.h"
@@ -19,6 +20,8 @@ using namespace AGS::DataUtil;
 
 const char *HELP_STRING = "Usage: agspak <input-dir> <output-pak> [OPTIONS]\n"
 "Options:\n"
+"  -c             compress assets (requires engine supporting pack format 31)\n"
+"  -j <N>         number of worker threads, 0 to use all the CPU cores\n"
 "  -p <MB>        split game assets between partitions of this size max\n"
 "  -r             recursive mode: include all subdirectories too";
 
@@ -44,13 +47,20 @@ int main(int argc, char *argv[])
 
     size_t part_size = 0;
     bool do_subdirs = false;
+    PackOptions pack_opts;
     for (int i = 3; i < argc; ++i)
     {
         if (ags_stricmp(argv[i], "-p") == 0 && (i < argc - 1))
             part_size = StrUtil::StringToInt(argv[++i]);
         else if (ags_stricmp(argv[i], "-r") == 0)
             do_subdirs = true;
+        else if (ags_stricmp(argv[i], "-c") == 0)
+            pack_opts.Compress = true;
+        else if (ags_stricmp(argv[i], "-j") == 0 && (i < argc - 1))
+            pack_opts.Jobs = std::max(0, StrUtil::StringToInt(argv[++i]));
     }
+    if (pack_opts.Jobs == 0)
+        pack_opts.Jobs = std::max(1u, std::thread::hardware_concurrency());
 
     const char *src = argv[1];
     const char *dst = argv[2];
@@ -97,7 +107,8 @@ int main(int argc, char *argv[])
     // Write pack file
     //-----------------------------------------------------------------------//
     String lib_dir = Path::GetParent(lib_basefile);
-    err = WriteLibrary(lib, asset_dir, lib_dir, MFLUtil::kMFLVersion_MultiV30);
+    err = WriteLibrary(lib, asset_dir, lib_dir,
+        pack_opts.Compress ? MFLUtil::kMFLVersion_MultiV31 : MFLUtil::kMFLVersion_MultiV30, pack_opts);
     if (!err)
     {
         printf("Error: failed to write pack file:\n");
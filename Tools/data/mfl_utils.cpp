@@ -12,9 +12,18 @@
 //
 //=============================================================================
 #include "data/mfl_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
 #include "util/directory.h"
 #include "util/file.h"
+#include "util/lzw.h"
+#include "util/memorystream.h"
 #include "util/path.h"
 #include "util/stream.h"
 
@@ -59,12 +68,26 @@ HError UnpackLibrary(const AssetLibInfo &lib, const String &lib_dir, const Strin
                 continue;
             }
             lib_in->Seek(asset.Offset, kSeekBegin);
-            soff_t wrote = CopyStream(lib_in.get(), out.get(), asset.Size);
-            if (wrote == asset.Size)
+            soff_t expect = asset.Size;
+            soff_t wrote = 0;
+            if ((asset.Flags & kAssetFlag_Compressed) != 0)
+            {
+                expect = asset.UncompressedSize;
+                std::vector<uint8_t> packed(static_cast<size_t>(asset.Size));
+                std::vector<uint8_t> data(static_cast<size_t>(asset.UncompressedSize));
+                if ((lib_in->Read(packed.data(), packed.size()) == packed.size()) &&
+                    (data.empty() || lzwexpand(packed.data(), packed.size(), data.data(), data.size())))
+                    wrote = out->Write(data.data(), data.size());
+            }
+            else
+            {
+                wrote = CopyStream(lib_in.get(), out.get(), asset.Size);
+            }
+            if (wrote == expect)
                 printf("+ %s\n", asset.FileName.GetCStr());
             else
                 printf("Error: file was not written correctly: %s\n Expected: %jd, wrote: %jd bytes\n",
-                    asset.FileName.GetCStr(), static_cast<intmax_t>(asset.Size), static_cast<intmax_t>(wrote));
+                    asset.FileName.GetCStr(), static_cast<intmax_t>(expect), static_cast<intmax_t>(wrote));
         }
     }
     return HError::None();
@@ -139,42 +162,367 @@ HError MakeAssetLib(AssetLibInfo &lib, const String &lib_basefile,
     return HError::None();
 }
 
-HError WriteLibraryFile(AssetLibInfo &lib, const String &asset_dir,
-    const String &lib_filename, MFLUtil::MFLVersion lib_version, int lib_index)
+// Assets larger than this are copied to the library right from their files
+// by the writing thread, instead of being read into memory by a worker
+static const soff_t MaxBufferedAssetSize = 4 * 1024 * 1024;
+// Assets larger than this are never compressed, because the engine
+// has to unpack the whole compressed asset into memory when opening it
+static const soff_t MaxCompressedAssetSize = 16 * 1024 * 1024;
+// Size of a chunk to read when hashing or comparing files
+static const size_t FileChunkSize = 64 * 1024;
+
+// Runs fn for each index in [0, count) on the given number of threads
+template <typename TFunc>
+static void ParallelFor(size_t count, size_t jobs, TFunc fn)
+{
+    jobs = std::min(jobs, count);
+    if (jobs <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+            fn(i);
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < jobs; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads)
+        t.join();
+}
+
+// Calculates the 64-bit FNV-1a hash of the file's contents
+static bool HashFile(const String &path, uint64_t &hash)
+{
+    std::unique_ptr<Stream> in(File::OpenFileRead(path));
+    if (!in)
+        return false;
+    std::vector<uint8_t> buf(FileChunkSize);
+    hash = 0xcbf29ce484222325ULL;
+    for (size_t read = in->Read(buf.data(), buf.size()); read > 0;
+         read = in->Read(buf.data(), buf.size()))
+    {
+        for (size_t i = 0; i < read; ++i)
+            hash = (hash ^ buf[i]) * 0x100000001b3ULL;
+    }
+    return true;
+}
+
+// Tells if the two files have identical contents
+static bool CompareFiles(const String &path1, const String &path2)
+{
+    std::unique_ptr<Stream> in1(File::OpenFileRead(path1));
+    std::unique_ptr<Stream> in2(File::OpenFileRead(path2));
+    if (!in1 || !in2)
+        return false;
+    std::vector<uint8_t> buf1(FileChunkSize), buf2(FileChunkSize);
+    for (;;)
+    {
+        size_t read1 = in1->Read(buf1.data(), buf1.size());
+        size_t read2 = in2->Read(buf2.data(), buf2.size());
+        if (read1 != read2 || memcmp(buf1.data(), buf2.data(), read1) != 0)
+            return false;
+        if (read1 == 0)
+            return true;
+    }
+}
+
+// Finds the assets with identical contents; for each asset dup_of tells
+// the index of the first asset with the same data, or -1 if there's none
+static HError FindDuplicates(const AssetLibInfo &lib, const String &asset_dir,
+    size_t jobs, std::vector<int> &dup_of)
+{
+    const auto &assets = lib.AssetInfos;
+    dup_of.assign(assets.size(), -1);
+    // Only the assets of the same size may be identical, so only these are hashed
+    std::unordered_map<soff_t, std::vector<size_t>> by_size;
+    for (size_t i = 0; i < assets.size(); ++i)
+    {
+        if (assets[i].Size > 0)
+            by_size[assets[i].Size].push_back(i);
+    }
+    std::vector<size_t> to_hash;
+    for (const auto &group : by_size)
+    {
+        if (group.second.size() > 1)
+            to_hash.insert(to_hash.end(), group.second.begin(), group.second.end());
+    }
+    if (to_hash.empty())
+        return HError::None();
+
+    // NOTE: the paths are made beforehand, because String's reference
+    // counting is not thread-safe
+    std::vector<String> paths(assets.size());
+    for (size_t i : to_hash)
+        paths[i] = Path::ConcatPaths(asset_dir, assets[i].FileName);
+    std::vector<uint64_t> hashes(assets.size());
+    std::vector<uint8_t> hashed(assets.size());
+    ParallelFor(to_hash.size(), jobs, [&](size_t n)
+    {
+        const size_t i = to_hash[n];
+        hashed[i] = HashFile(paths[i], hashes[i]);
+    });
+    for (size_t i : to_hash)
+    {
+        if (!hashed[i])
+            return new Error(String::FromFormat("Failed to read the asset '%s'.", assets[i].FileName.GetCStr()));
+    }
+
+    // Match assets by hash, and make sure that they are really identical
+    for (const auto &group : by_size)
+    {
+        const auto &idx = group.second;
+        for (size_t k = 1; k < idx.size(); ++k)
+        {
+            for (size_t m = 0; m < k; ++m)
+            {
+                if (dup_of[idx[m]] >= 0 || hashes[idx[m]] != hashes[idx[k]])
+                    continue;
+                if (CompareFiles(paths[idx[m]], paths[idx[k]]))
+                {
+                    dup_of[idx[k]] = static_cast<int>(idx[m]);
+                    break;
+                }
+            }
+        }
+    }
+    return HError::None();
+}
+
+// Asset data prepared for writing into the library
+struct AssetBlock
+{
+    bool Ready = false;
+    HError Err;
+    // Data to write, unless the asset is streamed from its file
+    std::vector<uint8_t> Data;
+    bool Streamed = false;
+    uint32_t Flags = 0u;
+    soff_t UncompressedSize = 0;
+};
+
+// Reads the asset and optionally compresses it
+static void PrepareAsset(const AssetInfo &asset, const String &path,
+    const PackOptions &opts, AssetBlock &block)
+{
+    const soff_t asset_size = asset.Size;
+    block.UncompressedSize = asset_size;
+    const bool compress = opts.Compress && asset_size > 0 && asset_size <= MaxCompressedAssetSize;
+    if (!compress && asset_size > MaxBufferedAssetSize)
+    {
+        block.Streamed = true;
+        return;
+    }
+
+    std::unique_ptr<Stream> in(File::OpenFileRead(path));
+    if (!in)
+    {
+        block.Err = new Error(String::FromFormat("Failed to open the asset '%s' for reading.", asset.FileName.GetCStr()));
+        return;
+    }
+    block.Data.resize(static_cast<size_t>(asset_size));
+    if (in->Read(block.Data.data(), block.Data.size()) < block.Data.size())
+    {
+        block.Err = new Error(String::FromFormat("Failed to read the asset '%s'.", asset.FileName.GetCStr()));
+        return;
+    }
+    if (!compress)
+        return;
+
+    // Keep the compressed data only if it's actually smaller
+    std::vector<uint8_t> packed;
+    VectorStream data_in(block.Data);
+    VectorStream packed_out(packed, kStream_Write);
+    if (lzwcompress(&data_in, &packed_out) && packed.size() < block.Data.size())
+    {
+        block.Data = std::move(packed);
+        block.Flags |= kAssetFlag_Compressed;
+    }
+}
+
+// Writes the assets of the given indexes into the library stream.
+// Assets are read and compressed on the worker threads, while the calling
+// thread writes them in order; the number of the assets prepared ahead
+// is limited, to keep the memory use bounded.
+static HError WriteAssets(AssetLibInfo &lib, const std::vector<size_t> &indexes,
+    const String &asset_dir, const PackOptions &opts, Stream *out, soff_t s_offset)
+{
+    const size_t jobs = std::min(opts.Jobs, indexes.size());
+    const size_t window = std::max<size_t>(jobs, 1) * 2;
+    std::vector<AssetBlock> blocks(indexes.size());
+    // NOTE: the paths are made beforehand, because String's reference
+    // counting is not thread-safe
+    std::vector<String> paths(indexes.size());
+    for (size_t n = 0; n < indexes.size(); ++n)
+        paths[n] = Path::ConcatPaths(asset_dir, lib.AssetInfos[indexes[n]].FileName);
+    std::mutex mutex;
+    std::condition_variable cv_ready, cv_space;
+    size_t next = 0, written = 0;
+    bool stop = false;
+
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            size_t n;
+            {
+                std::unique_lock<std::mutex> lk(mutex);
+                cv_space.wait(lk, [&]() { return stop || next >= blocks.size() || next < written + window; });
+                if (stop || next >= blocks.size())
+                    return;
+                n = next++;
+            }
+            // the writing thread does not touch this asset until it's ready
+            AssetBlock block;
+            PrepareAsset(lib.AssetInfos[indexes[n]], paths[n], opts, block);
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                blocks[n] = std::move(block);
+                blocks[n].Ready = true;
+            }
+            cv_ready.notify_all();
+        }
+    };
+    std::vector<std::thread> threads;
+    if (jobs > 1)
+    {
+        for (size_t i = 0; i < jobs; ++i)
+            threads.emplace_back(worker);
+    }
+
+    HError err = HError::None();
+    for (size_t n = 0; n < indexes.size() && err; ++n)
+    {
+        AssetInfo &asset = lib.AssetInfos[indexes[n]];
+        AssetBlock block;
+        if (threads.empty())
+        {
+            PrepareAsset(asset, paths[n], opts, block);
+        }
+        else
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv_ready.wait(lk, [&]() { return blocks[n].Ready; });
+            block = std::move(blocks[n]);
+        }
+
+        if (!block.Err)
+        {
+            err = block.Err;
+            break;
+        }
+        asset.Offset = out->GetPosition() - s_offset;
+        if (block.Streamed)
+        {
+            std::unique_ptr<Stream> in(File::OpenFileRead(paths[n]));
+            if (!in)
+                err = new Error("Failed to open the file for reading.");
+            else if (CopyStream(in.get(), out, asset.Size) < asset.Size)
+                err = new Error(String::FromFormat("Failed to write the asset '%s'.", asset.FileName.GetCStr()));
+        }
+        else
+        {
+            if (out->Write(block.Data.data(), block.Data.size()) < block.Data.size())
+                err = new Error(String::FromFormat("Failed to write the asset '%s'.", asset.FileName.GetCStr()));
+            asset.Size = block.Data.size();
+        }
+        asset.Flags = block.Flags;
+        asset.UncompressedSize = block.UncompressedSize;
+
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            written = n + 1;
+        }
+        cv_space.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        stop = true;
+    }
+    cv_space.notify_all();
+    for (auto &t : threads)
+        t.join();
+    return err;
+}
+
+// Writes the library partition into the file lib_filename;
+// recalculates asset offsets and stores in lib as it goes.
+static HError WriteLibraryFile(AssetLibInfo &lib, const std::vector<int> &dup_of,
+    const String &asset_dir, const String &lib_filename, MFLUtil::MFLVersion lib_version,
+    int lib_index, const PackOptions &opts)
 {
     std::unique_ptr<Stream> out(File::CreateFile(lib_filename));
     if (!out)
         return new Error("Error: failed to open pack file for writing.");
 
+    // Only V30+ table of contents may be written
+    const MFLUtil::MFLVersion toc_version = std::max(lib_version, MFLUtil::kMFLVersion_MultiV30);
     soff_t s_offset = out->GetPosition();
-    MFLUtil::WriteHeader(lib, MFLUtil::kMFLVersion_MultiV30, lib_index, out.get());
-    for (auto &asset : lib.AssetInfos)
+    MFLUtil::WriteHeader(lib, toc_version, lib_index, out.get());
+    std::vector<size_t> indexes;
+    for (size_t i = 0; i < lib.AssetInfos.size(); ++i)
     {
-        if (asset.LibUid == lib_index)
+        if (lib.AssetInfos[i].LibUid == lib_index && dup_of[i] < 0)
+            indexes.push_back(i);
+    }
+    HError err = WriteAssets(lib, indexes, asset_dir, opts, out.get(), s_offset);
+    if (!err)
+        return err;
+    // The first partition is written last and has the table of contents,
+    // so this is where the duplicates get their final locations
+    if (lib_index == 0)
+    {
+        for (size_t i = 0; i < lib.AssetInfos.size(); ++i)
         {
-            asset.Offset = out->GetPosition() - s_offset;
-            String path = Path::ConcatPaths(asset_dir, asset.FileName);
-            std::unique_ptr<Stream> in(File::OpenFileRead(path));
-            if (!in)
-                return new Error("Failed to open the file for reading.");
-            if (CopyStream(in.get(), out.get(), asset.Size) < asset.Size)
-                return new Error(String::FromFormat("Failed to write the asset '%s'.", asset.FileName.GetCStr()));
+            if (dup_of[i] < 0)
+                continue;
+            AssetInfo &dup = lib.AssetInfos[i];
+            const AssetInfo &orig = lib.AssetInfos[dup_of[i]];
+            dup.LibUid = orig.LibUid;
+            dup.Offset = orig.Offset;
+            dup.Size = orig.Size;
+            dup.Flags = orig.Flags;
+            dup.UncompressedSize = orig.UncompressedSize;
         }
     }
     out->Seek(s_offset, kSeekBegin);
-    MFLUtil::WriteHeader(lib, MFLUtil::kMFLVersion_MultiV30, lib_index, out.get());
+    MFLUtil::WriteHeader(lib, toc_version, lib_index, out.get());
     out->Seek(0, kSeekEnd);
     MFLUtil::WriteEnder(s_offset, lib_version, out.get());
     return HError::None();
 }
 
 HError WriteLibrary(AssetLibInfo &lib, const String &asset_dir,
-    const String &dst_dir, MFLUtil::MFLVersion lib_version)
+    const String &dst_dir, MFLUtil::MFLVersion lib_version, const PackOptions &opts)
 {
-    for (size_t id = 0; id < lib.LibFileNames.size(); ++id)
+    if (opts.Compress && lib_version < MFLUtil::kMFLVersion_MultiV31)
+        return new Error("Compressed assets require library format version 31 or higher.");
+
+    std::vector<int> dup_of;
+    if (opts.Deduplicate)
+    {
+        HError err = FindDuplicates(lib, asset_dir, opts.Jobs, dup_of);
+        if (!err)
+            return err;
+    }
+    else
+    {
+        dup_of.assign(lib.AssetInfos.size(), -1);
+    }
+
+    // Partitions are written in the reverse order, because the first one has
+    // the table of contents of the whole library, which must be written with
+    // the final locations of all the assets
+    for (size_t id = lib.LibFileNames.size(); id-- > 0;)
     {
         String dst_file = Path::ConcatPaths(dst_dir, lib.LibFileNames[id]);
-        HError err = WriteLibraryFile(lib, asset_dir, dst_file, lib_version, id);
+        HError err = WriteLibraryFile(lib, dup_of, asset_dir, dst_file, lib_version, id, opts);
         if (!err)
             return err;
     }
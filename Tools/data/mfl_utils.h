@@ -29,6 +29,19 @@ namespace DataUtil
     using AGS::Common::Stream;
     using AGS::Common::String;
 
+    // Library packing options
+    struct PackOptions
+    {
+        // Number of the worker threads, which read, hash and compress assets
+        size_t Jobs = 1;
+        // Store the assets of identical contents only once, letting them
+        // share a single data block in the library
+        bool Deduplicate = true;
+        // Compress the assets, when that makes them smaller;
+        // requires library format kMFLVersion_MultiV31 or higher
+        bool Compress = false;
+    };
+
     // Unpacks the library by reading its parts and writing assets into files.
     // lib_dir - tells the directory where the library parts are located;
     // The output files will be written into dst_dir directory;
@@ -42,14 +55,11 @@ namespace DataUtil
     // library partition by part_size bytes
     HError MakeAssetLib(AssetLibInfo &lib, const String &lib_basefile,
         std::vector<AssetInfo> &assets, soff_t part_size = 0);
-    // Writes the library partition into the file lib_filename;
-    // recalculates asset offsets and stores in lib as it goes.
-    HError WriteLibraryFile(AssetLibInfo &lib, const String &src_dir,
-        const String &lib_filename, AGS::Common::MFLUtil::MFLVersion lib_version, int lib_index);
     // Writes the potentially multi-file library into the dst_dir directory;
     // recalculates asset offsets and stores in lib as it goes.
     HError WriteLibrary(AssetLibInfo &lib, const String &asset_dir,
-        const String &dst_dir, AGS::Common::MFLUtil::MFLVersion lib_version);
+        const String &dst_dir, AGS::Common::MFLUtil::MFLVersion lib_version,
+        const PackOptions &opts = PackOptions());
 
 } // namespace DataUtil
 } // namespace AGS